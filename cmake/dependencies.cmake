@@ -90,4 +90,12 @@ FetchContent_Declare(
 	GIT_SHALLOW ON
 	GIT_PROGRESS ON
 	SYSTEM
-)
\ No newline at end of file
+)
+
+FetchContent_Declare(
+	stb
+	GIT_REPOSITORY https://github.com/nothings/stb.git
+	GIT_TAG 013ac3beddff3dbffafd5177e7972067cd2b5083
+	GIT_PROGRESS ON
+	SYSTEM
+)
@@ -1,19 +1,34 @@
 #version 460
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 inDiffuseColor;
 layout(location = 1) in vec3 inSpecularColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec3 inWorldPosition;
+layout(location = 4) in vec2 inUV;
 
 layout(location = 0) out vec4 outDiffuseColor;
 layout(location = 1) out vec4 outSpecularColor;
 layout(location = 2) out vec4 outNormal;
 layout(location = 3) out vec4 outWorldPosition;
 
+// Streamed by TextureStreamer, index 0 is always white
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+// Shares the vertex shader's push constant, which fills the first 80 bytes
+layout( push_constant ) uniform PushConstant
+{
+	layout(offset = 80) vec4 baseColorFactor;
+	uint baseColorTexture;
+} pushConstant;
+
 void main()
 {
+	vec4 baseColor = texture(textures[pushConstant.baseColorTexture], inUV)
+		* pushConstant.baseColorFactor;
+
 	outWorldPosition = vec4(inWorldPosition, 1.0);
 	outNormal = vec4(inNormal, 0.0);
-	outDiffuseColor = vec4(inDiffuseColor, 1.0);
+	outDiffuseColor = vec4(inDiffuseColor * baseColor.rgb, 1.0);
 	outSpecularColor = vec4(inSpecularColor, 1.0);
 }
\ No newline at end of file
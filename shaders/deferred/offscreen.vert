@@ -6,6 +6,7 @@ layout(location = 0) out vec3 outDiffuseColor;
 layout(location = 1) out vec3 outSpecularColor;
 layout(location = 2) out vec3 outNormal;
 layout(location = 3) out vec3 outWorldPosition;
+layout(location = 4) out vec2 outUV;
 
 #include "../types/camera.glsl"
 #include "../types/vertex.glsl"
@@ -18,6 +19,10 @@ layout(buffer_reference, std430) readonly buffer VertexBuffer{
 	Vertex vertices[];
 };
 
+layout(buffer_reference, std430) readonly buffer PackedVertexBuffer{
+	PackedVertex vertices[];
+};
+
 layout(buffer_reference, std430) readonly buffer ModelBuffer{
 	mat4 models[];
 };
@@ -26,20 +31,48 @@ layout(buffer_reference, std430) readonly buffer ModelInverseTransposeBuffer{
 	mat4 modelInverseTransposes[];
 };
 
+layout(buffer_reference, std430) readonly buffer InstanceIndexBuffer{
+	uint indices[];
+};
+
 layout( push_constant ) uniform PushConstant
 {
 	VertexBuffer vertexBuffer;
 	ModelBuffer modelBuffer;
 	ModelInverseTransposeBuffer modelInverseTransposeBuffer;
 	CameraBuffer cameraBuffer;
+	InstanceIndexBuffer instanceIndexBuffer;
 	uint cameraIndex;
+	uint vertexFormat;
+	vec4 positionMin;
+	vec4 positionExtent;
+	// Only read by the fragment shader
+	vec4 baseColorFactor;
+	uint baseColorTexture;
 } pushConstant;
 
+Vertex loadVertex(uint index)
+{
+	if (pushConstant.vertexFormat == VERTEX_FORMAT_PACKED)
+	{
+		PackedVertexBuffer packedVertices = PackedVertexBuffer(pushConstant.vertexBuffer);
+		return unpackVertex(
+			packedVertices.vertices[index],
+			pushConstant.positionMin.xyz,
+			pushConstant.positionExtent.xyz
+		);
+	}
+	return pushConstant.vertexBuffer.vertices[index];
+}
+
 void main()
 {
-	mat4 model = pushConstant.modelBuffer.models[gl_InstanceIndex];
-	mat4 modelInverseTranspose = pushConstant.modelInverseTransposeBuffer.modelInverseTransposes[gl_InstanceIndex];
-	Vertex vertex = pushConstant.vertexBuffer.vertices[gl_VertexIndex];
+	// Instances are sorted by level of detail, so we look up the real index
+	uint instanceIndex = pushConstant.instanceIndexBuffer.indices[gl_InstanceIndex];
+
+	mat4 model = pushConstant.modelBuffer.models[instanceIndex];
+	mat4 modelInverseTranspose = pushConstant.modelInverseTransposeBuffer.modelInverseTransposes[instanceIndex];
+	Vertex vertex = loadVertex(gl_VertexIndex);
 	Camera camera = pushConstant.cameraBuffer.cameras[pushConstant.cameraIndex];
 
 	vec4 position = model * vec4(vertex.position, 1.0);
@@ -50,6 +83,9 @@ void main()
 	vec4 normal = modelInverseTranspose * vec4(vertex.normal, 0.0);
 	outNormal = normalize(normal.xyz);
 
-	outDiffuseColor = vec3(0.8);
+	outUV = vec2(vertex.uv_x, vertex.uv_y);
+
+	// The material's base color is applied per fragment
+	outDiffuseColor = vec3(1.0);
 	outSpecularColor = vec3(1.0);
 }
\ No newline at end of file
@@ -8,28 +8,60 @@ layout(buffer_reference, std430) readonly buffer ProjViewBuffer{
 	mat4 matrices[];
 };
 
-layout(buffer_reference, std430) readonly buffer VertexBuffer{
-	Vertex vertices[];
+// Positions alone, so no other vertex attributes are fetched
+layout(buffer_reference, std430) readonly buffer PositionBuffer{
+	float positions[];
+};
+
+layout(buffer_reference, std430) readonly buffer PackedPositionBuffer{
+	uvec2 positions[];
 };
 
 layout(buffer_reference, std430) readonly buffer ModelBuffer{
 	mat4 models[];
 };
 
+layout(buffer_reference, std430) readonly buffer InstanceIndexBuffer{
+	uint indices[];
+};
+
 layout( push_constant ) uniform PushConstant
 {
-	VertexBuffer vertexBuffer;
+	PositionBuffer positionBuffer;
 	ModelBuffer modelBuffer;
 	ProjViewBuffer projViewBuffer;
+	InstanceIndexBuffer instanceIndexBuffer;
 	uint projViewIndex;
+	uint vertexFormat;
+	vec4 positionMin;
+	vec4 positionExtent;
 } pushConstant;
 
+vec3 loadPosition(uint index)
+{
+	if (pushConstant.vertexFormat == VERTEX_FORMAT_PACKED)
+	{
+		PackedPositionBuffer packedPositions = PackedPositionBuffer(pushConstant.positionBuffer);
+		return unpackPosition(
+			packedPositions.positions[index],
+			pushConstant.positionMin.xyz,
+			pushConstant.positionExtent.xyz
+		);
+	}
+	return vec3(
+		pushConstant.positionBuffer.positions[index * 3],
+		pushConstant.positionBuffer.positions[index * 3 + 1],
+		pushConstant.positionBuffer.positions[index * 3 + 2]
+	);
+}
+
 void main()
 {
-	mat4 model = pushConstant.modelBuffer.models[gl_InstanceIndex];
+	uint instanceIndex = pushConstant.instanceIndexBuffer.indices[gl_InstanceIndex];
+	mat4 model = pushConstant.modelBuffer.models[instanceIndex];
 
-	Vertex vertex = pushConstant.vertexBuffer.vertices[gl_VertexIndex];
+	vec3 position = loadPosition(gl_VertexIndex);
 	mat4 projView = pushConstant.projViewBuffer.matrices[pushConstant.projViewIndex];
 
-	gl_Position = projView * model * vec4(vertex.position, 1.0f);
+	gl_Position = projView * model * vec4(position, 1.0f);
 }
\ No newline at end of file
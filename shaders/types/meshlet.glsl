@@ -0,0 +1,18 @@
+struct Meshlet {
+	vec3 boundsCenter;
+	float boundsRadius;
+
+	vec3 coneAxis;
+	float coneCutoff;
+
+	uint firstIndex;
+	uint indexCount;
+	int vertexOffset;
+	uint padding0;
+};
+
+struct CullView {
+	mat4 projView;
+
+	vec4 position;
+};
@@ -4,4 +4,46 @@ struct Vertex {
 	vec3 normal;
 	float uv_y;
 	vec4 color;
-};
\ No newline at end of file
+};
+
+// Matches VertexFormat in enginetypes.hpp
+#define VERTEX_FORMAT_FULL 0
+#define VERTEX_FORMAT_PACKED 1
+
+// See PackedVertex in enginetypes.hpp for the layout
+struct PackedVertex {
+	uvec4 data;
+};
+
+vec3 decodeOctahedral(vec2 octahedral)
+{
+	vec3 normal = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+	if (normal.z < 0.0)
+	{
+		normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(normal);
+}
+
+// Decodes the first half of a PackedVertex, which is also what the position
+// only stream of a packed mesh holds
+vec3 unpackPosition(uvec2 packed, vec3 positionMin, vec3 positionExtent)
+{
+	vec2 positionXY = unpackUnorm2x16(packed.x);
+	float positionZ = unpackUnorm2x16(packed.y).x;
+	return positionMin + vec3(positionXY, positionZ) * positionExtent;
+}
+
+Vertex unpackVertex(PackedVertex packed, vec3 positionMin, vec3 positionExtent)
+{
+	vec2 octahedral = unpackSnorm4x8(packed.data.y).zw;
+	vec2 uv = unpackHalf2x16(packed.data.z);
+
+	Vertex vertex;
+	vertex.position = unpackPosition(packed.data.xy, positionMin, positionExtent);
+	vertex.normal = decodeOctahedral(octahedral);
+	vertex.uv_x = uv.x;
+	vertex.uv_y = uv.y;
+	vertex.color = unpackUnorm4x8(packed.data.w);
+	return vertex;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+// Reads the flags of a command line strictly, for each executable's main.
+// Unknown flags, missing values, and values that do not parse in full or do
+// not fit their destination are reported to stderr, and fail the parse.
+class Arguments
+{
+public:
+    Arguments(int const argc, char** const argv)
+        : m_argc(argc)
+        , m_argv(argv)
+    {
+    }
+
+    // Moves to the next flag. False once every argument was read, or after
+    // any error.
+    bool next()
+    {
+        if (m_failed)
+        {
+            return false;
+        }
+
+        m_index++;
+        return m_index < m_argc;
+    }
+
+    std::string_view flag() const { return m_argv[m_index]; }
+
+    bool failed() const { return m_failed; }
+
+    // Reports the current flag as unrecognized.
+    void rejectFlag()
+    {
+        std::fprintf(stderr, "Unknown argument %s.\n", m_argv[m_index]);
+        m_failed = true;
+    }
+
+    // Each overload consumes the current flag's value into the destination,
+    // which is left unchanged on failure.
+
+    bool value(std::string& destination)
+    {
+        char const* const text{ consumeValue() };
+        if (text == nullptr)
+        {
+            return false;
+        }
+
+        destination = text;
+        return true;
+    }
+
+    template <typename T>
+        requires std::is_integral_v<T>
+    bool value(T& destination)
+    {
+        char const* const text{ consumeValue() };
+        if (text == nullptr)
+        {
+            return false;
+        }
+
+        // from_chars rejects values that overflow the type, as well as signs
+        // for unsigned types
+        std::string_view const digits{ text };
+        T parsed{};
+        auto const [end, error]{ std::from_chars(
+            digits.data(), digits.data() + digits.size(), parsed, 10
+        ) };
+        if (digits.empty() || error != std::errc{}
+            || end != digits.data() + digits.size())
+        {
+            return rejectValue(text, "a whole number in range");
+        }
+
+        destination = parsed;
+        return true;
+    }
+
+    bool value(double& destination)
+    {
+        char const* const text{ consumeValue() };
+        if (text == nullptr)
+        {
+            return false;
+        }
+
+        // strtod skips leading whitespace, which is rejected like any other
+        // stray character
+        char* end{ nullptr };
+        double const parsed{ std::strtod(text, &end) };
+        if (*text == '\0' || std::isspace(static_cast<unsigned char>(*text))
+            || *end != '\0' || !std::isfinite(parsed))
+        {
+            return rejectValue(text, "a number");
+        }
+
+        destination = parsed;
+        return true;
+    }
+
+    template <typename T> bool value(std::optional<T>& destination)
+    {
+        T parsed{};
+        if (!value(parsed))
+        {
+            return false;
+        }
+
+        destination = std::move(parsed);
+        return true;
+    }
+
+private:
+    char const* consumeValue()
+    {
+        if (m_index + 1 >= m_argc)
+        {
+            std::fprintf(stderr, "%s expects a value.\n", m_argv[m_index]);
+            m_failed = true;
+            return nullptr;
+        }
+
+        m_index++;
+        return m_argv[m_index];
+    }
+
+    bool rejectValue(char const* const text, char const* const expected)
+    {
+        std::fprintf(
+            stderr,
+            "%s expects %s, not %s.\n",
+            m_argv[m_index - 1],
+            expected,
+            text
+        );
+        m_failed = true;
+        return false;
+    }
+
+    int m_argc;
+    char** m_argv;
+    int m_index{ 0 };
+    bool m_failed{ false };
+};
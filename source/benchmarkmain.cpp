@@ -0,0 +1,81 @@
+#include "arguments.hpp"
+#include "syzygy.hpp"
+
+#include <cstdlib>
+#include <string_view>
+
+// Usage: SyzygyBenchmark [--scene <name>] [--seed <seed>]
+//     [--instances <count>] [--lights <count>] [--warmup <frames>]
+//     [--frames <frames>] [--width <pixels>] [--height <pixels>]
+//     [--output <path>] [--baseline <path>] [--threshold <fraction>]
+auto main(int argc, char** argv) -> int
+{
+    BenchmarkParameters parameters{};
+
+    Arguments arguments{ argc, argv };
+    while (arguments.next())
+    {
+        std::string_view const argument{ arguments.flag() };
+        if (argument == "--scene")
+        {
+            arguments.value(parameters.scene);
+        }
+        else if (argument == "--seed")
+        {
+            arguments.value(parameters.seed);
+        }
+        else if (argument == "--instances")
+        {
+            arguments.value(parameters.instanceCount);
+        }
+        else if (argument == "--lights")
+        {
+            arguments.value(parameters.spotLightCount);
+        }
+        else if (argument == "--warmup")
+        {
+            arguments.value(parameters.warmupFrames);
+        }
+        else if (argument == "--frames")
+        {
+            arguments.value(parameters.measuredFrames);
+        }
+        else if (argument == "--width")
+        {
+            arguments.value(parameters.width);
+        }
+        else if (argument == "--height")
+        {
+            arguments.value(parameters.height);
+        }
+        else if (argument == "--output")
+        {
+            arguments.value(parameters.outputPath);
+        }
+        else if (argument == "--baseline")
+        {
+            arguments.value(parameters.baselinePath);
+        }
+        else if (argument == "--threshold")
+        {
+            arguments.value(parameters.regressionThreshold);
+        }
+        else
+        {
+            arguments.rejectFlag();
+        }
+    }
+    if (arguments.failed())
+    {
+        return EXIT_FAILURE;
+    }
+
+    ApplicationResult const runResult{ Application::runBenchmark(parameters) };
+
+    if (runResult != ApplicationResult::SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
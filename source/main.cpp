@@ -1,10 +1,72 @@
+#include "arguments.hpp"
 #include "syzygy.hpp"
 
 #include <cstdlib>
+#include <string_view>
 
-auto main() -> int
+auto main(int argc, char** argv) -> int
 {
-    ApplicationResult const runResult{ Application::run() };
+    ApplicationParameters parameters{};
+
+    // Usage: Syzygy [--headless] [--frames <count>] [--record <path>]
+    //     [--replay <path>] [--unpaced] [--kernel <shader>]
+    //     [--dispatches <count>] [--save-reference] [--metrics-port <port>]
+    //     [--metrics-address <address>]
+    Arguments arguments{ argc, argv };
+    while (arguments.next())
+    {
+        std::string_view const argument{ arguments.flag() };
+        if (argument == "--headless")
+        {
+            parameters.headless = true;
+        }
+        else if (argument == "--frames")
+        {
+            arguments.value(parameters.headlessFrames);
+        }
+        else if (argument == "--record")
+        {
+            arguments.value(parameters.recordPath);
+        }
+        else if (argument == "--replay")
+        {
+            arguments.value(parameters.replayPath);
+        }
+        else if (argument == "--unpaced")
+        {
+            parameters.replayPacing = ReplayPacing::UNLIMITED;
+        }
+        else if (argument == "--kernel")
+        {
+            arguments.value(parameters.kernelBenchmarkShader);
+        }
+        else if (argument == "--dispatches")
+        {
+            arguments.value(parameters.kernelBenchmarkDispatches);
+        }
+        else if (argument == "--save-reference")
+        {
+            parameters.kernelSaveReference = true;
+        }
+        else if (argument == "--metrics-port")
+        {
+            arguments.value(parameters.metricsPort);
+        }
+        else if (argument == "--metrics-address")
+        {
+            arguments.value(parameters.metricsAddress);
+        }
+        else
+        {
+            arguments.rejectFlag();
+        }
+    }
+    if (arguments.failed())
+    {
+        return EXIT_FAILURE;
+    }
+
+    ApplicationResult const runResult{ Application::run(parameters) };
 
     if (runResult != ApplicationResult::SUCCESS)
     {
@@ -12,4 +74,4 @@ auto main() -> int
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
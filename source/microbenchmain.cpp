@@ -0,0 +1,53 @@
+#include "arguments.hpp"
+#include "syzygy.hpp"
+
+#include <cstdlib>
+#include <string_view>
+
+// Usage: SyzygyMicrobench [--filter <substring>] [--seconds <minimum>]
+//     [--mesh <path>] [--shader <path>]
+auto main(int argc, char** argv) -> int
+{
+    MicrobenchmarkParameters parameters{};
+
+    Arguments arguments{ argc, argv };
+    while (arguments.next())
+    {
+        std::string_view const argument{ arguments.flag() };
+        if (argument == "--filter")
+        {
+            arguments.value(parameters.filter);
+        }
+        else if (argument == "--seconds")
+        {
+            arguments.value(parameters.minimumSeconds);
+        }
+        else if (argument == "--mesh")
+        {
+            arguments.value(parameters.meshPath);
+        }
+        else if (argument == "--shader")
+        {
+            arguments.value(parameters.shaderPath);
+        }
+        else
+        {
+            arguments.rejectFlag();
+        }
+    }
+    if (arguments.failed())
+    {
+        return EXIT_FAILURE;
+    }
+
+    ApplicationResult const runResult{
+        Application::runMicrobenchmarks(parameters)
+    };
+
+    if (runResult != ApplicationResult::SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
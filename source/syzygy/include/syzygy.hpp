@@ -1,13 +1,108 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
 enum class ApplicationResult
 {
     SUCCESS,
     FAILURE,
 };
 
+enum class ReplayPacing
+{
+    // Each frame takes at least as long as it did when recorded
+    RECORDED,
+    // Frames render as fast as possible, such as for profiling
+    UNLIMITED,
+};
+
+struct ApplicationParameters
+{
+    // Renders offscreen without creating a window, surface or swapchain,
+    // then exits after headlessFrames.
+    bool headless{false};
+    uint32_t headlessFrames{1000};
+    uint16_t headlessWidth{1920};
+    uint16_t headlessHeight{1080};
+
+    // Writes the inputs of every frame to this file.
+    std::optional<std::string> recordPath{};
+
+    // Renders headless the frames recorded in this file, then exits. The
+    // scene viewport's recorded extent replaces the headless extent.
+    std::optional<std::string> replayPath{};
+    ReplayPacing replayPacing{ReplayPacing::RECORDED};
+
+    // Times the compute collection shader whose name contains this headless,
+    // at several resolutions, then exits. Outputs are compared against the
+    // references saved by an earlier run with kernelSaveReference.
+    std::optional<std::string> kernelBenchmarkShader{};
+    uint32_t kernelBenchmarkDispatches{100};
+    bool kernelSaveReference{false};
+
+    // Serves live metrics in the Prometheus text format at /metrics on this
+    // port. The default address only accepts scrapes from this machine.
+    std::optional<uint16_t> metricsPort{};
+    std::string metricsAddress{"127.0.0.1"};
+};
+
+struct BenchmarkParameters
+{
+    // Runs only the scene of this name, or every scene when empty.
+    std::string scene{};
+
+    // Overrides of every scene's layout, which is otherwise fixed
+    uint32_t seed{0};
+    std::optional<size_t> instanceCount{};
+    std::optional<size_t> spotLightCount{};
+
+    // Warm-up frames fill caches and streaming before any are measured.
+    uint32_t warmupFrames{120};
+    uint32_t measuredFrames{600};
+
+    uint16_t width{1920};
+    uint16_t height{1080};
+
+    std::string outputPath{"benchmark.json"};
+
+    // When set, any metric slower than the baseline's by more than the
+    // threshold, as a fraction of the baseline, fails the benchmark.
+    std::optional<std::string> baselinePath{};
+    double regressionThreshold{0.10};
+};
+
+struct MicrobenchmarkParameters
+{
+    // Runs only the benchmarks whose names contain this, or every one when
+    // empty.
+    std::string filter{};
+
+    // Each benchmark repeats until a batch of runs takes at least this long.
+    double minimumSeconds{0.5};
+
+    // Relative to the project's root
+    std::string meshPath{"assets/vkguide/basicmesh.glb"};
+
+    // Relative to the build tree's root, where shaders are compiled to
+    std::string shaderPath{"shaders/deferred/offscreen.frag.spv"};
+};
+
 class Application
 {
 public:
-    static auto run() -> ApplicationResult;
-};
\ No newline at end of file
+    static auto run(ApplicationParameters const& parameters)
+        -> ApplicationResult;
+
+    // Renders scripted scenes headless and writes their timings and memory
+    // as JSON.
+    static auto runBenchmark(BenchmarkParameters const& parameters)
+        -> ApplicationResult;
+
+    // Times CPU-only hot paths of the engine without creating a device, and
+    // logs nanoseconds per operation and throughput.
+    static auto runMicrobenchmarks(MicrobenchmarkParameters const& parameters)
+        -> ApplicationResult;
+};
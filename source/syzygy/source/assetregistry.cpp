@@ -0,0 +1,365 @@
+#include "assetregistry.hpp"
+
+#include "helpers.hpp"
+#include "meshloader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace
+{
+// Importing a file again produces the same meshes when every option matches,
+// since streaming for instance skips materials.
+auto sameSourceFile(MeshSource const& lhs, MeshSource const& rhs) -> bool
+{
+    return lhs.localPath == rhs.localPath && lhs.options == rhs.options;
+}
+
+auto sameSource(MeshSource const& lhs, MeshSource const& rhs) -> bool
+{
+    return sameSourceFile(lhs, rhs) && lhs.meshIndex == rhs.meshIndex;
+}
+} // namespace
+
+AssetRegistry::AssetRegistry(size_t const framesInFlight)
+{
+    m_framesInFlight = framesInFlight;
+}
+
+auto AssetRegistry::addMesh(std::shared_ptr<MeshAsset> mesh) -> MeshHandle
+{
+    uint32_t index{0};
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_slots.size());
+        m_slots.push_back(MeshSlot{});
+    }
+
+    MeshSlot& slot{m_slots[index]};
+    slot.mesh = std::move(mesh);
+    slot.lastUsedFrame = 0;
+    slot.reloadRequested = false;
+
+    return MeshHandle{
+        .index = index,
+        .generation = slot.generation,
+    };
+}
+
+void AssetRegistry::removeMesh(
+    MeshHandle const handle, uint64_t const currentFrame
+)
+{
+    MeshAsset* const mesh{getMutable(handle)};
+    if (mesh == nullptr)
+    {
+        return;
+    }
+
+    MeshSlot& slot{m_slots[handle.index]};
+
+    // The mesh may have been drawn by a frame that is recorded but not yet
+    // submitted, so treat it as used this frame.
+    releaseBuffers(*mesh, currentFrame);
+
+    slot.mesh.reset();
+    slot.generation += 1;
+    m_freeSlots.push_back(handle.index);
+}
+
+auto AssetRegistry::get(MeshHandle const handle) const -> MeshAsset const*
+{
+    if (handle.index >= m_slots.size())
+    {
+        return nullptr;
+    }
+
+    MeshSlot const& slot{m_slots[handle.index]};
+    if (slot.generation != handle.generation)
+    {
+        return nullptr;
+    }
+
+    return slot.mesh.get();
+}
+
+auto AssetRegistry::getMutable(MeshHandle const handle) -> MeshAsset*
+{
+    return const_cast<MeshAsset*>(std::as_const(*this).get(handle));
+}
+
+auto AssetRegistry::meshHandles() const -> std::vector<MeshHandle>
+{
+    std::vector<MeshHandle> handles{};
+    for (size_t index{0}; index < m_slots.size(); index++)
+    {
+        MeshSlot const& slot{m_slots[index]};
+        if (slot.mesh == nullptr)
+        {
+            continue;
+        }
+
+        handles.push_back(MeshHandle{
+            .index = static_cast<uint32_t>(index),
+            .generation = slot.generation,
+        });
+    }
+    return handles;
+}
+
+auto AssetRegistry::markUsed(
+    MeshHandle const handle, uint64_t const currentFrame, MeshLoader& loader
+) -> bool
+{
+    MeshAsset const* const mesh{get(handle)};
+    if (mesh == nullptr)
+    {
+        return false;
+    }
+
+    MeshSlot& slot{m_slots[handle.index]};
+    slot.lastUsedFrame = currentFrame;
+
+    if (mesh->meshBuffers != nullptr)
+    {
+        return true;
+    }
+
+    if (slot.reloadRequested)
+    {
+        return false;
+    }
+
+    // The whole file is imported again, which covers every mesh from it.
+    for (MeshSlot& otherSlot : m_slots)
+    {
+        if (otherSlot.mesh != nullptr
+            && sameSourceFile(otherSlot.mesh->source, mesh->source))
+        {
+            otherSlot.reloadRequested = true;
+        }
+    }
+
+    Log(fmt::format(
+        "Mesh \"{}\" is not resident, importing \"{}\" again.",
+        mesh->name,
+        mesh->source.localPath
+    ));
+    loader.loadAsync(mesh->source.localPath, mesh->source.options);
+
+    return false;
+}
+
+void AssetRegistry::addLoadedMeshes(
+    std::vector<std::shared_ptr<MeshAsset>> const& loadedMeshes
+)
+{
+    for (std::shared_ptr<MeshAsset> const& loadedMesh : loadedMeshes)
+    {
+        auto const reloadedSlot{std::find_if(
+            m_slots.begin(),
+            m_slots.end(),
+            [&](MeshSlot const& slot)
+            {
+                return slot.mesh != nullptr && slot.reloadRequested
+                    && sameSource(slot.mesh->source, loadedMesh->source);
+            }
+        )};
+        if (reloadedSlot == m_slots.end())
+        {
+            addMesh(loadedMesh);
+            continue;
+        }
+
+        reloadedSlot->reloadRequested = false;
+
+        // Meshes from the same file that were still resident are already up
+        // to date, so their duplicate buffers are dropped.
+        if (reloadedSlot->mesh->meshBuffers == nullptr)
+        {
+            reloadedSlot->mesh->meshBuffers =
+                std::move(loadedMesh->meshBuffers);
+        }
+    }
+}
+
+void AssetRegistry::releaseBuffers(
+    MeshAsset& mesh, uint64_t const lastUsedFrame
+)
+{
+    if (mesh.meshBuffers == nullptr)
+    {
+        return;
+    }
+
+    m_pendingDestruction.push_back(PendingDestruction{
+        .lastUsedFrame = lastUsedFrame,
+        .buffers = std::move(mesh.meshBuffers),
+    });
+}
+
+void AssetRegistry::update(
+    MeshResidencyParameters const& parameters,
+    uint64_t const currentFrame,
+    VmaAllocator const allocator
+)
+{
+    // The fence for a frame is waited on before the frame that reuses its
+    // resources, so buffers last used that many frames ago are idle.
+    std::erase_if(
+        m_pendingDestruction,
+        [&](PendingDestruction const& pending)
+        { return currentFrame >= pending.lastUsedFrame + m_framesInFlight; }
+    );
+
+    VkDeviceSize residentBytes{0};
+    for (MeshSlot const& slot : m_slots)
+    {
+        if (slot.mesh != nullptr && slot.mesh->meshBuffers != nullptr)
+        {
+            residentBytes += slot.mesh->meshBuffers->allocatedBytes();
+        }
+    }
+
+    VkDeviceSize pendingDestructionBytes{0};
+    for (PendingDestruction const& pending : m_pendingDestruction)
+    {
+        pendingDestructionBytes += pending.buffers->allocatedBytes();
+    }
+
+    VkPhysicalDeviceMemoryProperties const* memoryProperties{nullptr};
+    vmaGetMemoryProperties(allocator, &memoryProperties);
+
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heapBudgets{};
+    vmaGetHeapBudgets(allocator, heapBudgets.data());
+
+    VkDeviceSize deviceUsageBytes{0};
+    VkDeviceSize deviceBudgetBytes{0};
+    for (uint32_t heap{0}; heap < memoryProperties->memoryHeapCount; heap++)
+    {
+        if ((memoryProperties->memoryHeaps[heap].flags
+             & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            == 0)
+        {
+            continue;
+        }
+
+        deviceUsageBytes += heapBudgets[heap].usage;
+        deviceBudgetBytes += heapBudgets[heap].budget;
+    }
+
+    VkDeviceSize residentLimitBytes{static_cast<VkDeviceSize>(
+        static_cast<double>(parameters.budgetMegabytes) * 1024.0 * 1024.0
+    )};
+
+    // Pending buffers are already on their way out, so they do not count
+    // towards the device's excess.
+    auto const deviceLimitBytes{static_cast<VkDeviceSize>(
+        static_cast<double>(deviceBudgetBytes)
+        * static_cast<double>(parameters.deviceBudgetFraction)
+    )};
+    VkDeviceSize const deviceRetainedBytes{
+        deviceUsageBytes - std::min(deviceUsageBytes, pendingDestructionBytes)
+    };
+    if (deviceRetainedBytes > deviceLimitBytes)
+    {
+        VkDeviceSize const excessBytes{deviceRetainedBytes - deviceLimitBytes};
+        residentLimitBytes = std::min(
+            residentLimitBytes,
+            residentBytes - std::min(residentBytes, excessBytes)
+        );
+    }
+
+    if (residentBytes > residentLimitBytes)
+    {
+        // Meshes drawn this frame are never evicted, nor are meshes that
+        // cannot be imported again.
+        std::vector<MeshSlot*> candidates{};
+        for (MeshSlot& slot : m_slots)
+        {
+            if (slot.mesh != nullptr && slot.mesh->meshBuffers != nullptr
+                && slot.lastUsedFrame < currentFrame
+                && !slot.mesh->source.localPath.empty())
+            {
+                candidates.push_back(&slot);
+            }
+        }
+
+        std::sort(
+            candidates.begin(),
+            candidates.end(),
+            [](MeshSlot const* lhs, MeshSlot const* rhs)
+            { return lhs->lastUsedFrame < rhs->lastUsedFrame; }
+        );
+
+        for (MeshSlot* const slot : candidates)
+        {
+            if (residentBytes <= residentLimitBytes)
+            {
+                break;
+            }
+
+            VkDeviceSize const meshBytes{
+                slot->mesh->meshBuffers->allocatedBytes()
+            };
+            Log(fmt::format(
+                "Evicting mesh \"{}\", freeing {} bytes.",
+                slot->mesh->name,
+                meshBytes
+            ));
+
+            releaseBuffers(*slot->mesh, slot->lastUsedFrame);
+            residentBytes -= meshBytes;
+            pendingDestructionBytes += meshBytes;
+        }
+    }
+
+    m_statistics = Statistics{
+        .residentBytes = residentBytes,
+        .pendingDestructionBytes = pendingDestructionBytes,
+        .deviceUsageBytes = deviceUsageBytes,
+        .deviceBudgetBytes = deviceBudgetBytes,
+    };
+    for (MeshSlot const& slot : m_slots)
+    {
+        if (slot.mesh == nullptr)
+        {
+            continue;
+        }
+
+        if (slot.mesh->meshBuffers != nullptr)
+        {
+            m_statistics.residentMeshes += 1;
+        }
+        else
+        {
+            m_statistics.evictedMeshes += 1;
+        }
+    }
+}
+
+void AssetRegistry::cleanup()
+{
+    m_pendingDestruction.clear();
+
+    // Other owners of a mesh may outlive the allocator, so only its buffers
+    // are released here.
+    for (MeshSlot& slot : m_slots)
+    {
+        if (slot.mesh != nullptr)
+        {
+            slot.mesh->meshBuffers.reset();
+        }
+    }
+
+    m_slots.clear();
+    m_freeSlots.clear();
+
+    m_statistics = {};
+}
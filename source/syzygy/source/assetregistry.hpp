@@ -0,0 +1,128 @@
+#pragma once
+
+#include "assets.hpp"
+#include "buffers.hpp"
+#include "enginetypes.hpp"
+
+#include <limits>
+
+class MeshLoader;
+
+// Refers to a mesh in an AssetRegistry. Slots are reused once their mesh is
+// removed, so stale handles are detected by their generation instead of
+// referring to whichever mesh took the slot.
+struct MeshHandle
+{
+    uint32_t index{std::numeric_limits<uint32_t>::max()};
+    uint32_t generation{0};
+
+    bool operator==(MeshHandle const& other) const = default;
+};
+
+struct MeshResidencyParameters
+{
+    // The most device memory that mesh buffers can use in total.
+    float budgetMegabytes{1024.0F};
+
+    // Meshes are also evicted when the device as a whole uses more than this
+    // fraction of its memory budget.
+    float deviceBudgetFraction{0.9F};
+
+    bool operator==(MeshResidencyParameters const& other) const = default;
+};
+
+// Owns every loaded mesh, tracking the last frame each was drawn in. When
+// over budget, the device buffers of the least recently drawn meshes are
+// evicted. Evicted meshes keep their host side data, and are imported again
+// from their source file once they are drawn.
+class AssetRegistry
+{
+public:
+    struct Statistics
+    {
+        size_t residentMeshes{0};
+        size_t evictedMeshes{0};
+
+        VkDeviceSize residentBytes{0};
+
+        // Released buffers that frames in flight may still be reading.
+        VkDeviceSize pendingDestructionBytes{0};
+
+        // Summed across device local heaps. These come from
+        // VK_EXT_memory_budget when enabled, otherwise they are estimates.
+        VkDeviceSize deviceUsageBytes{0};
+        VkDeviceSize deviceBudgetBytes{0};
+    };
+
+    explicit AssetRegistry(size_t framesInFlight);
+
+    AssetRegistry(AssetRegistry const& other) = delete;
+    AssetRegistry& operator=(AssetRegistry const& other) = delete;
+
+    MeshHandle addMesh(std::shared_ptr<MeshAsset> mesh);
+
+    // The mesh's buffers are destroyed once no frame in flight can use them.
+    void removeMesh(MeshHandle handle, uint64_t currentFrame);
+
+    // Returns null for stale handles.
+    MeshAsset const* get(MeshHandle handle) const;
+
+    // Every live mesh, in the order they were added.
+    std::vector<MeshHandle> meshHandles() const;
+
+    // Records that the mesh is drawn this frame. If its buffers were evicted,
+    // they are requested from the loader and false is returned, in which case
+    // the mesh should not be drawn.
+    bool markUsed(MeshHandle handle, uint64_t currentFrame, MeshLoader& loader);
+
+    // Meshes that were imported again to replace evicted buffers are restored
+    // into their existing handles, everything else is added.
+    void addLoadedMeshes(
+        std::vector<std::shared_ptr<MeshAsset>> const& loadedMeshes
+    );
+
+    // Must be called after waiting on the current frame's fence. Destroys
+    // buffers that are no longer in flight, then evicts meshes that were not
+    // drawn this frame until under budget.
+    void update(
+        MeshResidencyParameters const& parameters,
+        uint64_t currentFrame,
+        VmaAllocator allocator
+    );
+
+    Statistics statistics() const { return m_statistics; }
+
+    // Destroys everything immediately, so the device must be idle.
+    void cleanup();
+
+private:
+    MeshAsset* getMutable(MeshHandle handle);
+
+    void releaseBuffers(MeshAsset& mesh, uint64_t lastUsedFrame);
+
+    struct MeshSlot
+    {
+        uint32_t generation{0};
+
+        // Null when the slot is free.
+        std::shared_ptr<MeshAsset> mesh{};
+
+        uint64_t lastUsedFrame{0};
+        bool reloadRequested{false};
+    };
+
+    struct PendingDestruction
+    {
+        uint64_t lastUsedFrame{0};
+        std::unique_ptr<GPUMeshBuffers> buffers{};
+    };
+
+    size_t m_framesInFlight{0};
+
+    std::vector<MeshSlot> m_slots{};
+    std::vector<uint32_t> m_freeSlots{};
+
+    std::vector<PendingDestruction> m_pendingDestruction{};
+
+    Statistics m_statistics{};
+};
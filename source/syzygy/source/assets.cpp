@@ -2,19 +2,914 @@
 
 #include "engine.hpp"
 #include "initializers.hpp"
+#include "meshlets.hpp"
+#include "meshlod.hpp"
+#include "vertexpacking.hpp"
 
+#include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <glm/gtx/transform.hpp>
 
 #include <fastgltf/core.hpp>
 #include <fastgltf/glm_element_traits.hpp>
 #include <fastgltf/tools.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
 
 #include "helpers.hpp"
 
-auto loadGltfMeshes(Engine* const engine, std::string const& localPath)
-    -> std::optional<std::vector<std::shared_ptr<MeshAsset>>>
+namespace
+{
+// Files that require these can still be loaded, even if only some of the
+// extension's data is used.
+auto constexpr GLTF_EXTENSIONS{fastgltf::Extensions::EXT_mesh_gpu_instancing};
+
+// Returns the accessor to iterate in place of the one at the given index,
+// after making its data available. Returns nothing on failure.
+using AccessorLoader =
+    std::function<std::optional<fastgltf::Accessor>(size_t accessorIndex)>;
+
+// Appends the primitive's geometry as a new surface. Returns false if the
+// primitive is malformed or its data could not be loaded, in which case the
+// mesh should be discarded.
+auto appendPrimitive(
+    fastgltf::Asset const& gltf,
+    fastgltf::Primitive const& primitive,
+    AccessorLoader const& loadAccessor,
+    std::vector<uint32_t>& indices,
+    std::vector<Vertex>& vertices,
+    std::vector<GeometrySurface>& surfaces
+) -> bool
+{
+    size_t const initialVertexIndex{vertices.size()};
+    size_t const initialIndexIndex{indices.size()};
+
+    auto const* const positions{primitive.findAttribute("POSITION")};
+    if (!primitive.indicesAccessor.has_value()
+        || positions == primitive.attributes.end())
+    {
+        Error("Primitive is missing its indices or positions.");
+        return false;
+    }
+
+    { // Indices, not optional
+        std::optional<fastgltf::Accessor> const indexAccessor{
+            loadAccessor(primitive.indicesAccessor.value())
+        };
+        if (!indexAccessor.has_value())
+        {
+            return false;
+        }
+
+        indices.reserve(indices.size() + indexAccessor->count);
+
+        fastgltf::iterateAccessor<std::uint32_t>(
+            gltf,
+            indexAccessor.value(),
+            [&](std::uint32_t index) { indices.push_back(index); }
+        );
+    }
+
+    { // Positions, not optional
+        std::optional<fastgltf::Accessor> const positionAccessor{
+            loadAccessor(positions->second)
+        };
+        if (!positionAccessor.has_value())
+        {
+            return false;
+        }
+
+        vertices.reserve(vertices.size() + positionAccessor->count);
+
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(
+            gltf,
+            positionAccessor.value(),
+            [&](glm::vec3 position, size_t /*index*/)
+            {
+                vertices.push_back(Vertex{
+                    .position = position,
+                    .uv_x = 0.0F,
+                    .normal = glm::vec3{1, 0, 0},
+                    .uv_y = 0.0F,
+                    .color = glm::vec4{1.0F},
+                });
+            }
+        );
+    }
+
+    size_t const vertexCount{vertices.size() - initialVertexIndex};
+
+    // Indices come from the file, and are checked once here so that meshlet
+    // and level of detail generation can index the vertices with them.
+    if (std::any_of(
+            indices.begin() + static_cast<std::ptrdiff_t>(initialIndexIndex),
+            indices.end(),
+            [&](uint32_t const index) { return index >= vertexCount; }
+        ))
+    {
+        Error(fmt::format(
+            "Primitive indexes past its {} vertices.", vertexCount
+        ));
+        return false;
+    }
+
+    // Attributes are written by index into the positions' vertices, so they
+    // must not have more elements.
+    auto const loadAttribute{
+        [&](size_t const accessorIndex) -> std::optional<fastgltf::Accessor>
+    {
+        if (gltf.accessors[accessorIndex].count > vertexCount)
+        {
+            Error(fmt::format(
+                "Accessor {} has more elements than the {} vertices.",
+                accessorIndex,
+                vertexCount
+            ));
+            return std::nullopt;
+        }
+        return loadAccessor(accessorIndex);
+    }};
+
+    // The rest of these parameters are optional.
+
+    { // Normals
+        auto const* const normals{primitive.findAttribute("NORMAL")};
+        if (normals != primitive.attributes.end())
+        {
+            std::optional<fastgltf::Accessor> const normalAccessor{
+                loadAttribute((*normals).second)
+            };
+            if (!normalAccessor.has_value())
+            {
+                return false;
+            }
+
+            fastgltf::iterateAccessorWithIndex<glm::vec3>(
+                gltf,
+                normalAccessor.value(),
+                [&](glm::vec3 normal, size_t index)
+                { vertices[initialVertexIndex + index].normal = normal; }
+            );
+        }
+    }
+
+    { // UVs
+        auto const* const uvs{primitive.findAttribute("TEXCOORD_0")};
+        if (uvs != primitive.attributes.end())
+        {
+            std::optional<fastgltf::Accessor> const uvAccessor{
+                loadAttribute((*uvs).second)
+            };
+            if (!uvAccessor.has_value())
+            {
+                return false;
+            }
+
+            fastgltf::iterateAccessorWithIndex<glm::vec2>(
+                gltf,
+                uvAccessor.value(),
+                [&](glm::vec2 texcoord, size_t index)
+                {
+                    vertices[initialVertexIndex + index].uv_x = texcoord.x;
+                    vertices[initialVertexIndex + index].uv_y = texcoord.y;
+                }
+            );
+        }
+    }
+
+    { // Colors
+        auto const* const colors{primitive.findAttribute("COLOR_0")};
+        if (colors != primitive.attributes.end())
+        {
+            std::optional<fastgltf::Accessor> const colorAccessor{
+                loadAttribute((*colors).second)
+            };
+            if (!colorAccessor.has_value())
+            {
+                return false;
+            }
+
+            fastgltf::iterateAccessorWithIndex<glm::vec4>(
+                gltf,
+                colorAccessor.value(),
+                [&](glm::vec4 color, size_t index)
+                { vertices[initialVertexIndex + index].color = color; }
+            );
+        }
+    }
+
+    surfaces.push_back(GeometrySurface{
+        .firstIndex = static_cast<uint32_t>(initialIndexIndex),
+        .indexCount = static_cast<uint32_t>(indices.size() - initialIndexIndex),
+        .vertexOffset = static_cast<int32_t>(initialVertexIndex),
+        .vertexCount = static_cast<uint32_t>(vertexCount),
+    });
+
+    return true;
+}
+
+// Meshes without indices are skipped, since Vulkan does not allow the empty
+// buffers they would be uploaded to. Indices are validated against the
+// vertices, so a mesh with indices always has vertices too.
+void warnEmptyMesh(fastgltf::Mesh const& mesh)
+{
+    Warning(fmt::format(
+        "Skipping mesh \"{}\", which has no indices.", std::string{mesh.name}
+    ));
+}
+
+// Returns the encoded bytes of an image, such as a PNG, that were loaded
+// alongside the file. Returns an empty span if they are unavailable.
+auto imageBytes(fastgltf::Asset const& gltf, fastgltf::Image const& image)
+    -> std::span<uint8_t const>
+{
+    auto const loadedBytes{
+        [](fastgltf::DataSource const& source) -> std::span<uint8_t const>
+    {
+        if (auto const* const vector{
+                std::get_if<fastgltf::sources::Vector>(&source)
+            })
+        {
+            return vector->bytes;
+        }
+        if (auto const* const view{
+                std::get_if<fastgltf::sources::ByteView>(&source)
+            })
+        {
+            return std::span<uint8_t const>{
+                reinterpret_cast<uint8_t const*>(view->bytes.data()),
+                view->bytes.size()
+            };
+        }
+        return {};
+    }};
+
+    auto const* const bufferViewSource{
+        std::get_if<fastgltf::sources::BufferView>(&image.data)
+    };
+    if (bufferViewSource == nullptr)
+    {
+        return loadedBytes(image.data);
+    }
+
+    fastgltf::BufferView const& bufferView{
+        gltf.bufferViews[bufferViewSource->bufferViewIndex]
+    };
+    std::span<uint8_t const> const buffer{
+        loadedBytes(gltf.buffers[bufferView.bufferIndex].data)
+    };
+    if (bufferView.byteOffset + bufferView.byteLength > buffer.size())
+    {
+        return {};
+    }
+
+    return buffer.subspan(bufferView.byteOffset, bufferView.byteLength);
+}
+
+// Compressed textures by image index, so that each image in a file is only
+// compressed once.
+using TextureImportCache = std::map<
+    size_t,
+    std::shared_ptr<textures::CompressedTexture const>>;
+
+auto loadMaterial(
+    fastgltf::Asset const& gltf,
+    fastgltf::Primitive const& primitive,
+    TextureImportCache& textureCache
+) -> MeshMaterial
+{
+    if (!primitive.materialIndex.has_value())
+    {
+        return MeshMaterial{};
+    }
+
+    fastgltf::Material const& gltfMaterial{
+        gltf.materials[primitive.materialIndex.value()]
+    };
+    auto const& factor{gltfMaterial.pbrData.baseColorFactor};
+
+    MeshMaterial material{
+        .baseColorFactor =
+            glm::vec4{factor[0], factor[1], factor[2], factor[3]},
+    };
+
+    if (!gltfMaterial.pbrData.baseColorTexture.has_value())
+    {
+        return material;
+    }
+
+    fastgltf::Texture const& texture{
+        gltf.textures[gltfMaterial.pbrData.baseColorTexture->textureIndex]
+    };
+    if (!texture.imageIndex.has_value())
+    {
+        return material;
+    }
+
+    size_t const imageIndex{texture.imageIndex.value()};
+    if (auto const cached{textureCache.find(imageIndex)};
+        cached != textureCache.end())
+    {
+        material.baseColorTexture = cached->second;
+        return material;
+    }
+
+    std::span<uint8_t const> const encodedImage{
+        imageBytes(gltf, gltf.images[imageIndex])
+    };
+    std::optional<textures::CompressedTexture> compressed{};
+    if (!encodedImage.empty())
+    {
+        compressed = textures::loadCompressedTexture(encodedImage);
+    }
+    if (!compressed.has_value())
+    {
+        Warning(fmt::format(
+            "Unable to load image {}, the material will be untextured.",
+            imageIndex
+        ));
+    }
+    else
+    {
+        material.baseColorTexture =
+            std::make_shared<textures::CompressedTexture const>(
+                std::move(compressed).value()
+            );
+    }
+
+    // Failures are cached too, so they are only reported once
+    textureCache[imageIndex] = material.baseColorTexture;
+
+    return material;
+}
+
+// Generates the derived data of a mesh. The passed geometry is consumed, so it
+// can be released as early as possible.
+auto finishDecoding(
+    std::string name,
+    std::vector<uint32_t> indices,
+    std::vector<Vertex> vertices,
+    std::vector<GeometrySurface> surfaces,
+    MeshMaterial material,
+    MeshSource source
+) -> DecodedMesh
+{
+    bool constexpr DEBUG_OVERRIDE_COLORS{false};
+    if (DEBUG_OVERRIDE_COLORS)
+    {
+        for (Vertex& vertex : vertices)
+        {
+            vertex.color = glm::vec4(vertex.normal, 1.0F);
+        }
+    }
+
+    bool constexpr FLIP_Y{true};
+    if (FLIP_Y)
+    {
+        for (Vertex& vertex : vertices)
+        {
+            vertex.normal.y *= -1;
+            vertex.position.y *= -1;
+        }
+    }
+
+    glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+    glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+    for (Vertex const& vertex : vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+
+    glm::vec3 const boundsCenter{
+        vertices.empty() ? glm::vec3{0.0F} : (boundsMin + boundsMax) / 2.0F
+    };
+    float boundsRadius{0.0F};
+    for (Vertex const& vertex : vertices)
+    {
+        boundsRadius = glm::max(
+            boundsRadius, glm::distance(boundsCenter, vertex.position)
+        );
+    }
+
+    for (GeometrySurface& surface : surfaces)
+    {
+        std::span<Vertex const> const surfaceVertices{
+            std::span<Vertex const>{vertices}.subspan(
+                static_cast<size_t>(surface.vertexOffset), surface.vertexCount
+            )
+        };
+        lod::generateSurfaceLODs(surfaceVertices, indices, surface);
+    }
+
+    // Meshlets are built after levels of detail since those append to the
+    // index list, which would invalidate any spans into it.
+    std::vector<Meshlet> meshlets{};
+    for (GeometrySurface& surface : surfaces)
+    {
+        std::span<Vertex const> const surfaceVertices{
+            std::span<Vertex const>{vertices}.subspan(
+                static_cast<size_t>(surface.vertexOffset), surface.vertexCount
+            )
+        };
+        std::span<uint32_t const> const surfaceIndices{
+            std::span<uint32_t const>{indices}.subspan(
+                surface.firstIndex, surface.indexCount
+            )
+        };
+
+        std::vector<Meshlet> const surfaceMeshlets{meshlets::buildMeshlets(
+            surfaceVertices, surfaceIndices, surface.firstIndex
+        )};
+
+        surface.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+        surface.meshletCount = static_cast<uint32_t>(surfaceMeshlets.size());
+        meshlets.insert(
+            meshlets.end(), surfaceMeshlets.begin(), surfaceMeshlets.end()
+        );
+    }
+    std::vector<gputypes::Meshlet> deviceMeshlets{
+        meshlets::toDeviceMeshlets(surfaces, meshlets)
+    };
+
+    DecodedMesh decoded{
+        .name = std::move(name),
+        .surfaces = std::move(surfaces),
+        .boundsCenter = boundsCenter,
+        .boundsRadius = boundsRadius,
+        .meshlets = std::move(meshlets),
+        .indices = std::move(indices),
+        .deviceMeshlets = std::move(deviceMeshlets),
+        .material = std::move(material),
+        .source = std::move(source),
+    };
+
+    if (decoded.source.options.packVertices)
+    {
+        decoded.encoding = vertexpacking::computePackedEncoding(vertices);
+        decoded.vertices =
+            vertexpacking::packVertices(vertices, decoded.encoding);
+    }
+    else
+    {
+        decoded.encoding = VertexEncoding{.format = VertexFormat::FULL};
+        decoded.vertices = std::move(vertices);
+    }
+
+    return decoded;
+}
+
+// The location of each chunk in a binary glTF file.
+struct GlbLayout
+{
+    uint64_t jsonOffset{0};
+    uint64_t jsonLength{0};
+
+    // Zero length when the file has no binary chunk.
+    uint64_t binaryOffset{0};
+    uint64_t binaryLength{0};
+};
+
+auto readGlbLayout(std::ifstream& file) -> std::optional<GlbLayout>
+{
+    uint32_t constexpr GLB_MAGIC{0x46546C67};
+    uint32_t constexpr GLB_VERSION{2};
+    uint32_t constexpr CHUNK_JSON{0x4E4F534A};
+    uint32_t constexpr CHUNK_BIN{0x004E4942};
+
+    struct GlbHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t length;
+    };
+    struct GlbChunkHeader
+    {
+        uint32_t length;
+        uint32_t type;
+    };
+
+    GlbHeader header{};
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(&header), sizeof(GlbHeader));
+    if (!file || header.magic != GLB_MAGIC || header.version != GLB_VERSION)
+    {
+        return std::nullopt;
+    }
+
+    GlbChunkHeader jsonChunk{};
+    file.read(reinterpret_cast<char*>(&jsonChunk), sizeof(GlbChunkHeader));
+    if (!file || jsonChunk.type != CHUNK_JSON)
+    {
+        return std::nullopt;
+    }
+
+    GlbLayout layout{
+        .jsonOffset = sizeof(GlbHeader) + sizeof(GlbChunkHeader),
+        .jsonLength = jsonChunk.length,
+    };
+
+    uint64_t const binaryChunkOffset{layout.jsonOffset + layout.jsonLength};
+    if (binaryChunkOffset + sizeof(GlbChunkHeader) > header.length)
+    {
+        return layout;
+    }
+
+    GlbChunkHeader binaryChunk{};
+    file.seekg(static_cast<std::streamoff>(binaryChunkOffset), std::ios::beg);
+    file.read(reinterpret_cast<char*>(&binaryChunk), sizeof(GlbChunkHeader));
+    if (!file || binaryChunk.type != CHUNK_BIN)
+    {
+        return std::nullopt;
+    }
+
+    layout.binaryOffset = binaryChunkOffset + sizeof(GlbChunkHeader);
+    layout.binaryLength = binaryChunk.length;
+
+    return layout;
+}
+
+struct AccessorByteRange
+{
+    uint64_t offset{0};
+    uint64_t length{0};
+};
+
+// The bytes of the binary chunk that an accessor reads from. Only dense
+// accessors into the binary chunk can be streamed.
+auto findAccessorByteRange(
+    fastgltf::Asset const& gltf, fastgltf::Accessor const& accessor
+) -> std::optional<AccessorByteRange>
+{
+    if (accessor.sparse.has_value() || !accessor.bufferViewIndex.has_value())
+    {
+        return std::nullopt;
+    }
+
+    fastgltf::BufferView const& view{
+        gltf.bufferViews[accessor.bufferViewIndex.value()]
+    };
+    if (view.bufferIndex != 0)
+    {
+        return std::nullopt;
+    }
+
+    uint64_t const elementSize{
+        fastgltf::getElementByteSize(accessor.type, accessor.componentType)
+    };
+    uint64_t const stride{view.byteStride.value_or(elementSize)};
+
+    return AccessorByteRange{
+        .offset = view.byteOffset + accessor.byteOffset,
+        .length = accessor.count == 0
+                    ? 0
+                    : stride * (accessor.count - 1) + elementSize,
+    };
+}
+
+// The sizes of a mesh that is about to be streamed, read from its accessors.
+struct StreamedMeshSize
+{
+    uint64_t vertexCount{0};
+    uint64_t indexCount{0};
+
+    // An upper bound on the memory held at once while importing and
+    // uploading the mesh.
+    uint64_t peakBytes{0};
+};
+
+// Returns nothing if the mesh's data cannot be streamed. The bound sums every
+// allocation made per mesh, even those that are not alive at the same time.
+auto measureStreamedMesh(
+    fastgltf::Asset const& gltf,
+    fastgltf::Mesh const& mesh,
+    MeshImportOptions const& options
+) -> std::optional<StreamedMeshSize>
+{
+    uint64_t vertexCount{0};
+    uint64_t indexCount{0};
+    uint64_t largestRead{0};
+
+    for (fastgltf::Primitive const& primitive : mesh.primitives)
+    {
+        if (!primitive.indicesAccessor.has_value()
+            || primitive.findAttribute("POSITION")
+                   == primitive.attributes.end())
+        {
+            return std::nullopt;
+        }
+
+        std::vector<size_t> accessorIndices{
+            primitive.indicesAccessor.value()
+        };
+        for (auto const& attribute : primitive.attributes)
+        {
+            accessorIndices.push_back(attribute.second);
+        }
+
+        for (size_t const accessorIndex : accessorIndices)
+        {
+            std::optional<AccessorByteRange> const range{findAccessorByteRange(
+                gltf, gltf.accessors[accessorIndex]
+            )};
+            if (!range.has_value())
+            {
+                return std::nullopt;
+            }
+            largestRead = std::max(largestRead, range->length);
+        }
+
+        indexCount += gltf.accessors[primitive.indicesAccessor.value()].count;
+        vertexCount +=
+            gltf.accessors[primitive.findAttribute("POSITION")->second].count;
+    }
+
+    uint64_t const lodIndexCount{lod::maxLODIndexCount(indexCount)};
+    uint64_t const meshletCount{
+        meshlets::maxMeshletCount(indexCount / 3, mesh.primitives.size())
+    };
+    uint64_t const uploadedVertexBytes{
+        vertexCount
+        * (options.packVertices ? sizeof(PackedVertex) : sizeof(Vertex))
+    };
+
+    // The decoded vertices, and the indices which are reserved up front to
+    // hold every level of detail.
+    uint64_t const decodedBytes{
+        vertexCount * sizeof(Vertex) + lodIndexCount * sizeof(uint32_t)
+    };
+
+    // Meshlets are built per surface then merged, and either list can have
+    // up to double its size reserved while growing.
+    uint64_t const meshletBytes{
+        meshletCount * (4 * sizeof(Meshlet) + sizeof(gputypes::Meshlet))
+        + vertexCount * sizeof(uint32_t)
+    };
+
+    // The packed copy is made while the full vertices are still alive.
+    uint64_t const packedBytes{
+        options.packVertices ? vertexCount * sizeof(PackedVertex) : 0
+    };
+
+    // Staging narrows the indices to 16 bits when possible and extracts the
+    // positions twice over, before copying everything into one buffer.
+    uint64_t const positionBytes{vertexCount * sizeof(glm::vec3)};
+    uint64_t const stagingBytes{
+        lodIndexCount * (sizeof(uint16_t) + sizeof(uint32_t))
+        + 3 * positionBytes + uploadedVertexBytes
+        + meshletCount * sizeof(gputypes::Meshlet)
+    };
+
+    return StreamedMeshSize{
+        .vertexCount = vertexCount,
+        .indexCount = indexCount,
+        .peakBytes = largestRead + decodedBytes
+                   + lod::maxLODScratchBytes(vertexCount, indexCount)
+                   + meshletBytes + packedBytes + stagingBytes,
+    };
+}
+
+auto decodeGltfMeshesStreaming(
+    std::filesystem::path const& assetPath,
+    std::string const& localPath,
+    MeshImportOptions const& options,
+    DecodedMeshCallback const& onDecoded
+) -> bool
+{
+    std::ifstream file(assetPath, std::ios::binary);
+    if (!file.is_open())
+    {
+        Error(fmt::format("Unable to open glTF: {}", assetPath.string()));
+        return false;
+    }
+
+    std::optional<GlbLayout> const layoutResult{readGlbLayout(file)};
+    if (!layoutResult.has_value())
+    {
+        Error("Streaming import requires a binary glTF (.glb) file.");
+        return false;
+    }
+    GlbLayout const layout{layoutResult.value()};
+
+    // Only the JSON chunk is parsed up front. Buffers are skipped entirely,
+    // since their data is read from the binary chunk one accessor at a time.
+    std::vector<uint8_t> json(layout.jsonLength);
+    file.seekg(static_cast<std::streamoff>(layout.jsonOffset));
+    file.read(
+        reinterpret_cast<char*>(json.data()),
+        static_cast<std::streamsize>(json.size())
+    );
+    if (!file)
+    {
+        Error("Failed to read glTF JSON chunk.");
+        return false;
+    }
+
+    fastgltf::GltfDataBuffer jsonData;
+    jsonData.copyBytes(json.data(), json.size());
+    json.clear();
+    json.shrink_to_fit();
+
+    auto const GLTF_CATEGORIES{
+        fastgltf::Category::OnlyRenderable & ~fastgltf::Category::Buffers
+        & ~fastgltf::Category::Images
+    };
+
+    fastgltf::Parser parser{GLTF_EXTENSIONS};
+
+    fastgltf::Expected<fastgltf::Asset> load{parser.loadGltfJson(
+        &jsonData,
+        assetPath.parent_path(),
+        fastgltf::Options::None,
+        GLTF_CATEGORIES
+    )};
+    if (!load)
+    {
+        Error(fmt::format(
+            "Failed to load glTF: {}", fastgltf::to_underlying(load.error())
+        ));
+        return false;
+    }
+    fastgltf::Asset gltf{std::move(load.get())};
+
+    // Accessors are redirected through this buffer and view, which hold only
+    // the bytes of the accessor currently being decoded.
+    size_t const windowBufferIndex{gltf.buffers.size()};
+    gltf.buffers.emplace_back();
+    size_t const windowViewIndex{gltf.bufferViews.size()};
+    gltf.bufferViews.emplace_back();
+
+    std::vector<std::byte> window{};
+
+    AccessorLoader const loadAccessor{
+        [&](size_t const accessorIndex) -> std::optional<fastgltf::Accessor>
+    {
+        fastgltf::Accessor accessor{gltf.accessors[accessorIndex]};
+
+        std::optional<AccessorByteRange> const range{
+            findAccessorByteRange(gltf, accessor)
+        };
+        if (!range.has_value()
+            || range->offset + range->length > layout.binaryLength)
+        {
+            Error(fmt::format(
+                "Accessor {} cannot be streamed from the binary chunk.",
+                accessorIndex
+            ));
+            return std::nullopt;
+        }
+
+        window.resize(range->length);
+        file.seekg(
+            static_cast<std::streamoff>(layout.binaryOffset + range->offset)
+        );
+        file.read(
+            reinterpret_cast<char*>(window.data()),
+            static_cast<std::streamsize>(window.size())
+        );
+        if (!file)
+        {
+            Error(fmt::format("Failed to read accessor {}.", accessorIndex));
+            return std::nullopt;
+        }
+
+        fastgltf::BufferView const& sourceView{
+            gltf.bufferViews[accessor.bufferViewIndex.value()]
+        };
+
+        fastgltf::sources::ByteView windowSource{};
+        windowSource.bytes =
+            fastgltf::span<std::byte const>{window.data(), window.size()};
+        windowSource.mimeType = fastgltf::MimeType::GltfBuffer;
+
+        fastgltf::Buffer& windowBuffer{gltf.buffers[windowBufferIndex]};
+        windowBuffer.byteLength = window.size();
+        windowBuffer.data = windowSource;
+
+        fastgltf::BufferView& windowView{gltf.bufferViews[windowViewIndex]};
+        windowView.bufferIndex = windowBufferIndex;
+        windowView.byteOffset = 0;
+        windowView.byteLength = window.size();
+        windowView.byteStride = sourceView.byteStride;
+
+        accessor.bufferViewIndex = windowViewIndex;
+        accessor.byteOffset = 0;
+
+        return accessor;
+    }};
+
+    // Every mesh is checked before any is decoded, so an import either fits
+    // the budget entirely or fails without producing a partial set of meshes.
+    std::vector<StreamedMeshSize> meshSizes{};
+    meshSizes.reserve(gltf.meshes.size());
+    uint64_t peakBytes{0};
+    for (fastgltf::Mesh const& mesh : gltf.meshes)
+    {
+        std::optional<StreamedMeshSize> const size{
+            measureStreamedMesh(gltf, mesh, options)
+        };
+        if (!size.has_value())
+        {
+            Error(fmt::format(
+                "Mesh \"{}\" cannot be streamed, since its data is not "
+                "indexed triangles in the binary chunk.",
+                std::string{mesh.name}
+            ));
+            return false;
+        }
+        if (size->peakBytes > options.streamingBudgetBytes)
+        {
+            Error(fmt::format(
+                "Mesh \"{}\" needs up to {} bytes to import, which is over "
+                "the streaming budget of {} bytes.",
+                std::string{mesh.name},
+                size->peakBytes,
+                options.streamingBudgetBytes
+            ));
+            return false;
+        }
+        peakBytes = std::max(peakBytes, size->peakBytes);
+        meshSizes.push_back(size.value());
+    }
+
+    for (size_t meshIndex{0}; meshIndex < gltf.meshes.size(); meshIndex++)
+    {
+        fastgltf::Mesh const& mesh{gltf.meshes[meshIndex]};
+        StreamedMeshSize const& size{meshSizes[meshIndex]};
+
+        // Reserved in full, so growth never overshoots the estimate.
+        std::vector<uint32_t> indices{};
+        indices.reserve(lod::maxLODIndexCount(size.indexCount));
+        std::vector<Vertex> vertices{};
+        vertices.reserve(size.vertexCount);
+        std::vector<GeometrySurface> surfaces{};
+
+        bool decoded{true};
+        for (fastgltf::Primitive const& primitive : mesh.primitives)
+        {
+            decoded = appendPrimitive(
+                gltf, primitive, loadAccessor, indices, vertices, surfaces
+            );
+            if (!decoded)
+            {
+                break;
+            }
+        }
+
+        // The source bytes are not needed once decoded
+        window.clear();
+        window.shrink_to_fit();
+
+        if (!decoded)
+        {
+            Error(fmt::format(
+                "Mesh \"{}\" failed to decode.", std::string{mesh.name}
+            ));
+            return false;
+        }
+        if (indices.empty())
+        {
+            warnEmptyMesh(mesh);
+            continue;
+        }
+
+        if (!onDecoded(finishDecoding(
+                std::string{mesh.name},
+                std::move(indices),
+                std::move(vertices),
+                std::move(surfaces),
+                // Images are skipped, since they may not fit in the budget.
+                MeshMaterial{},
+                MeshSource{
+                    .localPath = localPath,
+                    .options = options,
+                    .meshIndex = meshIndex,
+                }
+            )))
+        {
+            return false;
+        }
+    }
+
+    Log(fmt::format(
+        "Streamed {} meshes, using at most {} bytes per mesh.",
+        gltf.meshes.size(),
+        peakBytes
+    ));
+
+    return true;
+}
+} // namespace
+
+auto decodeGltfMeshes(
+    std::string const& localPath,
+    MeshImportOptions const& options,
+    DecodedMeshCallback const& onDecoded
+) -> bool
 {
     std::filesystem::path const assetPath{
         DebugUtils::getLoadedDebugUtils().makeAbsolutePath(localPath)
@@ -22,15 +917,23 @@ auto loadGltfMeshes(Engine* const engine, std::string const& localPath)
 
     Log(fmt::format("Loading glTF: {}", assetPath.string()));
 
+    if (options.streaming)
+    {
+        return decodeGltfMeshesStreaming(
+            assetPath, localPath, options, onDecoded
+        );
+    }
+
     fastgltf::GltfDataBuffer data;
     data.loadFromFile(assetPath);
 
     auto constexpr GLTF_OPTIONS{
         fastgltf::Options::LoadGLBBuffers
         | fastgltf::Options::LoadExternalBuffers
+        | fastgltf::Options::LoadExternalImages
     };
 
-    fastgltf::Parser parser{};
+    fastgltf::Parser parser{GLTF_EXTENSIONS};
 
     fastgltf::Expected<fastgltf::Asset> load{
         parser.loadGltfBinary(&data, assetPath.parent_path(), GLTF_OPTIONS)
@@ -40,13 +943,20 @@ auto loadGltfMeshes(Engine* const engine, std::string const& localPath)
         Error(fmt::format(
             "Failed to load glTF: {}", fastgltf::to_underlying(load.error())
         ));
-        return {};
+        return false;
     }
     fastgltf::Asset const gltf{std::move(load.get())};
 
-    std::vector<std::shared_ptr<MeshAsset>> newMeshes{};
-    for (fastgltf::Mesh const& mesh : gltf.meshes)
+    AccessorLoader const loadAccessor{
+        [&](size_t const accessorIndex) -> std::optional<fastgltf::Accessor>
+    { return gltf.accessors[accessorIndex]; }};
+
+    TextureImportCache textureCache{};
+
+    for (size_t meshIndex{0}; meshIndex < gltf.meshes.size(); meshIndex++)
     {
+        fastgltf::Mesh const& mesh{gltf.meshes[meshIndex]};
+
         std::vector<uint32_t> indices{};
         std::vector<Vertex> vertices{};
 
@@ -55,138 +965,357 @@ auto loadGltfMeshes(Engine* const engine, std::string const& localPath)
         // Proliferate indices and vertices
         for (auto&& primitive : mesh.primitives)
         {
-            surfaces.push_back(GeometrySurface{
-                .firstIndex = static_cast<uint32_t>(indices.size()),
-                .indexCount = static_cast<uint32_t>(
-                    gltf.accessors[primitive.indicesAccessor.value()].count
-                ),
-            });
+            if (!appendPrimitive(
+                    gltf, primitive, loadAccessor, indices, vertices, surfaces
+                ))
+            {
+                Error(fmt::format(
+                    "Mesh \"{}\" failed to decode.", std::string{mesh.name}
+                ));
+                return false;
+            }
+        }
+
+        if (indices.empty())
+        {
+            warnEmptyMesh(mesh);
+            continue;
+        }
 
-            size_t const initialVertexIndex{vertices.size()};
+        // Only one material is drawn per mesh, so the first surface's is used
+        MeshMaterial material{};
+        if (!mesh.primitives.empty())
+        {
+            material = loadMaterial(gltf, mesh.primitives[0], textureCache);
+        }
 
-            { // Indices, not optional
-                fastgltf::Accessor const& indexAccessor{
-                    gltf.accessors[primitive.indicesAccessor.value()]
-                };
-                indices.reserve(indices.size() + indexAccessor.count);
+        if (!onDecoded(finishDecoding(
+                std::string{mesh.name},
+                std::move(indices),
+                std::move(vertices),
+                std::move(surfaces),
+                std::move(material),
+                MeshSource{
+                    .localPath = localPath,
+                    .options = options,
+                    .meshIndex = meshIndex,
+                }
+            )))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto DecodedMesh::vertexBytes() const -> std::span<uint8_t const>
+{
+    return std::visit(
+        [](auto const& typedVertices)
+        {
+            return std::span<uint8_t const>(
+                reinterpret_cast<uint8_t const*>(typedVertices.data()),
+                typedVertices.size() * sizeof(typedVertices[0])
+            );
+        },
+        vertices
+    );
+}
 
-                fastgltf::iterateAccessor<std::uint32_t>(
-                    gltf,
-                    indexAccessor,
-                    [&](std::uint32_t index)
-                    { indices.push_back(index + initialVertexIndex); }
+auto makeMeshAsset(
+    DecodedMesh&& mesh, std::unique_ptr<GPUMeshBuffers> meshBuffers
+) -> std::shared_ptr<MeshAsset>
+{
+    return std::make_shared<MeshAsset>(MeshAsset{
+        .name = std::move(mesh.name),
+        .surfaces = std::move(mesh.surfaces),
+        .boundsCenter = mesh.boundsCenter,
+        .boundsRadius = mesh.boundsRadius,
+        .meshlets = std::move(mesh.meshlets),
+        .material = std::move(mesh.material),
+        .source = std::move(mesh.source),
+        .meshBuffers = std::move(meshBuffers),
+    });
+}
+
+auto loadGltfMeshes(
+    Engine* const engine,
+    std::string const& localPath,
+    MeshImportOptions const& options
+) -> std::optional<std::vector<std::shared_ptr<MeshAsset>>>
+{
+    std::vector<std::shared_ptr<MeshAsset>> newMeshes{};
+
+    // Each mesh is uploaded as soon as it is decoded, so only one mesh's
+    // geometry is ever held on the host.
+    bool const decoded{decodeGltfMeshes(
+        localPath,
+        options,
+        [&](DecodedMesh&& mesh)
+        {
+            std::unique_ptr<GPUMeshBuffers> meshBuffers{};
+            if (std::holds_alternative<std::vector<PackedVertex>>(
+                    mesh.vertices
+                ))
+            {
+                meshBuffers = engine->uploadMeshToGPU(
+                    mesh.indices,
+                    std::get<std::vector<PackedVertex>>(mesh.vertices),
+                    mesh.encoding,
+                    mesh.deviceMeshlets
                 );
             }
-
-            { // Positions, not optional
-                fastgltf::Accessor const& positionAccessor{
-                    gltf.accessors[primitive.findAttribute("POSITION")->second]
-                };
-
-                vertices.reserve(vertices.size() + positionAccessor.count);
-
-                fastgltf::iterateAccessorWithIndex<glm::vec3>(
-                    gltf,
-                    positionAccessor,
-                    [&](glm::vec3 position, size_t /*index*/)
-                    {
-                        vertices.push_back(Vertex{
-                            .position = position,
-                            .uv_x = 0.0F,
-                            .normal = glm::vec3{1, 0, 0},
-                            .uv_y = 0.0F,
-                            .color = glm::vec4{1.0F},
-                        });
-                    }
+            else
+            {
+                meshBuffers = engine->uploadMeshToGPU(
+                    mesh.indices,
+                    std::get<std::vector<Vertex>>(mesh.vertices),
+                    mesh.deviceMeshlets
                 );
             }
 
-            // The rest of these parameters are optional.
+            newMeshes.push_back(
+                makeMeshAsset(std::move(mesh), std::move(meshBuffers))
+            );
+            return true;
+        }
+    )};
+    if (!decoded)
+    {
+        return std::nullopt;
+    }
 
-            { // Normals
-                auto const* const normals{primitive.findAttribute("NORMAL")};
-                if (normals != primitive.attributes.end())
-                {
-                    fastgltf::iterateAccessorWithIndex<glm::vec3>(
-                        gltf,
-                        gltf.accessors[(*normals).second],
-                        [&](glm::vec3 normal, size_t index) {
-                            vertices[initialVertexIndex + index].normal =
-                                normal;
-                        }
-                    );
-                }
-            }
+    return newMeshes;
+}
 
-            { // UVs
-                auto const* const uvs{primitive.findAttribute("TEXCOORD_0")};
-                if (uvs != primitive.attributes.end())
-                {
-                    fastgltf::iterateAccessorWithIndex<glm::vec2>(
-                        gltf,
-                        gltf.accessors[(*uvs).second],
-                        [&](glm::vec2 texcoord, size_t index)
-                        {
-                            vertices[initialVertexIndex + index].uv_x =
-                                texcoord.x;
-                            vertices[initialVertexIndex + index].uv_y =
-                                texcoord.y;
-                        }
-                    );
-                }
-            }
+namespace
+{
+// Matches the flip applied to the positions of imported vertices.
+auto toEngineSpace(glm::mat4x4 const& gltfTransform) -> glm::mat4x4
+{
+    glm::mat4x4 const flipY{glm::scale(glm::vec3{1.0F, -1.0F, 1.0F})};
+    return flipY * gltfTransform * flipY;
+}
 
-            { // Colors
-                auto const* const colors{primitive.findAttribute("COLOR_0")};
-                if (colors != primitive.attributes.end())
-                {
-                    fastgltf::iterateAccessorWithIndex<glm::vec4>(
-                        gltf,
-                        gltf.accessors[(*colors).second],
-                        [&](glm::vec4 color, size_t index)
-                        { vertices[initialVertexIndex + index].color = color; }
-                    );
-                }
-            }
-        }
+auto localTransform(fastgltf::Node const& node) -> glm::mat4x4
+{
+    if (auto const* const matrix{
+            std::get_if<fastgltf::Node::TransformMatrix>(&node.transform)
+        };
+        matrix != nullptr)
+    {
+        return glm::make_mat4(matrix->data());
+    }
+
+    auto const& trs{std::get<fastgltf::Node::TRS>(node.transform)};
+
+    // glTF stores quaternions as XYZW
+    glm::quat const rotation{
+        trs.rotation[3], trs.rotation[0], trs.rotation[1], trs.rotation[2]
+    };
+
+    return glm::translate(glm::make_vec3(trs.translation.data()))
+         * glm::toMat4(rotation) * glm::scale(glm::make_vec3(trs.scale.data()));
+}
+
+// Copies an EXT_mesh_gpu_instancing attribute in one pass, which is a single
+// copy when the data is tightly packed. Empty if the node lacks it.
+template <typename T>
+auto readInstancingAttribute(
+    fastgltf::Asset const& gltf,
+    fastgltf::Node const& node,
+    std::string_view const name
+) -> std::vector<T>
+{
+    auto const attribute{std::find_if(
+        node.instancingAttributes.begin(),
+        node.instancingAttributes.end(),
+        [&](auto const& attribute) { return attribute.first == name; }
+    )};
+    if (attribute == node.instancingAttributes.end())
+    {
+        return {};
+    }
+
+    fastgltf::Accessor const& accessor{gltf.accessors[attribute->second]};
 
-        bool constexpr DEBUG_OVERRIDE_COLORS{false};
-        if (DEBUG_OVERRIDE_COLORS)
+    std::vector<T> values(accessor.count);
+    fastgltf::copyFromAccessor<T>(gltf, accessor, values.data());
+
+    return values;
+}
+
+void appendInstancedTransforms(
+    fastgltf::Asset const& gltf,
+    fastgltf::Node const& node,
+    glm::mat4x4 const& nodeTransform,
+    std::vector<glm::mat4x4>& transforms
+)
+{
+    std::vector<glm::vec3> const translations{
+        readInstancingAttribute<glm::vec3>(gltf, node, "TRANSLATION")
+    };
+    std::vector<glm::vec4> const rotations{
+        readInstancingAttribute<glm::vec4>(gltf, node, "ROTATION")
+    };
+    std::vector<glm::vec3> const scales{
+        readInstancingAttribute<glm::vec3>(gltf, node, "SCALE")
+    };
+
+    // Every attribute should have the same count, but this tolerates any
+    // that do not.
+    size_t const instanceCount{
+        std::max({translations.size(), rotations.size(), scales.size()})
+    };
+    transforms.reserve(transforms.size() + instanceCount);
+
+    for (size_t index{0}; index < instanceCount; index++)
+    {
+        glm::mat4x4 instanceTransform{1.0F};
+        if (index < translations.size())
         {
-            for (Vertex& vertex : vertices)
-            {
-                vertex.color = glm::vec4(vertex.normal, 1.0F);
-            }
+            instanceTransform *= glm::translate(translations[index]);
+        }
+        if (index < rotations.size())
+        {
+            glm::vec4 const rotation{rotations[index]};
+            instanceTransform *= glm::toMat4(
+                glm::quat{rotation.w, rotation.x, rotation.y, rotation.z}
+            );
         }
+        if (index < scales.size())
+        {
+            instanceTransform *= glm::scale(scales[index]);
+        }
+
+        transforms.push_back(
+            toEngineSpace(nodeTransform * instanceTransform)
+        );
+    }
+}
+} // namespace
+
+auto loadGltfSceneInstances(std::string const& localPath)
+    -> std::optional<SceneInstances>
+{
+    std::filesystem::path const assetPath{
+        DebugUtils::getLoadedDebugUtils().makeAbsolutePath(localPath)
+    };
+
+    Log(fmt::format("Loading glTF scene: {}", assetPath.string()));
+
+    fastgltf::GltfDataBuffer data;
+    data.loadFromFile(assetPath);
 
-        bool constexpr FLIP_Y{true};
-        if (FLIP_Y)
+    auto constexpr GLTF_OPTIONS{
+        fastgltf::Options::LoadGLBBuffers
+        | fastgltf::Options::LoadExternalBuffers
+    };
+
+    fastgltf::Parser parser{GLTF_EXTENSIONS};
+
+    fastgltf::Expected<fastgltf::Asset> load{
+        parser.loadGltfBinary(&data, assetPath.parent_path(), GLTF_OPTIONS)
+    };
+    if (!load)
+    {
+        Error(fmt::format(
+            "Failed to load glTF: {}", fastgltf::to_underlying(load.error())
+        ));
+        return std::nullopt;
+    }
+    fastgltf::Asset const gltf{std::move(load.get())};
+
+    SceneInstances instances{
+        .meshTransforms =
+            std::vector<std::vector<glm::mat4x4>>(gltf.meshes.size()),
+    };
+
+    if (gltf.scenes.empty())
+    {
+        Warning(fmt::format("glTF \"{}\" has no scenes.", localPath));
+        return instances;
+    }
+
+    size_t const sceneIndex{
+        gltf.defaultScene.has_value() ? gltf.defaultScene.value() : 0
+    };
+
+    // An explicit stack, since scene hierarchies can be arbitrarily deep.
+    struct PendingNode
+    {
+        size_t nodeIndex;
+        glm::mat4x4 parentTransform;
+    };
+    std::vector<PendingNode> pendingNodes{};
+    for (size_t const nodeIndex : gltf.scenes[sceneIndex].nodeIndices)
+    {
+        pendingNodes.push_back(PendingNode{
+            .nodeIndex = nodeIndex,
+            .parentTransform = glm::mat4x4{1.0F},
+        });
+    }
+
+    size_t instanceCount{0};
+    while (!pendingNodes.empty())
+    {
+        PendingNode const pending{pendingNodes.back()};
+        pendingNodes.pop_back();
+
+        fastgltf::Node const& node{gltf.nodes[pending.nodeIndex]};
+        glm::mat4x4 const nodeTransform{
+            pending.parentTransform * localTransform(node)
+        };
+
+        if (node.meshIndex.has_value())
         {
-            for (Vertex& vertex : vertices)
+            std::vector<glm::mat4x4>& transforms{
+                instances.meshTransforms[node.meshIndex.value()]
+            };
+            size_t const previousCount{transforms.size()};
+
+            if (node.instancingAttributes.empty())
+            {
+                transforms.push_back(toEngineSpace(nodeTransform));
+            }
+            else
             {
-                vertex.normal.y *= -1;
-                vertex.position.y *= -1;
+                appendInstancedTransforms(
+                    gltf, node, nodeTransform, transforms
+                );
             }
+
+            instanceCount += transforms.size() - previousCount;
         }
 
-        newMeshes.push_back(std::make_shared<MeshAsset>(MeshAsset{
-            .name = std::string{mesh.name},
-            .surfaces = surfaces,
-            .meshBuffers = engine->uploadMeshToGPU(indices, vertices),
-        }));
+        for (size_t const childIndex : node.children)
+        {
+            pendingNodes.push_back(PendingNode{
+                .nodeIndex = childIndex,
+                .parentTransform = nodeTransform,
+            });
+        }
     }
 
-    return newMeshes;
+    Log(fmt::format(
+        "Scene places {} instances across {} meshes.",
+        instanceCount,
+        gltf.meshes.size()
+    ));
+
+    return instances;
 }
 
-auto loadAssetFile(std::string const& localPath)
-    -> AssetLoadingResult
+namespace
+{
+// Reads the file at the resolved path, which is null if the local path was
+// malformed.
+auto readAssetFile(
+    std::unique_ptr<std::filesystem::path> const& pPath,
+    std::string const& localPath
+) -> AssetLoadingResult
 {
-    std::unique_ptr<std::filesystem::path> const pPath{
-        DebugUtils::getLoadedDebugUtils().loadAssetPath(
-            std::filesystem::path(localPath)
-        )
-    };
     if (pPath == nullptr)
     {
         return AssetLoadingError{
@@ -235,3 +1364,24 @@ auto loadAssetFile(std::string const& localPath)
         .fileBytes = buffer,
     };
 }
+} // namespace
+
+auto loadAssetFile(std::string const& localPath) -> AssetLoadingResult
+{
+    return readAssetFile(
+        DebugUtils::getLoadedDebugUtils().loadAssetPath(
+            std::filesystem::path(localPath)
+        ),
+        localPath
+    );
+}
+
+auto loadBuildOutputFile(std::string const& localPath) -> AssetLoadingResult
+{
+    return readAssetFile(
+        DebugUtils::getLoadedDebugUtils().loadBuildOutputPath(
+            std::filesystem::path(localPath)
+        ),
+        localPath
+    );
+}
@@ -2,28 +2,173 @@
 
 #include "buffers.hpp"
 #include "enginetypes.hpp"
+#include "textures.hpp"
 #include <filesystem>
 #include <optional>
 #include <variant>
 
+/** A simplified version of a surface, indexing the same vertices. */
+struct SurfaceLOD
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+
+    // The furthest any vertex moved during simplification, in object space.
+    float error;
+};
+
+/** A small cluster of triangles from a surface, that is culled as a unit. */
+struct Meshlet
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+
+    // A sphere in object space containing every vertex of the meshlet.
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+
+    // Every triangle's normal is within this cone, so the meshlet is entirely
+    // backfacing when viewed from inside its negation. A cutoff of 1 means
+    // the meshlet can never be culled this way.
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
 /** An interval of indices from an index buffer. */
 struct GeometrySurface
 {
     uint32_t firstIndex;
     uint32_t indexCount;
+
+    // Indices are relative to the surface's vertices, which begin here. This
+    // keeps index values small enough to fit into 16 bits for most surfaces.
+    int32_t vertexOffset{0};
+    uint32_t vertexCount{0};
+
+    // Progressively coarser levels of detail, stored in the same index buffer.
+    std::vector<SurfaceLOD> lods{};
+
+    // The full detail indices are partitioned into meshlets, which are found
+    // in the mesh's meshlet list.
+    uint32_t firstMeshlet{0};
+    uint32_t meshletCount{0};
+};
+
+struct MeshImportOptions
+{
+    // Quantizes vertices into PackedVertex, at a third of the memory.
+    bool packVertices{false};
+
+    // Reads a .glb one mesh at a time instead of loading the entire file, so
+    // files larger than memory can be imported. The import fails if any mesh
+    // would need more than the budget, before any mesh is decoded.
+    bool streaming{false};
+    uint64_t streamingBudgetBytes{512ULL * 1024ULL * 1024ULL};
+
+    bool operator==(MeshImportOptions const& other) const = default;
+};
+
+/** Where a mesh was imported from, so that it can be imported again. */
+struct MeshSource
+{
+    std::string localPath{};
+    MeshImportOptions options{};
+
+    // The mesh's index within the file.
+    size_t meshIndex{0};
+};
+
+/** The glTF metallic-roughness base color of a mesh's first surface. */
+struct MeshMaterial
+{
+    // Meshes without a material keep the engine's old flat grey.
+    glm::vec4 baseColorFactor{0.8F, 0.8F, 0.8F, 1.0F};
+
+    // Shared by every mesh from the same file that samples the same image.
+    // Null when untextured.
+    std::shared_ptr<textures::CompressedTexture const> baseColorTexture{};
 };
 
 struct MeshAsset
 {
     std::string name{};
     std::vector<GeometrySurface> surfaces{};
+
+    // A sphere in object space containing every vertex.
+    glm::vec3 boundsCenter{0.0f};
+    float boundsRadius{0.0f};
+
+    std::vector<Meshlet> meshlets{};
+
+    MeshMaterial material{};
+
+    MeshSource source{};
+
+    // Null while the mesh is not resident on the device.
     std::unique_ptr<GPUMeshBuffers> meshBuffers{};
 };
 
+/** A mesh and its derived data, decoded on the host but not yet uploaded. */
+struct DecodedMesh
+{
+    std::string name{};
+    std::vector<GeometrySurface> surfaces{};
+
+    glm::vec3 boundsCenter{0.0f};
+    float boundsRadius{0.0f};
+
+    std::vector<Meshlet> meshlets{};
+
+    std::vector<uint32_t> indices{};
+    std::variant<std::vector<Vertex>, std::vector<PackedVertex>> vertices{};
+    VertexEncoding encoding{};
+
+    std::vector<gputypes::Meshlet> deviceMeshlets{};
+
+    MeshMaterial material{};
+
+    MeshSource source{};
+
+    std::span<uint8_t const> vertexBytes() const;
+};
+
+std::shared_ptr<MeshAsset> makeMeshAsset(
+    DecodedMesh&& mesh, std::unique_ptr<GPUMeshBuffers> meshBuffers
+);
+
 class Engine;
 
-std::optional<std::vector<std::shared_ptr<MeshAsset>>>
-loadGltfMeshes(Engine* engine, std::string const& localPath);
+// Called with each mesh once decoded. Returning false stops decoding.
+using DecodedMeshCallback = std::function<bool(DecodedMesh&&)>;
+
+// Decodes every mesh without touching the GPU, so it can run on any thread.
+// Base color textures are compressed here too, except when streaming.
+// Returns false if the file could not be read or decoding was stopped.
+bool decodeGltfMeshes(
+    std::string const& localPath,
+    MeshImportOptions const& options,
+    DecodedMeshCallback const& onDecoded
+);
+
+std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGltfMeshes(
+    Engine* engine,
+    std::string const& localPath,
+    MeshImportOptions const& options = {}
+);
+
+/** The placements of every mesh by a glTF scene. */
+struct SceneInstances
+{
+    // The flattened world transform of each instance, indexed by the mesh's
+    // index within the file.
+    std::vector<std::vector<glm::mat4x4>> meshTransforms{};
+};
+
+// Walks the node hierarchy of the file's default scene, including instances
+// placed by EXT_mesh_gpu_instancing. No meshes are decoded.
+std::optional<SceneInstances> loadGltfSceneInstances(
+    std::string const& localPath
+);
 
 struct AssetFile
 {
@@ -38,4 +183,8 @@ struct AssetLoadingError
 
 using AssetLoadingResult = std::variant<AssetFile, AssetLoadingError>;
 
-AssetLoadingResult loadAssetFile(std::string const& localPath);
\ No newline at end of file
+// Reads a file relative to the project's root.
+AssetLoadingResult loadAssetFile(std::string const& localPath);
+
+// Reads a file relative to the build tree's root, such as a compiled shader.
+AssetLoadingResult loadBuildOutputFile(std::string const& localPath);
\ No newline at end of file
@@ -0,0 +1,647 @@
+#include "syzygy.hpp"
+
+#include "cpuprofiler.hpp"
+#include "engine.hpp"
+#include "frametimes.hpp"
+#include "gpuprofiler.hpp"
+#include "helpers.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string_view>
+
+namespace
+{
+enum class CameraPath
+{
+    STATIC,
+    ORBIT,
+    FLYOVER,
+};
+
+struct BenchmarkScene
+{
+    std::string name{};
+    SceneParameters scene{};
+    CameraPath cameraPath{CameraPath::STATIC};
+};
+
+// Renamed or retuned scenes no longer compare against older baselines, so
+// prefer adding scenes to changing them.
+auto benchmarkScenes() -> std::vector<BenchmarkScene>
+{
+    return {
+        BenchmarkScene{
+            .name = "default_orbit",
+            .scene = SceneParameters{.instanceCount = 81 * 81},
+            .cameraPath = CameraPath::ORBIT,
+        },
+        BenchmarkScene{
+            .name = "dense_flyover",
+            .scene = SceneParameters{
+                .instanceCount = 160 * 160,
+                .spotLightCount = 4,
+            },
+            .cameraPath = CameraPath::FLYOVER,
+        },
+        BenchmarkScene{
+            .name = "many_lights_static",
+            .scene = SceneParameters{
+                .instanceCount = 81 * 81,
+                .spotLightCount = DeferredShadingPipeline::LIGHT_CAPACITY,
+            },
+            .cameraPath = CameraPath::STATIC,
+        },
+    };
+}
+
+// A fixed timestep, so every run animates the scene identically
+double constexpr DELTA_TIME_SECONDS{1.0 / 60.0};
+
+// Changes in timings smaller than this are treated as noise
+double constexpr MINIMUM_REGRESSION_MILLISECONDS{0.05};
+
+auto cameraAt(CameraPath const path, double const elapsedTimeSeconds)
+    -> CameraParameters
+{
+    CameraParameters camera{
+        .cameraPosition = glm::vec3{0.0F, -8.0F, -8.0F},
+        .eulerAngles = glm::vec3{-0.3F, 0.0F, 0.0F},
+        .fov = 70.0F,
+        .near = 0.1F,
+        .far = 10000.0F,
+    };
+
+    auto const time{static_cast<float>(elapsedTimeSeconds)};
+    switch (path)
+    {
+    case CameraPath::STATIC:
+        break;
+    case CameraPath::ORBIT:
+    {
+        // Circles the origin while facing it
+        float constexpr RADIUS{12.0F};
+        float const angle{time * 0.5F};
+        camera.cameraPosition = glm::vec3{
+            -RADIUS * glm::sin(angle), -8.0F, -RADIUS * glm::cos(angle)
+        };
+        camera.eulerAngles.z = angle;
+        break;
+    }
+    case CameraPath::FLYOVER:
+    {
+        // Sweeps low over the grid while looking down
+        float constexpr SWEEP_DISTANCE{60.0F};
+        camera.cameraPosition = glm::vec3{
+            SWEEP_DISTANCE * glm::sin(time * 0.2F), -12.0F, -20.0F
+        };
+        camera.eulerAngles.x = -0.6F;
+        break;
+    }
+    }
+
+    return camera;
+}
+
+struct PassResult
+{
+    std::string name{};
+    double meanMilliseconds{0.0};
+    WorkCounters work{};
+};
+
+struct SceneResult
+{
+    std::string name{};
+    SceneParameters scene{};
+
+    FrameTimeSummary frameTimes{};
+    std::vector<CPUProfiler::ZoneStatistics> cpuZones{};
+    std::vector<PassResult> gpuPasses{};
+    WorkCounters frameWork{};
+
+    VmaTotalStatistics memory{};
+};
+
+// The names of everything that has not settled, separated by commas.
+auto describePending(Engine::Readiness const& readiness) -> std::string
+{
+    std::string pending{};
+    auto const add{[&](bool const settled, std::string_view const name)
+    {
+        if (settled)
+        {
+            return;
+        }
+        pending += pending.empty() ? "" : ", ";
+        pending += name;
+    }};
+
+    add(readiness.meshResident, "mesh residency");
+    add(readiness.meshLoadsFinished, "mesh loading");
+    add(readiness.pipelinesCompiled, "pipeline compilation");
+    add(readiness.workgroupsTuned, "workgroup tuning");
+    add(readiness.texturesSettled, "texture streaming");
+
+    return pending;
+}
+
+// Renders the first frame of the scene until background work settles, so
+// warm-up starts from the same state on every run instead of measuring
+// whichever loads, compiles, or tuning happen to still be running. Returns
+// false if it never settles.
+auto waitUntilReady(
+    Engine& engine, BenchmarkScene const& scene, glm::u16vec2 const extent
+) -> bool
+{
+    // Settling has to hold for a few frames, since some work only begins
+    // once a frame requests it, such as streaming textures for a new mesh.
+    uint32_t constexpr SETTLED_FRAMES_REQUIRED{8};
+    uint32_t constexpr FRAME_LIMIT{20'000};
+
+    engine.setCameraParameters(cameraAt(scene.cameraPath, 0.0));
+
+    uint32_t settledFrames{0};
+    for (uint32_t frame{0}; frame < FRAME_LIMIT; frame++)
+    {
+        engine.mainLoop(0.0, DELTA_TIME_SECONDS, true, extent);
+
+        settledFrames = engine.readiness().ready() ? settledFrames + 1 : 0;
+        if (settledFrames == SETTLED_FRAMES_REQUIRED)
+        {
+            Log(fmt::format(
+                "Scene '{}' was ready after {} frames.", scene.name, frame + 1
+            ));
+            return true;
+        }
+    }
+
+    Error(fmt::format(
+        "Scene '{}' did not become ready after {} frames, still waiting on: "
+        "{}.",
+        scene.name,
+        FRAME_LIMIT,
+        describePending(engine.readiness())
+    ));
+    return false;
+}
+
+auto runScene(
+    Engine& engine,
+    BenchmarkScene const& scene,
+    BenchmarkParameters const& parameters
+) -> std::optional<SceneResult>
+{
+    Log(fmt::format("Running benchmark scene '{}'.", scene.name));
+
+    glm::u16vec2 const extent{parameters.width, parameters.height};
+
+    engine.loadScene(scene.scene);
+
+    if (!waitUntilReady(engine, scene, extent))
+    {
+        return std::nullopt;
+    }
+
+    FrameTimeStatistics frameTimes{
+        std::max<size_t>(parameters.measuredFrames, 1)
+    };
+    CPUZoneCollector cpuZones{};
+
+    GPUProfiler const* const gpuProfiler{GPUProfiler::getLoadedGPUProfiler()};
+    uint64_t gpuFramesRead{
+        gpuProfiler != nullptr ? gpuProfiler->framesRead() : 0
+    };
+    std::map<std::string, double> gpuTotalMilliseconds{};
+    size_t gpuFramesMeasured{0};
+
+    uint32_t const totalFrames{
+        parameters.warmupFrames + parameters.measuredFrames
+    };
+    for (uint32_t frame{0}; frame < totalFrames; frame++)
+    {
+        bool const measured{frame >= parameters.warmupFrames};
+        if (frame == parameters.warmupFrames)
+        {
+            cpuZones.reset();
+        }
+
+        double const elapsedTimeSeconds{
+            static_cast<double>(frame) * DELTA_TIME_SECONDS
+        };
+        engine.setCameraParameters(
+            cameraAt(scene.cameraPath, elapsedTimeSeconds)
+        );
+
+        int64_t const frameBegin{CPUProfiler::now()};
+        engine.mainLoop(elapsedTimeSeconds, DELTA_TIME_SECONDS, true, extent);
+        int64_t const frameEnd{CPUProfiler::now()};
+
+        if (measured)
+        {
+            frameTimes.write(
+                static_cast<double>(frameEnd - frameBegin) / 1'000'000.0
+            );
+
+            // Read every frame, so no zone is overwritten before it counts
+            cpuZones.update();
+        }
+
+        // Results arrive a few frames late, and at most once per frame
+        if (gpuProfiler == nullptr
+            || gpuProfiler->framesRead() == gpuFramesRead)
+        {
+            continue;
+        }
+        gpuFramesRead = gpuProfiler->framesRead();
+        if (!measured)
+        {
+            continue;
+        }
+
+        size_t const latest{
+            (gpuProfiler->historyIndex() + GPUProfiler::HISTORY_LENGTH - 1)
+            % GPUProfiler::HISTORY_LENGTH
+        };
+        for (GPUProfiler::ScopeHistory const& scope : gpuProfiler->scopes())
+        {
+            gpuTotalMilliseconds[scope.name] += scope.milliseconds[latest];
+        }
+        gpuFramesMeasured += 1;
+    }
+
+    SceneResult result{
+        .name = scene.name,
+        .scene = scene.scene,
+        .frameTimes = frameTimes.summarize(frameTimes.count()),
+        .cpuZones = cpuZones.statistics(),
+        .memory = engine.memoryStatistics(),
+    };
+
+    if (gpuProfiler != nullptr)
+    {
+        result.frameWork = gpuProfiler->frameWork();
+        for (GPUProfiler::ScopeHistory const& scope : gpuProfiler->scopes())
+        {
+            result.gpuPasses.push_back(PassResult{
+                .name = scope.name,
+                .meanMilliseconds =
+                    gpuFramesMeasured > 0
+                        ? gpuTotalMilliseconds[scope.name]
+                              / static_cast<double>(gpuFramesMeasured)
+                        : 0.0,
+                .work = scope.work,
+            });
+        }
+    }
+
+    return result;
+}
+
+// Every metric is lower-is-better, keyed by scene and measurement.
+auto flattenMetrics(
+    std::span<SceneResult const> const results, uint32_t const measuredFrames
+) -> std::map<std::string, double>
+{
+    std::map<std::string, double> metrics{};
+    for (SceneResult const& result : results)
+    {
+        std::string const& scene{result.name};
+
+        metrics[scene + "/frame_mean_ms"] = result.frameTimes.meanMilliseconds;
+        metrics[scene + "/frame_p50_ms"] = result.frameTimes.p50Milliseconds;
+        metrics[scene + "/frame_p95_ms"] = result.frameTimes.p95Milliseconds;
+        metrics[scene + "/frame_p99_ms"] = result.frameTimes.p99Milliseconds;
+
+        for (CPUProfiler::ZoneStatistics const& zone : result.cpuZones)
+        {
+            metrics[fmt::format("{}/cpu/{}_ms", scene, zone.name)] =
+                zone.totalMilliseconds
+                / static_cast<double>(std::max<uint32_t>(measuredFrames, 1));
+        }
+        for (PassResult const& pass : result.gpuPasses)
+        {
+            metrics[fmt::format("{}/gpu/{}_ms", scene, pass.name)] =
+                pass.meanMilliseconds;
+        }
+
+        metrics[scene + "/memory_allocated_bytes"] = static_cast<double>(
+            result.memory.total.statistics.allocationBytes
+        );
+    }
+    return metrics;
+}
+
+void writeWorkCounters(std::ostream& file, WorkCounters const& work)
+{
+    file << fmt::format(
+        "{{\"draw_calls\":{},\"dispatches\":{},\"barriers\":{},"
+        "\"bytes_copied\":{},\"instances\":{},\"primitives\":{},"
+        "\"vertex_invocations\":{},\"fragment_invocations\":{},"
+        "\"compute_invocations\":{}}}",
+        work.drawCalls,
+        work.dispatches,
+        work.barriers,
+        work.bytesCopied,
+        work.instances,
+        work.primitives,
+        work.vertexInvocations,
+        work.fragmentInvocations,
+        work.computeInvocations
+    );
+}
+
+auto writeResults(
+    std::filesystem::path const& path,
+    BenchmarkParameters const& parameters,
+    std::span<SceneResult const> const results,
+    std::map<std::string, double> const& metrics
+) -> bool
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        Error(fmt::format("Unable to write benchmark to {}", path.string()));
+        return false;
+    }
+
+    file << fmt::format(
+        "{{\n\"warmup_frames\":{},\"measured_frames\":{},"
+        "\"width\":{},\"height\":{},\n\"scenes\":[",
+        parameters.warmupFrames,
+        parameters.measuredFrames,
+        parameters.width,
+        parameters.height
+    );
+
+    for (size_t index{0}; index < results.size(); index++)
+    {
+        SceneResult const& result{results[index]};
+        FrameTimeSummary const& frameTimes{result.frameTimes};
+
+        file << (index == 0 ? "\n" : ",\n");
+        file << fmt::format(
+            "{{\"name\":\"{}\",\"seed\":{},\"instances\":{},"
+            "\"spot_lights\":{},\n\"frame_ms\":{{\"mean\":{:.4f},"
+            "\"p50\":{:.4f},\"p95\":{:.4f},\"p99\":{:.4f},\"max\":{:.4f},"
+            "\"stutters\":{}}},\n\"cpu_zones\":[",
+            EscapeJSON(result.name),
+            result.scene.seed,
+            result.scene.instanceCount,
+            result.scene.spotLightCount,
+            frameTimes.meanMilliseconds,
+            frameTimes.p50Milliseconds,
+            frameTimes.p95Milliseconds,
+            frameTimes.p99Milliseconds,
+            frameTimes.maxMilliseconds,
+            frameTimes.stutters
+        );
+
+        for (size_t zone{0}; zone < result.cpuZones.size(); zone++)
+        {
+            CPUProfiler::ZoneStatistics const& statistics{
+                result.cpuZones[zone]
+            };
+            file << (zone == 0 ? "\n" : ",\n");
+            file << fmt::format(
+                "{{\"name\":\"{}\",\"calls\":{},\"total_ms\":{:.4f},"
+                "\"mean_ms\":{:.4f},\"min_ms\":{:.4f},\"max_ms\":{:.4f}}}",
+                EscapeJSON(statistics.name),
+                statistics.calls,
+                statistics.totalMilliseconds,
+                statistics.meanMilliseconds(),
+                statistics.minMilliseconds,
+                statistics.maxMilliseconds
+            );
+        }
+
+        file << "],\n\"gpu_passes\":[";
+        for (size_t pass{0}; pass < result.gpuPasses.size(); pass++)
+        {
+            PassResult const& passResult{result.gpuPasses[pass]};
+            file << (pass == 0 ? "\n" : ",\n");
+            file << fmt::format(
+                "{{\"name\":\"{}\",\"mean_ms\":{:.4f},\"work\":",
+                EscapeJSON(passResult.name),
+                passResult.meanMilliseconds
+            );
+            writeWorkCounters(file, passResult.work);
+            file << "}";
+        }
+
+        file << "],\n\"frame_work\":";
+        writeWorkCounters(file, result.frameWork);
+
+        VmaStatistics const& memory{result.memory.total.statistics};
+        file << fmt::format(
+            ",\n\"memory\":{{\"allocations\":{},\"allocated_bytes\":{},"
+            "\"blocks\":{},\"block_bytes\":{}}}}}",
+            memory.allocationCount,
+            memory.allocationBytes,
+            memory.blockCount,
+            memory.blockBytes
+        );
+    }
+
+    file << "\n],\n\"metrics\":{";
+    bool firstMetric{true};
+    for (auto const& [name, value] : metrics)
+    {
+        file << fmt::format(
+            "{}\n\"{}\":{:.6f}", firstMetric ? "" : ",", EscapeJSON(name), value
+        );
+        firstMetric = false;
+    }
+    file << "\n}\n}\n";
+
+    Log(fmt::format("Wrote benchmark results to {}", path.string()));
+    return true;
+}
+
+// Reads back the flat metrics object that writeResults writes. This is not a
+// general JSON parser, and only expects the benchmark's own output.
+auto readMetrics(std::filesystem::path const& path)
+    -> std::optional<std::map<std::string, double>>
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        Error(fmt::format("Unable to read baseline {}", path.string()));
+        return std::nullopt;
+    }
+
+    std::stringstream contents{};
+    contents << file.rdbuf();
+    std::string const text{contents.str()};
+
+    size_t const metricsKey{text.find("\"metrics\"")};
+    size_t const objectBegin{text.find('{', metricsKey)};
+    if (metricsKey == std::string::npos || objectBegin == std::string::npos)
+    {
+        Error(fmt::format("Baseline {} has no metrics.", path.string()));
+        return std::nullopt;
+    }
+    size_t const objectEnd{text.find('}', objectBegin)};
+
+    std::map<std::string, double> metrics{};
+    size_t position{objectBegin + 1};
+    while (true)
+    {
+        size_t const keyBegin{text.find('"', position)};
+        if (keyBegin == std::string::npos || keyBegin > objectEnd)
+        {
+            break;
+        }
+
+        size_t const keyEnd{text.find('"', keyBegin + 1)};
+        size_t const colon{text.find(':', keyEnd)};
+        if (keyEnd == std::string::npos || colon == std::string::npos)
+        {
+            break;
+        }
+
+        char* valueEnd{nullptr};
+        double const value{std::strtod(text.c_str() + colon + 1, &valueEnd)};
+        metrics[text.substr(keyBegin + 1, keyEnd - keyBegin - 1)] = value;
+
+        position = static_cast<size_t>(valueEnd - text.c_str());
+    }
+
+    return metrics;
+}
+
+// Returns how many metrics regressed past the threshold.
+auto compareMetrics(
+    std::map<std::string, double> const& current,
+    std::map<std::string, double> const& baseline,
+    double const threshold
+) -> size_t
+{
+    size_t regressions{0};
+    for (auto const& [name, baselineValue] : baseline)
+    {
+        auto const currentIt{current.find(name)};
+        if (currentIt == current.end())
+        {
+            Warning(fmt::format("Baseline metric {} was not measured.", name));
+            continue;
+        }
+
+        double const currentValue{currentIt->second};
+        double const difference{currentValue - baselineValue};
+        if (name.ends_with("_ms")
+            && difference < MINIMUM_REGRESSION_MILLISECONDS)
+        {
+            continue;
+        }
+        if (baselineValue <= 0.0 || difference <= baselineValue * threshold)
+        {
+            continue;
+        }
+
+        Error(fmt::format(
+            "Regression in {}: {:.4f} -> {:.4f} (+{:.1f}%)",
+            name,
+            baselineValue,
+            currentValue,
+            difference / baselineValue * 100.0
+        ));
+        regressions += 1;
+    }
+    return regressions;
+}
+} // namespace
+
+auto Application::runBenchmark(BenchmarkParameters const& parameters)
+    -> ApplicationResult
+{
+    std::vector<BenchmarkScene> scenes{};
+    for (BenchmarkScene scene : benchmarkScenes())
+    {
+        if (!parameters.scene.empty() && parameters.scene != scene.name)
+        {
+            continue;
+        }
+
+        scene.scene.seed = parameters.seed;
+        scene.scene.instanceCount =
+            parameters.instanceCount.value_or(scene.scene.instanceCount);
+        scene.scene.spotLightCount =
+            parameters.spotLightCount.value_or(scene.scene.spotLightCount);
+        scenes.push_back(scene);
+    }
+    if (scenes.empty())
+    {
+        Error(fmt::format("No benchmark scene is named '{}'.", parameters.scene)
+        );
+        return ApplicationResult::FAILURE;
+    }
+
+    std::optional<std::map<std::string, double>> baseline{};
+    if (parameters.baselinePath.has_value())
+    {
+        baseline = readMetrics(parameters.baselinePath.value());
+        if (!baseline.has_value())
+        {
+            return ApplicationResult::FAILURE;
+        }
+    }
+
+    Engine* const renderer{
+        Engine::loadHeadlessEngine({parameters.width, parameters.height})
+    };
+    if (renderer == nullptr)
+    {
+        Error("Failed to load headless renderer.");
+        return ApplicationResult::FAILURE;
+    }
+
+    std::vector<SceneResult> results{};
+    for (BenchmarkScene const& scene : scenes)
+    {
+        std::optional<SceneResult> result{
+            runScene(*renderer, scene, parameters)
+        };
+        if (!result.has_value())
+        {
+            renderer->cleanup();
+            return ApplicationResult::FAILURE;
+        }
+        results.push_back(std::move(result).value());
+    }
+
+    renderer->cleanup();
+
+    std::map<std::string, double> const metrics{
+        flattenMetrics(results, parameters.measuredFrames)
+    };
+    if (!writeResults(parameters.outputPath, parameters, results, metrics))
+    {
+        return ApplicationResult::FAILURE;
+    }
+
+    if (!baseline.has_value())
+    {
+        return ApplicationResult::SUCCESS;
+    }
+
+    size_t const regressions{compareMetrics(
+        metrics, baseline.value(), parameters.regressionThreshold
+    )};
+    if (regressions > 0)
+    {
+        Error(fmt::format(
+            "{} metrics regressed by more than {:.1f}%.",
+            regressions,
+            parameters.regressionThreshold * 100.0
+        ));
+        return ApplicationResult::FAILURE;
+    }
+
+    Log(fmt::format(
+        "No regressions against {}.", parameters.baselinePath.value()
+    ));
+    return ApplicationResult::SUCCESS;
+}
@@ -1,5 +1,20 @@
 #include "buffers.hpp"
+#include "gpuprofiler.hpp"
 #include "helpers.hpp"
+#include "vertexpacking.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+template <typename T>
+auto copyToBytes(std::vector<T> const& values) -> std::vector<uint8_t>
+{
+    auto const* const bytes{reinterpret_cast<uint8_t const*>(values.data())};
+    return std::vector<uint8_t>(bytes, bytes + values.size() * sizeof(T));
+}
+} // namespace
 
 auto AllocatedBuffer::allocate(
     VkDevice const device,
@@ -69,6 +84,7 @@ void StagedBuffer::recordCopyToDevice(
     vkCmdCopyBuffer(
         cmd, m_stagingBuffer.buffer, m_deviceBuffer.buffer, 1, &copyInfo
     );
+    GPUProfiler::countWork(WorkCounters{.bytesCopied = m_stagedSizeBytes});
 
     m_deviceSizeBytes = m_stagedSizeBytes;
 }
@@ -104,6 +120,14 @@ void StagedBuffer::pushStagedBytes(std::span<uint8_t const> const data)
     m_stagedSizeBytes += data.size_bytes();
 }
 
+void StagedBuffer::resizeStagedBytes(VkDeviceSize const size)
+{
+    assert(size <= m_stagingBuffer.info.size);
+
+    markDirty(true);
+    m_stagedSizeBytes = size;
+}
+
 void StagedBuffer::popStagedBytes(size_t const count)
 {
     markDirty(true);
@@ -204,4 +228,259 @@ void StagedBuffer::recordTotalCopyBarrier(
     };
 
     vkCmdPipelineBarrier2(cmd, &transformsDependency);
+    GPUProfiler::countWork(WorkCounters{.barriers = 1});
+}
+
+auto StagedMeshUpload::stage(
+    VkDevice const device,
+    VmaAllocator const allocator,
+    std::span<uint32_t const> const indices,
+    std::span<uint8_t const> const vertexBytes,
+    VertexEncoding const& encoding,
+    std::span<gputypes::Meshlet const> const meshlets
+) -> std::optional<StagedMeshUpload>
+{
+    // Vulkan does not allow empty buffers
+    if (indices.empty() || vertexBytes.empty())
+    {
+        Warning("Mesh upload failed: The mesh has no indices or vertices.");
+        return std::nullopt;
+    }
+
+    // 0xFFFF is reserved as the primitive restart value, so 16-bit indices
+    // can only address one fewer vertex.
+    uint32_t constexpr INDEX_16_LIMIT{std::numeric_limits<uint16_t>::max()};
+
+    bool const fitsIn16Bits{std::all_of(
+        indices.begin(),
+        indices.end(),
+        [&](uint32_t const index) { return index < INDEX_16_LIMIT; }
+    )};
+
+    std::vector<uint16_t> narrowedIndices{};
+    VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+    std::span<uint8_t const> indexBytes(
+        reinterpret_cast<uint8_t const*>(indices.data()), indices.size_bytes()
+    );
+    if (fitsIn16Bits)
+    {
+        narrowedIndices.assign(indices.begin(), indices.end());
+        indexType = VK_INDEX_TYPE_UINT16;
+        indexBytes = std::span<uint8_t const>(
+            reinterpret_cast<uint8_t const*>(narrowedIndices.data()),
+            narrowedIndices.size() * sizeof(uint16_t)
+        );
+    }
+
+    // Depth only passes read just the positions, which saves most of the
+    // bandwidth of fetching whole vertices.
+    std::vector<uint8_t> positionBytes{};
+    if (encoding.format == VertexFormat::PACKED)
+    {
+        positionBytes = copyToBytes(vertexpacking::extractPackedPositions(
+            std::span<PackedVertex const>(
+                reinterpret_cast<PackedVertex const*>(vertexBytes.data()),
+                vertexBytes.size() / sizeof(PackedVertex)
+            )
+        ));
+    }
+    else
+    {
+        positionBytes = copyToBytes(vertexpacking::extractPositions(
+            std::span<Vertex const>(
+                reinterpret_cast<Vertex const*>(vertexBytes.data()),
+                vertexBytes.size() / sizeof(Vertex)
+            )
+        ));
+    }
+
+    // Allocate buffer
+
+    size_t const indexBufferSize{indexBytes.size_bytes()};
+    size_t const vertexBufferSize{vertexBytes.size_bytes()};
+    size_t const positionBufferSize{positionBytes.size()};
+    size_t const meshletBufferSize{meshlets.size_bytes()};
+
+    AllocatedBuffer indexBuffer{AllocatedBuffer::allocate(
+        device,
+        allocator,
+        indexBufferSize,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        0
+    )};
+
+    AllocatedBuffer vertexBuffer{AllocatedBuffer::allocate(
+        device,
+        allocator,
+        vertexBufferSize,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        0
+    )};
+
+    AllocatedBuffer positionBuffer{AllocatedBuffer::allocate(
+        device,
+        allocator,
+        positionBufferSize,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        0
+    )};
+
+    // A mesh with fewer than three indices has no meshlets, but still needs
+    // its other buffers.
+    AllocatedBuffer meshletBuffer{
+        meshletBufferSize > 0
+            ? AllocatedBuffer::allocate(
+                device,
+                allocator,
+                meshletBufferSize,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                    | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                    | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY,
+                0
+            )
+            : AllocatedBuffer{}
+    };
+
+    // Copy data into buffer
+
+    std::unique_ptr<AllocatedBuffer> stagingBuffer{
+        std::make_unique<AllocatedBuffer>(AllocatedBuffer::allocate(
+            device,
+            allocator,
+            vertexBufferSize + positionBufferSize + indexBufferSize
+                + meshletBufferSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_CPU_ONLY,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT
+        ))
+    };
+
+    uint8_t* const data{
+        reinterpret_cast<uint8_t*>(stagingBuffer->allocation->GetMappedData())
+    };
+
+    if (data == nullptr)
+    {
+        Warning("Mesh upload failed: Pointer to staging buffer was nullptr.");
+        return std::nullopt;
+    }
+
+    // The staging buffer holds vertices, positions, indices, then meshlets.
+    size_t const positionOffset{vertexBufferSize};
+    size_t const indexOffset{positionOffset + positionBufferSize};
+    size_t const meshletOffset{indexOffset + indexBufferSize};
+
+    memcpy(data, vertexBytes.data(), vertexBufferSize);
+    memcpy(data + positionOffset, positionBytes.data(), positionBufferSize);
+    memcpy(data + indexOffset, indexBytes.data(), indexBufferSize);
+    if (meshletBufferSize > 0)
+    {
+        memcpy(data + meshletOffset, meshlets.data(), meshletBufferSize);
+    }
+
+    return StagedMeshUpload{
+        .meshBuffers = std::make_unique<GPUMeshBuffers>(
+            std::move(indexBuffer),
+            indexType,
+            std::move(vertexBuffer),
+            std::move(positionBuffer),
+            encoding,
+            std::move(meshletBuffer),
+            static_cast<uint32_t>(meshlets.size())
+        ),
+        .stagingBuffer = std::move(stagingBuffer),
+        .vertexBytes = vertexBufferSize,
+        .positionBytes = positionBufferSize,
+        .indexBytes = indexBufferSize,
+        .meshletBytes = meshletBufferSize,
+    };
+}
+
+void StagedMeshUpload::recordCopy(VkCommandBuffer const cmd) const
+{
+    VkBufferCopy const vertexCopy{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = vertexBytes,
+    };
+    vkCmdCopyBuffer(
+        cmd,
+        stagingBuffer->buffer,
+        meshBuffers->vertexBuffer(),
+        1,
+        &vertexCopy
+    );
+
+    VkBufferCopy const positionCopy{
+        .srcOffset = vertexBytes,
+        .dstOffset = 0,
+        .size = positionBytes,
+    };
+    vkCmdCopyBuffer(
+        cmd,
+        stagingBuffer->buffer,
+        meshBuffers->positionBuffer(),
+        1,
+        &positionCopy
+    );
+
+    VkBufferCopy const indexCopy{
+        .srcOffset = vertexBytes + positionBytes,
+        .dstOffset = 0,
+        .size = indexBytes,
+    };
+    vkCmdCopyBuffer(
+        cmd, stagingBuffer->buffer, meshBuffers->indexBuffer(), 1, &indexCopy
+    );
+
+    if (meshletBytes > 0)
+    {
+        VkBufferCopy const meshletCopy{
+            .srcOffset = vertexBytes + positionBytes + indexBytes,
+            .dstOffset = 0,
+            .size = meshletBytes,
+        };
+        vkCmdCopyBuffer(
+            cmd,
+            stagingBuffer->buffer,
+            meshBuffers->meshletBuffer(),
+            1,
+            &meshletCopy
+        );
+    }
+
+    VkMemoryBarrier2 const copyBarrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+
+        .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT,
+    };
+
+    VkDependencyInfo const dependency{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pNext = nullptr,
+
+        .dependencyFlags = 0,
+
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &copyBarrier,
+
+        .bufferMemoryBarrierCount = 0,
+        .pBufferMemoryBarriers = nullptr,
+
+        .imageMemoryBarrierCount = 0,
+        .pImageMemoryBarriers = nullptr,
+    };
+
+    vkCmdPipelineBarrier2(cmd, &dependency);
 }
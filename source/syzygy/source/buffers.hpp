@@ -1,6 +1,7 @@
 #pragma once
 
 #include "enginetypes.hpp"
+#include "gputypes.hpp"
 
 #include "helpers.hpp"
 
@@ -87,6 +88,10 @@ struct StagedBuffer
     void pushStagedBytes(std::span<uint8_t const> data);
     void popStagedBytes(size_t count);
 
+    // Sets the staged size without writing, so the mapped memory can be
+    // filled in place. New bytes hold whatever was staged there before.
+    void resizeStagedBytes(VkDeviceSize size);
+
     // This zeroes out the size flags, and leaves the memory as-is.
     void clearStaged();
     // This zeroes out the size flags, and leaves the memory as-is.
@@ -167,6 +172,10 @@ template <typename T> struct TStagedBuffer : public StagedBuffer
         StagedBuffer::pushStagedBytes(bytes);
     }
     void pop(size_t count) { StagedBuffer::popStagedBytes(count * sizeof(T)); }
+    void resizeStaged(size_t count)
+    {
+        StagedBuffer::resizeStagedBytes(count * sizeof(T));
+    }
 
     // These values may be out of date, and not the values used by the GPU
     // upon command execution.
@@ -229,10 +238,21 @@ struct GPUMeshBuffers
     GPUMeshBuffers() = delete;
 
     explicit GPUMeshBuffers(
-        AllocatedBuffer&& indexBuffer, AllocatedBuffer&& vertexBuffer
+        AllocatedBuffer&& indexBuffer,
+        VkIndexType const indexType,
+        AllocatedBuffer&& vertexBuffer,
+        AllocatedBuffer&& positionBuffer,
+        VertexEncoding const vertexEncoding,
+        AllocatedBuffer&& meshletBuffer,
+        uint32_t const meshletCount
     )
         : m_indexBuffer(std::move(indexBuffer))
+        , m_indexType(indexType)
         , m_vertexBuffer(std::move(vertexBuffer))
+        , m_positionBuffer(std::move(positionBuffer))
+        , m_vertexEncoding(vertexEncoding)
+        , m_meshletBuffer(std::move(meshletBuffer))
+        , m_meshletCount(meshletCount)
     {
     }
 
@@ -248,11 +268,67 @@ struct GPUMeshBuffers
 
     VkDeviceAddress indexAddress() { return m_indexBuffer.deviceAddress; }
     VkBuffer indexBuffer() { return m_indexBuffer.buffer; }
+    VkIndexType indexType() const { return m_indexType; }
 
     VkDeviceAddress vertexAddress() { return m_vertexBuffer.deviceAddress; }
     VkBuffer vertexBuffer() { return m_vertexBuffer.buffer; }
 
+    // Only the position of each vertex, in the same order. Full vertices
+    // store a vec3 as three floats, packed vertices their quantized uvec2.
+    VkDeviceAddress positionAddress() { return m_positionBuffer.deviceAddress; }
+    VkBuffer positionBuffer() { return m_positionBuffer.buffer; }
+
+    VertexEncoding vertexEncoding() const { return m_vertexEncoding; }
+
+    // Holds gputypes::Meshlet for every surface of the mesh.
+    VkDeviceAddress meshletAddress() { return m_meshletBuffer.deviceAddress; }
+    VkBuffer meshletBuffer() { return m_meshletBuffer.buffer; }
+    uint32_t meshletCount() const { return m_meshletCount; }
+
+    // The device memory held across all of the buffers.
+    VkDeviceSize allocatedBytes() const
+    {
+        return m_indexBuffer.info.size + m_vertexBuffer.info.size
+             + m_positionBuffer.info.size + m_meshletBuffer.info.size;
+    }
+
 private:
     AllocatedBuffer m_indexBuffer{};
+    VkIndexType m_indexType{VK_INDEX_TYPE_UINT32};
+
     AllocatedBuffer m_vertexBuffer{};
+    AllocatedBuffer m_positionBuffer{};
+    VertexEncoding m_vertexEncoding{};
+
+    AllocatedBuffer m_meshletBuffer{};
+    uint32_t m_meshletCount{0};
+};
+
+// The device buffers for a mesh, alongside a filled staging buffer that has yet
+// to be copied into them. Staging only touches the allocator, so it can be
+// done off of the thread that records commands.
+struct StagedMeshUpload
+{
+    std::unique_ptr<GPUMeshBuffers> meshBuffers{};
+    std::unique_ptr<AllocatedBuffer> stagingBuffer{};
+
+    size_t vertexBytes{0};
+    size_t positionBytes{0};
+    size_t indexBytes{0};
+    size_t meshletBytes{0};
+
+    // Indices are stored as 16 bits when every value fits. A position only
+    // stream is derived from the vertices, based on their encoding.
+    static std::optional<StagedMeshUpload> stage(
+        VkDevice device,
+        VmaAllocator allocator,
+        std::span<uint32_t const> indices,
+        std::span<uint8_t const> vertexBytes,
+        VertexEncoding const& encoding,
+        std::span<gputypes::Meshlet const> meshlets
+    );
+
+    // Copies into the mesh buffers, with a barrier so that any later commands
+    // on the queue can read them.
+    void recordCopy(VkCommandBuffer cmd) const;
 };
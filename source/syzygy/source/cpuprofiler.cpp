@@ -0,0 +1,352 @@
+#include "cpuprofiler.hpp"
+
+#include "helpers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+struct Zone
+{
+    char const* name{nullptr};
+    int64_t begin{0};
+    int64_t end{0};
+};
+
+// Written only by its own thread. Readers copy a range and then drop any
+// zones the writer may have overwritten meanwhile, so neither side locks.
+struct ThreadBuffer
+{
+    static size_t constexpr CAPACITY{1 << 16};
+
+    std::array<Zone, CAPACITY> zones{};
+    std::atomic<uint64_t> written{0};
+
+    uint32_t threadID{0};
+    std::string name{};
+};
+
+struct ThreadBuffers
+{
+    // Only taken when a thread records its first zone, is named, or exits
+    std::mutex mutex{};
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers{};
+
+    // Buffers of exited threads, which new threads take before allocating
+    std::vector<ThreadBuffer*> freeBuffers{};
+
+    std::atomic<bool> exportOnExit{false};
+};
+
+auto threadBuffers() -> ThreadBuffers&
+{
+    static ThreadBuffers buffers{};
+    return buffers;
+}
+
+auto startTime() -> std::chrono::steady_clock::time_point
+{
+    static std::chrono::steady_clock::time_point const start{
+        std::chrono::steady_clock::now()
+    };
+    return start;
+}
+
+// Returns the thread's buffer to the free list when the thread exits. Each
+// buffer is about a megabyte and a half, so pools that start and stop threads
+// would otherwise keep growing. The zone count keeps climbing across owners,
+// so readers never mistake a new owner's zones for ones they already read,
+// and the previous owner's zones stay exportable until overwritten.
+struct ThreadBufferLease
+{
+    ThreadBuffer* buffer{nullptr};
+
+    ThreadBufferLease() = default;
+    ThreadBufferLease(ThreadBufferLease const& other) = delete;
+    ThreadBufferLease& operator=(ThreadBufferLease const& other) = delete;
+
+    ~ThreadBufferLease()
+    {
+        if (buffer == nullptr)
+        {
+            return;
+        }
+
+        ThreadBuffers& buffers{threadBuffers()};
+        std::lock_guard const lock{buffers.mutex};
+        buffers.freeBuffers.push_back(buffer);
+    }
+};
+
+auto currentThreadBuffer() -> ThreadBuffer&
+{
+    thread_local ThreadBufferLease lease{};
+    if (lease.buffer == nullptr)
+    {
+        ThreadBuffers& buffers{threadBuffers()};
+        std::lock_guard const lock{buffers.mutex};
+
+        if (!buffers.freeBuffers.empty())
+        {
+            lease.buffer = buffers.freeBuffers.back();
+            buffers.freeBuffers.pop_back();
+        }
+        else
+        {
+            auto newBuffer{std::make_unique<ThreadBuffer>()};
+            newBuffer->threadID = static_cast<uint32_t>(buffers.buffers.size());
+
+            lease.buffer = newBuffer.get();
+            buffers.buffers.push_back(std::move(newBuffer));
+        }
+        lease.buffer->name = fmt::format("Thread {}", lease.buffer->threadID);
+    }
+    return *lease.buffer;
+}
+
+// Copies the zones from the first index onwards that are still in the ring,
+// and returns the index after the last one copied.
+auto copyZones(
+    ThreadBuffer const& buffer, uint64_t const first, std::vector<Zone>& zones
+) -> uint64_t
+{
+    zones.clear();
+
+    uint64_t const end{buffer.written.load(std::memory_order_acquire)};
+    uint64_t const begin{std::max(
+        first, end > ThreadBuffer::CAPACITY ? end - ThreadBuffer::CAPACITY : 0
+    )};
+
+    zones.reserve(end > begin ? end - begin : 0);
+    for (uint64_t index{begin}; index < end; index++)
+    {
+        zones.push_back(buffer.zones[index % ThreadBuffer::CAPACITY]);
+    }
+
+    // Drop the oldest zones if the writer lapped them during the copy. The
+    // zone at endAfterCopy may be partially written already, and it shares
+    // a slot with the zone a whole ring before it.
+    uint64_t const endAfterCopy{
+        buffer.written.load(std::memory_order_acquire)
+    };
+    uint64_t const firstIntact{
+        endAfterCopy + 1 > ThreadBuffer::CAPACITY
+            ? endAfterCopy + 1 - ThreadBuffer::CAPACITY
+            : 0
+    };
+    if (firstIntact > begin)
+    {
+        zones.erase(
+            zones.begin(),
+            zones.begin()
+                + static_cast<std::ptrdiff_t>(
+                    std::min(firstIntact - begin, zones.size())
+                )
+        );
+    }
+
+    return std::max(end, begin);
+}
+} // namespace
+
+auto CPUProfiler::now() -> int64_t
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - startTime()
+    )
+        .count();
+}
+
+void CPUProfiler::setThreadName(std::string const& name)
+{
+    ThreadBuffer& buffer{currentThreadBuffer()};
+
+    std::lock_guard const lock{threadBuffers().mutex};
+    buffer.name = name;
+}
+
+void CPUProfiler::recordZone(
+    char const* const name, int64_t const begin, int64_t const end
+)
+{
+    ThreadBuffer& buffer{currentThreadBuffer()};
+
+    uint64_t const index{buffer.written.load(std::memory_order_relaxed)};
+    buffer.zones[index % ThreadBuffer::CAPACITY] = Zone{
+        .name = name,
+        .begin = begin,
+        .end = end,
+    };
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+auto CPUProfiler::exportChromeTrace(std::filesystem::path const& path) -> bool
+{
+    std::error_code error{};
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        Warning(fmt::format("Unable to write CPU trace to {}", path.string()));
+        return false;
+    }
+
+    size_t zoneCount{0};
+    bool firstEvent{true};
+    auto const writeEvent{
+        [&](std::string const& event)
+        {
+            file << (firstEvent ? "\n" : ",\n") << event;
+            firstEvent = false;
+        }
+    };
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    std::vector<Zone> zones{};
+    ThreadBuffers& buffers{threadBuffers()};
+    std::lock_guard const lock{buffers.mutex};
+    for (std::unique_ptr<ThreadBuffer> const& buffer : buffers.buffers)
+    {
+        writeEvent(fmt::format(
+            "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},"
+            "\"args\":{{\"name\":\"{}\"}}}}",
+            buffer->threadID,
+            EscapeJSON(buffer->name)
+        ));
+
+        // Trace timestamps are in microseconds
+        copyZones(*buffer, 0, zones);
+        for (Zone const& zone : zones)
+        {
+            writeEvent(fmt::format(
+                "{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},"
+                "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                EscapeJSON(zone.name),
+                buffer->threadID,
+                static_cast<double>(zone.begin) / 1000.0,
+                static_cast<double>(zone.end - zone.begin) / 1000.0
+            ));
+            zoneCount += 1;
+        }
+    }
+
+    file << "\n]}\n";
+
+    Log(fmt::format("Exported {} CPU zones to {}", zoneCount, path.string()));
+    return true;
+}
+
+void CPUProfiler::setExportOnExit(bool const exportOnExit)
+{
+    threadBuffers().exportOnExit.store(exportOnExit);
+}
+
+auto CPUProfiler::exportOnExit() -> bool
+{
+    return threadBuffers().exportOnExit.load();
+}
+
+void CPUZoneCollector::reset()
+{
+    m_sinceNanoseconds = CPUProfiler::now();
+    m_zones.clear();
+
+    ThreadBuffers& buffers{threadBuffers()};
+    std::lock_guard const lock{buffers.mutex};
+    m_threadCursors.resize(buffers.buffers.size());
+    for (std::unique_ptr<ThreadBuffer> const& buffer : buffers.buffers)
+    {
+        m_threadCursors[buffer->threadID] =
+            buffer->written.load(std::memory_order_acquire);
+    }
+}
+
+void CPUZoneCollector::update()
+{
+    std::vector<Zone> zones{};
+
+    ThreadBuffers& buffers{threadBuffers()};
+    std::lock_guard const lock{buffers.mutex};
+
+    // Threads that started since the last update are read from the start
+    m_threadCursors.resize(buffers.buffers.size(), 0);
+    for (std::unique_ptr<ThreadBuffer> const& buffer : buffers.buffers)
+    {
+        uint64_t& cursor{m_threadCursors[buffer->threadID]};
+        cursor = copyZones(*buffer, cursor, zones);
+
+        for (Zone const& zone : zones)
+        {
+            if (zone.begin < m_sinceNanoseconds)
+            {
+                continue;
+            }
+
+            double const milliseconds{
+                static_cast<double>(zone.end - zone.begin) / 1'000'000.0
+            };
+
+            CPUProfiler::ZoneStatistics& statistics{m_zones[zone.name]};
+            if (statistics.calls == 0)
+            {
+                statistics.minMilliseconds = milliseconds;
+                statistics.maxMilliseconds = milliseconds;
+            }
+
+            statistics.calls += 1;
+            statistics.totalMilliseconds += milliseconds;
+            statistics.minMilliseconds =
+                std::min(statistics.minMilliseconds, milliseconds);
+            statistics.maxMilliseconds =
+                std::max(statistics.maxMilliseconds, milliseconds);
+        }
+    }
+}
+
+auto CPUZoneCollector::statistics() const
+    -> std::vector<CPUProfiler::ZoneStatistics>
+{
+    std::map<std::string, CPUProfiler::ZoneStatistics> statisticsByName{};
+    for (auto const& [name, zone] : m_zones)
+    {
+        CPUProfiler::ZoneStatistics& statistics{statisticsByName[name]};
+        if (statistics.calls == 0)
+        {
+            statistics = zone;
+            statistics.name = name;
+            continue;
+        }
+
+        statistics.calls += zone.calls;
+        statistics.totalMilliseconds += zone.totalMilliseconds;
+        statistics.minMilliseconds =
+            std::min(statistics.minMilliseconds, zone.minMilliseconds);
+        statistics.maxMilliseconds =
+            std::max(statistics.maxMilliseconds, zone.maxMilliseconds);
+    }
+
+    std::vector<CPUProfiler::ZoneStatistics> result{};
+    result.reserve(statisticsByName.size());
+    for (auto& [name, statistics] : statisticsByName)
+    {
+        result.push_back(std::move(statistics));
+    }
+    std::sort(
+        result.begin(),
+        result.end(),
+        [](CPUProfiler::ZoneStatistics const& lhs,
+           CPUProfiler::ZoneStatistics const& rhs)
+        { return lhs.totalMilliseconds > rhs.totalMilliseconds; }
+    );
+
+    return result;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Records nested zones of CPU time on any thread. Each thread writes into its
+// own fixed-size ring of zones without locking, so only the most recent zones
+// of each thread are kept, and rings of exited threads are reused by new
+// ones. Zones are named by string literals, such as __func__, and are only
+// recorded when the build enables profiling.
+class CPUProfiler
+{
+public:
+    struct ZoneStatistics
+    {
+        std::string name{};
+        size_t calls{0};
+
+        double totalMilliseconds{0.0};
+        double minMilliseconds{0.0};
+        double maxMilliseconds{0.0};
+
+        double meanMilliseconds() const
+        {
+            return calls > 0 ? totalMilliseconds / static_cast<double>(calls)
+                             : 0.0;
+        }
+    };
+
+    // Nanoseconds since the profiler started, on the clock zones use.
+    static int64_t now();
+
+    // Labels the calling thread in exported traces.
+    static void setThreadName(std::string const& name);
+
+    // The name must outlive the profiler, such as a string literal.
+    static void recordZone(char const* name, int64_t begin, int64_t end);
+
+    // Writes the recorded zones of every thread in the Chrome trace event
+    // format, which chrome://tracing and Perfetto can open.
+    static bool exportChromeTrace(std::filesystem::path const& path);
+
+    static void setExportOnExit(bool exportOnExit);
+    static bool exportOnExit();
+};
+
+// Totals zones across threads incrementally, so it can be polled every frame.
+// Each update reads only the zones recorded since the previous one, and zones
+// that a thread overwrote in between are missed.
+class CPUZoneCollector
+{
+public:
+    // Forgets the totals, and only counts zones beginning from now on.
+    void reset();
+
+    // Adds the zones recorded since the previous update or reset.
+    void update();
+
+    // Totals since the last reset, sorted by total time.
+    std::vector<CPUProfiler::ZoneStatistics> statistics() const;
+
+private:
+    int64_t m_sinceNanoseconds{0};
+
+    // How many zones of each thread were read, indexed by thread ID
+    std::vector<uint64_t> m_threadCursors{};
+
+    // Keyed by the name's address, which is cheap to hash. The same literal
+    // may have several addresses, which are merged into one when read.
+    std::unordered_map<char const*, CPUProfiler::ZoneStatistics> m_zones{};
+};
+
+// Records a zone spanning its lifetime. Use the macros below, so zones compile
+// out when profiling is disabled.
+class CPUProfileZone
+{
+public:
+    explicit CPUProfileZone(char const* const name)
+        : m_name(name)
+        , m_begin(CPUProfiler::now())
+    {
+    }
+    ~CPUProfileZone()
+    {
+        CPUProfiler::recordZone(m_name, m_begin, CPUProfiler::now());
+    }
+
+    CPUProfileZone(CPUProfileZone const& other) = delete;
+    CPUProfileZone& operator=(CPUProfileZone const& other) = delete;
+
+private:
+    char const* m_name;
+    int64_t m_begin;
+};
+
+#define VKR_CONCAT_INNER(a, b) a##b
+#define VKR_CONCAT(a, b) VKR_CONCAT_INNER(a, b)
+
+#if VKRENDERER_COMPILE_WITH_PROFILING
+#define VKR_PROFILE_ZONE(name)                                                 \
+    CPUProfileZone const VKR_CONCAT(profileZone, __LINE__) { name }
+#else
+#define VKR_PROFILE_ZONE(name)
+#endif
+
+#define VKR_PROFILE_FUNCTION() VKR_PROFILE_ZONE(__func__)
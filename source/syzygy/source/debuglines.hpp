@@ -17,6 +17,9 @@ public:
     bool enabled{false};
     float lineWidth{1.0};
 
+    // Whether lines are hidden behind the scene's geometry.
+    bool occluded{false};
+
 public:
     // NOLINTBEGIN(readability-make-member-function-const): Manual propagation
     // of const-correctness
@@ -1,9 +1,39 @@
 #include "deferred.hpp"
 
+#include "../gpuprofiler.hpp"
 #include "../initializers.hpp"
+#include "../meshlod.hpp"
 
 namespace
 {
+uint32_t constexpr LIGHT_CAPACITY{DeferredShadingPipeline::LIGHT_CAPACITY};
+
+// Specialization constant IDs in directional_light.comp
+uint32_t constexpr LIGHTING_SHADOWS_ENABLED_ID{0};
+uint32_t constexpr LIGHTING_MAX_DIRECTIONAL_LIGHTS_ID{1};
+uint32_t constexpr LIGHTING_MAX_SPOT_LIGHTS_ID{2};
+
+// Specialization constant IDs in sky.comp
+uint32_t constexpr SKY_VIEW_SAMPLE_COUNT_ID{0};
+uint32_t constexpr SKY_LIGHT_SAMPLE_COUNT_ID{1};
+
+// Rounds a light count up to the next power of two, so only a handful of
+// variants are ever compiled as lights come and go.
+auto lightCountBucket(size_t const count) -> uint32_t
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint32_t bucket{1};
+    while (bucket < count && bucket < LIGHT_CAPACITY)
+    {
+        bucket *= 2;
+    }
+    return bucket;
+}
+
 void validatePushConstant(
     ShaderObjectReflected const& shaderObject, size_t const expectedSize
 )
@@ -38,21 +68,11 @@ void validatePushConstant(
     }
 }
 
-auto loadShader(
-    VkDevice const device,
-    std::string const& path,
-    VkShaderStageFlagBits const stage,
-    VkShaderStageFlags const nextStage,
-    std::span<VkDescriptorSetLayout const> const descriptorSets,
+auto takeShader(
+    std::optional<ShaderObjectReflected> const& loadResult,
     size_t const expectedPushConstantSize
 ) -> ShaderObjectReflected
 {
-    std::optional<ShaderObjectReflected> const loadResult{
-        vkutil::loadShaderObject(
-            device, path, stage, nextStage, descriptorSets, {}
-        )
-    };
-
     if (loadResult.has_value())
     {
         validatePushConstant(loadResult.value(), expectedPushConstantSize);
@@ -62,27 +82,6 @@ auto loadShader(
     return ShaderObjectReflected::makeInvalid();
 }
 
-auto loadShader(
-    VkDevice const device,
-    std::string const& path,
-    VkShaderStageFlagBits const stage,
-    VkShaderStageFlags const nextStage,
-    std::span<VkDescriptorSetLayout const> const descriptorSets,
-    VkPushConstantRange const rangeOverride
-) -> ShaderObjectReflected
-{
-    std::optional<ShaderObjectReflected> loadResult{vkutil::loadShaderObject(
-        device, path, stage, nextStage, descriptorSets, rangeOverride, {}
-    )};
-    if (loadResult.has_value())
-    {
-        validatePushConstant(loadResult.value(), rangeOverride.size);
-        return loadResult.value();
-    }
-
-    return ShaderObjectReflected::makeInvalid();
-}
-
 auto createLayout(
     VkDevice const device,
     std::span<VkDescriptorSetLayout const> const setLayouts,
@@ -116,10 +115,13 @@ auto createLayout(
 } // namespace
 
 DeferredShadingPipeline::DeferredShadingPipeline(
+    VkPhysicalDevice const physicalDevice,
     VkDevice const device,
     VmaAllocator const allocator,
     DescriptorAllocator& descriptorAllocator,
-    VkExtent2D const dimensionCapacity
+    VkExtent2D const dimensionCapacity,
+    VkDescriptorSetLayout const texturesLayout,
+    PipelineCompiler& compiler
 )
 {
     m_allocator = allocator;
@@ -139,8 +141,6 @@ DeferredShadingPipeline::DeferredShadingPipeline(
     }
 
     { // Lights used during the pass
-        VkDeviceSize constexpr LIGHT_CAPACITY{16};
-
         m_directionalLights =
             std::make_unique<TStagedBuffer<gputypes::LightDirectional>>(
                 TStagedBuffer<gputypes::LightDirectional>::allocate(
@@ -258,6 +258,10 @@ DeferredShadingPipeline::DeferredShadingPipeline(
             descriptorAllocator.allocate(device, m_depthImageLayout);
     }
 
+    m_meshletCullPass = std::make_unique<MeshletCullPass>(
+        physicalDevice, device, allocator
+    );
+
     uint32_t constexpr SHADOWMAP_SIZE{8192};
     size_t constexpr SHADOWMAP_COUNT{10};
 
@@ -276,91 +280,111 @@ DeferredShadingPipeline::DeferredShadingPipeline(
         )
             .value();
 
-    { // GBuffer pipelines
-        VkPushConstantRange const graphicsPushConstantRange{
-            .stageFlags =
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-            .offset = 0,
-            .size = sizeof(GBufferVertexPushConstant),
+    VkPushConstantRange const graphicsPushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        .offset = 0,
+        .size = sizeof(GBufferVertexPushConstant),
+    };
+    VkPushConstantRange const lightingPassPushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(LightingPassComputePushConstant),
+    };
+    VkPushConstantRange const skyPassPushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(SkyPassComputePushConstant),
+    };
+
+    std::vector<VkDescriptorSetLayout> const gBufferDescriptorSets{
+        texturesLayout
+    };
+    std::vector<VkDescriptorSetLayout> const lightingPassDescriptorSets{
+        m_drawImageLayout,
+        m_gBuffer.descriptorLayout,
+        m_shadowPassArray.samplerSetLayout(),
+        m_shadowPassArray.texturesSetLayout()
+    };
+    std::vector<VkDescriptorSetLayout> const skyPassDescriptorSets{
+        m_drawImageLayout, m_depthImageLayout
+    };
+
+    { // Shaders, compiled together as one batch
+        std::array<vkutil::ShaderObjectLoadInfo, 4> const loadInfos{
+            vkutil::ShaderObjectLoadInfo{
+                .path = "shaders/deferred/offscreen.vert.spv",
+                .stage = VK_SHADER_STAGE_VERTEX_BIT,
+                .nextStage = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .layouts = gBufferDescriptorSets,
+                .rangeOverride = graphicsPushConstantRange,
+            },
+            vkutil::ShaderObjectLoadInfo{
+                .path = "shaders/deferred/offscreen.frag.spv",
+                .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .nextStage = 0,
+                .layouts = gBufferDescriptorSets,
+                .rangeOverride = graphicsPushConstantRange,
+            },
+            vkutil::ShaderObjectLoadInfo{
+                .path = "shaders/deferred/directional_light.comp.spv",
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .nextStage = 0,
+                .layouts = lightingPassDescriptorSets,
+            },
+            vkutil::ShaderObjectLoadInfo{
+                .path = "shaders/deferred/sky.comp.spv",
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .nextStage = 0,
+                .layouts = skyPassDescriptorSets,
+            },
         };
 
-        m_gBufferVertexShader = loadShader(
-            device,
-            "shaders/deferred/offscreen.vert.spv",
-            VK_SHADER_STAGE_VERTEX_BIT,
-            VK_SHADER_STAGE_FRAGMENT_BIT,
-            {},
-            graphicsPushConstantRange
-        );
+        std::vector<std::optional<ShaderObjectReflected>> const loadResults{
+            vkutil::loadShaderObjects(device, loadInfos)
+        };
 
-        m_gBufferFragmentShader = loadShader(
+        m_gBufferVertexShader =
+            takeShader(loadResults[0], graphicsPushConstantRange.size);
+        m_gBufferFragmentShader =
+            takeShader(loadResults[1], graphicsPushConstantRange.size);
+        m_lightingPassComputeShader =
+            std::make_unique<ShaderObjectPermutations>(
+                device,
+                takeShader(loadResults[2], lightingPassPushConstantRange.size),
+                compiler,
+                loadInfos[2]
+            );
+        m_skyPassComputeShader = std::make_unique<ShaderObjectPermutations>(
             device,
-            "shaders/deferred/offscreen.frag.spv",
-            VK_SHADER_STAGE_FRAGMENT_BIT,
-            0,
-            {},
-            graphicsPushConstantRange
+            takeShader(loadResults[3], skyPassPushConstantRange.size),
+            compiler,
+            loadInfos[3]
         );
-
-        std::vector<VkPushConstantRange> const gBufferPushConstantRanges{
-            VkPushConstantRange{
-                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-                .offset = 0,
-                .size = sizeof(GBufferVertexPushConstant),
-            }
-        };
-        m_gBufferLayout = createLayout(device, {}, gBufferPushConstantRanges);
     }
 
-    { // Lighting pass pipeline
-        std::vector<VkDescriptorSetLayout> const lightingPassDescriptorSets{
-            m_drawImageLayout,
-            m_gBuffer.descriptorLayout,
-            m_shadowPassArray.samplerSetLayout(),
-            m_shadowPassArray.texturesSetLayout()
-        };
+    m_lightingPassTuner = std::make_unique<WorkgroupTuner>(
+        physicalDevice, device, LIGHTING_PASS_NAME
+    );
+    m_skyPassTuner =
+        std::make_unique<WorkgroupTuner>(physicalDevice, device, SKY_PASS_NAME);
 
-        m_lightingPassComputeShader = loadShader(
-            device,
-            "shaders/deferred/directional_light.comp.spv",
-            VK_SHADER_STAGE_COMPUTE_BIT,
-            0,
-            lightingPassDescriptorSets,
-            sizeof(LightingPassComputePushConstant)
+    { // Pipeline layouts
+        std::vector<VkPushConstantRange> const gBufferPushConstantRanges{
+            graphicsPushConstantRange
+        };
+        m_gBufferLayout = createLayout(
+            device, gBufferDescriptorSets, gBufferPushConstantRanges
         );
 
         std::vector<VkPushConstantRange> const lightingPassPushConstantRanges{
-            VkPushConstantRange{
-                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-                .offset = 0,
-                .size = sizeof(LightingPassComputePushConstant),
-            }
+            lightingPassPushConstantRange
         };
         m_lightingPassLayout = createLayout(
             device, lightingPassDescriptorSets, lightingPassPushConstantRanges
         );
-    }
-
-    { // Sky pass pipeline
-        std::vector<VkDescriptorSetLayout> const skyPassDescriptorSets{
-            m_drawImageLayout, m_depthImageLayout
-        };
-
-        m_skyPassComputeShader = loadShader(
-            device,
-            "shaders/deferred/sky.comp.spv",
-            VK_SHADER_STAGE_COMPUTE_BIT,
-            0,
-            skyPassDescriptorSets,
-            sizeof(SkyPassComputePushConstant)
-        );
 
         std::vector<VkPushConstantRange> const skyPassPushConstantRanges{
-            VkPushConstantRange{
-                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-                .offset = 0,
-                .size = sizeof(SkyPassComputePushConstant),
-            }
+            skyPassPushConstantRange
         };
         m_skyPassLayout = createLayout(
             device, skyPassDescriptorSets, skyPassPushConstantRanges
@@ -421,6 +445,45 @@ void setRasterizationShaderObjectState(
 
     vkCmdSetStencilTestEnable(cmd, VK_FALSE);
 }
+
+struct TunedShader
+{
+    VkShaderEXT shader{VK_NULL_HANDLE};
+    WorkgroupSize dispatchSize{};
+
+    // The dispatch uses the tuner's size, so it can be timed
+    bool specialized{false};
+};
+
+auto selectTunedShader(
+    ShaderObjectPermutations& permutations,
+    WorkgroupTuner& tuner,
+    SpecializationConstants constants
+) -> TunedShader
+{
+    tuner.update();
+
+    WorkgroupSize const size{tuner.size()};
+    constants.set(WorkgroupTuner::SIZE_X_CONSTANT_ID, size.x)
+        .set(WorkgroupTuner::SIZE_Y_CONSTANT_ID, size.y);
+
+    VkShaderEXT const shader{permutations.select(constants).shaderObject()};
+
+    CompileStatus const status{permutations.status(constants)};
+    if (status == CompileStatus::FAILED)
+    {
+        tuner.rejectCandidate();
+    }
+
+    // The generic shader stands in at the default size until the variant
+    // is compiled
+    bool const specialized{status == CompileStatus::READY};
+    return TunedShader{
+        .shader = shader,
+        .dispatchSize = specialized ? size : WorkgroupSize{},
+        .specialized = specialized,
+    };
+}
 } // namespace
 
 void DeferredShadingPipeline::recordDrawCommands(
@@ -435,11 +498,14 @@ void DeferredShadingPipeline::recordDrawCommands(
     TStagedBuffer<gputypes::Camera> const& cameras,
     uint32_t const atmosphereIndex,
     TStagedBuffer<gputypes::Atmosphere> const& atmospheres,
-    bool const renderMesh,
-    MeshAsset const& sceneMesh,
-    MeshInstances const& sceneGeometry
+    MeshAsset const* const sceneMesh,
+    MeshInstances const& sceneGeometry,
+    TextureStreamer const& textures,
+    DeletionQueue& frameDeletionQueue
 )
 {
+    bool const renderMesh{sceneMesh != nullptr};
+
     VkPipelineStageFlags2 const bufferStages{
         VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT
         | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT
@@ -456,6 +522,9 @@ void DeferredShadingPipeline::recordDrawCommands(
     sceneGeometry.modelInverseTransposes->recordTotalCopyBarrier(
         cmd, bufferStages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT
     );
+    sceneGeometry.lodSortedIndices->recordTotalCopyBarrier(
+        cmd, bufferStages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+    );
 
     { // Update lights
         if (!directionalLights.empty())
@@ -491,8 +560,12 @@ void DeferredShadingPipeline::recordDrawCommands(
         }
     }
 
+    bool const drawShadows{renderMesh && m_parameters.shadows};
+
     if (renderMesh)
     { // Shadow maps
+        GPUProfileScope const profileScope{cmd, "Shadows"};
+
         m_shadowPassArray.recordInitialize(
             cmd,
             m_parameters.shadowPassParameters,
@@ -500,9 +573,42 @@ void DeferredShadingPipeline::recordDrawCommands(
             m_spotLights->readValidStaged()
         );
 
-        m_shadowPassArray.recordDrawCommands(
-            cmd, sceneMesh, *sceneGeometry.models
-        );
+        if (m_parameters.meshletCulling)
+        { // Views are the main camera, followed by each shadow map
+            gputypes::Camera const& camera{
+                cameras.readValidStaged()[viewCameraIndex]
+            };
+
+            std::vector<gputypes::CullView> cullViews{gputypes::CullView{
+                .projView = camera.projection * camera.view,
+                .position = camera.position,
+            }};
+            for (glm::mat4x4 const& projView :
+                 m_shadowPassArray.projViewMatrices())
+            {
+                cullViews.push_back(gputypes::CullView{
+                    .projView = projView,
+                    .position = glm::vec4{0.0F},
+                });
+            }
+
+            m_meshletCullPass->reserveDraws(
+                *sceneMesh, sceneGeometry, frameDeletionQueue
+            );
+            m_meshletCullPass->recordUploadViews(cmd, cullViews);
+        }
+
+        // Cleared maps are still transitioned for the lighting pass, so the
+        // generic lighting variant sees every fragment as lit.
+        if (drawShadows)
+        {
+            m_shadowPassArray.recordDrawCommands(
+                cmd,
+                *sceneMesh,
+                sceneGeometry,
+                m_parameters.meshletCulling ? m_meshletCullPass.get() : nullptr
+            );
+        }
     }
 
     if (renderMesh)
@@ -524,6 +630,16 @@ void DeferredShadingPipeline::recordDrawCommands(
 
     if (renderMesh)
     { // Deferred GBuffer pass
+        GPUProfileScope const profileScope{cmd, "GBuffer"};
+
+        // Back faces are culled here, so meshlets facing away can be too
+        bool const meshletsCulled{
+            m_parameters.meshletCulling
+            && m_meshletCullPass->recordCull(
+                cmd, 0, true, *sceneMesh, sceneGeometry
+            )
+        };
+
         setRasterizationShaderObjectState(
             cmd, VkRect2D{.extent{drawRect.extent}}
         );
@@ -631,21 +747,43 @@ void DeferredShadingPipeline::recordDrawCommands(
 
         vkCmdBindShadersEXT(cmd, 2, stages.data(), shaders.data());
 
-        GPUMeshBuffers& meshBuffers{*sceneMesh.meshBuffers};
+        VkDescriptorSet const texturesSet{textures.set()};
+        vkCmdBindDescriptorSets(
+            cmd,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            m_gBufferLayout,
+            0,
+            1,
+            &texturesSet,
+            0,
+            nullptr
+        );
 
-        { // Vertex push constant
+        GPUMeshBuffers& meshBuffers{*sceneMesh->meshBuffers};
+
+        { // Vertex and fragment push constant
+            VertexEncoding const encoding{meshBuffers.vertexEncoding()};
             GBufferVertexPushConstant const vertexPushConstant{
                 .vertexBuffer = meshBuffers.vertexAddress(),
                 .modelBuffer = sceneGeometry.models->deviceAddress(),
                 .modelInverseTransposeBuffer =
                     sceneGeometry.modelInverseTransposes->deviceAddress(),
                 .cameraBuffer = cameras.deviceAddress(),
+                .instanceIndexBuffer =
+                    sceneGeometry.lodSortedIndices->deviceAddress(),
                 .cameraIndex = viewCameraIndex,
+                .vertexFormat = encoding.format,
+                .positionMin = glm::vec4{encoding.positionMin, 0.0F},
+                .positionExtent = glm::vec4{encoding.positionExtent, 0.0F},
+                .baseColorFactor = sceneMesh->material.baseColorFactor,
+                .baseColorTexture = textures.bindlessIndex(
+                    sceneMesh->material.baseColorTexture.get()
+                ),
             };
             vkCmdPushConstants(
                 cmd,
                 m_gBufferLayout,
-                VK_SHADER_STAGE_VERTEX_BIT,
+                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 0,
                 sizeof(GBufferVertexPushConstant),
                 &vertexPushConstant
@@ -653,21 +791,47 @@ void DeferredShadingPipeline::recordDrawCommands(
             m_gBufferVertexPushConstant = vertexPushConstant;
         }
 
-        GeometrySurface const& drawnSurface{sceneMesh.surfaces[0]};
+        GeometrySurface const& drawnSurface{sceneMesh->surfaces[0]};
 
         // Bind the entire index buffer of the mesh, but only draw a single
-        // surface.
+        // surface. Each level of detail is its own draw over a contiguous
+        // range of the sorted instances.
         vkCmdBindIndexBuffer(
-            cmd, meshBuffers.indexBuffer(), 0, VK_INDEX_TYPE_UINT32
-        );
-        vkCmdDrawIndexed(
-            cmd,
-            drawnSurface.indexCount,
-            sceneGeometry.models->deviceSize(),
-            drawnSurface.firstIndex,
-            0,
-            0
+            cmd, meshBuffers.indexBuffer(), 0, meshBuffers.indexType()
         );
+        std::span<InstanceRange const> const ranges{
+            lod::surfaceInstanceRanges(sceneGeometry, 0)
+        };
+        for (size_t level{0}; level < ranges.size(); level++)
+        {
+            InstanceRange const& instances{ranges[level]};
+            if (instances.instanceCount == 0)
+            {
+                continue;
+            }
+
+            if (level == 0 && meshletsCulled)
+            {
+                m_meshletCullPass->recordDrawIndirect(cmd);
+                continue;
+            }
+
+            lod::IndexRange const indices{
+                lod::surfaceLODRange(drawnSurface, level)
+            };
+            vkCmdDrawIndexed(
+                cmd,
+                indices.indexCount,
+                instances.instanceCount,
+                indices.firstIndex,
+                drawnSurface.vertexOffset,
+                instances.firstInstance
+            );
+            GPUProfiler::countWork(WorkCounters{
+                .drawCalls = 1,
+                .instances = instances.instanceCount,
+            });
+        }
 
         std::array<VkShaderStageFlagBits, 2> const unboundStages{
             VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT
@@ -741,6 +905,8 @@ void DeferredShadingPipeline::recordDrawCommands(
 
     if (renderMesh)
     { // Lighting pass using GBuffer output
+        GPUProfileScope const profileScope{cmd, "Lighting"};
+
         m_gBuffer.recordTransitionImages(
             cmd,
             VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -751,9 +917,23 @@ void DeferredShadingPipeline::recordDrawCommands(
             cmd, VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL
         );
 
+        SpecializationConstants constants{};
+        constants.setBool(LIGHTING_SHADOWS_ENABLED_ID, drawShadows)
+            .set(
+                LIGHTING_MAX_DIRECTIONAL_LIGHTS_ID,
+                lightCountBucket(m_directionalLights->deviceSize())
+            )
+            .set(
+                LIGHTING_MAX_SPOT_LIGHTS_ID,
+                lightCountBucket(m_spotLights->deviceSize())
+            );
+
+        TunedShader const tunedShader{selectTunedShader(
+            *m_lightingPassComputeShader, *m_lightingPassTuner, constants
+        )};
+
         VkShaderStageFlagBits const computeStage{VK_SHADER_STAGE_COMPUTE_BIT};
-        VkShaderEXT const shader{m_lightingPassComputeShader.shaderObject()};
-        vkCmdBindShadersEXT(cmd, 1, &computeStage, &shader);
+        vkCmdBindShadersEXT(cmd, 1, &computeStage, &tunedShader.shader);
 
         std::array<VkDescriptorSet, 4> descriptorSets{
             m_drawImageSet,
@@ -799,22 +979,25 @@ void DeferredShadingPipeline::recordDrawCommands(
             &m_lightingPassPushConstant
         );
 
-        uint32_t constexpr COMPUTE_WORKGROUP_SIZE{16};
+        WorkgroupSize const workgroupSize{tunedShader.dispatchSize};
 
+        m_lightingPassTuner->recordBegin(cmd, tunedShader.specialized);
         vkCmdDispatch(
             cmd,
-            computeDispatchCount(drawRect.extent.width, COMPUTE_WORKGROUP_SIZE),
-            computeDispatchCount(
-                drawRect.extent.height, COMPUTE_WORKGROUP_SIZE
-            ),
+            computeDispatchCount(drawRect.extent.width, workgroupSize.x),
+            computeDispatchCount(drawRect.extent.height, workgroupSize.y),
             1
         );
+        GPUProfiler::countWork(WorkCounters{.dispatches = 1});
+        m_lightingPassTuner->recordEnd(cmd);
 
         VkShaderEXT const unboundHandle{VK_NULL_HANDLE};
         vkCmdBindShadersEXT(cmd, 1, &computeStage, &unboundHandle);
     }
 
     { // Sky post-process pass
+        GPUProfileScope const profileScope{cmd, "Sky"};
+
         vkutil::transitionImage(
             cmd,
             m_drawImage.image,
@@ -831,9 +1014,29 @@ void DeferredShadingPipeline::recordDrawCommands(
             VK_IMAGE_ASPECT_DEPTH_BIT
         );
 
+        SpecializationConstants constants{};
+        switch (m_parameters.skyQuality)
+        {
+        case SkyQuality::LOW:
+            constants.set(SKY_VIEW_SAMPLE_COUNT_ID, 8)
+                .set(SKY_LIGHT_SAMPLE_COUNT_ID, 4);
+            break;
+        case SkyQuality::MEDIUM:
+            constants.set(SKY_VIEW_SAMPLE_COUNT_ID, 12)
+                .set(SKY_LIGHT_SAMPLE_COUNT_ID, 8);
+            break;
+        case SkyQuality::HIGH:
+            constants.set(SKY_VIEW_SAMPLE_COUNT_ID, 16)
+                .set(SKY_LIGHT_SAMPLE_COUNT_ID, 16);
+            break;
+        }
+
+        TunedShader const tunedShader{selectTunedShader(
+            *m_skyPassComputeShader, *m_skyPassTuner, constants
+        )};
+
         VkShaderStageFlagBits const computeStage{VK_SHADER_STAGE_COMPUTE_BIT};
-        VkShaderEXT const shader{m_skyPassComputeShader.shaderObject()};
-        vkCmdBindShadersEXT(cmd, 1, &computeStage, &shader);
+        vkCmdBindShadersEXT(cmd, 1, &computeStage, &tunedShader.shader);
 
         std::array<VkDescriptorSet, 2> const descriptorSets{
             m_drawImageSet, m_depthImageSet
@@ -869,16 +1072,17 @@ void DeferredShadingPipeline::recordDrawCommands(
             &m_skyPassPushConstant
         );
 
-        uint32_t constexpr COMPUTE_WORKGROUP_SIZE{16};
+        WorkgroupSize const workgroupSize{tunedShader.dispatchSize};
 
+        m_skyPassTuner->recordBegin(cmd, tunedShader.specialized);
         vkCmdDispatch(
             cmd,
-            computeDispatchCount(drawRect.extent.width, COMPUTE_WORKGROUP_SIZE),
-            computeDispatchCount(
-                drawRect.extent.height, COMPUTE_WORKGROUP_SIZE
-            ),
+            computeDispatchCount(drawRect.extent.width, workgroupSize.x),
+            computeDispatchCount(drawRect.extent.height, workgroupSize.y),
             1
         );
+        GPUProfiler::countWork(WorkCounters{.dispatches = 1});
+        m_skyPassTuner->recordEnd(cmd);
 
         VkShaderEXT const unboundHandle{VK_NULL_HANDLE};
         vkCmdBindShadersEXT(cmd, 1, &computeStage, &unboundHandle);
@@ -948,11 +1152,29 @@ void DeferredShadingPipeline::updateRenderTargetDescriptors(
     vkUpdateDescriptorSets(device, VKR_ARRAY(writes), VKR_ARRAY_NONE);
 }
 
+auto DeferredShadingPipeline::shaderVariantsReady() const -> size_t
+{
+    return m_lightingPassComputeShader->readyCount()
+         + m_skyPassComputeShader->readyCount();
+}
+
+auto DeferredShadingPipeline::shaderVariantsRequested() const -> size_t
+{
+    return m_lightingPassComputeShader->variantCount()
+         + m_skyPassComputeShader->variantCount();
+}
+
+auto DeferredShadingPipeline::tuningWorkgroups() const -> bool
+{
+    return m_lightingPassTuner->tuning() || m_skyPassTuner->tuning();
+}
+
 void DeferredShadingPipeline::cleanup(
     VkDevice const device, VmaAllocator const allocator
 )
 {
     m_shadowPassArray.cleanup(device, allocator);
+    m_meshletCullPass->cleanup(device);
     m_gBuffer.cleanup(device, allocator);
 
     m_directionalLights.reset();
@@ -971,6 +1193,9 @@ void DeferredShadingPipeline::cleanup(
 
     m_gBufferVertexShader.cleanup(device);
     m_gBufferFragmentShader.cleanup(device);
-    m_lightingPassComputeShader.cleanup(device);
-    m_skyPassComputeShader.cleanup(device);
+    m_lightingPassComputeShader->cleanup(device);
+    m_skyPassComputeShader->cleanup(device);
+
+    m_lightingPassTuner->cleanup(device);
+    m_skyPassTuner->cleanup(device);
 }
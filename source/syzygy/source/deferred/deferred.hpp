@@ -2,21 +2,40 @@
 
 #include "../engineparams.hpp"
 #include "../enginetypes.hpp"
+#include "../meshletcull.hpp"
+#include "../pipelinecompiler.hpp"
 #include "../pipelines.hpp"
+#include "../shaderpermutations.hpp"
 #include "../shadowpass.hpp"
+#include "../texturestreamer.hpp"
+#include "../workgrouptuner.hpp"
 
 #include "gbuffer.hpp"
 
 class DeferredShadingPipeline
 {
 public:
+    // Names the passes whose workgroup sizes are tuned and saved
+    static char constexpr LIGHTING_PASS_NAME[]{"deferred_lighting"};
+    static char constexpr SKY_PASS_NAME[]{"deferred_sky"};
+
+    // Of each kind of light. Matches the loop bounds that
+    // directional_light.comp defaults to.
+    static uint32_t constexpr LIGHT_CAPACITY{16};
+
     DeferredShadingPipeline(
+        VkPhysicalDevice physicalDevice,
         VkDevice device,
         VmaAllocator allocator,
         DescriptorAllocator& descriptorAllocator,
-        VkExtent2D dimensionCapacity
+        VkExtent2D dimensionCapacity,
+        VkDescriptorSetLayout texturesLayout,
+        PipelineCompiler& compiler
     );
 
+    // The scene mesh may be null, in which case only the sky and lighting are
+    // drawn. Resources replaced while recording are retired through the
+    // frame's deletion queue.
     void recordDrawCommands(
         VkCommandBuffer cmd,
         VkRect2D drawRect,
@@ -29,20 +48,32 @@ public:
         TStagedBuffer<gputypes::Camera> const& cameras,
         uint32_t atmosphereIndex,
         TStagedBuffer<gputypes::Atmosphere> const& atmospheres,
-        bool renderMesh,
-        MeshAsset const& sceneMesh,
-        MeshInstances const& sceneGeometry
+        MeshAsset const* sceneMesh,
+        MeshInstances const& sceneGeometry,
+        TextureStreamer const& textures,
+        DeletionQueue& frameDeletionQueue
     );
 
     void updateRenderTargetDescriptors(
         VkDevice device, AllocatedImage const& depthImage
     );
 
+    // Variants of the lighting and sky shaders compiled so far, out of those
+    // requested.
+    size_t shaderVariantsReady() const;
+    size_t shaderVariantsRequested() const;
+
+    // Whether any tuned pass is still timing workgroup sizes. Sizes are saved
+    // as soon as tuning finishes.
+    bool tuningWorkgroups() const;
+
     void cleanup(VkDevice device, VmaAllocator allocator);
 
 private:
     ShadowPassArray m_shadowPassArray{};
 
+    std::unique_ptr<MeshletCullPass> m_meshletCullPass{};
+
     AllocatedImage m_drawImage{};
 
     VmaAllocator m_allocator{VK_NULL_HANDLE};
@@ -73,7 +104,17 @@ private:
         VkDeviceAddress modelInverseTransposeBuffer{};
         VkDeviceAddress cameraBuffer{};
 
+        VkDeviceAddress instanceIndexBuffer{};
         uint32_t cameraIndex{0};
+        VertexFormat vertexFormat{VertexFormat::FULL};
+
+        glm::vec4 positionMin{};
+        glm::vec4 positionExtent{};
+
+        // Read by the fragment shader
+        glm::vec4 baseColorFactor{};
+        uint32_t baseColorTexture{TextureStreamer::FALLBACK_INDEX};
+
         uint8_t padding0[12]{};
     };
 
@@ -107,9 +148,11 @@ private:
 
     LightingPassComputePushConstant /* mutable */ m_lightingPassPushConstant{};
 
-    ShaderObjectReflected m_lightingPassComputeShader{
-        ShaderObjectReflected::makeInvalid()
-    };
+    // Specialized by whether shadows are sampled, by the light counts
+    // rounded up to a power of two so the loops can unroll, and by the
+    // workgroup size being tuned or picked
+    std::unique_ptr<ShaderObjectPermutations> m_lightingPassComputeShader{};
+    std::unique_ptr<WorkgroupTuner> m_lightingPassTuner{};
 
     VkPipelineLayout m_lightingPassLayout{VK_NULL_HANDLE};
 
@@ -129,16 +172,35 @@ private:
 
     SkyPassComputePushConstant /* mutable */ m_skyPassPushConstant{};
 
-    ShaderObjectReflected m_skyPassComputeShader{
-        ShaderObjectReflected::makeInvalid()
-    };
+    // Specialized by the ray-marching sample counts of the sky quality, and
+    // by the workgroup size being tuned or picked
+    std::unique_ptr<ShaderObjectPermutations> m_skyPassComputeShader{};
+    std::unique_ptr<WorkgroupTuner> m_skyPassTuner{};
 
     VkPipelineLayout m_skyPassLayout{VK_NULL_HANDLE};
 
 public:
+    enum class SkyQuality
+    {
+        LOW,
+        MEDIUM,
+        HIGH,
+    };
+
     struct Parameters
     {
         ShadowPassParameters shadowPassParameters{};
+
+        // When disabled, shadow maps are not drawn and the lighting pass is
+        // specialized to skip sampling them
+        bool shadows{true};
+
+        SkyQuality skyQuality{SkyQuality::HIGH};
+
+        // Cull the meshlets of full detail instances on the GPU
+        bool meshletCulling{true};
+
+        bool operator==(Parameters const& other) const = default;
     };
     Parameters m_parameters;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "descriptors.hpp"
 #include "helpers.hpp"
+#include "shadercache.hpp"
 
 auto DescriptorLayoutBuilder::addBinding(
     AddBindingParameters const parameters, uint32_t const count
@@ -95,6 +96,8 @@ auto DescriptorLayoutBuilder::build(
         return {};
     }
 
+    ShaderCache::registerSetLayout(set, info, bindingFlags);
+
     return set;
 }
 
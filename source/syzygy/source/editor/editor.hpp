@@ -51,4 +51,6 @@ public:
     static auto create() -> std::optional<Editor>;
 
     auto run() -> EditorResult;
+
+    Engine* renderer() const { return m_renderer; }
 };
\ No newline at end of file
@@ -11,7 +11,9 @@
 
 #include <iostream>
 
+#include <algorithm>
 #include <chrono>
+#include <random>
 #include <thread>
 
 #include <imgui.h>
@@ -21,7 +23,6 @@
 #include <implot.h>
 
 #include <glm/gtc/matrix_inverse.hpp>
-#include <glm/gtc/random.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/transform.hpp>
 
@@ -29,11 +30,15 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
 
+#include "cpuprofiler.hpp"
 #include "descriptors.hpp"
+#include "gpuprofiler.hpp"
 #include "helpers.hpp"
 #include "images.hpp"
 #include "initializers.hpp"
 #include "pipelines.hpp"
+#include "shadercache.hpp"
+#include "shadermanager.hpp"
 
 #include "lights.hpp"
 
@@ -68,7 +73,16 @@ AtmosphereParameters const Engine::m_defaultAtmosphereParameters{
     }
 };
 
-Engine::Engine(PlatformWindow const& window) { init(window); }
+Engine::Engine(PlatformWindow const& window)
+{
+    init(window.handle, window.extent());
+}
+
+Engine::Engine(glm::u16vec2 const headlessExtent)
+{
+    m_headless = true;
+    init(nullptr, headlessExtent);
+}
 
 auto Engine::loadEngine(PlatformWindow const& window) -> Engine*
 {
@@ -86,35 +100,80 @@ auto Engine::loadEngine(PlatformWindow const& window) -> Engine*
     return m_loadedEngine;
 }
 
-void Engine::init(PlatformWindow const& window)
+auto Engine::loadHeadlessEngine(glm::u16vec2 const extent) -> Engine*
 {
+    if (m_loadedEngine == nullptr)
+    {
+        Log("Loading headless Engine.");
+        m_loadedEngine = new Engine(extent);
+    }
+    else
+    {
+        Warning("Called loadHeadlessEngine when one was already loaded. No "
+                "new engine was loaded.");
+    }
+
+    return m_loadedEngine;
+}
+
+void Engine::init(GLFWwindow* const window, glm::u16vec2 const extent)
+{
+    CPUProfiler::setThreadName("Main");
+
     m_uiPreferences.dpiScale = glm::round(glm::min<float>(
-        static_cast<float>(window.extent().y)
+        static_cast<float>(extent.y)
             / static_cast<float>(RESOLUTION_DEFAULT.height),
-        static_cast<float>(window.extent().x)
+        static_cast<float>(extent.x)
             / static_cast<float>(RESOLUTION_DEFAULT.width)
     ));
 
-    initVulkan(window);
+    initVulkan(window, extent);
 
     m_initialized = true;
 
     Log("Engine Initialized.");
 }
 
-void Engine::initVulkan(PlatformWindow const& window)
+void Engine::initVulkan(GLFWwindow* const window, glm::u16vec2 const extent)
 {
     Log("Initializing Vulkan...");
 
+    // Every shader built during startup, read and reflected in the background
+    // while the device and other resources are created.
+    std::vector<std::string> const startupShaderPaths{
+        "shaders/booleanpush.comp.spv",
+        "shaders/gradient_color.comp.spv",
+        "shaders/sparse_push_constant.comp.spv",
+        "shaders/matrix_color.comp.spv",
+        "shaders/debug/debugline.vert.spv",
+        "shaders/debug/debugline.frag.spv",
+        "shaders/offscreenpass/depthpass.vert.spv",
+        "shaders/culling/meshlet_cull.comp.spv",
+        "shaders/deferred/offscreen.vert.spv",
+        "shaders/deferred/offscreen.frag.spv",
+        "shaders/deferred/directional_light.comp.spv",
+        "shaders/deferred/sky.comp.spv",
+    };
+    ShaderManager::preload(startupShaderPaths);
+
     volkInitialize();
 
-    initInstanceSurfaceDevices(window.handle);
+    initInstanceSurfaceDevices(window);
 
     volkLoadDevice(m_device);
 
+    ShaderCache::init(m_physicalDevice, m_device);
+    GPUProfiler::init(
+        m_physicalDevice,
+        m_device,
+        m_graphicsQueueFamily,
+        FRAMES_IN_FLIGHT,
+        m_pipelineStatisticsSupported
+    );
+
     initAllocator();
 
-    initSwapchain(window.extent());
+    initSwapchain(extent);
     initDrawTargets();
 
     initCommands();
@@ -124,13 +183,25 @@ void Engine::initVulkan(PlatformWindow const& window)
     updateDescriptors();
 
     initDefaultMeshData();
+    m_pipelineCompiler = std::make_unique<PipelineCompiler>();
+    m_meshLoader = std::make_unique<MeshLoader>(
+        m_device, m_allocator, m_graphicsQueueFamily
+    );
     initWorld();
     initDebug();
     initGenericComputePipelines();
 
     initDeferredShadingPipeline();
 
-    initImgui(window.handle);
+    initImgui(window);
+
+    if (ShaderCache const* const cache{ShaderCache::getLoadedShaderCache()};
+        cache != nullptr)
+    {
+        cache->logStatistics();
+    }
+
+    ShaderManager::clear();
 
     Log("Vulkan Initialized.");
 }
@@ -145,6 +216,7 @@ void Engine::initInstanceSurfaceDevices(GLFWwindow* const window)
             .request_validation_layers()
             .use_default_debug_messenger()
             .require_api_version(1, 3, 0)
+            .set_headless(m_headless)
             .build()
     };
     vkb::Instance const vkbInstance{UnwrapVkbResult(instanceBuildResult)};
@@ -154,9 +226,12 @@ void Engine::initInstanceSurfaceDevices(GLFWwindow* const window)
     m_instance = vkbInstance.instance;
     m_debugMessenger = vkbInstance.debug_messenger;
 
-    // create VkSurfaceKHR
+    // create VkSurfaceKHR, which headless engines go without
 
-    glfwCreateWindowSurface(m_instance, window, nullptr, &m_surface);
+    if (!m_headless)
+    {
+        glfwCreateWindowSurface(m_instance, window, nullptr, &m_surface);
+    }
 
     // create VkPhysicalDevice and VkDevice
 
@@ -166,8 +241,11 @@ void Engine::initInstanceSurfaceDevices(GLFWwindow* const window)
     };
 
     VkPhysicalDeviceVulkan12Features const features12{
+        .drawIndirectCount = VK_TRUE,
+
         .descriptorIndexing = VK_TRUE,
 
+        .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
         .descriptorBindingPartiallyBound = VK_TRUE,
         .runtimeDescriptorArray = VK_TRUE,
 
@@ -175,7 +253,10 @@ void Engine::initInstanceSurfaceDevices(GLFWwindow* const window)
     };
 
     VkPhysicalDeviceFeatures const features{
+        .multiDrawIndirect = VK_TRUE,
+        .drawIndirectFirstInstance = VK_TRUE,
         .wideLines = VK_TRUE,
+        .textureCompressionBC = VK_TRUE,
     };
 
     VkPhysicalDeviceShaderObjectFeaturesEXT const shaderObjectFeature{
@@ -194,12 +275,24 @@ void Engine::initInstanceSurfaceDevices(GLFWwindow* const window)
             .add_required_extension_features(shaderObjectFeature)
             .add_required_extension(VK_EXT_SHADER_OBJECT_EXTENSION_NAME)
             .set_surface(m_surface)
+            .require_present(!m_headless)
             .select()
     };
-    vkb::PhysicalDevice const vkbPhysicalDevice{
+    vkb::PhysicalDevice vkbPhysicalDevice{
         UnwrapVkbResult(physicalDeviceBuildResult)
     };
 
+    // Optional, otherwise memory budgets are estimated from heap sizes.
+    m_memoryBudgetSupported = vkbPhysicalDevice.enable_extension_if_present(
+        VK_EXT_MEMORY_BUDGET_EXTENSION_NAME
+    );
+
+    // Optional, otherwise the profiler only counts work on the CPU.
+    m_pipelineStatisticsSupported =
+        vkbPhysicalDevice.enable_features_if_present(VkPhysicalDeviceFeatures{
+            .pipelineStatisticsQuery = VK_TRUE,
+        });
+
     vkb::DeviceBuilder const deviceBuilder{vkbPhysicalDevice};
     vkb::Result<vkb::Device> const deviceBuildResult = deviceBuilder.build();
     vkb::Device const vkbDevice = UnwrapVkbResult(deviceBuildResult);
@@ -224,17 +317,48 @@ void Engine::initInstanceSurfaceDevices(GLFWwindow* const window)
 
 void Engine::initAllocator()
 {
+    // VMA loads the rest of its functions through these, which includes the
+    // Vulkan 1.1 functions needed to query memory budgets.
+    VmaVulkanFunctions const vulkanFunctions{
+        .vkGetInstanceProcAddr = vkGetInstanceProcAddr,
+        .vkGetDeviceProcAddr = vkGetDeviceProcAddr,
+    };
+
+    VmaAllocatorCreateFlags flags{
+        VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT
+    };
+    if (m_memoryBudgetSupported)
+    {
+        flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
+
     VmaAllocatorCreateInfo const allocatorInfo{
-        .flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,
+        .flags = flags,
         .physicalDevice = m_physicalDevice,
         .device = m_device,
+        .pVulkanFunctions = &vulkanFunctions,
         .instance = m_instance,
+        .vulkanApiVersion = VK_API_VERSION_1_3,
     };
     vmaCreateAllocator(&allocatorInfo, &m_allocator);
 }
 
 void Engine::initSwapchain(glm::u16vec2 extent)
 {
+    // Headless frames end in the draw image, which stands in for the
+    // swapchain at the same extent
+    if (m_headless)
+    {
+        m_swapchainExtent = {
+            .width = std::min<uint32_t>(extent.x, MAX_DRAW_EXTENTS.width),
+            .height = std::min<uint32_t>(extent.y, MAX_DRAW_EXTENTS.height),
+        };
+        m_sceneRect = VkRect2D{
+            .extent{m_swapchainExtent},
+        };
+        return;
+    }
+
     m_swapchainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
 
     VkSurfaceFormatKHR const surfaceFormat{
@@ -336,6 +460,12 @@ void Engine::initDrawTargets()
 
 void Engine::cleanupSwapchain()
 {
+    // Swapchain functions are not loaded without the extension
+    if (m_headless)
+    {
+        return;
+    }
+
     vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
 
     for (VkImageView const& imageView : m_swapchainImageViews)
@@ -494,21 +624,64 @@ void Engine::updateDescriptors()
 
 void Engine::initDefaultMeshData()
 {
-    m_testMeshes =
+    std::string const meshPath{"assets/vkguide/basicmesh.glb"};
+
+    std::vector<std::shared_ptr<MeshAsset>> const meshes{
         loadGltfMeshes( // NOLINT(bugprone-unchecked-optional-access):
                         // Necessary for program execution
             this,
-            "assets/vkguide/basicmesh.glb"
+            meshPath
         )
-            .value();
+            .value()
+    };
+    for (std::shared_ptr<MeshAsset> const& mesh : meshes)
+    {
+        m_meshes.addMesh(mesh);
+    }
+    if (m_meshes.meshHandles().empty())
+    {
+        Warning(fmt::format("No meshes were found in {}.", meshPath));
+        return;
+    }
+    m_testMeshUsed = m_meshes.meshHandles().front();
+
+    // Load the packed variants alongside, so the two can be compared.
+    std::optional<std::vector<std::shared_ptr<MeshAsset>>> const packedMeshes{
+        loadGltfMeshes(this, meshPath, MeshImportOptions{.packVertices = true})
+    };
+    if (!packedMeshes.has_value())
+    {
+        Warning("Failed to load packed variants of test meshes.");
+        return;
+    }
+
+    for (std::shared_ptr<MeshAsset> const& mesh : packedMeshes.value())
+    {
+        mesh->name += " (Packed)";
+        m_meshes.addMesh(mesh);
+    }
+}
+
+auto randomDiskPoint(std::mt19937& generator) -> glm::vec2
+{
+    std::uniform_real_distribution<float> coordinate{-1.0F, 1.0F};
+    while (true)
+    {
+        glm::vec2 const point{coordinate(generator), coordinate(generator)};
+        float const lengthSquared{glm::length2(point)};
+        if (lengthSquared > 0.0F && lengthSquared < 1.0F)
+        {
+            return point;
+        }
+    }
 }
 
-auto randomQuat() -> glm::quat
+auto randomQuat(std::mt19937& generator) -> glm::quat
 {
     // https://stackoverflow.com/a/56794499
 
-    glm::vec2 const xy{glm::diskRand(1.0F)};
-    glm::vec2 const uv{glm::diskRand(1.0F)};
+    glm::vec2 const xy{randomDiskPoint(generator)};
+    glm::vec2 const uv{randomDiskPoint(generator)};
 
     float const s{glm::sqrt((1 - glm::length2(xy)) / glm::length2(uv))};
 
@@ -517,9 +690,6 @@ auto randomQuat() -> glm::quat
 
 void Engine::initWorld()
 {
-    int32_t const coordinateMin{-40};
-    int32_t const coordinateMax{40};
-
     if (m_meshInstances.models != nullptr
         || m_meshInstances.modelInverseTransposes != nullptr)
     {
@@ -527,83 +697,7 @@ void Engine::initWorld()
         return;
     }
 
-    { // Mesh Instances
-        // Floor
-        for (int32_t x{coordinateMin}; x <= coordinateMax; x++)
-        {
-            for (int32_t z{coordinateMin}; z <= coordinateMax; z++)
-            {
-                glm::vec3 const position{
-                    static_cast<float>(x) * 20.0F,
-                    1.0F,
-                    static_cast<float>(z) * 20.0F
-                };
-                glm::vec3 const scale{10.0F, 2.0F, 10.0F};
-
-                m_meshInstances.originals.push_back(
-                    glm::translate(position) * glm::scale(scale)
-                );
-            }
-        }
-
-        m_meshInstances.dynamicIndex = m_meshInstances.originals.size();
-
-        for (int32_t x{coordinateMin}; x <= coordinateMax; x++)
-        {
-            for (int32_t z{coordinateMin}; z <= coordinateMax; z++)
-            {
-                glm::vec3 const position{
-                    static_cast<float>(x), -4.0, static_cast<float>(z)
-                };
-                glm::quat const orientation{randomQuat()};
-                glm::vec3 const scale{0.2F};
-
-                m_meshInstances.originals.push_back(
-                    glm::translate(position) * glm::toMat4(orientation)
-                    * glm::scale(scale)
-                );
-            }
-        }
-
-        VkDeviceSize const maxInstanceCount{m_meshInstances.originals.size()};
-        m_meshInstances.models = std::make_unique<TStagedBuffer<glm::mat4x4>>(
-            TStagedBuffer<glm::mat4x4>::allocate(
-                m_device,
-                m_allocator,
-                maxInstanceCount,
-                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
-            )
-        );
-        m_meshInstances.modelInverseTransposes =
-            std::make_unique<TStagedBuffer<glm::mat4x4>>(
-                TStagedBuffer<glm::mat4x4>::allocate(
-                    m_device,
-                    m_allocator,
-                    maxInstanceCount,
-                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
-                )
-            );
-
-        std::vector<glm::mat4x4> modelInverseTransposes{};
-        modelInverseTransposes.reserve(m_meshInstances.originals.size());
-        for (glm::mat4x4 const& model : m_meshInstances.originals)
-        {
-            modelInverseTransposes.push_back(glm::inverseTranspose(model));
-        }
-
-        m_meshInstances.models->stage(m_meshInstances.originals);
-        m_meshInstances.modelInverseTransposes->stage(modelInverseTransposes);
-
-        immediateSubmit(
-            [&](VkCommandBuffer cmd)
-            {
-                m_meshInstances.models->recordCopyToDevice(cmd, m_allocator);
-                m_meshInstances.modelInverseTransposes->recordCopyToDevice(
-                    cmd, m_allocator
-                );
-            }
-        );
-    }
+    loadScene(SceneParameters{});
 
     { // Camera
 
@@ -642,6 +736,364 @@ void Engine::initWorld()
     }
 }
 
+void Engine::loadScene(SceneParameters const& parameters)
+{
+    std::mt19937 generator{parameters.seed};
+
+    std::vector<glm::mat4x4> originals{};
+
+    int32_t constexpr FLOOR_COORDINATE_MIN{-40};
+    int32_t constexpr FLOOR_COORDINATE_MAX{40};
+    for (int32_t x{FLOOR_COORDINATE_MIN}; x <= FLOOR_COORDINATE_MAX; x++)
+    {
+        for (int32_t z{FLOOR_COORDINATE_MIN}; z <= FLOOR_COORDINATE_MAX; z++)
+        {
+            glm::vec3 const position{
+                static_cast<float>(x) * 20.0F,
+                1.0F,
+                static_cast<float>(z) * 20.0F
+            };
+            glm::vec3 const scale{10.0F, 2.0F, 10.0F};
+
+            originals.push_back(glm::translate(position) * glm::scale(scale));
+        }
+    }
+
+    size_t const dynamicIndex{originals.size()};
+
+    // One unit apart, centered on the origin
+    auto const gridSide{static_cast<size_t>(
+        std::ceil(std::sqrt(static_cast<double>(parameters.instanceCount)))
+    )};
+    float const gridOffset{static_cast<float>(gridSide) * 0.5F - 0.5F};
+    for (size_t index{0}; index < parameters.instanceCount; index++)
+    {
+        glm::vec3 const position{
+            static_cast<float>(index % gridSide) - gridOffset,
+            -4.0F,
+            static_cast<float>(index / gridSide) - gridOffset
+        };
+        glm::quat const orientation{randomQuat(generator)};
+        glm::vec3 const scale{0.2F};
+
+        originals.push_back(
+            glm::translate(position) * glm::toMat4(orientation)
+            * glm::scale(scale)
+        );
+    }
+
+    setMeshInstances(std::move(originals), dynamicIndex);
+
+    size_t const spotLightCount{std::min<size_t>(
+        parameters.spotLightCount, DeferredShadingPipeline::LIGHT_CAPACITY
+    )};
+    if (spotLightCount < parameters.spotLightCount)
+    {
+        Warning(fmt::format(
+            "Scene requested {} spot lights, only {} are placed.",
+            parameters.spotLightCount,
+            spotLightCount
+        ));
+    }
+
+    // The first lights are always the same, so small scenes look alike
+    std::array<gputypes::LightSpot, 2> const fixedSpotLights{
+        lights::makeSpot(
+            glm::vec4(0.0, 1.0, 0.0, 1.0),
+            30.0,
+            1.0,
+            1.0,
+            60,
+            1.0,
+            glm::vec3(-1.0, 0.0, 1.0),
+            glm::vec3(-8.0, -10.0, -2.0),
+            0.1,
+            1000.0
+        ),
+        lights::makeSpot(
+            glm::vec4(1.0, 0.0, 0.0, 1.0),
+            30.0,
+            1.0,
+            1.0,
+            60,
+            1.0,
+            glm::vec3(-1.0, 0.0, -1.0),
+            glm::vec3(8.0, -10.0, 2.0),
+            0.1,
+            1000.0
+        ),
+    };
+
+    std::uniform_real_distribution<float> unit{0.0F, 1.0F};
+    m_spotLights.clear();
+    for (size_t index{0}; index < spotLightCount; index++)
+    {
+        if (index < fixedSpotLights.size())
+        {
+            m_spotLights.push_back(fixedSpotLights[index]);
+            continue;
+        }
+
+        glm::vec4 const color{unit(generator), unit(generator), 1.0F, 1.0F};
+        glm::vec3 const eulerAngles{
+            -1.0F, glm::two_pi<float>() * unit(generator), 0.0F
+        };
+        glm::vec3 const position{
+            (unit(generator) * 2.0F - 1.0F) * gridOffset,
+            -10.0F,
+            (unit(generator) * 2.0F - 1.0F) * gridOffset
+        };
+
+        m_spotLights.push_back(lights::makeSpot(
+            color,
+            30.0,
+            1.0,
+            1.0,
+            60,
+            1.0,
+            eulerAngles,
+            position,
+            0.1,
+            1000.0
+        ));
+    }
+}
+
+auto Engine::benchmarkComputeKernel(
+    KernelBenchmarkParameters const& parameters
+) -> std::vector<KernelBenchmarkResult>
+{
+    ComputeCollectionPipeline& pipeline{*m_genericComputePipeline};
+
+    std::span<ShaderObjectReflected const> const shaders{pipeline.shaders()};
+    auto const shader{std::find_if(
+        shaders.begin(),
+        shaders.end(),
+        [&](ShaderObjectReflected const& candidate)
+        {
+            return candidate.name().find(parameters.shaderName)
+                != std::string::npos;
+        }
+    )};
+    if (shader == shaders.end())
+    {
+        Warning(fmt::format(
+            "No compute collection shader is named '{}'.", parameters.shaderName
+        ));
+        return {};
+    }
+
+    std::unique_ptr<KernelBenchmark> const benchmark{KernelBenchmark::create(
+        m_physicalDevice, m_device, m_allocator, m_graphicsQueueFamily
+    )};
+    if (benchmark == nullptr)
+    {
+        return {};
+    }
+
+    // Frames in flight may still use the scene texture
+    CheckVkResult(vkDeviceWaitIdle(m_device));
+
+    size_t const previousShaderIndex{pipeline.shaderIndex()};
+    pipeline.selectShader(
+        static_cast<size_t>(std::distance(shaders.begin(), shader))
+    );
+
+    std::vector<KernelBenchmarkResult> results{};
+    for (VkExtent2D const extent : parameters.extents)
+    {
+        VkExtent2D const capacity{m_sceneColorTexture.extent2D()};
+        if (extent.width > capacity.width || extent.height > capacity.height)
+        {
+            Warning(fmt::format(
+                "Skipping {}x{}, which is larger than the scene texture.",
+                extent.width,
+                extent.height
+            ));
+            continue;
+        }
+
+        immediateSubmit(
+            [&](VkCommandBuffer cmd)
+            {
+                benchmark->record(
+                    cmd,
+                    pipeline,
+                    m_sceneTextureDescriptors,
+                    m_sceneColorTexture,
+                    extent,
+                    parameters.dispatches
+                );
+            }
+        );
+        results.push_back(benchmark->collect(shader->name(), parameters));
+    }
+
+    pipeline.selectShader(previousShaderIndex);
+
+    return results;
+}
+
+auto Engine::memoryStatistics() const -> VmaTotalStatistics
+{
+    VmaTotalStatistics statistics{};
+    vmaCalculateStatistics(m_allocator, &statistics);
+    return statistics;
+}
+
+auto Engine::readiness() const -> Readiness
+{
+    MeshAsset const* const mesh{m_meshes.get(m_testMeshUsed)};
+
+    std::vector<MeshLoader::JobProgress> const jobs{m_meshLoader->progress()};
+    bool const meshLoadsFinished{std::none_of(
+        jobs.begin(),
+        jobs.end(),
+        [](MeshLoader::JobProgress const& job)
+        {
+            return job.status != MeshLoader::JobStatus::FINISHED
+                && job.status != MeshLoader::JobStatus::FAILED;
+        }
+    )};
+
+    return Readiness{
+        .meshResident = mesh != nullptr && mesh->meshBuffers != nullptr,
+        .meshLoadsFinished = meshLoadsFinished,
+        .pipelinesCompiled = m_pipelineCompiler->queueDepth() == 0,
+        .workgroupsTuned = !m_deferredShadingPipeline->tuningWorkgroups(),
+        .texturesSettled =
+            m_textureStreamer->statistics().uploadedBytesLastFrame == 0,
+    };
+}
+
+void Engine::setMeshInstances(
+    std::vector<glm::mat4x4> originals, size_t const dynamicIndex
+)
+{
+    // Frames in flight may still read the previous buffers. Every one of
+    // them has finished once the most recently submitted frame's fence is
+    // waited on, which is when its deletion queue is flushed.
+    if (m_meshInstances.models != nullptr)
+    {
+        FrameData& lastSubmittedFrame{
+            m_frames[(m_frameNumber + m_frames.size() - 1) % m_frames.size()]
+        };
+
+        // Shared, since the deletion queue's functions must be copyable
+        std::shared_ptr<TStagedBuffer<glm::mat4x4>> models{
+            std::move(m_meshInstances.models)
+        };
+        std::shared_ptr<TStagedBuffer<glm::mat4x4>> modelInverseTransposes{
+            std::move(m_meshInstances.modelInverseTransposes)
+        };
+        std::shared_ptr<TStagedBuffer<uint32_t>> lodSortedIndices{
+            std::move(m_meshInstances.lodSortedIndices)
+        };
+        lastSubmittedFrame.deletionQueue.pushFunction(
+            [models, modelInverseTransposes, lodSortedIndices]() mutable
+            {
+                models.reset();
+                modelInverseTransposes.reset();
+                lodSortedIndices.reset();
+            }
+        );
+    }
+
+    m_meshInstances.originals = std::move(originals);
+    m_meshInstances.dynamicIndex = dynamicIndex;
+    m_meshInstances.lodRanges.clear();
+
+    // Buffers cannot be empty
+    size_t const instanceCount{m_meshInstances.originals.size()};
+    VkDeviceSize const maxInstanceCount{
+        std::max<VkDeviceSize>(instanceCount, 1)
+    };
+    m_meshInstances.models = std::make_unique<TStagedBuffer<glm::mat4x4>>(
+        TStagedBuffer<glm::mat4x4>::allocate(
+            m_device,
+            m_allocator,
+            maxInstanceCount,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+        )
+    );
+    m_meshInstances.modelInverseTransposes =
+        std::make_unique<TStagedBuffer<glm::mat4x4>>(
+            TStagedBuffer<glm::mat4x4>::allocate(
+                m_device,
+                m_allocator,
+                maxInstanceCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            )
+        );
+    m_meshInstances.lodSortedIndices =
+        std::make_unique<TStagedBuffer<uint32_t>>(
+            TStagedBuffer<uint32_t>::allocate(
+                m_device,
+                m_allocator,
+                maxInstanceCount,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            )
+        );
+
+    // Written in place, and copied to the device at the start of the next
+    // frame.
+    m_meshInstances.models->resizeStaged(instanceCount);
+    m_meshInstances.modelInverseTransposes->resizeStaged(instanceCount);
+
+    std::span<glm::mat4x4> const models{m_meshInstances.models->mapValidStaged()
+    };
+    std::span<glm::mat4x4> const modelInverseTransposes{
+        m_meshInstances.modelInverseTransposes->mapValidStaged()
+    };
+    for (size_t index{0}; index < instanceCount; index++)
+    {
+        glm::mat4x4 const& model{m_meshInstances.originals[index]};
+        models[index] = model;
+        modelInverseTransposes[index] = glm::inverseTranspose(model);
+    }
+}
+
+void Engine::placeTestMeshFromScene()
+{
+    MeshAsset const* const mesh{m_meshes.get(m_testMeshUsed)};
+    if (mesh == nullptr || mesh->source.localPath.empty())
+    {
+        Warning("Selected mesh has no source file to read a scene from.");
+        return;
+    }
+
+    std::optional<SceneInstances> sceneInstances{
+        loadGltfSceneInstances(mesh->source.localPath)
+    };
+    if (!sceneInstances.has_value())
+    {
+        return;
+    }
+
+    std::vector<std::vector<glm::mat4x4>>& meshTransforms{
+        sceneInstances.value().meshTransforms
+    };
+    if (mesh->source.meshIndex >= meshTransforms.size()
+        || meshTransforms[mesh->source.meshIndex].empty())
+    {
+        Warning(fmt::format(
+            "Mesh \"{}\" is not placed by its file's scene.", mesh->name
+        ));
+        return;
+    }
+
+    std::vector<glm::mat4x4>& transforms{
+        meshTransforms[mesh->source.meshIndex]
+    };
+    Log(fmt::format(
+        "Placing {} instances of \"{}\".", transforms.size(), mesh->name
+    ));
+
+    // Scene instances are static, so none are animated
+    size_t const dynamicIndex{transforms.size()};
+    setMeshInstances(std::move(transforms), dynamicIndex);
+}
+
 void Engine::initDebug()
 {
     m_debugLines.pipeline = std::make_unique<DebugLineGraphicsPipeline>(
@@ -649,7 +1101,8 @@ void Engine::initDebug()
         DebugLineGraphicsPipeline::ImageFormats{
             .color = m_sceneColorTexture.imageFormat,
             .depth = m_sceneDepthTexture.imageFormat,
-        }
+        },
+        *m_pipelineCompiler
     );
     m_debugLines.indices = std::make_unique<TStagedBuffer<uint32_t>>(
         TStagedBuffer<uint32_t>::allocate(
@@ -670,8 +1123,18 @@ void Engine::initDebug()
 
 void Engine::initDeferredShadingPipeline()
 {
+    m_textureStreamer = std::make_unique<TextureStreamer>(
+        m_device, m_allocator, FRAMES_IN_FLIGHT
+    );
+
     m_deferredShadingPipeline = std::make_unique<DeferredShadingPipeline>(
-        m_device, m_allocator, m_globalDescriptorAllocator, MAX_DRAW_EXTENTS
+        m_physicalDevice,
+        m_device,
+        m_allocator,
+        m_globalDescriptorAllocator,
+        MAX_DRAW_EXTENTS,
+        m_textureStreamer->layout(),
+        *m_pipelineCompiler
     );
 
     m_deferredShadingPipeline->updateRenderTargetDescriptors(
@@ -687,8 +1150,16 @@ void Engine::initGenericComputePipelines()
         "shaders/sparse_push_constant.comp.spv",
         "shaders/matrix_color.comp.spv"
     };
+    // The backgrounds are full-screen passes like the sky, so they share
+    // its tuned workgroup size once there is one
+    WorkgroupSize const workgroupSize{
+        WorkgroupTuner::loadTunedSize(
+            m_physicalDevice, DeferredShadingPipeline::SKY_PASS_NAME
+        )
+            .value_or(WorkgroupSize{})
+    };
     m_genericComputePipeline = std::make_unique<ComputeCollectionPipeline>(
-        m_device, m_sceneTextureDescriptorLayout, shaderPaths
+        m_device, m_sceneTextureDescriptorLayout, shaderPaths, workgroupSize
     );
 }
 
@@ -742,7 +1213,10 @@ void Engine::initImgui(GLFWwindow* const window)
     };
 
     ImGui::StyleColorsDark();
-    ImGui_ImplGlfw_InitForVulkan(window, true);
+    if (!m_headless)
+    {
+        ImGui_ImplGlfw_InitForVulkan(window, true);
+    }
 
     // Load functions since we are using volk,
     // and not the built-in vulkan loader
@@ -861,83 +1335,54 @@ void Engine::immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function
 
 auto Engine::uploadMeshToGPU(
     std::span<uint32_t const> const indices,
-    std::span<Vertex const> const vertices
+    std::span<Vertex const> const vertices,
+    std::span<gputypes::Meshlet const> const meshlets
 ) -> std::unique_ptr<GPUMeshBuffers>
 {
-    // Allocate buffer
-
-    size_t const indexBufferSize{indices.size_bytes()};
-    size_t const vertexBufferSize{vertices.size_bytes()};
-
-    AllocatedBuffer indexBuffer{AllocatedBuffer::allocate(
-        m_device,
-        m_allocator,
-        indexBufferSize,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VMA_MEMORY_USAGE_GPU_ONLY,
-        0
-    )};
-
-    AllocatedBuffer vertexBuffer{AllocatedBuffer::allocate(
-        m_device,
-        m_allocator,
-        vertexBufferSize,
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
-            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-        VMA_MEMORY_USAGE_GPU_ONLY,
-        0
-    )};
+    std::span<uint8_t const> const vertexBytes(
+        reinterpret_cast<uint8_t const*>(vertices.data()), vertices.size_bytes()
+    );
 
-    // Copy data into buffer
+    return uploadMeshBytesToGPU(
+        indices,
+        vertexBytes,
+        VertexEncoding{.format = VertexFormat::FULL},
+        meshlets
+    );
+}
 
-    AllocatedBuffer stagingBuffer{AllocatedBuffer::allocate(
-        m_device,
-        m_allocator,
-        vertexBufferSize + indexBufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_CPU_ONLY,
-        VMA_ALLOCATION_CREATE_MAPPED_BIT
-    )};
+auto Engine::uploadMeshToGPU(
+    std::span<uint32_t const> const indices,
+    std::span<PackedVertex const> const vertices,
+    VertexEncoding const& encoding,
+    std::span<gputypes::Meshlet const> const meshlets
+) -> std::unique_ptr<GPUMeshBuffers>
+{
+    std::span<uint8_t const> const vertexBytes(
+        reinterpret_cast<uint8_t const*>(vertices.data()), vertices.size_bytes()
+    );
 
-    uint8_t* const data{
-        reinterpret_cast<uint8_t*>(stagingBuffer.allocation->GetMappedData())
-    };
+    return uploadMeshBytesToGPU(indices, vertexBytes, encoding, meshlets);
+}
 
-    if (data == nullptr)
+auto Engine::uploadMeshBytesToGPU(
+    std::span<uint32_t const> const indices,
+    std::span<uint8_t const> const vertexBytes,
+    VertexEncoding const& encoding,
+    std::span<gputypes::Meshlet const> const meshlets
+) -> std::unique_ptr<GPUMeshBuffers>
+{
+    std::optional<StagedMeshUpload> staged{StagedMeshUpload::stage(
+        m_device, m_allocator, indices, vertexBytes, encoding, meshlets
+    )};
+    if (!staged.has_value())
     {
-        Warning("Mesh upload failed: Pointer to staging buffer was nullptr.");
         return nullptr;
     }
 
-    memcpy(data, vertices.data(), vertexBufferSize);
-    memcpy(data + vertexBufferSize, indices.data(), indexBufferSize);
-
-    immediateSubmit(
-        [&](VkCommandBuffer cmd)
-        {
-            VkBufferCopy const vertexCopy{
-                .srcOffset = 0,
-                .dstOffset = 0,
-                .size = vertexBufferSize,
-            };
-            vkCmdCopyBuffer(
-                cmd, stagingBuffer.buffer, vertexBuffer.buffer, 1, &vertexCopy
-            );
-
-            VkBufferCopy const indexCopy{
-                .srcOffset = vertexBufferSize,
-                .dstOffset = 0,
-                .size = indexBufferSize,
-            };
-            vkCmdCopyBuffer(
-                cmd, stagingBuffer.buffer, indexBuffer.buffer, 1, &indexCopy
-            );
-        }
-    );
+    immediateSubmit([&](VkCommandBuffer cmd) { staged->recordCopy(cmd); });
 
-    return std::make_unique<GPUMeshBuffers>(
-        std::move(indexBuffer), std::move(vertexBuffer)
-    );
+    return std::move(staged->meshBuffers);
 }
 
 // TODO: Once scenes are made, extract this to a testing scene
@@ -975,6 +1420,8 @@ void Engine::mainLoop(
     glm::u16vec2 windowExtent
 )
 {
+    VKR_PROFILE_FUNCTION();
+
     m_debugLines.clear();
 
     TickTiming const tickTiming{
@@ -982,35 +1429,190 @@ void Engine::mainLoop(
         .deltaTimeSeconds = deltaTimeSeconds,
     };
 
+    m_meshes.addLoadedMeshes(m_meshLoader->update(m_graphicsQueue));
+
     tickWorld(tickTiming);
 #if VKRENDERER_COMPILE_WITH_TESTING
     testDebugLines(currentTimeSeconds, m_debugLines);
 #endif
-    double const instantFPS{1.0F / tickTiming.deltaTimeSeconds};
+    m_frameTimes.write(tickTiming.deltaTimeSeconds * 1000.0);
+
+    if (shouldRender && !m_headless)
+    {
+        if (m_resizeRequested)
+        {
+            Log("Resizing swapchain.");
+            resizeSwapchain(windowExtent);
+        }
+
+        if (renderUI(m_device))
+        {
+            // TODO: fix
+            // For some reason, ImGui gives visual artifacts for two frames
+            // when resetting certain docking states. We force updating to
+            // flush these through.
+            renderUI(m_device);
+            renderUI(m_device);
+        }
+    }
 
-    m_fpsValues.write(instantFPS);
+    // After the UI, so the frame's edits are recorded with it
+    if (m_inputRecorder != nullptr)
+    {
+        m_inputRecorder->write(
+            captureFrameInputs(tickTiming, shouldRender, windowExtent)
+        );
+    }
 
     if (!shouldRender)
     {
         return;
     }
 
-    if (m_resizeRequested)
+    draw();
+
+    if (m_metricsServer != nullptr)
     {
-        Log("Resizing swapchain.");
-        resizeSwapchain(windowExtent);
+        publishMetrics();
     }
+}
+
+void Engine::startInputRecording(std::filesystem::path const& path)
+{
+    stopInputRecording();
 
-    if (renderUI(m_device))
+    m_inputRecorder = InputRecorder::create(path);
+    if (m_inputRecorder != nullptr)
     {
-        // TODO: fix
-        // For some reason, ImGui gives visual artifacts for two frames
-        // when resetting certain docking states. We force updating to
-        // flush these through.
-        renderUI(m_device);
-        renderUI(m_device);
+        Log(fmt::format("Recording inputs to {}", path.string()));
     }
-    draw();
+}
+
+void Engine::stopInputRecording()
+{
+    if (m_inputRecorder == nullptr)
+    {
+        return;
+    }
+
+    Log(fmt::format(
+        "Recorded inputs of {} frames.", m_inputRecorder->frameCount()
+    ));
+    m_inputRecorder.reset();
+}
+
+void Engine::startMetricsServer(
+    std::string const& address, uint16_t const port
+)
+{
+    m_metricsServer.reset();
+    m_metricsServer = MetricsServer::create(address, port);
+}
+
+void Engine::publishMetrics()
+{
+    MetricsSnapshot& snapshot{m_metricsServer->snapshot()};
+
+    VkPhysicalDeviceMemoryProperties const* memoryProperties{nullptr};
+    vmaGetMemoryProperties(m_allocator, &memoryProperties);
+
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> heapBudgets{};
+    vmaGetHeapBudgets(m_allocator, heapBudgets.data());
+
+    snapshot.heapCount = memoryProperties->memoryHeapCount;
+    for (uint32_t heap{0}; heap < snapshot.heapCount; heap++)
+    {
+        VmaBudget const& budget{heapBudgets[heap]};
+        snapshot.heaps[heap] = MetricsSnapshot::Heap{
+            .usageBytes = budget.usage,
+            .budgetBytes = budget.budget,
+            .allocationBytes = budget.statistics.allocationBytes,
+            .blockBytes = budget.statistics.blockBytes,
+        };
+    }
+
+    snapshot.passCount = 0;
+    GPUProfiler const* const profiler{GPUProfiler::getLoadedGPUProfiler()};
+    if (profiler != nullptr && profiler->historyCount() > 0)
+    {
+        size_t const latest{
+            (profiler->historyIndex() + GPUProfiler::HISTORY_LENGTH - 1)
+            % GPUProfiler::HISTORY_LENGTH
+        };
+        for (GPUProfiler::ScopeHistory const& scope : profiler->scopes())
+        {
+            if (snapshot.passCount == snapshot.passes.size())
+            {
+                break;
+            }
+
+            MetricsSnapshot::Pass& pass{snapshot.passes[snapshot.passCount]};
+            size_t const length{
+                std::min(scope.name.size(), pass.name.size() - 1)
+            };
+            std::copy_n(scope.name.begin(), length, pass.name.begin());
+            pass.name[length] = '\0';
+            pass.seconds = scope.milliseconds[latest] / 1000.0;
+
+            snapshot.passCount += 1;
+        }
+    }
+
+    m_metricsServer->publish();
+}
+
+auto Engine::captureFrameInputs(
+    TickTiming const timing,
+    bool const shouldRender,
+    glm::u16vec2 const windowExtent
+) const -> FrameInputs
+{
+    return FrameInputs{
+        .elapsedTimeSeconds = timing.timeElapsed,
+        .deltaTimeSeconds = timing.deltaTimeSeconds,
+        .shouldRender = shouldRender,
+        .windowExtent = windowExtent,
+        .sceneExtent =
+            glm::u16vec2{
+                static_cast<uint16_t>(m_sceneRect.extent.width),
+                static_cast<uint16_t>(m_sceneRect.extent.height)
+            },
+        .camera = m_cameraParameters,
+        .useOrthographicProjection = m_useOrthographicProjection,
+        .atmosphere = m_atmosphereParameters,
+        .showSpotlights = m_showSpotlights,
+        .renderMeshInstances = m_renderMeshInstances,
+        .renderingPipeline = m_activeRenderingPipeline,
+        .deferredParameters = m_deferredShadingPipeline->m_parameters,
+        .lodParameters = m_lodParameters,
+        .textureStreaming = m_textureStreamingParameters,
+        .meshResidency = m_meshResidencyParameters,
+        .testMesh = m_testMeshUsed,
+    };
+}
+
+void Engine::applyFrameInputs(FrameInputs const& inputs)
+{
+    m_cameraParameters = inputs.camera;
+    m_useOrthographicProjection = inputs.useOrthographicProjection;
+
+    // The recorded sun already includes any animation, so animating it again
+    // would drift from the recording.
+    m_atmosphereParameters = inputs.atmosphere;
+    m_atmosphereParameters.animation.animateSun = false;
+
+    m_showSpotlights = inputs.showSpotlights;
+    m_renderMeshInstances = inputs.renderMeshInstances;
+    m_activeRenderingPipeline = inputs.renderingPipeline;
+
+    m_deferredShadingPipeline->m_parameters = inputs.deferredParameters;
+    m_lodParameters = inputs.lodParameters;
+    m_textureStreamingParameters = inputs.textureStreaming;
+    m_meshResidencyParameters = inputs.meshResidency;
+
+    // A handle that does not resolve, such as from a different scene, falls
+    // back to the first mesh when drawing
+    m_testMeshUsed = inputs.testMesh;
 }
 
 // TODO: Break this method up to get rid of the NOLINT. It should be as pure as
@@ -1020,6 +1622,8 @@ void Engine::mainLoop(
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 auto Engine::renderUI(VkDevice const device) -> bool
 {
+    VKR_PROFILE_FUNCTION();
+
     if (m_uiReloadRequested)
     {
         // It is necessary to defer reloading to before each frame, since
@@ -1139,9 +1743,37 @@ auto Engine::renderUI(VkDevice const device) -> bool
             if (ImGui::Begin("Scene Controls"))
             {
                 imguiMeshInstanceControls(
-                    m_renderMeshInstances, m_testMeshes, m_testMeshUsed
+                    m_renderMeshInstances, m_meshes, m_testMeshUsed
+                );
+
+                if (ImGui::Button("Place Instances From Scene"))
+                {
+                    placeTestMeshFromScene();
+                }
+
+                ImGui::Separator();
+                imguiMeshLoadingControls(
+                    *m_meshLoader, m_meshLoadPath, m_meshLoadOptions
+                );
+
+                ImGui::Separator();
+                imguiMeshResidencyControls(
+                    m_meshResidencyParameters, m_meshes.statistics()
                 );
 
+                ImGui::Separator();
+                imguiTextureStreamingControls(
+                    m_textureStreamingParameters,
+                    m_textureStreamer->statistics()
+                );
+
+                if (MeshAsset const* const mesh{m_meshes.get(m_testMeshUsed)};
+                    mesh != nullptr)
+                {
+                    ImGui::Separator();
+                    imguiLODControls(m_lodParameters, m_meshInstances, *mesh);
+                }
+
                 ImGui::Separator();
                 imguiStructureControls(m_sceneBounds, DEFAULT_SCENE_BOUNDS);
 
@@ -1192,6 +1824,9 @@ auto Engine::renderUI(VkDevice const device) -> bool
 
                 ImGui::Separator();
                 imguiStructureControls(m_debugLines);
+
+                ImGui::Separator();
+                imguiPipelineCompilationStatus(*m_pipelineCompiler);
             }
             ImGui::End();
         }
@@ -1204,11 +1839,12 @@ auto Engine::renderUI(VkDevice const device) -> bool
 
             imguiPerformanceWindow(
                 PerformanceValues{
-                    .samplesFPS = m_fpsValues.values(),
-                    .averageFPS = m_fpsValues.average(),
-                    .currentFrame = m_fpsValues.current(),
+                    .samplesMilliseconds = m_frameTimes.values(),
+                    .summary = m_frameTimes.summarize(m_frameTimeWindow),
+                    .currentFrame = m_frameTimes.current(),
                 },
-                m_targetFPS
+                m_targetFPS,
+                m_frameTimeWindow
             );
         }
 
@@ -1267,8 +1903,46 @@ auto Engine::renderUI(VkDevice const device) -> bool
     return skipFrame;
 }
 
+void animateInstances(
+    std::span<glm::mat4x4 const> const originals,
+    size_t const dynamicIndex,
+    double const timeElapsedSeconds,
+    std::span<glm::mat4x4> const models,
+    std::span<glm::mat4x4> const modelInverseTransposes
+)
+{
+    size_t const count{std::min(
+        {originals.size(), models.size(), modelInverseTransposes.size()}
+    )};
+    for (size_t index{dynamicIndex}; index < count; index++)
+    {
+        glm::mat4x4 const& modelOriginal{originals[index]};
+
+        glm::vec4 const position{modelOriginal * glm::vec4(0.0, 0.0, 0.0, 1.0)
+        };
+
+        double const timeOffset{
+            (position.x - (-10) + position.z - (-10)) / 3.1415
+        };
+
+        double const y{std::sin(timeElapsedSeconds + timeOffset)};
+
+        glm::mat4x4 const translation{glm::translate(glm::vec3(0.0, y, 0.0))};
+
+        models[index] = translation * modelOriginal;
+
+        // In general, the model inverse transposes only need to be updated
+        // once per tick, before rendering and after the last update of the
+        // model matrices. For now, we only update once per tick, so we just
+        // compute it here.
+        modelInverseTransposes[index] = glm::inverseTranspose(models[index]);
+    }
+}
+
 void Engine::tickWorld(TickTiming timing)
 {
+    VKR_PROFILE_FUNCTION();
+
     std::span<glm::mat4x4> const models{m_meshInstances.models->mapValidStaged()
     };
     std::span<glm::mat4x4> const modelInverseTransposes{
@@ -1281,35 +1955,13 @@ void Engine::tickWorld(TickTiming timing)
         return;
     }
 
-    size_t index{0};
-    for (glm::mat4x4 const& modelOriginal : m_meshInstances.originals)
-    {
-        if (index >= m_meshInstances.dynamicIndex)
-        {
-            glm::vec4 const position{
-                modelOriginal * glm::vec4(0.0, 0.0, 0.0, 1.0)
-            };
-
-            double const timeOffset{
-                (position.x - (-10) + position.z - (-10)) / 3.1415
-            };
-
-            double const y{std::sin(timing.timeElapsed + timeOffset)};
-
-            glm::mat4x4 const translation{glm::translate(glm::vec3(0.0, y, 0.0))
-            };
-
-            models[index] = translation * modelOriginal;
-
-            // In general, the model inverse transposes only need to be updated
-            // once per tick, before rendering and after the last update of the
-            // model matrices. For now, we only update once per tick, so we
-            // just compute it here.
-            modelInverseTransposes[index] =
-                glm::inverseTranspose(models[index]);
-        }
-        index += 1;
-    }
+    animateInstances(
+        m_meshInstances.originals,
+        m_meshInstances.dynamicIndex,
+        timing.timeElapsed,
+        models,
+        modelInverseTransposes
+    );
 
     // Atmosphere
     {
@@ -1355,19 +2007,63 @@ void Engine::tickWorld(TickTiming timing)
 
 void Engine::draw()
 {
+    VKR_PROFILE_FUNCTION();
+
     FrameData& currentFrame = getCurrentFrame();
 
     uint64_t constexpr FRAME_WAIT_TIMEOUT_NANOSECONDS = 1'000'000'000;
-    CheckVkResult(vkWaitForFences(
-        m_device,
-        1,
-        &currentFrame.renderFence,
-        VK_TRUE,
-        FRAME_WAIT_TIMEOUT_NANOSECONDS
-    ));
+    {
+        VKR_PROFILE_ZONE("Wait for Frame Fence");
+        CheckVkResult(vkWaitForFences(
+            m_device,
+            1,
+            &currentFrame.renderFence,
+            VK_TRUE,
+            FRAME_WAIT_TIMEOUT_NANOSECONDS
+        ));
+    }
 
     currentFrame.deletionQueue.flush();
 
+    // Acquired before recording, since recording commits state such as
+    // streamed textures and tuning queries that assume the frame is
+    // submitted.
+    uint32_t swapchainImageIndex{0};
+    if (!m_headless)
+    {
+        VkResult const acquireResult{vkAcquireNextImageKHR(
+            m_device,
+            m_swapchain,
+            FRAME_WAIT_TIMEOUT_NANOSECONDS,
+            currentFrame.swapchainSemaphore,
+            VK_NULL_HANDLE // No Fence to signal
+            ,
+            &swapchainImageIndex
+        )};
+        if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            m_resizeRequested = true;
+            return;
+        }
+        CheckVkResult(acquireResult);
+    }
+
+    if (m_meshes.get(m_testMeshUsed) == nullptr
+        && !m_meshes.meshHandles().empty())
+    {
+        m_testMeshUsed = m_meshes.meshHandles().front();
+    }
+
+    // Null when every mesh was removed, in which case none is drawn.
+    MeshAsset const* const testMesh{m_meshes.get(m_testMeshUsed)};
+
+    // Marked before updating, so the mesh is not evicted while being drawn.
+    bool const testMeshResident{
+        testMesh != nullptr
+        && m_meshes.markUsed(m_testMeshUsed, m_frameNumber, *m_meshLoader)
+    };
+    m_meshes.update(m_meshResidencyParameters, m_frameNumber, m_allocator);
+
     CheckVkResult(vkResetFences(m_device, 1, &currentFrame.renderFence));
 
     VkCommandBuffer const& cmd = currentFrame.mainCommandBuffer;
@@ -1378,8 +2074,35 @@ void Engine::draw()
     )};
     CheckVkResult(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
 
+    // The fence was waited on, so this frame's previous timings are ready
+    if (GPUProfiler* const profiler{GPUProfiler::getLoadedGPUProfiler()};
+        profiler != nullptr)
+    {
+        profiler->beginFrame(cmd, m_frameNumber % m_frames.size());
+    }
+
+    // Textures are only streamed in for meshes that will be drawn.
+    if (testMeshResident)
+    {
+        m_textureStreamer->requestTexture(
+            testMesh->material.baseColorTexture, m_frameNumber
+        );
+    }
+    m_textureStreamer->recordUpdate(
+        cmd, m_textureStreamingParameters, m_frameNumber
+    );
+
     // Begin scene drawing
 
+    // Models are copied first, so selecting levels of detail reads the
+    // staged values that the device will see.
+    { // Copy models to gpu
+        m_meshInstances.models->recordCopyToDevice(cmd, m_allocator);
+        m_meshInstances.modelInverseTransposes->recordCopyToDevice(
+            cmd, m_allocator
+        );
+    }
+
     { // Copy cameras to gpu
         float const aspectRatio{
             static_cast<float>(vkutil::aspectRatio(m_sceneRect.extent))
@@ -1399,6 +2122,22 @@ void Engine::draw()
         };
 
         m_camerasBuffer->recordCopyToDevice(cmd, m_allocator);
+
+        // Selection reads the main camera and staged models, which are both
+        // final for this frame at this point.
+        if (testMesh != nullptr)
+        {
+            lod::selectInstanceLODs(
+                m_lodParameters,
+                cameras[m_cameraIndexMain],
+                static_cast<float>(m_sceneRect.extent.height),
+                *testMesh,
+                m_meshInstances
+            );
+            m_meshInstances.lodSortedIndices->recordCopyToDevice(
+                cmd, m_allocator
+            );
+        }
     }
 
     { // Copy atmospheres to gpu
@@ -1421,13 +2160,6 @@ void Engine::draw()
         m_atmospheresBuffer->recordCopyToDevice(cmd, m_allocator);
     }
 
-    { // Copy models to gpu
-        m_meshInstances.models->recordCopyToDevice(cmd, m_allocator);
-        m_meshInstances.modelInverseTransposes->recordCopyToDevice(
-            cmd, m_allocator
-        );
-    }
-
     {
         vkutil::transitionImage(
             cmd,
@@ -1517,33 +2249,6 @@ void Engine::draw()
                 ));
             }
 
-            std::vector<gputypes::LightSpot> const spotLights{
-                lights::makeSpot(
-                    glm::vec4(0.0, 1.0, 0.0, 1.0),
-                    30.0,
-                    1.0,
-                    1.0,
-                    60,
-                    1.0,
-                    glm::vec3(-1.0, 0.0, 1.0),
-                    glm::vec3(-8.0, -10.0, -2.0),
-                    0.1,
-                    1000.0
-                ),
-                lights::makeSpot(
-                    glm::vec4(1.0, 0.0, 0.0, 1.0),
-                    30.0,
-                    1.0,
-                    1.0,
-                    60,
-                    1.0,
-                    glm::vec3(-1.0, 0.0, -1.0),
-                    glm::vec3(8.0, -10.0, 2.0),
-                    0.1,
-                    1000.0
-                ),
-            };
-
             m_deferredShadingPipeline->recordDrawCommands(
                 cmd,
                 m_sceneRect,
@@ -1551,15 +2256,17 @@ void Engine::draw()
                 m_sceneColorTexture,
                 m_sceneDepthTexture,
                 directionalLights,
-                m_showSpotlights ? spotLights
+                m_showSpotlights ? m_spotLights
                                  : std::vector<gputypes::LightSpot>{},
                 m_cameraIndexMain,
                 *m_camerasBuffer,
                 m_atmosphereIndex,
                 *m_atmospheresBuffer,
-                m_renderMeshInstances,
-                *m_testMeshes[m_testMeshUsed],
-                m_meshInstances
+                m_renderMeshInstances && testMeshResident ? testMesh
+                                                          : nullptr,
+                m_meshInstances,
+                *m_textureStreamer,
+                currentFrame.deletionQueue
             );
 
             m_debugLines.pushBox(
@@ -1567,12 +2274,16 @@ void Engine::draw()
                 glm::quat_identity<float, glm::qualifier::defaultp>(),
                 m_sceneBounds.extent
             );
-            recordDrawDebugLines(cmd, m_cameraIndexMain, *m_camerasBuffer);
+            {
+                GPUProfileScope const profileScope{cmd, "Debug Lines"};
+                recordDrawDebugLines(cmd, m_cameraIndexMain, *m_camerasBuffer);
+            }
 
             break;
         }
         case RenderingPipelines::COMPUTE_COLLECTION:
         {
+            GPUProfileScope const profileScope{cmd, "Background"};
             m_genericComputePipeline->recordDrawCommands(
                 cmd, m_sceneTextureDescriptors, m_sceneRect.extent
             );
@@ -1584,6 +2295,12 @@ void Engine::draw()
 
     // End scene drawing
 
+    if (m_headless)
+    {
+        submitHeadlessFrame(cmd);
+        return;
+    }
+
     // ImGui Drawing
 
     vkutil::transitionImage(
@@ -1602,7 +2319,10 @@ void Engine::draw()
         VK_IMAGE_ASPECT_COLOR_BIT
     );
 
-    recordDrawImgui(cmd, m_drawImage.imageView);
+    {
+        GPUProfileScope const profileScope{cmd, "ImGui"};
+        recordDrawImgui(cmd, m_drawImage.imageView);
+    }
 
     vkutil::transitionImage(
         cmd,
@@ -1616,24 +2336,6 @@ void Engine::draw()
 
     // Copy image to swapchain
 
-    uint32_t swapchainImageIndex;
-    VkResult const acquireResult{vkAcquireNextImageKHR(
-        m_device,
-        m_swapchain,
-        FRAME_WAIT_TIMEOUT_NANOSECONDS,
-        currentFrame.swapchainSemaphore,
-        VK_NULL_HANDLE // No Fence to signal
-        ,
-        &swapchainImageIndex
-    )};
-    if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
-    {
-        m_resizeRequested = true;
-        CheckVkResult(vkEndCommandBuffer(cmd));
-        return;
-    }
-    CheckVkResult(acquireResult);
-
     VkImage const& swapchainImage{m_swapchainImages[swapchainImageIndex]};
     VkImageView const& swapchainImageView{
         m_swapchainImageViews[swapchainImageIndex]
@@ -1695,6 +2397,12 @@ void Engine::draw()
         m_graphicsQueue, 1, &submitInfo, currentFrame.renderFence
     ));
 
+    if (GPUProfiler* const profiler{GPUProfiler::getLoadedGPUProfiler()};
+        profiler != nullptr)
+    {
+        profiler->endFrame();
+    }
+
     VkPresentInfoKHR const presentInfo = {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
         .pNext = nullptr,
@@ -1709,9 +2417,11 @@ void Engine::draw()
         .pResults = nullptr, // Only one swapchain
     };
 
-    VkResult const presentResult{
-        vkQueuePresentKHR(m_graphicsQueue, &presentInfo)
-    };
+    VkResult presentResult{VK_SUCCESS};
+    {
+        VKR_PROFILE_ZONE("Present");
+        presentResult = vkQueuePresentKHR(m_graphicsQueue, &presentInfo);
+    }
     if (presentResult == VK_ERROR_OUT_OF_DATE_KHR)
     {
         m_resizeRequested = true;
@@ -1724,6 +2434,68 @@ void Engine::draw()
     m_frameNumber++;
 }
 
+void Engine::submitHeadlessFrame(VkCommandBuffer const cmd)
+{
+    FrameData& currentFrame = getCurrentFrame();
+
+    // Without the UI to composite the scene, the draw image holds just the
+    // scene, like a swapchain image would
+    m_drawRect = VkRect2D{.extent{m_swapchainExtent}};
+
+    vkutil::transitionImage(
+        cmd,
+        m_sceneColorTexture.image,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+    vkutil::transitionImage(
+        cmd,
+        m_drawImage.image,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+
+    vkutil::recordCopyImageToImage(
+        cmd,
+        m_sceneColorTexture.image,
+        m_drawImage.image,
+        m_sceneRect,
+        m_drawRect
+    );
+
+    vkutil::transitionImage(
+        cmd,
+        m_drawImage.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+
+    CheckVkResult(vkEndCommandBuffer(cmd));
+
+    // Nothing is acquired or presented, so only the fence is needed
+    std::vector<VkCommandBufferSubmitInfo> const cmdSubmitInfos{
+        vkinit::commandBufferSubmitInfo(cmd)
+    };
+    std::vector<VkSemaphoreSubmitInfo> const noSemaphores{};
+    VkSubmitInfo2 const submitInfo =
+        vkinit::submitInfo(cmdSubmitInfos, noSemaphores, noSemaphores);
+
+    CheckVkResult(vkQueueSubmit2(
+        m_graphicsQueue, 1, &submitInfo, currentFrame.renderFence
+    ));
+
+    if (GPUProfiler* const profiler{GPUProfiler::getLoadedGPUProfiler()};
+        profiler != nullptr)
+    {
+        profiler->endFrame();
+    }
+
+    m_frameNumber++;
+}
+
 void Engine::recordDrawImgui(VkCommandBuffer const cmd, VkImageView const view)
 {
     VkRenderingAttachmentInfo const colorAttachmentInfo{
@@ -1769,10 +2541,12 @@ void Engine::recordDrawDebugLines(
     {
         m_debugLines.recordCopy(cmd, m_allocator);
 
+        m_debugLines.pipeline->requestVariant(m_debugLines.occluded);
+
         DrawResultsGraphics const drawResults{
             m_debugLines.pipeline->recordDrawCommands(
                 cmd,
-                false,
+                m_debugLines.occluded,
                 m_debugLines.lineWidth,
                 m_sceneRect,
                 m_sceneColorTexture,
@@ -1797,26 +2571,52 @@ void Engine::cleanup()
 
     Log("Engine cleaning up.");
 
+    stopInputRecording();
+    m_metricsServer.reset();
+
+    if (CPUProfiler::exportOnExit())
+    {
+        CPUProfiler::exportChromeTrace(
+            DebugUtils::getLoadedDebugUtils().makeAbsolutePath(
+                std::filesystem::path{"profiles"} / "cpu_trace.json"
+            )
+        );
+    }
+
     CheckVkResult(vkDeviceWaitIdle(m_device));
 
     ImPlot::DestroyContext();
 
     ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    if (!m_headless)
+    {
+        ImGui_ImplGlfw_Shutdown();
+    }
     ImGui::DestroyContext();
     vkDestroyDescriptorPool(m_device, m_imguiDescriptorPool, nullptr);
     vkDestroySampler(m_device, m_imguiSceneTextureSampler, nullptr);
 
+    // Jobs may still reference the pipelines below
+    m_pipelineCompiler->cleanup();
+
     m_genericComputePipeline->cleanup(m_device);
     m_deferredShadingPipeline->cleanup(m_device, m_allocator);
+    m_textureStreamer->cleanup();
 
     m_meshInstances.models.reset();
     m_meshInstances.modelInverseTransposes.reset();
+    m_meshInstances.lodSortedIndices.reset();
+    for (FrameData& frameData : m_frames)
+    {
+        frameData.deletionQueue.flush();
+    }
 
     m_atmospheresBuffer.reset();
     m_camerasBuffer.reset();
 
-    m_testMeshes.clear();
+    m_meshLoader->cleanup();
+    m_meshLoader.reset();
+    m_meshes.cleanup();
     m_debugLines.cleanup(m_device, m_allocator);
 
     m_globalDescriptorAllocator.destroyPool(m_device);
@@ -1840,10 +2640,16 @@ void Engine::cleanup()
     cleanupDrawTargets();
     cleanupSwapchain();
 
+    GPUProfiler::cleanup();
+    ShaderCache::cleanup();
+
     vmaDestroyAllocator(m_allocator);
 
     vkDestroyDevice(m_device, nullptr);
-    vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+    if (!m_headless)
+    {
+        vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+    }
 
     vkDestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, nullptr);
     vkDestroyInstance(m_instance, nullptr);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "assetregistry.hpp"
 #include "assets.hpp"
 #include "buffers.hpp"
 #include "debuglines.hpp"
@@ -8,10 +9,18 @@
 #include "editor/window.hpp"
 #include "engineparams.hpp"
 #include "enginetypes.hpp"
+#include "frametimes.hpp"
 #include "imgui.h"
+#include "inputrecording.hpp"
+#include "kernelbenchmark.hpp"
+#include "meshloader.hpp"
+#include "meshlod.hpp"
+#include "metricsserver.hpp"
+#include "pipelinecompiler.hpp"
 #include "pipelines.hpp"
 #include "shaders.hpp"
 #include "shadowpass.hpp"
+#include "texturestreamer.hpp"
 
 struct GLFWwindow;
 
@@ -35,14 +44,33 @@ struct FrameData
 
 size_t constexpr FRAMES_IN_FLIGHT = 2;
 
+// Bobs each instance from dynamicIndex onwards up and down from its original
+// transform. This is the per-tick work of Engine::tickWorld, and needs no
+// device.
+void animateInstances(
+    std::span<glm::mat4x4 const> originals,
+    size_t dynamicIndex,
+    double timeElapsedSeconds,
+    std::span<glm::mat4x4> models,
+    std::span<glm::mat4x4> modelInverseTransposes
+);
+
 class Engine
 {
 private:
     Engine(PlatformWindow const& window);
+    explicit Engine(glm::u16vec2 headlessExtent);
 
 public:
     static Engine* loadEngine(PlatformWindow const& window);
 
+    // Loads an engine without a window, surface or swapchain, such as for
+    // machines without a display. Frames render the same scene passes into
+    // the draw image at the extent, but skip the UI and presenting.
+    static Engine* loadHeadlessEngine(glm::u16vec2 extent);
+
+    bool headless() const { return m_headless; }
+
     void mainLoop(
         double elapsedTimeSeconds,
         double deltaTimeSeconds,
@@ -53,9 +81,10 @@ public:
     void cleanup();
 
 private:
-    void init(PlatformWindow const& window);
+    // The window is null when headless.
+    void init(GLFWwindow* window, glm::u16vec2 extent);
 
-    void initVulkan(PlatformWindow const& window);
+    void initVulkan(GLFWwindow* window, glm::u16vec2 extent);
 
     struct TickTiming
     {
@@ -68,6 +97,9 @@ private:
     bool renderUI(VkDevice device);
     void draw();
 
+    // Ends and submits the frame's commands without the UI or a swapchain.
+    void submitHeadlessFrame(VkCommandBuffer cmd);
+
     void recordDrawImgui(VkCommandBuffer cmd, VkImageView view);
     void recordDrawDebugLines(
         VkCommandBuffer cmd,
@@ -77,9 +109,10 @@ private:
 
 
     bool m_initialized{false};
+    bool m_headless{false};
     inline static Engine* m_loadedEngine{nullptr};
 
-    RingBuffer m_fpsValues{};
+    FrameTimeStatistics m_frameTimes{};
 
     uint32_t m_frameNumber{0};
 
@@ -104,6 +137,16 @@ private:
 
     void initDefaultMeshData();
     void initWorld();
+
+    // Replaces every mesh instance, reallocating the instance buffers. The
+    // previous buffers are destroyed once the frames reading them finish.
+    void setMeshInstances(
+        std::vector<glm::mat4x4> originals, size_t dynamicIndex
+    );
+
+    // Places the instances of the selected mesh where the default scene of
+    // its source file places that mesh.
+    void placeTestMeshFromScene();
     void initDebug();
     void initDeferredShadingPipeline();
 
@@ -120,6 +163,12 @@ private:
     VkQueue m_graphicsQueue{VK_NULL_HANDLE};
     uint32_t m_graphicsQueueFamily{0};
 
+    // Whether VK_EXT_memory_budget was enabled, for exact heap budgets.
+    bool m_memoryBudgetSupported{false};
+
+    // Whether pipeline statistics queries were enabled, for counting work.
+    bool m_pipelineStatisticsSupported{false};
+
     VmaAllocator m_allocator{VK_NULL_HANDLE};
 
     // Swapchain Resources
@@ -207,26 +256,139 @@ private:
 
 public:
     std::unique_ptr<GPUMeshBuffers> uploadMeshToGPU(
-        std::span<uint32_t const> indices, std::span<Vertex const> vertices
+        std::span<uint32_t const> indices,
+        std::span<Vertex const> vertices,
+        std::span<gputypes::Meshlet const> meshlets
+    );
+    std::unique_ptr<GPUMeshBuffers> uploadMeshToGPU(
+        std::span<uint32_t const> indices,
+        std::span<PackedVertex const> vertices,
+        VertexEncoding const& encoding,
+        std::span<gputypes::Meshlet const> meshlets
     );
 
+private:
+    // Blocks until the copy to the device has finished.
+    std::unique_ptr<GPUMeshBuffers> uploadMeshBytesToGPU(
+        std::span<uint32_t const> indices,
+        std::span<uint8_t const> vertexBytes,
+        VertexEncoding const& encoding,
+        std::span<gputypes::Meshlet const> meshlets
+    );
+
+public:
+
     float targetFPS() const { return m_targetFPS; }
+    FrameTimeStatistics const& frameTimes() const { return m_frameTimes; }
+
+    // Replaces the mesh instances and spot lights with a seeded layout. This
+    // reallocates the instance buffers, so it should not be called per frame.
+    void loadScene(SceneParameters const& parameters);
+
+    CameraParameters const& cameraParameters() const
+    {
+        return m_cameraParameters;
+    }
+    void setCameraParameters(CameraParameters const& parameters)
+    {
+        m_cameraParameters = parameters;
+    }
+
+    // Totals of every allocation made through the engine's allocator.
+    VmaTotalStatistics memoryStatistics() const;
+
+    // Background work that makes frames unrepresentative while it runs. Each
+    // is true once settled.
+    struct Readiness
+    {
+        // The selected mesh has buffers, and no mesh imports are pending.
+        bool meshResident{false};
+        bool meshLoadsFinished{false};
+
+        bool pipelinesCompiled{false};
+
+        // Tuned sizes are saved as soon as tuning finishes.
+        bool workgroupsTuned{false};
+
+        // Nothing was uploaded last frame, so streaming is either complete or
+        // held at its budget.
+        bool texturesSettled{false};
+
+        bool ready() const
+        {
+            return meshResident && meshLoadsFinished && pipelinesCompiled
+                && workgroupsTuned && texturesSettled;
+        }
+    };
+    Readiness readiness() const;
+
+    // Writes the inputs of every following frame to the file, replacing any
+    // recording in progress.
+    void startInputRecording(std::filesystem::path const& path);
+    void stopInputRecording();
+    bool recordingInputs() const { return m_inputRecorder != nullptr; }
+
+    // Overwrites the state that a recorded frame's inputs describe. Call
+    // before mainLoop, passing along the frame's timings.
+    void applyFrameInputs(FrameInputs const& inputs);
+
+    // Times a shader of the compute collection at each extent, with the push
+    // constants it currently has. This waits for the device to be idle, so it
+    // should not be called per frame.
+    std::vector<KernelBenchmarkResult>
+    benchmarkComputeKernel(KernelBenchmarkParameters const& parameters);
+
+    // Serves frame times, memory usage, and pass timings for Prometheus to
+    // scrape, replacing any server already running. Nothing is served if the
+    // port cannot be bound.
+    void startMetricsServer(std::string const& address, uint16_t port);
 
 private:
     // Meshes
 
-    std::vector<std::shared_ptr<MeshAsset>> m_testMeshes{};
+    AssetRegistry m_meshes{FRAMES_IN_FLIGHT};
+    MeshResidencyParameters m_meshResidencyParameters{};
+
+    // Meshes loaded at runtime are added to the registry once uploaded. This
+    // also imports meshes again after they are evicted.
+    std::unique_ptr<MeshLoader> m_meshLoader{};
+    std::string m_meshLoadPath{"assets/vkguide/basicmesh.glb"};
+    MeshImportOptions m_meshLoadOptions{};
+
+    // Textures of drawn materials, streamed in a level at a time.
+    std::unique_ptr<TextureStreamer> m_textureStreamer{};
+    TextureStreamingParameters m_textureStreamingParameters{};
+
+    // Builds pipeline variants requested after startup in the background.
+    std::unique_ptr<PipelineCompiler> m_pipelineCompiler{};
+
+    // Null unless recording
+    std::unique_ptr<InputRecorder> m_inputRecorder{};
+
+    // Null unless serving metrics
+    std::unique_ptr<MetricsServer> m_metricsServer{};
+
+    // Copies this frame's metrics into the server without allocating, since
+    // it runs every frame.
+    void publishMetrics();
+
+    FrameInputs captureFrameInputs(
+        TickTiming timing, bool shouldRender, glm::u16vec2 windowExtent
+    ) const;
 
     // Scene
 
     float m_targetFPS{160.0};
+    size_t m_frameTimeWindow{500};
     uint32_t m_cameraIndexMain{0};
-    size_t m_testMeshUsed{0};
+    MeshHandle m_testMeshUsed{};
 
     bool m_showSpotlights{true};
+    std::vector<gputypes::LightSpot> m_spotLights{};
     bool m_renderMeshInstances{true};
 
     MeshInstances m_meshInstances{};
+    LODParameters m_lodParameters{};
 
     // These scene bounds help inform shadow map generation
     // TODO: compute this from the scene
@@ -241,4 +241,16 @@ struct CameraParameters
     {
         return projection(aspectRatio) * view();
     }
-};
\ No newline at end of file
+};
+// A reproducible world, such as for benchmarks. The same seed always places
+// the same instances and lights.
+struct SceneParameters
+{
+    uint32_t seed{0};
+
+    // Animated instances in a square grid above the floor
+    size_t instanceCount{81 * 81};
+
+    // Clamped to what the deferred pipeline can hold
+    size_t spotLightCount{2};
+};
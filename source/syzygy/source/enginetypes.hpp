@@ -35,6 +35,13 @@ enum class RenderingPipelines
 
 template <typename T> struct TStagedBuffer;
 
+// A contiguous range of instances that are drawn together.
+struct InstanceRange
+{
+    uint32_t firstInstance{0};
+    uint32_t instanceCount{0};
+};
+
 struct MeshInstances
 {
     std::unique_ptr<TStagedBuffer<glm::mat4x4>> models{};
@@ -44,6 +51,18 @@ struct MeshInstances
 
     // An index to where the first dynamic object begins
     size_t dynamicIndex{};
+
+    // Instance indices sorted by the level of detail they are drawn with.
+    // Draws index into this first, then into the model buffers.
+    std::unique_ptr<TStagedBuffer<uint32_t>> lodSortedIndices{};
+
+    // Per surface, the range of lodSortedIndices drawn at each level of
+    // detail, starting from full detail.
+    std::vector<std::vector<InstanceRange>> lodRanges{};
+
+    // Reused by each selection of levels of detail
+    std::vector<float> lodPixelScales{};
+    std::vector<uint32_t> lodSortScratch{};
 };
 
 struct SceneBounds
@@ -61,38 +80,32 @@ struct Vertex
     glm::vec4 color;
 };
 
-struct RingBuffer
+// Matches the VERTEX_FORMAT_* definitions in shaders/types/vertex.glsl.
+enum class VertexFormat : uint32_t
 {
-    void write(double const value)
-    {
-        m_values[m_index] = value;
-        m_index += 1;
-        m_saturated |= (m_index >= m_values.size());
-        m_index = m_index % m_values.size();
-    }
+    FULL = 0,
+    PACKED = 1,
+};
 
-    static double arithmeticAverage(std::span<double const> const span)
-    {
-        double const sum{std::accumulate(span.begin(), span.end(), 1.0)};
-        return sum / static_cast<double>(span.size());
-    }
+// A 16 byte vertex, quantized from Vertex:
+// x: position.xy as unorm16, relative to the mesh's position bounds
+// y: position.z as unorm16, octahedral normal as snorm8 in the upper bytes
+// z: uv as two half floats
+// w: color as unorm8 RGBA
+struct PackedVertex
+{
+    glm::uvec4 data;
+};
 
-    double average() const
-    {
-        if (!m_saturated)
-        {
-            std::span<double const> const validSpan(m_values.data(), m_index);
-            return arithmeticAverage(validSpan);
-        }
-        return arithmeticAverage(m_values);
-    };
-    size_t current() const { return m_index; }
-    std::span<double const> values() const { return m_values; }
+// Everything needed by shaders to read a vertex buffer.
+struct VertexEncoding
+{
+    VertexFormat format{VertexFormat::FULL};
 
-private:
-    std::array<double, 500> m_values{};
-    size_t m_index{0};
-    bool m_saturated{false};
+    // Packed positions are stored as a fraction of these bounds. Unused for
+    // full vertices.
+    glm::vec3 positionMin{0.0F};
+    glm::vec3 positionExtent{1.0F};
 };
 
 // A quick and dirty way to keep track of the destruction order for
@@ -0,0 +1,86 @@
+#include "frametimes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+// Nearest-rank percentile, so the result is always a measured frame
+auto percentile(std::span<double const> const sorted, double const fraction)
+    -> double
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    auto const rank{static_cast<size_t>(
+        std::ceil(fraction * static_cast<double>(sorted.size()))
+    )};
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+} // namespace
+
+FrameTimeStatistics::FrameTimeStatistics(size_t const capacity)
+    : m_values(std::max<size_t>(capacity, 1), 0.0)
+{
+}
+
+void FrameTimeStatistics::write(double const milliseconds)
+{
+    m_values[m_index] = milliseconds;
+    m_index = (m_index + 1) % m_values.size();
+    m_count = std::min(m_count + 1, m_values.size());
+}
+
+auto FrameTimeStatistics::summarize(
+    size_t const windowFrames, double const stutterFactor
+) const -> FrameTimeSummary
+{
+    size_t const frames{std::min(windowFrames, m_count)};
+    if (frames == 0)
+    {
+        return FrameTimeSummary{};
+    }
+
+    // Walk back from the newest frame, since the values wrap around
+    std::vector<double> sorted{};
+    sorted.reserve(frames);
+    for (size_t i{1}; i <= frames; i++)
+    {
+        sorted.push_back(
+            m_values[(m_index + m_values.size() - i) % m_values.size()]
+        );
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    FrameTimeSummary summary{
+        .frames = frames,
+        .meanMilliseconds = std::accumulate(sorted.begin(), sorted.end(), 0.0)
+                          / static_cast<double>(frames),
+        .p50Milliseconds = percentile(sorted, 0.50),
+        .p95Milliseconds = percentile(sorted, 0.95),
+        .p99Milliseconds = percentile(sorted, 0.99),
+        .maxMilliseconds = sorted.back(),
+    };
+
+    double const stutterThreshold{summary.p50Milliseconds * stutterFactor};
+    for (double const milliseconds : sorted)
+    {
+        if (milliseconds > stutterThreshold)
+        {
+            summary.stutters += 1;
+        }
+
+        // Clamp before converting, so huge or negative times stay in range
+        double const bucket{std::clamp(
+            milliseconds / FrameTimeSummary::HISTOGRAM_BUCKET_MILLISECONDS,
+            0.0,
+            static_cast<double>(FrameTimeSummary::HISTOGRAM_BUCKET_COUNT - 1)
+        )};
+        summary.histogram[static_cast<size_t>(bucket)] += 1;
+    }
+
+    return summary;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Tail latency of frames over a window of the most recent frames, all in
+// milliseconds.
+struct FrameTimeSummary
+{
+    // Buckets are HISTOGRAM_BUCKET_MILLISECONDS wide, and the last one also
+    // counts every longer frame.
+    static size_t constexpr HISTOGRAM_BUCKET_COUNT{25};
+    static double constexpr HISTOGRAM_BUCKET_MILLISECONDS{2.0};
+
+    size_t frames{0};
+
+    double meanMilliseconds{0.0};
+    double p50Milliseconds{0.0};
+    double p95Milliseconds{0.0};
+    double p99Milliseconds{0.0};
+    double maxMilliseconds{0.0};
+
+    // Frames that took longer than the median by the stutter factor
+    size_t stutters{0};
+
+    std::array<size_t, HISTOGRAM_BUCKET_COUNT> histogram{};
+};
+
+// Keeps the time of the most recent frames to summarize their distribution.
+// Frame rate averages hide hitches, so prefer the percentiles for judging
+// smoothness.
+class FrameTimeStatistics
+{
+public:
+    static size_t constexpr DEFAULT_CAPACITY{2000};
+    static double constexpr DEFAULT_STUTTER_FACTOR{2.0};
+
+    explicit FrameTimeStatistics(size_t capacity = DEFAULT_CAPACITY);
+
+    void write(double milliseconds);
+
+    // Summarizes up to windowFrames of the most recent frames. A frame
+    // counts as a stutter when it exceeds the window's median by
+    // stutterFactor.
+    FrameTimeSummary summarize(
+        size_t windowFrames, double stutterFactor = DEFAULT_STUTTER_FACTOR
+    ) const;
+
+    size_t capacity() const { return m_values.size(); }
+    size_t count() const { return m_count; }
+
+    // Where the next frame is written, since the values wrap around.
+    size_t current() const { return m_index; }
+    std::span<double const> values() const { return m_values; }
+
+private:
+    std::vector<double> m_values{};
+    size_t m_index{0};
+    size_t m_count{0};
+};
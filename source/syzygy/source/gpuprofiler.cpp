@@ -0,0 +1,471 @@
+#include "gpuprofiler.hpp"
+
+#include "helpers.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+// Results are written in the order of these bits, which WorkCounters matches
+VkQueryPipelineStatisticFlags constexpr PIPELINE_STATISTICS{
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT
+};
+size_t constexpr PIPELINE_STATISTICS_COUNT{4};
+} // namespace
+
+auto WorkCounters::operator+=(WorkCounters const& other) -> WorkCounters&
+{
+    drawCalls += other.drawCalls;
+    dispatches += other.dispatches;
+    barriers += other.barriers;
+    bytesCopied += other.bytesCopied;
+    instances += other.instances;
+    primitives += other.primitives;
+    vertexInvocations += other.vertexInvocations;
+    fragmentInvocations += other.fragmentInvocations;
+    computeInvocations += other.computeInvocations;
+    return *this;
+}
+
+void GPUProfiler::init(
+    VkPhysicalDevice const physicalDevice,
+    VkDevice const device,
+    uint32_t const queueFamilyIndex,
+    size_t const framesInFlight,
+    bool const pipelineStatisticsEnabled
+)
+{
+    if (m_loadedGPUProfiler != nullptr)
+    {
+        Warning("Called GPUProfiler::init when one was already loaded.");
+        return;
+    }
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t queueFamilyCount{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        physicalDevice, &queueFamilyCount, nullptr
+    );
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        physicalDevice, &queueFamilyCount, queueFamilies.data()
+    );
+
+    uint32_t const validBits{
+        queueFamilyIndex < queueFamilies.size()
+            ? queueFamilies[queueFamilyIndex].timestampValidBits
+            : 0
+    };
+    if (validBits == 0 || properties.limits.timestampPeriod == 0.0F)
+    {
+        Warning("Queue does not support timestamps, GPU profiling disabled.");
+        return;
+    }
+
+    std::unique_ptr<GPUProfiler> profiler{new GPUProfiler()};
+    profiler->m_device = device;
+    profiler->m_nanosecondsPerTick =
+        static_cast<double>(properties.limits.timestampPeriod);
+    profiler->m_timestampMask =
+        validBits >= 64 ? ~0ULL : (1ULL << validBits) - 1;
+    profiler->m_pipelineStatisticsSupported = pipelineStatisticsEnabled;
+
+    VkQueryPoolCreateInfo const createInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = static_cast<uint32_t>(MAX_SCOPES_PER_FRAME * 2),
+        .pipelineStatistics = 0,
+    };
+
+    VkQueryPoolCreateInfo const statisticsCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        .queryCount = static_cast<uint32_t>(MAX_SCOPES_PER_FRAME),
+        .pipelineStatistics = PIPELINE_STATISTICS,
+    };
+
+    profiler->m_frames.resize(framesInFlight);
+    for (FrameQueries& frame : profiler->m_frames)
+    {
+        VkResult const result{
+            vkCreateQueryPool(device, &createInfo, nullptr, &frame.queryPool)
+        };
+        if (result != VK_SUCCESS)
+        {
+            LogVkResult(result, "Creating GPU profiler query pool");
+            return;
+        }
+
+        if (!profiler->m_pipelineStatisticsSupported)
+        {
+            continue;
+        }
+
+        VkResult const statisticsResult{vkCreateQueryPool(
+            device,
+            &statisticsCreateInfo,
+            nullptr,
+            &frame.statisticsQueryPool
+        )};
+        if (statisticsResult != VK_SUCCESS)
+        {
+            LogVkResult(
+                statisticsResult, "Creating GPU profiler statistics query pool"
+            );
+            return;
+        }
+    }
+
+    m_loadedGPUProfiler = std::move(profiler);
+}
+
+void GPUProfiler::cleanup() { m_loadedGPUProfiler.reset(); }
+
+void GPUProfiler::countWork(WorkCounters const& work)
+{
+    GPUProfiler* const profiler{m_loadedGPUProfiler.get()};
+    if (profiler == nullptr || !profiler->m_openFrame.has_value())
+    {
+        return;
+    }
+
+    FrameQueries& frame{profiler->m_frames[profiler->m_openFrame.value()]};
+    if (profiler->m_openScope.has_value())
+    {
+        frame.scopeWork[profiler->m_openScope.value()] += work;
+    }
+    else
+    {
+        frame.unscopedWork += work;
+    }
+}
+
+GPUProfiler::~GPUProfiler()
+{
+    for (FrameQueries const& frame : m_frames)
+    {
+        vkDestroyQueryPool(m_device, frame.queryPool, nullptr);
+        vkDestroyQueryPool(m_device, frame.statisticsQueryPool, nullptr);
+    }
+}
+
+void GPUProfiler::beginFrame(VkCommandBuffer const cmd, size_t const frameIndex)
+{
+    size_t const index{frameIndex % m_frames.size()};
+    FrameQueries& frame{m_frames[index]};
+
+    if (frame.submitted)
+    {
+        readResults(frame);
+    }
+
+    frame.scopeIndices.clear();
+    frame.scopeWork.clear();
+    frame.unscopedWork = WorkCounters{};
+    frame.submitted = false;
+
+    vkCmdResetQueryPool(
+        cmd,
+        frame.queryPool,
+        0,
+        static_cast<uint32_t>(MAX_SCOPES_PER_FRAME * 2)
+    );
+    if (m_pipelineStatisticsSupported)
+    {
+        vkCmdResetQueryPool(
+            cmd,
+            frame.statisticsQueryPool,
+            0,
+            static_cast<uint32_t>(MAX_SCOPES_PER_FRAME)
+        );
+    }
+
+    m_openFrame = index;
+    m_openScope.reset();
+}
+
+void GPUProfiler::endFrame()
+{
+    if (!m_openFrame.has_value())
+    {
+        return;
+    }
+
+    m_frames[m_openFrame.value()].submitted = true;
+    m_openFrame.reset();
+    m_openScope.reset();
+}
+
+auto GPUProfiler::beginScope(
+    VkCommandBuffer const cmd, std::string_view const name
+) -> std::optional<uint32_t>
+{
+    if (!m_openFrame.has_value())
+    {
+        return std::nullopt;
+    }
+
+    FrameQueries& frame{m_frames[m_openFrame.value()]};
+    if (frame.scopeIndices.size() >= MAX_SCOPES_PER_FRAME
+        || m_openScope.has_value())
+    {
+        return std::nullopt;
+    }
+
+    auto const queryPair{static_cast<uint32_t>(frame.scopeIndices.size())};
+    frame.scopeIndices.push_back(findOrAddScope(name));
+    frame.scopeWork.push_back(WorkCounters{});
+
+    vkCmdWriteTimestamp2(
+        cmd,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        frame.queryPool,
+        queryPair * 2
+    );
+    if (m_pipelineStatisticsSupported)
+    {
+        vkCmdBeginQuery(cmd, frame.statisticsQueryPool, queryPair, 0);
+    }
+
+    m_openScope = queryPair;
+
+    return queryPair;
+}
+
+void GPUProfiler::endScope(VkCommandBuffer const cmd, uint32_t const queryPair)
+{
+    if (!m_openFrame.has_value())
+    {
+        return;
+    }
+
+    FrameQueries const& frame{m_frames[m_openFrame.value()]};
+    if (m_pipelineStatisticsSupported)
+    {
+        vkCmdEndQuery(cmd, frame.statisticsQueryPool, queryPair);
+    }
+    vkCmdWriteTimestamp2(
+        cmd,
+        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        frame.queryPool,
+        queryPair * 2 + 1
+    );
+
+    m_openScope.reset();
+}
+
+auto GPUProfiler::averageMilliseconds(ScopeHistory const& scope) const
+    -> double
+{
+    if (m_historyCount == 0)
+    {
+        return 0.0;
+    }
+
+    double sum{0.0};
+    for (size_t i{0}; i < m_historyCount; i++)
+    {
+        sum += scope.milliseconds[i];
+    }
+    return sum / static_cast<double>(m_historyCount);
+}
+
+auto GPUProfiler::exportCSV(std::filesystem::path const& path) const -> bool
+{
+    std::error_code error{};
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        Warning(fmt::format("Unable to write GPU timings to {}", path.string())
+        );
+        return false;
+    }
+
+    file << "frame";
+    for (ScopeHistory const& scope : m_scopes)
+    {
+        file << "," << scope.name;
+    }
+    file << "\n";
+
+    // Once the history wraps, the oldest frame is the next to be written
+    size_t const oldest{m_historyCount < HISTORY_LENGTH ? 0 : m_historyIndex};
+    for (size_t frame{0}; frame < m_historyCount; frame++)
+    {
+        size_t const index{(oldest + frame) % HISTORY_LENGTH};
+
+        file << frame;
+        for (ScopeHistory const& scope : m_scopes)
+        {
+            file << "," << fmt::format("{:.4f}", scope.milliseconds[index]);
+        }
+        file << "\n";
+    }
+
+    Log(fmt::format(
+        "Exported {} frames of GPU timings to {}", m_historyCount, path.string()
+    ));
+    return true;
+}
+
+void GPUProfiler::readResults(FrameQueries& frame)
+{
+    readWork(frame);
+
+    size_t const queryCount{frame.scopeIndices.size() * 2};
+    if (queryCount == 0)
+    {
+        return;
+    }
+
+    // Each query is its timestamp followed by its availability
+    std::vector<uint64_t> results(queryCount * 2);
+    VkResult const result{vkGetQueryPoolResults(
+        m_device,
+        frame.queryPool,
+        0,
+        static_cast<uint32_t>(queryCount),
+        results.size() * sizeof(uint64_t),
+        results.data(),
+        sizeof(uint64_t) * 2,
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+    )};
+    if (result != VK_SUCCESS && result != VK_NOT_READY)
+    {
+        LogVkResult(result, "Reading GPU profiler timestamps");
+        return;
+    }
+
+    std::vector<double> frameMilliseconds(m_scopes.size(), 0.0);
+    for (size_t pair{0}; pair < frame.scopeIndices.size(); pair++)
+    {
+        uint64_t const begin{results[pair * 4]};
+        bool const beginAvailable{results[pair * 4 + 1] != 0};
+        uint64_t const end{results[pair * 4 + 2]};
+        bool const endAvailable{results[pair * 4 + 3] != 0};
+
+        if (!beginAvailable || !endAvailable)
+        {
+            continue;
+        }
+
+        uint64_t const ticks{(end - begin) & m_timestampMask};
+        frameMilliseconds[frame.scopeIndices[pair]] +=
+            static_cast<double>(ticks) * m_nanosecondsPerTick / 1'000'000.0;
+    }
+
+    for (size_t scope{0}; scope < m_scopes.size(); scope++)
+    {
+        m_scopes[scope].milliseconds[m_historyIndex] = frameMilliseconds[scope];
+    }
+
+    m_historyIndex = (m_historyIndex + 1) % HISTORY_LENGTH;
+    m_historyCount = std::min(m_historyCount + 1, HISTORY_LENGTH);
+    m_framesRead += 1;
+}
+
+void GPUProfiler::readWork(FrameQueries const& frame)
+{
+    m_frameWork = frame.unscopedWork;
+    for (ScopeHistory& scope : m_scopes)
+    {
+        scope.work = WorkCounters{};
+    }
+
+    size_t const queryCount{frame.scopeIndices.size()};
+    if (queryCount == 0)
+    {
+        return;
+    }
+
+    // Each query is its statistics followed by its availability
+    size_t constexpr STRIDE{PIPELINE_STATISTICS_COUNT + 1};
+    std::vector<uint64_t> results(queryCount * STRIDE, 0);
+    if (m_pipelineStatisticsSupported)
+    {
+        VkResult const result{vkGetQueryPoolResults(
+            m_device,
+            frame.statisticsQueryPool,
+            0,
+            static_cast<uint32_t>(queryCount),
+            results.size() * sizeof(uint64_t),
+            results.data(),
+            STRIDE * sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+        )};
+        if (result != VK_SUCCESS && result != VK_NOT_READY)
+        {
+            LogVkResult(result, "Reading GPU profiler pipeline statistics");
+            std::fill(results.begin(), results.end(), 0);
+        }
+    }
+
+    for (size_t query{0}; query < queryCount; query++)
+    {
+        WorkCounters work{frame.scopeWork[query]};
+
+        std::span<uint64_t const> const statistics{
+            results.data() + query * STRIDE, STRIDE
+        };
+        if (statistics[PIPELINE_STATISTICS_COUNT] != 0)
+        {
+            work.primitives = statistics[0];
+            work.vertexInvocations = statistics[1];
+            work.fragmentInvocations = statistics[2];
+            work.computeInvocations = statistics[3];
+        }
+
+        m_scopes[frame.scopeIndices[query]].work += work;
+        m_frameWork += work;
+    }
+}
+
+auto GPUProfiler::findOrAddScope(std::string_view const name) -> size_t
+{
+    for (size_t index{0}; index < m_scopes.size(); index++)
+    {
+        if (m_scopes[index].name == name)
+        {
+            return index;
+        }
+    }
+
+    m_scopes.push_back(ScopeHistory{
+        .name = std::string{name},
+        .milliseconds = std::vector<double>(HISTORY_LENGTH, 0.0),
+    });
+    return m_scopes.size() - 1;
+}
+
+GPUProfileScope::GPUProfileScope(
+    VkCommandBuffer const cmd, std::string_view const name
+)
+    : m_cmd(cmd)
+{
+    if (GPUProfiler* const profiler{GPUProfiler::getLoadedGPUProfiler()};
+        profiler != nullptr)
+    {
+        m_queryPair = profiler->beginScope(cmd, name);
+    }
+}
+
+GPUProfileScope::~GPUProfileScope()
+{
+    GPUProfiler* const profiler{GPUProfiler::getLoadedGPUProfiler()};
+    if (profiler != nullptr && m_queryPair.has_value())
+    {
+        profiler->endScope(m_cmd, m_queryPair.value());
+    }
+}
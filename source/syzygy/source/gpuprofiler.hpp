@@ -0,0 +1,180 @@
+#pragma once
+
+#include "enginetypes.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The amount of work recorded into a frame or a scope of it.
+struct WorkCounters
+{
+    // Counted while recording
+    uint64_t drawCalls{0};
+    uint64_t dispatches{0};
+    uint64_t barriers{0};
+    uint64_t bytesCopied{0};
+
+    // Only draws whose counts are known while recording, so indirect draws
+    // are not included
+    uint64_t instances{0};
+
+    // From pipeline statistics queries, so zero when they are unsupported.
+    // Primitives are triangles, except for line draws.
+    uint64_t primitives{0};
+    uint64_t vertexInvocations{0};
+    uint64_t fragmentInvocations{0};
+    uint64_t computeInvocations{0};
+
+    WorkCounters& operator+=(WorkCounters const& other);
+};
+
+// Times named scopes of GPU work with timestamp queries, and counts the work
+// recorded in them. Each frame in flight records into its own query pools,
+// which are read back once the CPU has waited on that frame's fence, so
+// results never stall the frame and arrive a few frames late.
+//
+// There is at most one loaded profiler. Scopes are ignored when none is
+// loaded, or when the device does not support timestamps. Scopes must not
+// nest, since pipeline statistics queries cannot. Only use from the thread
+// that records frames.
+class GPUProfiler
+{
+public:
+    static size_t constexpr MAX_SCOPES_PER_FRAME{32};
+    static size_t constexpr HISTORY_LENGTH{500};
+
+    // Per-frame time spent in every scope of one name
+    struct ScopeHistory
+    {
+        std::string name{};
+        std::vector<double> milliseconds{};
+
+        // Of the most recently read frame
+        WorkCounters work{};
+    };
+
+    static void init(
+        VkPhysicalDevice physicalDevice,
+        VkDevice device,
+        uint32_t queueFamilyIndex,
+        size_t framesInFlight,
+        bool pipelineStatisticsEnabled
+    );
+
+    // Null when no profiler is loaded.
+    static GPUProfiler* getLoadedGPUProfiler()
+    {
+        return m_loadedGPUProfiler.get();
+    }
+
+    // The device must be idle.
+    static void cleanup();
+
+    // Adds work to the open scope and frame of the loaded profiler. Call
+    // alongside the commands that do the work.
+    static void countWork(WorkCounters const& work);
+
+    GPUProfiler(GPUProfiler const& other) = delete;
+    GPUProfiler& operator=(GPUProfiler const& other) = delete;
+
+    ~GPUProfiler();
+
+    // Reads back the results of the last frame recorded with the same index,
+    // so call it only after waiting on that frame's fence.
+    void beginFrame(VkCommandBuffer cmd, size_t frameIndex);
+
+    // Call once the frame's commands are submitted. Results of frames that
+    // are never submitted are discarded.
+    void endFrame();
+
+    // Returns the query pair of the scope, or nothing if it is not timed.
+    std::optional<uint32_t>
+    beginScope(VkCommandBuffer cmd, std::string_view name);
+    void endScope(VkCommandBuffer cmd, uint32_t queryPair);
+
+    std::span<ScopeHistory const> scopes() const { return m_scopes; }
+
+    // Where the next frame of history is written, since it wraps around.
+    size_t historyIndex() const { return m_historyIndex; }
+    size_t historyCount() const { return m_historyCount; }
+
+    // Every frame whose results were read, which keeps counting after the
+    // history wraps.
+    uint64_t framesRead() const { return m_framesRead; }
+
+    double averageMilliseconds(ScopeHistory const& scope) const;
+
+    // All work of the most recently read frame, including work outside of
+    // any scope.
+    WorkCounters const& frameWork() const { return m_frameWork; }
+    bool pipelineStatisticsSupported() const
+    {
+        return m_pipelineStatisticsSupported;
+    }
+
+    // Writes every frame of history, oldest first, with a column per scope.
+    bool exportCSV(std::filesystem::path const& path) const;
+
+private:
+    GPUProfiler() = default;
+
+    inline static std::unique_ptr<GPUProfiler> m_loadedGPUProfiler{nullptr};
+
+    struct FrameQueries
+    {
+        VkQueryPool queryPool{VK_NULL_HANDLE};
+
+        // One query per scope, when supported
+        VkQueryPool statisticsQueryPool{VK_NULL_HANDLE};
+
+        // The scope of each query pair written this frame
+        std::vector<size_t> scopeIndices{};
+
+        // Counted while recording, indexed like the query pairs
+        std::vector<WorkCounters> scopeWork{};
+        WorkCounters unscopedWork{};
+
+        bool submitted{false};
+    };
+
+    void readResults(FrameQueries& frame);
+    void readWork(FrameQueries const& frame);
+
+    size_t findOrAddScope(std::string_view name);
+
+    VkDevice m_device{VK_NULL_HANDLE};
+
+    double m_nanosecondsPerTick{1.0};
+    uint64_t m_timestampMask{~0ULL};
+    bool m_pipelineStatisticsSupported{false};
+
+    std::vector<FrameQueries> m_frames{};
+    std::optional<size_t> m_openFrame{};
+    std::optional<uint32_t> m_openScope{};
+
+    WorkCounters m_frameWork{};
+
+    std::vector<ScopeHistory> m_scopes{};
+    size_t m_historyIndex{0};
+    size_t m_historyCount{0};
+    uint64_t m_framesRead{0};
+};
+
+// Times the commands recorded during its lifetime into a GPUProfiler scope.
+class GPUProfileScope
+{
+public:
+    GPUProfileScope(VkCommandBuffer cmd, std::string_view name);
+    ~GPUProfileScope();
+
+    GPUProfileScope(GPUProfileScope const& other) = delete;
+    GPUProfileScope& operator=(GPUProfileScope const& other) = delete;
+
+private:
+    VkCommandBuffer m_cmd{VK_NULL_HANDLE};
+    std::optional<uint32_t> m_queryPair{};
+};
@@ -89,4 +89,26 @@ struct LightSpot
     float falloffDistance;
     uint8_t padding0[4]{};
 };
+// See Meshlet in assets.hpp
+struct Meshlet
+{
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+
+    glm::vec3 coneAxis;
+    float coneCutoff;
+
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+    uint8_t padding0[4]{};
+};
+
+// A view that meshlets are culled against.
+struct CullView
+{
+    glm::mat4x4 projView;
+
+    glm::vec4 position;
+};
 } // namespace gputypes
@@ -89,6 +89,20 @@ void Error(std::string const& message, std::source_location const location)
     LogBase(message, location, fmt::color::red);
 }
 
+auto EscapeJSON(std::string_view const text) -> std::string
+{
+    std::string escaped{};
+    for (char const character : text)
+    {
+        if (character == '"' || character == '\\')
+        {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(character);
+    }
+    return escaped;
+}
+
 void DebugUtils::init()
 {
     std::filesystem::path const sourcePath{
@@ -106,6 +120,8 @@ void DebugUtils::init()
 
     m_loadedDebugUtils = std::make_unique<DebugUtils>();
     m_loadedDebugUtils->m_sourcePath = sourcePath;
+    m_loadedDebugUtils->m_binaryPath =
+        std::filesystem::weakly_canonical(std::filesystem::path{BINARY_DIR});
 
     PrintLine(
         fmt::format(
@@ -143,6 +159,18 @@ auto DebugUtils::loadAssetPath(std::filesystem::path const& localPath) const
     return std::make_unique<std::filesystem::path>(makeAbsolutePath(localPath));
 }
 
+auto DebugUtils::loadBuildOutputPath(std::filesystem::path const& localPath
+) const -> std::unique_ptr<std::filesystem::path>
+{
+    if (!validateRelativePath(localPath))
+    {
+        return nullptr;
+    }
+    return std::make_unique<std::filesystem::path>(
+        (m_binaryPath / localPath).lexically_normal()
+    );
+}
+
 auto DebugUtils::makeRelativePath(std::filesystem::path const& absolutePath
 ) const -> std::filesystem::path
 {
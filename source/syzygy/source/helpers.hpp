@@ -4,6 +4,7 @@
 #include <filesystem>
 #include <fmt/color.h>
 #include <source_location>
+#include <string_view>
 #include <vulkan/vk_enum_string_helper.h>
 
 #define VKR_ARRAY(x) static_cast<uint32_t>(x.size()), x.data()
@@ -25,6 +26,7 @@ public:
 
 private:
     std::filesystem::path m_sourcePath{};
+    std::filesystem::path m_binaryPath{};
 
     inline static std::unique_ptr<DebugUtils> m_loadedDebugUtils{nullptr};
 
@@ -47,6 +49,12 @@ public:
     std::unique_ptr<std::filesystem::path>
     loadAssetPath(std::filesystem::path const& localPath) const;
 
+    // Returns the absolute path to a build output, such as a compiled shader,
+    // specified by the path relative to the build tree's root. Null when the
+    // path is invalid as defined by validateRelativePath.
+    std::unique_ptr<std::filesystem::path>
+    loadBuildOutputPath(std::filesystem::path const& localPath) const;
+
     // Given an absolute path on disk, returns the portion relative
     // to the project's root.
     // Asserts that the path is valid as defined by validateRelativePath.
@@ -115,3 +123,7 @@ void Error(
     std::string const& message,
     std::source_location location = std::source_location::current()
 );
+
+// Escapes quotes and backslashes, so the text can be written into a JSON
+// string.
+std::string EscapeJSON(std::string_view text);
@@ -1,5 +1,6 @@
 #include "images.hpp"
 
+#include "gpuprofiler.hpp"
 #include "helpers.hpp"
 #include "initializers.hpp"
 
@@ -48,6 +49,7 @@ void vkutil::transitionImage(
     };
 
     vkCmdPipelineBarrier2(cmd, &depInfo);
+    GPUProfiler::countWork(WorkCounters{.barriers = 1});
 }
 
 void vkutil::recordCopyImageToImage(
@@ -219,12 +221,13 @@ auto AllocatedImage::allocate(
         .imageFormat = parameters.format
     };
 
-    VkImageCreateInfo const imageInfo{vkinit::imageCreateInfo(
+    VkImageCreateInfo imageInfo{vkinit::imageCreateInfo(
         image.imageFormat,
         VK_IMAGE_LAYOUT_UNDEFINED,
         parameters.usageFlags,
         image.imageExtent
     )};
+    imageInfo.mipLevels = parameters.mipLevels;
 
     VmaAllocationCreateInfo const imageAllocInfo{
         .usage = VMA_MEMORY_USAGE_GPU_ONLY,
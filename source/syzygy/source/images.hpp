@@ -92,6 +92,9 @@ struct AllocatedImage
         VkFormat format;
         VkImageUsageFlags usageFlags;
         VkImageAspectFlags viewFlags;
+
+        // The view covers every level.
+        uint32_t mipLevels{1};
     };
 
     static std::optional<AllocatedImage> allocate(
@@ -0,0 +1,352 @@
+#include "inputrecording.hpp"
+
+#include "helpers.hpp"
+
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+namespace
+{
+// "SZYR", followed by the version. Bump the version whenever the layout of
+// frames changes, since older logs are not migrated.
+uint32_t constexpr MAGIC{0x52595A53};
+uint32_t constexpr VERSION{2};
+
+// Which optional blocks follow a frame's fixed fields
+uint8_t constexpr CHANGED_CAMERA{1U << 0U};
+uint8_t constexpr CHANGED_ATMOSPHERE{1U << 1U};
+uint8_t constexpr CHANGED_SETTINGS{1U << 2U};
+
+uint8_t constexpr TOGGLE_SHOULD_RENDER{1U << 0U};
+uint8_t constexpr TOGGLE_ORTHOGRAPHIC{1U << 1U};
+uint8_t constexpr TOGGLE_SPOTLIGHTS{1U << 2U};
+uint8_t constexpr TOGGLE_MESH_INSTANCES{1U << 3U};
+uint8_t constexpr TOGGLE_COMPUTE_COLLECTION{1U << 4U};
+
+// Flags within the settings block
+uint8_t constexpr SETTING_SHADOWS{1U << 0U};
+uint8_t constexpr SETTING_MESHLET_CULLING{1U << 1U};
+uint8_t constexpr SETTING_LOD{1U << 2U};
+
+// Values are written in the host's byte order, which is little endian on
+// every platform the engine targets.
+template <typename T> void writeValue(std::ofstream& file, T const& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+class LogReader
+{
+public:
+    explicit LogReader(std::vector<char> bytes)
+        : m_bytes(std::move(bytes))
+    {
+    }
+
+    template <typename T> auto read(T& value) -> bool
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (m_bytes.size() - m_offset < sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&value, m_bytes.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    auto finished() const -> bool { return m_offset == m_bytes.size(); }
+
+private:
+    std::vector<char> m_bytes;
+    size_t m_offset{0};
+};
+
+auto cameraEquals(CameraParameters const& lhs, CameraParameters const& rhs)
+    -> bool
+{
+    return lhs.cameraPosition == rhs.cameraPosition
+        && lhs.eulerAngles == rhs.eulerAngles && lhs.fov == rhs.fov
+        && lhs.near == rhs.near && lhs.far == rhs.far;
+}
+
+// Animation settings are not compared, since replays fix the sun to its
+// recorded direction.
+auto atmosphereEquals(
+    AtmosphereParameters const& lhs, AtmosphereParameters const& rhs
+) -> bool
+{
+    return lhs.sunEulerAngles == rhs.sunEulerAngles
+        && lhs.earthRadiusMeters == rhs.earthRadiusMeters
+        && lhs.atmosphereRadiusMeters == rhs.atmosphereRadiusMeters
+        && lhs.groundColor == rhs.groundColor
+        && lhs.scatteringCoefficientRayleigh
+               == rhs.scatteringCoefficientRayleigh
+        && lhs.altitudeDecayRayleigh == rhs.altitudeDecayRayleigh
+        && lhs.scatteringCoefficientMie == rhs.scatteringCoefficientMie
+        && lhs.altitudeDecayMie == rhs.altitudeDecayMie;
+}
+
+void writeCamera(std::ofstream& file, CameraParameters const& camera)
+{
+    writeValue(file, camera.cameraPosition);
+    writeValue(file, camera.eulerAngles);
+    writeValue(file, camera.fov);
+    writeValue(file, camera.near);
+    writeValue(file, camera.far);
+}
+
+auto readCamera(LogReader& reader, CameraParameters& camera) -> bool
+{
+    return reader.read(camera.cameraPosition)
+        && reader.read(camera.eulerAngles) && reader.read(camera.fov)
+        && reader.read(camera.near) && reader.read(camera.far);
+}
+
+void writeAtmosphere(std::ofstream& file, AtmosphereParameters const& sky)
+{
+    writeValue(file, sky.sunEulerAngles);
+    writeValue(file, sky.earthRadiusMeters);
+    writeValue(file, sky.atmosphereRadiusMeters);
+    writeValue(file, sky.groundColor);
+    writeValue(file, sky.scatteringCoefficientRayleigh);
+    writeValue(file, sky.altitudeDecayRayleigh);
+    writeValue(file, sky.scatteringCoefficientMie);
+    writeValue(file, sky.altitudeDecayMie);
+}
+
+auto readAtmosphere(LogReader& reader, AtmosphereParameters& sky) -> bool
+{
+    return reader.read(sky.sunEulerAngles)
+        && reader.read(sky.earthRadiusMeters)
+        && reader.read(sky.atmosphereRadiusMeters)
+        && reader.read(sky.groundColor)
+        && reader.read(sky.scatteringCoefficientRayleigh)
+        && reader.read(sky.altitudeDecayRayleigh)
+        && reader.read(sky.scatteringCoefficientMie)
+        && reader.read(sky.altitudeDecayMie);
+}
+
+// The pipeline, level of detail, streaming and mesh selection settings, which
+// change rarely enough to share one block.
+auto settingsEqual(FrameInputs const& lhs, FrameInputs const& rhs) -> bool
+{
+    return lhs.deferredParameters == rhs.deferredParameters
+        && lhs.lodParameters == rhs.lodParameters
+        && lhs.textureStreaming == rhs.textureStreaming
+        && lhs.meshResidency == rhs.meshResidency
+        && lhs.testMesh == rhs.testMesh;
+}
+
+void writeSettings(std::ofstream& file, FrameInputs const& inputs)
+{
+    DeferredShadingPipeline::Parameters const& deferred{
+        inputs.deferredParameters
+    };
+
+    uint8_t flags{0};
+    flags |= deferred.shadows ? SETTING_SHADOWS : 0U;
+    flags |= deferred.meshletCulling ? SETTING_MESHLET_CULLING : 0U;
+    flags |= inputs.lodParameters.enabled ? SETTING_LOD : 0U;
+
+    writeValue(file, flags);
+    writeValue(file, static_cast<uint8_t>(deferred.skyQuality));
+    writeValue(file, deferred.shadowPassParameters.depthBiasConstant);
+    writeValue(file, deferred.shadowPassParameters.depthBiasSlope);
+    writeValue(file, inputs.lodParameters.maxErrorPixels);
+    writeValue(file, inputs.textureStreaming.budgetMegabytes);
+    writeValue(file, inputs.textureStreaming.uploadMegabytesPerFrame);
+    writeValue(file, inputs.meshResidency.budgetMegabytes);
+    writeValue(file, inputs.meshResidency.deviceBudgetFraction);
+    writeValue(file, inputs.testMesh.index);
+    writeValue(file, inputs.testMesh.generation);
+}
+
+auto readSettings(LogReader& reader, FrameInputs& inputs) -> bool
+{
+    DeferredShadingPipeline::Parameters& deferred{inputs.deferredParameters};
+
+    uint8_t flags{0};
+    uint8_t skyQuality{0};
+    bool const read{
+        reader.read(flags) && reader.read(skyQuality)
+        && reader.read(deferred.shadowPassParameters.depthBiasConstant)
+        && reader.read(deferred.shadowPassParameters.depthBiasSlope)
+        && reader.read(inputs.lodParameters.maxErrorPixels)
+        && reader.read(inputs.textureStreaming.budgetMegabytes)
+        && reader.read(inputs.textureStreaming.uploadMegabytesPerFrame)
+        && reader.read(inputs.meshResidency.budgetMegabytes)
+        && reader.read(inputs.meshResidency.deviceBudgetFraction)
+        && reader.read(inputs.testMesh.index)
+        && reader.read(inputs.testMesh.generation)
+    };
+    auto constexpr SKY_QUALITY_MAX{
+        static_cast<uint8_t>(DeferredShadingPipeline::SkyQuality::HIGH)
+    };
+    if (!read || skyQuality > SKY_QUALITY_MAX)
+    {
+        return false;
+    }
+
+    deferred.shadows = (flags & SETTING_SHADOWS) != 0;
+    deferred.meshletCulling = (flags & SETTING_MESHLET_CULLING) != 0;
+    deferred.skyQuality =
+        static_cast<DeferredShadingPipeline::SkyQuality>(skyQuality);
+    inputs.lodParameters.enabled = (flags & SETTING_LOD) != 0;
+
+    return true;
+}
+} // namespace
+
+InputRecorder::InputRecorder(std::ofstream&& file)
+    : m_file(std::move(file))
+{
+}
+
+auto InputRecorder::create(std::filesystem::path const& path)
+    -> std::unique_ptr<InputRecorder>
+{
+    std::error_code error{};
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        Warning(fmt::format("Unable to record inputs to {}", path.string()));
+        return nullptr;
+    }
+
+    writeValue(file, MAGIC);
+    writeValue(file, VERSION);
+
+    return std::unique_ptr<InputRecorder>(new InputRecorder(std::move(file)));
+}
+
+void InputRecorder::write(FrameInputs const& inputs)
+{
+    uint8_t changed{0};
+    if (!m_previous.has_value()
+        || !cameraEquals(m_previous->camera, inputs.camera))
+    {
+        changed |= CHANGED_CAMERA;
+    }
+    if (!m_previous.has_value()
+        || !atmosphereEquals(m_previous->atmosphere, inputs.atmosphere))
+    {
+        changed |= CHANGED_ATMOSPHERE;
+    }
+    if (!m_previous.has_value() || !settingsEqual(m_previous.value(), inputs))
+    {
+        changed |= CHANGED_SETTINGS;
+    }
+
+    uint8_t toggles{0};
+    toggles |= inputs.shouldRender ? TOGGLE_SHOULD_RENDER : 0U;
+    toggles |= inputs.useOrthographicProjection ? TOGGLE_ORTHOGRAPHIC : 0U;
+    toggles |= inputs.showSpotlights ? TOGGLE_SPOTLIGHTS : 0U;
+    toggles |= inputs.renderMeshInstances ? TOGGLE_MESH_INSTANCES : 0U;
+    bool const computeCollection{
+        inputs.renderingPipeline == RenderingPipelines::COMPUTE_COLLECTION
+    };
+    toggles |= computeCollection ? TOGGLE_COMPUTE_COLLECTION : 0U;
+
+    writeValue(m_file, changed);
+    writeValue(m_file, toggles);
+    writeValue(m_file, inputs.elapsedTimeSeconds);
+    writeValue(m_file, inputs.deltaTimeSeconds);
+    writeValue(m_file, inputs.windowExtent);
+    writeValue(m_file, inputs.sceneExtent);
+
+    if ((changed & CHANGED_CAMERA) != 0)
+    {
+        writeCamera(m_file, inputs.camera);
+    }
+    if ((changed & CHANGED_ATMOSPHERE) != 0)
+    {
+        writeAtmosphere(m_file, inputs.atmosphere);
+    }
+    if ((changed & CHANGED_SETTINGS) != 0)
+    {
+        writeSettings(m_file, inputs);
+    }
+
+    m_previous = inputs;
+    m_frameCount += 1;
+}
+
+auto loadInputRecording(std::filesystem::path const& path)
+    -> std::optional<std::vector<FrameInputs>>
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        Error(fmt::format("Unable to open input recording {}", path.string()));
+        return std::nullopt;
+    }
+
+    LogReader reader{std::vector<char>(
+        std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()
+    )};
+
+    uint32_t magic{0};
+    uint32_t version{0};
+    if (!reader.read(magic) || !reader.read(version) || magic != MAGIC
+        || version != VERSION)
+    {
+        Error(fmt::format(
+            "{} is not an input recording of version {}.",
+            path.string(),
+            VERSION
+        ));
+        return std::nullopt;
+    }
+
+    std::vector<FrameInputs> frames{};
+    FrameInputs frame{};
+    while (!reader.finished())
+    {
+        uint8_t changed{0};
+        uint8_t toggles{0};
+        bool const read{
+            reader.read(changed) && reader.read(toggles)
+            && reader.read(frame.elapsedTimeSeconds)
+            && reader.read(frame.deltaTimeSeconds)
+            && reader.read(frame.windowExtent)
+            && reader.read(frame.sceneExtent)
+            && ((changed & CHANGED_CAMERA) == 0
+                || readCamera(reader, frame.camera))
+            && ((changed & CHANGED_ATMOSPHERE) == 0
+                || readAtmosphere(reader, frame.atmosphere))
+            && ((changed & CHANGED_SETTINGS) == 0
+                || readSettings(reader, frame))
+        };
+        if (!read)
+        {
+            // A recording cut short, such as by a crash, keeps its whole
+            // frames
+            Warning(fmt::format(
+                "Input recording {} ends mid-frame after {} frames.",
+                path.string(),
+                frames.size()
+            ));
+            break;
+        }
+
+        frame.shouldRender = (toggles & TOGGLE_SHOULD_RENDER) != 0;
+        frame.useOrthographicProjection = (toggles & TOGGLE_ORTHOGRAPHIC) != 0;
+        frame.showSpotlights = (toggles & TOGGLE_SPOTLIGHTS) != 0;
+        frame.renderMeshInstances = (toggles & TOGGLE_MESH_INSTANCES) != 0;
+        frame.renderingPipeline = (toggles & TOGGLE_COMPUTE_COLLECTION) != 0
+                                    ? RenderingPipelines::COMPUTE_COLLECTION
+                                    : RenderingPipelines::DEFERRED;
+
+        frames.push_back(frame);
+    }
+
+    Log(fmt::format(
+        "Loaded {} frames of inputs from {}", frames.size(), path.string()
+    ));
+    return frames;
+}
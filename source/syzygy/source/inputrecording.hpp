@@ -0,0 +1,72 @@
+#pragma once
+
+#include "assetregistry.hpp"
+#include "deferred/deferred.hpp"
+#include "engineparams.hpp"
+#include "enginetypes.hpp"
+#include "meshlod.hpp"
+#include "texturestreamer.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Everything a frame of Engine::mainLoop reads that varies between runs, such
+// as the clock and the user's edits in the UI.
+struct FrameInputs
+{
+    double elapsedTimeSeconds{0.0};
+    double deltaTimeSeconds{0.0};
+    bool shouldRender{true};
+
+    glm::u16vec2 windowExtent{0, 0};
+
+    // The extent of the scene viewport, which the UI lays out
+    glm::u16vec2 sceneExtent{0, 0};
+
+    CameraParameters camera{};
+    bool useOrthographicProjection{false};
+
+    AtmosphereParameters atmosphere{};
+
+    bool showSpotlights{true};
+    bool renderMeshInstances{true};
+    RenderingPipelines renderingPipeline{RenderingPipelines::DEFERRED};
+
+    DeferredShadingPipeline::Parameters deferredParameters{};
+    LODParameters lodParameters{};
+    TextureStreamingParameters textureStreaming{};
+    MeshResidencyParameters meshResidency{};
+
+    // The mesh drawn by the instances, which is the same between runs that
+    // load the same scene
+    MeshHandle testMesh{};
+};
+
+// Appends the inputs of each frame to a binary log. The camera, atmosphere and
+// remaining settings are only written for frames where they changed, so frames
+// without edits take a few dozen bytes.
+class InputRecorder
+{
+public:
+    // Returns null if the file could not be opened.
+    static std::unique_ptr<InputRecorder>
+    create(std::filesystem::path const& path);
+
+    void write(FrameInputs const& inputs);
+
+    size_t frameCount() const { return m_frameCount; }
+
+private:
+    explicit InputRecorder(std::ofstream&& file);
+
+    std::ofstream m_file;
+    std::optional<FrameInputs> m_previous{};
+    size_t m_frameCount{0};
+};
+
+// Reads every frame of a log written by InputRecorder.
+std::optional<std::vector<FrameInputs>>
+loadInputRecording(std::filesystem::path const& path);
@@ -0,0 +1,351 @@
+#include "kernelbenchmark.hpp"
+
+#include "gpuprofiler.hpp"
+#include "helpers.hpp"
+#include "pipelines.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <glm/gtc/packing.hpp>
+#include <iterator>
+#include <limits>
+
+namespace
+{
+// Matches the RGBA half float scene texture the collection draws into
+size_t constexpr BYTES_PER_PIXEL{4 * sizeof(uint16_t)};
+
+auto referencePath(std::string const& shaderName, VkExtent2D const extent)
+    -> std::filesystem::path
+{
+    return DebugUtils::getLoadedDebugUtils().makeAbsolutePath(
+        std::filesystem::path{"cache"} / "kernels"
+        / fmt::format(
+            "{}_{}x{}.bin",
+            std::filesystem::path{shaderName}.stem().string(),
+            extent.width,
+            extent.height
+        )
+    );
+}
+
+auto readReference(std::filesystem::path const& path)
+    -> std::optional<std::vector<uint16_t>>
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<char> const bytes{
+        std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()
+    };
+    std::vector<uint16_t> halves(bytes.size() / sizeof(uint16_t));
+    std::copy_n(
+        bytes.begin(),
+        halves.size() * sizeof(uint16_t),
+        reinterpret_cast<char*>(halves.data())
+    );
+    return halves;
+}
+
+void writeReference(
+    std::filesystem::path const& path, std::span<uint16_t const> const halves
+)
+{
+    std::error_code error{};
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        Warning(fmt::format("Unable to write reference {}", path.string()));
+        return;
+    }
+
+    file.write(
+        reinterpret_cast<char const*>(halves.data()),
+        static_cast<std::streamsize>(halves.size_bytes())
+    );
+    Log(fmt::format("Saved reference output to {}", path.string()));
+}
+} // namespace
+
+auto KernelBenchmark::create(
+    VkPhysicalDevice const physicalDevice,
+    VkDevice const device,
+    VmaAllocator const allocator,
+    uint32_t const queueFamilyIndex
+) -> std::unique_ptr<KernelBenchmark>
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t queueFamilyCount{0};
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        physicalDevice, &queueFamilyCount, nullptr
+    );
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        physicalDevice, &queueFamilyCount, queueFamilies.data()
+    );
+
+    uint32_t const validBits{
+        queueFamilyIndex < queueFamilies.size()
+            ? queueFamilies[queueFamilyIndex].timestampValidBits
+            : 0
+    };
+    if (validBits == 0 || properties.limits.timestampPeriod == 0.0F)
+    {
+        Warning("Queue does not support timestamps, kernels cannot be timed.");
+        return nullptr;
+    }
+
+    std::unique_ptr<KernelBenchmark> benchmark{new KernelBenchmark()};
+    benchmark->m_device = device;
+    benchmark->m_allocator = allocator;
+    benchmark->m_nanosecondsPerTick =
+        static_cast<double>(properties.limits.timestampPeriod);
+    benchmark->m_timestampMask =
+        validBits >= 64 ? ~0ULL : (1ULL << validBits) - 1;
+
+    VkQueryPoolCreateInfo const createInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = 2,
+        .pipelineStatistics = 0,
+    };
+    VkResult const result{vkCreateQueryPool(
+        device, &createInfo, nullptr, &benchmark->m_queryPool
+    )};
+    if (result != VK_SUCCESS)
+    {
+        LogVkResult(result, "Creating kernel benchmark query pool");
+        return nullptr;
+    }
+
+    return benchmark;
+}
+
+KernelBenchmark::~KernelBenchmark()
+{
+    m_readbackBuffer.reset();
+    vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+}
+
+void KernelBenchmark::record(
+    VkCommandBuffer const cmd,
+    ComputeCollectionPipeline const& pipeline,
+    VkDescriptorSet const drawImageDescriptors,
+    AllocatedImage const& image,
+    VkExtent2D const extent,
+    uint32_t const dispatches
+)
+{
+    m_extent = extent;
+    m_dispatches = dispatches;
+
+    size_t const readbackSize{
+        static_cast<size_t>(extent.width) * extent.height * BYTES_PER_PIXEL
+    };
+    m_readbackBuffer = std::make_unique<AllocatedBuffer>(
+        AllocatedBuffer::allocate(
+            m_device,
+            m_allocator,
+            readbackSize,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT
+                | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT
+        )
+    );
+
+    vkutil::transitionImage(
+        cmd,
+        image.image,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+
+    vkCmdResetQueryPool(cmd, m_queryPool, 0, 2);
+    vkCmdWriteTimestamp2(
+        cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_queryPool, 0
+    );
+
+    // Each dispatch waits on the last, as consecutive passes over the same
+    // image would in a frame.
+    VkMemoryBarrier2 const dispatchBarrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+
+        .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+                       | VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+    };
+    VkDependencyInfo const dispatchDependency{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pNext = nullptr,
+
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &dispatchBarrier,
+    };
+
+    for (uint32_t dispatch{0}; dispatch < dispatches; dispatch++)
+    {
+        if (dispatch > 0)
+        {
+            vkCmdPipelineBarrier2(cmd, &dispatchDependency);
+            GPUProfiler::countWork(WorkCounters{.barriers = 1});
+        }
+        pipeline.recordDrawCommands(cmd, drawImageDescriptors, extent);
+    }
+
+    vkCmdWriteTimestamp2(
+        cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_queryPool, 1
+    );
+
+    vkutil::transitionImage(
+        cmd,
+        image.image,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+
+    VkBufferImageCopy const copyRegion{
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource =
+            VkImageSubresourceLayers{
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .imageOffset = VkOffset3D{0, 0, 0},
+        .imageExtent = VkExtent3D{extent.width, extent.height, 1},
+    };
+    vkCmdCopyImageToBuffer(
+        cmd,
+        image.image,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        m_readbackBuffer->buffer,
+        1,
+        &copyRegion
+    );
+    GPUProfiler::countWork(WorkCounters{.bytesCopied = readbackSize});
+
+    vkutil::transitionImage(
+        cmd,
+        image.image,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+}
+
+auto KernelBenchmark::collect(
+    std::string const& shaderName, KernelBenchmarkParameters const& parameters
+) -> KernelBenchmarkResult
+{
+    KernelBenchmarkResult result{
+        .extent = m_extent,
+        .dispatches = m_dispatches,
+    };
+
+    std::array<uint64_t, 2> timestamps{};
+    VkResult const queryResult{vkGetQueryPoolResults(
+        m_device,
+        m_queryPool,
+        0,
+        2,
+        sizeof(timestamps),
+        timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT
+    )};
+    if (queryResult != VK_SUCCESS)
+    {
+        LogVkResult(queryResult, "Reading kernel benchmark timestamps");
+        return result;
+    }
+
+    uint64_t const ticks{(timestamps[1] - timestamps[0]) & m_timestampMask};
+    double const milliseconds{
+        static_cast<double>(ticks) * m_nanosecondsPerTick / 1'000'000.0
+    };
+    if (m_dispatches > 0 && milliseconds > 0.0)
+    {
+        double const pixels{
+            static_cast<double>(m_extent.width)
+            * static_cast<double>(m_extent.height)
+        };
+        result.millisecondsPerDispatch =
+            milliseconds / static_cast<double>(m_dispatches);
+        result.megapixelsPerSecond =
+            pixels / 1'000'000.0 / (result.millisecondsPerDispatch / 1000.0);
+    }
+
+    CheckVkResult(vmaInvalidateAllocation(
+        m_allocator, m_readbackBuffer->allocation, 0, VK_WHOLE_SIZE
+    ));
+    std::span<uint16_t const> const output{
+        reinterpret_cast<uint16_t const*>(m_readbackBuffer->info.pMappedData),
+        static_cast<size_t>(m_extent.width) * m_extent.height * 4
+    };
+
+    std::filesystem::path const path{referencePath(shaderName, m_extent)};
+    if (parameters.saveReference)
+    {
+        writeReference(path, output);
+        return result;
+    }
+
+    std::optional<std::vector<uint16_t>> const reference{readReference(path)};
+    if (!reference.has_value())
+    {
+        return result;
+    }
+    if (reference.value().size() != output.size())
+    {
+        Warning(fmt::format("Reference {} has the wrong size.", path.string()));
+        result.matchesReference = false;
+        return result;
+    }
+
+    float maxDifference{0.0F};
+    for (size_t index{0}; index < output.size(); index++)
+    {
+        uint16_t const value{output[index]};
+        uint16_t const expected{reference.value()[index]};
+        if (value == expected)
+        {
+            continue;
+        }
+
+        // Treat NaNs as differing by infinity, so they never match
+        float const difference{std::abs(
+            glm::unpackHalf1x16(value) - glm::unpackHalf1x16(expected)
+        )};
+        maxDifference = std::max(
+            maxDifference,
+            std::isnan(difference) ? std::numeric_limits<float>::infinity()
+                                   : difference
+        );
+    }
+
+    result.maxDifference = maxDifference;
+    result.matchesReference = maxDifference <= parameters.tolerance;
+    return result;
+}
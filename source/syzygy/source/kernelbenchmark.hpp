@@ -0,0 +1,98 @@
+#pragma once
+
+#include "buffers.hpp"
+#include "enginetypes.hpp"
+#include "images.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class ComputeCollectionPipeline;
+
+struct KernelBenchmarkParameters
+{
+    // Selects the first shader whose name contains this
+    std::string shaderName{};
+
+    uint32_t dispatches{100};
+    std::vector<VkExtent2D> extents{
+        VkExtent2D{1280, 720},
+        VkExtent2D{1920, 1080},
+        VkExtent2D{3840, 2160},
+    };
+
+    // Overwrites the stored reference outputs with this run's, such as after
+    // intentionally changing what a shader computes.
+    bool saveReference{false};
+
+    // The largest difference of any channel that still matches the reference
+    float tolerance{1.0e-3F};
+};
+
+struct KernelBenchmarkResult
+{
+    VkExtent2D extent{};
+    uint32_t dispatches{0};
+
+    double millisecondsPerDispatch{0.0};
+    double megapixelsPerSecond{0.0};
+
+    // Nothing when no reference is stored for the shader at this extent
+    std::optional<bool> matchesReference{};
+    float maxDifference{0.0F};
+};
+
+// Times a shader of a ComputeCollectionPipeline over many back-to-back
+// dispatches with timestamp queries, then reads back what it wrote to compare
+// against a reference output stored per shader and extent.
+class KernelBenchmark
+{
+public:
+    // Null when the queue does not support timestamps.
+    static std::unique_ptr<KernelBenchmark> create(
+        VkPhysicalDevice physicalDevice,
+        VkDevice device,
+        VmaAllocator allocator,
+        uint32_t queueFamilyIndex
+    );
+
+    KernelBenchmark(KernelBenchmark const& other) = delete;
+    KernelBenchmark& operator=(KernelBenchmark const& other) = delete;
+
+    ~KernelBenchmark();
+
+    // Records the dispatches of the pipeline's current shader between
+    // timestamps, then a copy of the written region for readback. The
+    // descriptors must bind the image, which is left in the general layout.
+    void record(
+        VkCommandBuffer cmd,
+        ComputeCollectionPipeline const& pipeline,
+        VkDescriptorSet drawImageDescriptors,
+        AllocatedImage const& image,
+        VkExtent2D extent,
+        uint32_t dispatches
+    );
+
+    // Call once the recorded commands have finished executing.
+    KernelBenchmarkResult collect(
+        std::string const& shaderName,
+        KernelBenchmarkParameters const& parameters
+    );
+
+private:
+    KernelBenchmark() = default;
+
+    VkDevice m_device{VK_NULL_HANDLE};
+    VmaAllocator m_allocator{VK_NULL_HANDLE};
+
+    double m_nanosecondsPerTick{1.0};
+    uint64_t m_timestampMask{~0ULL};
+    VkQueryPool m_queryPool{VK_NULL_HANDLE};
+
+    // Of the most recent recording
+    VkExtent2D m_extent{};
+    uint32_t m_dispatches{0};
+    std::unique_ptr<AllocatedBuffer> m_readbackBuffer{};
+};
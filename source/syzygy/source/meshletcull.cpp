@@ -0,0 +1,439 @@
+#include "meshletcull.hpp"
+
+#include "gpuprofiler.hpp"
+#include "helpers.hpp"
+#include "meshlod.hpp"
+#include "pipelines.hpp"
+
+#include <algorithm>
+
+namespace
+{
+void recordBufferBarrier(
+    VkCommandBuffer const cmd,
+    VkBuffer const buffer,
+    VkPipelineStageFlags2 const srcStage,
+    VkAccessFlags2 const srcAccess,
+    VkPipelineStageFlags2 const dstStage,
+    VkAccessFlags2 const dstAccess
+)
+{
+    VkBufferMemoryBarrier2 const bufferMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+
+        .srcStageMask = srcStage,
+        .srcAccessMask = srcAccess,
+
+        .dstStageMask = dstStage,
+        .dstAccessMask = dstAccess,
+
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+
+        .buffer = buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+
+    VkDependencyInfo const dependency{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pNext = nullptr,
+
+        .dependencyFlags = 0,
+
+        .memoryBarrierCount = 0,
+        .pMemoryBarriers = nullptr,
+
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers = &bufferMemoryBarrier,
+
+        .imageMemoryBarrierCount = 0,
+        .pImageMemoryBarriers = nullptr,
+    };
+
+    vkCmdPipelineBarrier2(cmd, &dependency);
+    GPUProfiler::countWork(WorkCounters{.barriers = 1});
+}
+} // namespace
+
+MeshletCullPass::MeshletCullPass(
+    VkPhysicalDevice const physicalDevice,
+    VkDevice const device,
+    VmaAllocator const allocator
+)
+{
+    m_device = device;
+    m_allocator = allocator;
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    m_maxWorkgroupCount = properties.limits.maxComputeWorkGroupCount[0];
+    m_maxDrawIndirectCount = properties.limits.maxDrawIndirectCount;
+
+    m_views = std::make_unique<TStagedBuffer<gputypes::CullView>>(
+        TStagedBuffer<gputypes::CullView>::allocate(
+            device, allocator, VIEW_CAPACITY, 0
+        )
+    );
+
+    allocateDrawCommands(
+        std::min(INITIAL_DRAW_CAPACITY, m_maxDrawIndirectCount)
+    );
+    m_drawCount = std::make_unique<AllocatedBuffer>(AllocatedBuffer::allocate(
+        device,
+        allocator,
+        sizeof(uint32_t),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+            | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY,
+        0
+    ));
+
+    VkPushConstantRange const pushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(CullPushConstant),
+    };
+
+    std::optional<ShaderObjectReflected> const loadResult{
+        vkutil::loadShaderObject(
+            device,
+            "shaders/culling/meshlet_cull.comp.spv",
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            {},
+            pushConstantRange,
+            {}
+        )
+    };
+    if (!loadResult.has_value())
+    {
+        Warning("Failed to load meshlet culling shader, meshlets will not be "
+                "culled.");
+        return;
+    }
+    m_cullShader = loadResult.value();
+
+    if (m_cullShader.reflectionData().defaultEntryPointHasPushConstant())
+    {
+        size_t const loadedPushConstantSize{
+            m_cullShader.reflectionData()
+                .defaultPushConstant()
+                .type.paddedSizeBytes
+        };
+        if (loadedPushConstantSize != sizeof(CullPushConstant))
+        {
+            Warning(fmt::format(
+                "Loaded Shader \"{}\" had a push constant of size {}, "
+                "while implementation expects {}.",
+                m_cullShader.name(),
+                loadedPushConstantSize,
+                sizeof(CullPushConstant)
+            ));
+        }
+    }
+
+    VkPipelineLayoutCreateInfo const layoutCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+
+        .flags = 0,
+
+        .setLayoutCount = 0,
+        .pSetLayouts = nullptr,
+
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    LogVkResult(
+        vkCreatePipelineLayout(
+            device, &layoutCreateInfo, nullptr, &m_cullLayout
+        ),
+        "Creating meshlet culling layout"
+    );
+}
+
+void MeshletCullPass::allocateDrawCommands(uint32_t const capacity)
+{
+    m_drawCapacity = capacity;
+    m_drawCommands = std::make_unique<AllocatedBuffer>(
+        AllocatedBuffer::allocate(
+            m_device,
+            m_allocator,
+            static_cast<size_t>(capacity)
+                * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY,
+            0
+        )
+    );
+}
+
+void MeshletCullPass::reserveDraws(
+    MeshAsset const& mesh,
+    MeshInstances const& instances,
+    DeletionQueue& frameDeletionQueue
+)
+{
+    if (mesh.surfaces.empty())
+    {
+        return;
+    }
+
+    uint64_t const candidateCount{
+        static_cast<uint64_t>(mesh.surfaces[0].meshletCount)
+        * instances.originals.size()
+    };
+    if (candidateCount <= m_drawCapacity
+        || m_drawCapacity == m_maxDrawIndirectCount)
+    {
+        return;
+    }
+
+    // Doubling keeps a growing scene from reallocating every time
+    uint64_t capacity{m_drawCapacity};
+    while (capacity < candidateCount)
+    {
+        capacity *= 2;
+    }
+    capacity = std::min<uint64_t>(capacity, m_maxDrawIndirectCount);
+
+    // Earlier frames in flight may still be drawing from the old list. They
+    // have all finished by the time this frame's queue is flushed, after its
+    // fence is waited on. Shared, since the queue's functions must be
+    // copyable.
+    std::shared_ptr<AllocatedBuffer> oldDrawCommands{
+        std::move(m_drawCommands)
+    };
+    frameDeletionQueue.pushFunction(
+        [oldDrawCommands]() mutable { oldDrawCommands.reset(); }
+    );
+    allocateDrawCommands(static_cast<uint32_t>(capacity));
+
+    Log(fmt::format(
+        "Grew meshlet draw list to {} draws, {:.1f} MB.",
+        capacity,
+        static_cast<double>(capacity * sizeof(VkDrawIndexedIndirectCommand))
+            / (1024.0 * 1024.0)
+    ));
+}
+
+void MeshletCullPass::recordUploadViews(
+    VkCommandBuffer const cmd, std::span<gputypes::CullView const> const views
+)
+{
+    m_views->clearStaged();
+
+    if (views.size() > VIEW_CAPACITY)
+    {
+        Warning("Too many views to cull against, some will not be culled.");
+    }
+    m_views->push(views.subspan(0, std::min(views.size(), VIEW_CAPACITY)));
+
+    m_views->recordCopyToDevice(cmd, m_allocator);
+    m_views->recordTotalCopyBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+    );
+}
+
+auto MeshletCullPass::recordCull(
+    VkCommandBuffer const cmd,
+    uint32_t const viewIndex,
+    bool const backfaceCulling,
+    MeshAsset const& mesh,
+    MeshInstances const& instances
+) -> bool
+{
+    if (m_cullShader.shaderObject() == VK_NULL_HANDLE
+        || m_cullLayout == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    std::span<InstanceRange const> const ranges{
+        lod::surfaceInstanceRanges(instances, 0)
+    };
+    if (viewIndex >= m_views->deviceSize() || mesh.surfaces.empty()
+        || ranges.empty())
+    {
+        return false;
+    }
+
+    GeometrySurface const& surface{mesh.surfaces[0]};
+    InstanceRange const& fullDetailInstances{ranges[0]};
+
+    uint64_t const candidateCount{
+        static_cast<uint64_t>(surface.meshletCount)
+        * fullDetailInstances.instanceCount
+    };
+    if (candidateCount == 0)
+    {
+        return false;
+    }
+    if (candidateCount > m_drawCapacity)
+    {
+        if (!m_warnedOverCapacity)
+        {
+            Warning(fmt::format(
+                "{} meshlet candidates exceed the draw list of {}, so they "
+                "are drawn without culling.",
+                candidateCount,
+                m_drawCapacity
+            ));
+            m_warnedOverCapacity = true;
+        }
+        return false;
+    }
+
+    // The previous view's draws must finish reading before we overwrite them.
+    VkPipelineStageFlags2 constexpr PREVIOUS_STAGES{
+        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT
+        | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT
+    };
+    recordBufferBarrier(
+        cmd,
+        m_drawCount->buffer,
+        PREVIOUS_STAGES,
+        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+        VK_PIPELINE_STAGE_2_CLEAR_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT
+    );
+    recordBufferBarrier(
+        cmd,
+        m_drawCommands->buffer,
+        PREVIOUS_STAGES,
+        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+    );
+
+    vkCmdFillBuffer(cmd, m_drawCount->buffer, 0, sizeof(uint32_t), 0);
+    recordBufferBarrier(
+        cmd,
+        m_drawCount->buffer,
+        VK_PIPELINE_STAGE_2_CLEAR_BIT,
+        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+            | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+    );
+
+    VkShaderStageFlagBits const computeStage{VK_SHADER_STAGE_COMPUTE_BIT};
+    VkShaderEXT const shader{m_cullShader.shaderObject()};
+    vkCmdBindShadersEXT(cmd, 1, &computeStage, &shader);
+
+    // Each dispatch culls a batch of whole instances, so none exceeds the
+    // device's workgroup count.
+    uint32_t constexpr COMPUTE_WORKGROUP_SIZE{64};
+    uint64_t const maxInvocations{
+        static_cast<uint64_t>(m_maxWorkgroupCount) * COMPUTE_WORKGROUP_SIZE
+    };
+    auto const instancesPerDispatch{static_cast<uint32_t>(
+        std::clamp<uint64_t>(
+            maxInvocations / surface.meshletCount,
+            1,
+            fullDetailInstances.instanceCount
+        )
+    )};
+
+    for (uint32_t batchBegin{0};
+         batchBegin < fullDetailInstances.instanceCount;
+         batchBegin += instancesPerDispatch)
+    {
+        uint32_t const batchInstances{std::min(
+            instancesPerDispatch,
+            fullDetailInstances.instanceCount - batchBegin
+        )};
+
+        CullPushConstant const pushConstant{
+            .viewBuffer = m_views->deviceAddress(),
+            .meshletBuffer = mesh.meshBuffers->meshletAddress(),
+            .modelBuffer = instances.models->deviceAddress(),
+            .instanceIndexBuffer = instances.lodSortedIndices->deviceAddress(),
+            .drawCommandBuffer = m_drawCommands->deviceAddress,
+            .drawCountBuffer = m_drawCount->deviceAddress,
+            .viewIndex = viewIndex,
+            .firstMeshlet = surface.firstMeshlet,
+            .meshletCount = surface.meshletCount,
+            .firstInstance = fullDetailInstances.firstInstance + batchBegin,
+            .instanceCount = batchInstances,
+            .backfaceCulling = backfaceCulling ? 1U : 0U,
+        };
+        vkCmdPushConstants(
+            cmd,
+            m_cullLayout,
+            VK_SHADER_STAGE_COMPUTE_BIT,
+            0,
+            sizeof(CullPushConstant),
+            &pushConstant
+        );
+
+        vkCmdDispatch(
+            cmd,
+            computeDispatchCount(
+                batchInstances * surface.meshletCount, COMPUTE_WORKGROUP_SIZE
+            ),
+            1,
+            1
+        );
+        GPUProfiler::countWork(WorkCounters{.dispatches = 1});
+    }
+
+    VkShaderStageFlagBits const unboundStage{VK_SHADER_STAGE_COMPUTE_BIT};
+    VkShaderEXT const unboundHandle{VK_NULL_HANDLE};
+    vkCmdBindShadersEXT(cmd, 1, &unboundStage, &unboundHandle);
+
+    recordBufferBarrier(
+        cmd,
+        m_drawCount->buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT
+    );
+    recordBufferBarrier(
+        cmd,
+        m_drawCommands->buffer,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT
+    );
+
+    m_maxDrawCount = static_cast<uint32_t>(candidateCount);
+
+    return true;
+}
+
+void MeshletCullPass::recordDrawIndirect(VkCommandBuffer const cmd) const
+{
+    vkCmdDrawIndexedIndirectCount(
+        cmd,
+        m_drawCommands->buffer,
+        0,
+        m_drawCount->buffer,
+        0,
+        m_maxDrawCount,
+        sizeof(VkDrawIndexedIndirectCommand)
+    );
+    GPUProfiler::countWork(WorkCounters{.drawCalls = 1});
+}
+
+void MeshletCullPass::cleanup(VkDevice const device)
+{
+    m_views.reset();
+
+    m_drawCommands.reset();
+    m_drawCount.reset();
+
+    vkDestroyPipelineLayout(device, m_cullLayout, nullptr);
+    m_cullLayout = VK_NULL_HANDLE;
+
+    m_cullShader.cleanup(device);
+}
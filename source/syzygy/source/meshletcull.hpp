@@ -0,0 +1,109 @@
+#pragma once
+
+#include "assets.hpp"
+#include "buffers.hpp"
+#include "enginetypes.hpp"
+#include "gputypes.hpp"
+#include "shaders.hpp"
+
+// Culls the meshlets of each full detail instance against a view on the GPU,
+// writing a compacted list of indirect draws. Only compute and index buffers
+// are used, so this works without mesh shaders.
+//
+// The draw list is reused between views, so each view's draws must be
+// recorded before culling the next.
+class MeshletCullPass
+{
+public:
+    // One main camera alongside every shadow map.
+    static size_t constexpr VIEW_CAPACITY{16};
+
+    // The (instance, meshlet) pairs that can be culled in a view before the
+    // draw list first grows.
+    static uint32_t constexpr INITIAL_DRAW_CAPACITY{1U << 16U};
+
+    MeshletCullPass(
+        VkPhysicalDevice physicalDevice, VkDevice device, VmaAllocator allocator
+    );
+
+    // Grows the draw list to fit every meshlet of every instance, so any view
+    // of them can be culled. Call before culling in a frame. The replaced list
+    // is retired through the deletion queue of the frame being recorded,
+    // since earlier frames in flight may still draw from it.
+    void reserveDraws(
+        MeshAsset const& mesh,
+        MeshInstances const& instances,
+        DeletionQueue& frameDeletionQueue
+    );
+
+    MeshletCullPass(MeshletCullPass const& other) = delete;
+    MeshletCullPass& operator=(MeshletCullPass const& other) = delete;
+
+    // Uploads the views that will be culled against this frame, indexed in
+    // the same order.
+    void recordUploadViews(
+        VkCommandBuffer cmd, std::span<gputypes::CullView const> views
+    );
+
+    // Returns false if nothing was culled, in which case the full detail
+    // instances should be drawn directly. Backface culling should only be
+    // used when the view's rasterization also culls back faces.
+    bool recordCull(
+        VkCommandBuffer cmd,
+        uint32_t viewIndex,
+        bool backfaceCulling,
+        MeshAsset const& mesh,
+        MeshInstances const& instances
+    );
+
+    // Draws the output of the last culling. The mesh's index buffer and the
+    // graphics shaders should already be bound.
+    void recordDrawIndirect(VkCommandBuffer cmd) const;
+
+    void cleanup(VkDevice device);
+
+private:
+    void allocateDrawCommands(uint32_t capacity);
+
+    VkDevice m_device{VK_NULL_HANDLE};
+    VmaAllocator m_allocator{VK_NULL_HANDLE};
+
+    // Limits of the device. Larger views are culled over several dispatches,
+    // and cannot have more draws than an indirect draw allows.
+    uint32_t m_maxWorkgroupCount{0};
+    uint32_t m_maxDrawIndirectCount{0};
+    bool m_warnedOverCapacity{false};
+
+    std::unique_ptr<TStagedBuffer<gputypes::CullView>> m_views{};
+
+    std::unique_ptr<AllocatedBuffer> m_drawCommands{};
+    uint32_t m_drawCapacity{0};
+    std::unique_ptr<AllocatedBuffer> m_drawCount{};
+
+    // The bound on the draw count for the last culled view.
+    uint32_t m_maxDrawCount{0};
+
+    struct CullPushConstant
+    {
+        VkDeviceAddress viewBuffer{};
+        VkDeviceAddress meshletBuffer{};
+
+        VkDeviceAddress modelBuffer{};
+        VkDeviceAddress instanceIndexBuffer{};
+
+        VkDeviceAddress drawCommandBuffer{};
+        VkDeviceAddress drawCountBuffer{};
+
+        uint32_t viewIndex{0};
+        uint32_t firstMeshlet{0};
+        uint32_t meshletCount{0};
+        uint32_t firstInstance{0};
+
+        uint32_t instanceCount{0};
+        uint32_t backfaceCulling{0};
+        uint8_t padding0[8]{};
+    };
+
+    ShaderObjectReflected m_cullShader{ShaderObjectReflected::makeInvalid()};
+    VkPipelineLayout m_cullLayout{VK_NULL_HANDLE};
+};
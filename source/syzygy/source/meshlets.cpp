@@ -0,0 +1,211 @@
+#include "meshlets.hpp"
+
+#include "assets.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+auto finalizeMeshlet(
+    std::span<Vertex const> const vertices,
+    std::span<uint32_t const> const indices,
+    uint32_t const firstIndex
+) -> Meshlet
+{
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+    for (uint32_t const index : indices)
+    {
+        min = glm::min(min, vertices[index].position);
+        max = glm::max(max, vertices[index].position);
+    }
+
+    glm::vec3 const center{(min + max) / 2.0F};
+    float radius{0.0F};
+    for (uint32_t const index : indices)
+    {
+        radius =
+            glm::max(radius, glm::distance(center, vertices[index].position));
+    }
+
+    // Triangle normals from the winding can be flipped relative to the vertex
+    // normals, such as after mirroring on import. The vertex normals are what
+    // is shaded, so we orient each face by them.
+    std::vector<glm::vec3> faceNormals{};
+    glm::vec3 normalSum{0.0F};
+    for (size_t triangle{0}; triangle + 2 < indices.size(); triangle += 3)
+    {
+        Vertex const& a{vertices[indices[triangle]]};
+        Vertex const& b{vertices[indices[triangle + 1]]};
+        Vertex const& c{vertices[indices[triangle + 2]]};
+
+        glm::vec3 const cross{
+            glm::cross(b.position - a.position, c.position - a.position)
+        };
+        float const area{glm::length(cross)};
+        if (area == 0.0F)
+        {
+            continue;
+        }
+
+        glm::vec3 normal{cross / area};
+        if (glm::dot(normal, a.normal + b.normal + c.normal) < 0.0F)
+        {
+            normal = -normal;
+        }
+
+        faceNormals.push_back(normal);
+        normalSum += normal;
+    }
+
+    // Cones wider than this are rarely culled, so we do not bother.
+    float constexpr MINIMUM_CONE_DOT{0.1F};
+
+    glm::vec3 coneAxis{0.0F};
+    float coneCutoff{1.0F};
+    if (!faceNormals.empty() && glm::length(normalSum) > 0.0F)
+    {
+        glm::vec3 const axis{glm::normalize(normalSum)};
+
+        float minimumDot{1.0F};
+        for (glm::vec3 const& normal : faceNormals)
+        {
+            minimumDot = glm::min(minimumDot, glm::dot(normal, axis));
+        }
+
+        if (minimumDot > MINIMUM_CONE_DOT)
+        {
+            coneAxis = axis;
+            coneCutoff = glm::sqrt(1.0F - minimumDot * minimumDot);
+        }
+    }
+
+    return Meshlet{
+        .firstIndex = firstIndex,
+        .indexCount = static_cast<uint32_t>(indices.size()),
+        .boundsCenter = center,
+        .boundsRadius = radius,
+        .coneAxis = coneAxis,
+        .coneCutoff = coneCutoff,
+    };
+}
+} // namespace
+
+auto meshlets::buildMeshlets(
+    std::span<Vertex const> const vertices,
+    std::span<uint32_t const> const indices,
+    uint32_t const firstIndex
+) -> std::vector<Meshlet>
+{
+    std::vector<Meshlet> result{};
+
+    // Marks which meshlet last referenced each vertex, to count unique
+    // vertices without clearing between meshlets.
+    std::vector<uint32_t> vertexMeshlet(
+        vertices.size(), std::numeric_limits<uint32_t>::max()
+    );
+
+    uint32_t meshletIndex{0};
+    size_t meshletBegin{0};
+    size_t meshletVertexCount{0};
+    size_t meshletTriangleCount{0};
+
+    auto const countNewVertices{[&](size_t const triangle) -> size_t
+    {
+        uint32_t const a{indices[triangle]};
+        uint32_t const b{indices[triangle + 1]};
+        uint32_t const c{indices[triangle + 2]};
+
+        size_t count{0};
+        count += vertexMeshlet[a] != meshletIndex ? 1 : 0;
+        count += vertexMeshlet[b] != meshletIndex && b != a ? 1 : 0;
+        count += vertexMeshlet[c] != meshletIndex && c != a && c != b ? 1 : 0;
+        return count;
+    }};
+
+    for (size_t triangle{0}; triangle + 2 < indices.size(); triangle += 3)
+    {
+        size_t newVertices{countNewVertices(triangle)};
+
+        if (meshletVertexCount + newVertices > MESHLET_MAX_VERTICES
+            || meshletTriangleCount + 1 > MESHLET_MAX_TRIANGLES)
+        {
+            result.push_back(finalizeMeshlet(
+                vertices,
+                indices.subspan(meshletBegin, triangle - meshletBegin),
+                firstIndex + static_cast<uint32_t>(meshletBegin)
+            ));
+
+            meshletIndex += 1;
+            meshletBegin = triangle;
+            meshletVertexCount = 0;
+            meshletTriangleCount = 0;
+
+            newVertices = countNewVertices(triangle);
+        }
+
+        vertexMeshlet[indices[triangle]] = meshletIndex;
+        vertexMeshlet[indices[triangle + 1]] = meshletIndex;
+        vertexMeshlet[indices[triangle + 2]] = meshletIndex;
+
+        meshletVertexCount += newVertices;
+        meshletTriangleCount += 1;
+    }
+
+    if (meshletTriangleCount > 0)
+    {
+        size_t const meshletEnd{meshletBegin + meshletTriangleCount * 3};
+        result.push_back(finalizeMeshlet(
+            vertices,
+            indices.subspan(meshletBegin, meshletEnd - meshletBegin),
+            firstIndex + static_cast<uint32_t>(meshletBegin)
+        ));
+    }
+
+    return result;
+}
+
+auto meshlets::maxMeshletCount(
+    uint64_t const triangleCount, uint64_t const surfaceCount
+) -> uint64_t
+{
+    // A triangle that does not fit adds at least one vertex, so the meshlet
+    // it closes already holds MESHLET_MAX_VERTICES - 2 vertices. That takes
+    // at least a third as many triangles, rounded up.
+    uint64_t const minimumVertices{MESHLET_MAX_VERTICES - 2};
+    uint64_t const minimumTriangles{std::min<uint64_t>(
+        (minimumVertices + 2) / 3, MESHLET_MAX_TRIANGLES
+    )};
+    return triangleCount / minimumTriangles + surfaceCount;
+}
+
+auto meshlets::toDeviceMeshlets(
+    std::span<GeometrySurface const> const surfaces,
+    std::span<Meshlet const> const meshlets
+) -> std::vector<gputypes::Meshlet>
+{
+    std::vector<gputypes::Meshlet> deviceMeshlets{};
+    deviceMeshlets.reserve(meshlets.size());
+
+    for (GeometrySurface const& surface : surfaces)
+    {
+        for (Meshlet const& meshlet :
+             meshlets.subspan(surface.firstMeshlet, surface.meshletCount))
+        {
+            deviceMeshlets.push_back(gputypes::Meshlet{
+                .boundsCenter = meshlet.boundsCenter,
+                .boundsRadius = meshlet.boundsRadius,
+                .coneAxis = meshlet.coneAxis,
+                .coneCutoff = meshlet.coneCutoff,
+                .firstIndex = meshlet.firstIndex,
+                .indexCount = meshlet.indexCount,
+                .vertexOffset = surface.vertexOffset,
+            });
+        }
+    }
+
+    return deviceMeshlets;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "enginetypes.hpp"
+#include "gputypes.hpp"
+
+struct GeometrySurface;
+struct Meshlet;
+
+namespace meshlets
+{
+// Limits that keep meshlets small enough to cull finely, while amortizing the
+// cost of each indirect draw.
+size_t constexpr MESHLET_MAX_VERTICES{64};
+size_t constexpr MESHLET_MAX_TRIANGLES{124};
+
+// Partitions a triangle list into meshlets, greedily in index order. The
+// vertices are only those of the surface, which its indices are relative to.
+// Every index must be in range, which importing checks for file data.
+// The meshlets' first indices are offset by firstIndex, where the triangle
+// list begins in the mesh's index buffer.
+std::vector<Meshlet> buildMeshlets(
+    std::span<Vertex const> vertices,
+    std::span<uint32_t const> indices,
+    uint32_t firstIndex
+);
+
+// The most meshlets buildMeshlets can produce across the surfaces. A meshlet
+// is only closed early once its vertices are nearly full, and each triangle
+// adds at most three vertices, so every meshlet but each surface's last holds
+// a minimum number of triangles.
+uint64_t maxMeshletCount(uint64_t triangleCount, uint64_t surfaceCount);
+
+// Flattens the meshlets of every surface for upload, since the device
+// equivalent also needs each surface's vertex offset.
+std::vector<gputypes::Meshlet> toDeviceMeshlets(
+    std::span<GeometrySurface const> surfaces,
+    std::span<Meshlet const> meshlets
+);
+} // namespace meshlets
@@ -0,0 +1,258 @@
+#include "meshloader.hpp"
+
+#include "cpuprofiler.hpp"
+#include "helpers.hpp"
+#include "initializers.hpp"
+
+MeshLoader::MeshLoader(
+    VkDevice const device,
+    VmaAllocator const allocator,
+    uint32_t const queueFamilyIndex
+)
+{
+    m_device = device;
+    m_allocator = allocator;
+
+    VkCommandPoolCreateInfo const commandPoolInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = queueFamilyIndex,
+    };
+    CheckVkResult(
+        vkCreateCommandPool(device, &commandPoolInfo, nullptr, &m_commandPool)
+    );
+
+    for (size_t i{0}; i < WORKER_COUNT; i++)
+    {
+        m_workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+void MeshLoader::loadAsync(
+    std::string const& localPath, MeshImportOptions const options
+)
+{
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+
+        size_t const id{m_progress.size()};
+        m_progress.push_back(JobProgress{.localPath = localPath});
+        m_jobs.push_back(Job{
+            .id = id,
+            .localPath = localPath,
+            .options = options,
+        });
+    }
+
+    m_jobAvailable.notify_one();
+}
+
+void MeshLoader::workerLoop()
+{
+    CPUProfiler::setThreadName("Mesh Loader");
+
+    while (true)
+    {
+        Job job{};
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_jobAvailable.wait(
+                lock, [&]() { return m_stopping || !m_jobs.empty(); }
+            );
+            if (m_stopping)
+            {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+
+            m_progress[job.id].status = JobStatus::DECODING;
+        }
+
+        VKR_PROFILE_ZONE("Decode Meshes");
+        bool const decoded{decodeGltfMeshes(
+            job.localPath,
+            job.options,
+            [&](DecodedMesh&& mesh)
+            {
+                std::optional<StagedMeshUpload> upload{StagedMeshUpload::stage(
+                    m_device,
+                    m_allocator,
+                    mesh.indices,
+                    mesh.vertexBytes(),
+                    mesh.encoding,
+                    mesh.deviceMeshlets
+                )};
+                if (!upload.has_value())
+                {
+                    return false;
+                }
+
+                // The staging buffer holds a copy, so only keep metadata
+                mesh.indices = {};
+                mesh.vertices = {};
+                mesh.deviceMeshlets = {};
+
+                std::lock_guard<std::mutex> const lock{m_mutex};
+
+                m_staged.push_back(StagedMesh{
+                    .jobID = job.id,
+                    .mesh = std::move(mesh),
+                    .upload = std::move(upload).value(),
+                });
+                m_progress[job.id].meshesDecoded += 1;
+
+                return !m_stopping;
+            }
+        )};
+
+        std::lock_guard<std::mutex> const lock{m_mutex};
+
+        JobProgress& progress{m_progress[job.id]};
+        if (!decoded)
+        {
+            Warning(fmt::format("Failed to load \"{}\".", job.localPath));
+            progress.status = JobStatus::FAILED;
+        }
+        else if (progress.meshesUploaded == progress.meshesDecoded)
+        {
+            progress.status = JobStatus::FINISHED;
+        }
+        else
+        {
+            progress.status = JobStatus::UPLOADING;
+        }
+    }
+}
+
+auto MeshLoader::update(VkQueue const queue)
+    -> std::vector<std::shared_ptr<MeshAsset>>
+{
+    std::vector<std::shared_ptr<MeshAsset>> loadedMeshes{};
+
+    // Collect finished copies first, so their meshes are published this frame
+    std::erase_if(
+        m_inFlight,
+        [&](InFlightCopy& copy)
+        {
+            VkResult const fenceStatus{vkGetFenceStatus(m_device, copy.fence)};
+            if (fenceStatus == VK_NOT_READY)
+            {
+                return false;
+            }
+            CheckVkResult(fenceStatus);
+
+            vkDestroyFence(m_device, copy.fence, nullptr);
+            vkFreeCommandBuffers(m_device, m_commandPool, 1, &copy.cmd);
+
+            std::lock_guard<std::mutex> const lock{m_mutex};
+            for (StagedMesh& staged : copy.meshes)
+            {
+                JobProgress& progress{m_progress[staged.jobID]};
+                progress.meshesUploaded += 1;
+                if (progress.status == JobStatus::UPLOADING
+                    && progress.meshesUploaded == progress.meshesDecoded)
+                {
+                    progress.status = JobStatus::FINISHED;
+                }
+
+                loadedMeshes.push_back(makeMeshAsset(
+                    std::move(staged.mesh),
+                    std::move(staged.upload.meshBuffers)
+                ));
+            }
+
+            return true;
+        }
+    );
+
+    std::vector<StagedMesh> staged{};
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        staged.swap(m_staged);
+    }
+    if (staged.empty())
+    {
+        return loadedMeshes;
+    }
+
+    // All meshes staged since the last update share one submission
+    InFlightCopy copy{.meshes = std::move(staged)};
+
+    VkCommandBufferAllocateInfo const cmdAllocInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = nullptr,
+
+        .commandPool = m_commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    CheckVkResult(vkAllocateCommandBuffers(m_device, &cmdAllocInfo, &copy.cmd)
+    );
+
+    VkFenceCreateInfo const fenceCreateInfo{vkinit::fenceCreateInfo()};
+    CheckVkResult(
+        vkCreateFence(m_device, &fenceCreateInfo, nullptr, &copy.fence)
+    );
+
+    VkCommandBufferBeginInfo const cmdBeginInfo{vkinit::commandBufferBeginInfo(
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    )};
+    CheckVkResult(vkBeginCommandBuffer(copy.cmd, &cmdBeginInfo));
+
+    for (StagedMesh const& mesh : copy.meshes)
+    {
+        mesh.upload.recordCopy(copy.cmd);
+    }
+
+    CheckVkResult(vkEndCommandBuffer(copy.cmd));
+
+    VkCommandBufferSubmitInfo const cmdSubmitInfo{
+        vkinit::commandBufferSubmitInfo(copy.cmd)
+    };
+    std::vector<VkCommandBufferSubmitInfo> const cmdSubmitInfos{cmdSubmitInfo};
+    VkSubmitInfo2 const submitInfo{vkinit::submitInfo(cmdSubmitInfos, {}, {})};
+
+    CheckVkResult(vkQueueSubmit2(queue, 1, &submitInfo, copy.fence));
+
+    m_inFlight.push_back(std::move(copy));
+
+    return loadedMeshes;
+}
+
+auto MeshLoader::progress() const -> std::vector<JobProgress>
+{
+    std::lock_guard<std::mutex> const lock{m_mutex};
+    return m_progress;
+}
+
+void MeshLoader::cleanup()
+{
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+
+    for (InFlightCopy const& copy : m_inFlight)
+    {
+        uint64_t constexpr COPY_TIMEOUT_NANOSECONDS{100'000'000'000};
+        CheckVkResult(vkWaitForFences(
+            m_device, 1, &copy.fence, VK_TRUE, COPY_TIMEOUT_NANOSECONDS
+        ));
+        vkDestroyFence(m_device, copy.fence, nullptr);
+    }
+    m_inFlight.clear();
+    m_staged.clear();
+
+    vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+    m_commandPool = VK_NULL_HANDLE;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "assets.hpp"
+#include "buffers.hpp"
+#include "enginetypes.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Loads glTF meshes in the background. Parsing, decoding, and staging run on
+// worker threads, while copies are submitted and polled without waiting from
+// the thread that owns the queue. This keeps large loads out of the frame.
+class MeshLoader
+{
+public:
+    static size_t constexpr WORKER_COUNT{2};
+
+    enum class JobStatus
+    {
+        QUEUED,
+        DECODING,
+        UPLOADING,
+        FINISHED,
+        FAILED,
+    };
+
+    struct JobProgress
+    {
+        std::string localPath{};
+        JobStatus status{JobStatus::QUEUED};
+
+        size_t meshesDecoded{0};
+        size_t meshesUploaded{0};
+    };
+
+    MeshLoader(
+        VkDevice device, VmaAllocator allocator, uint32_t queueFamilyIndex
+    );
+
+    MeshLoader(MeshLoader const& other) = delete;
+    MeshLoader& operator=(MeshLoader const& other) = delete;
+
+    void loadAsync(std::string const& localPath, MeshImportOptions options);
+
+    // Submits copies for any newly decoded meshes, and returns the meshes
+    // whose copies have completed. Never waits on the device. This must be
+    // called from the thread that submits to the queue.
+    std::vector<std::shared_ptr<MeshAsset>> update(VkQueue queue);
+
+    // A snapshot of every job that has been requested.
+    std::vector<JobProgress> progress() const;
+
+    // Stops the workers after their current mesh and waits for any in-flight
+    // copies.
+    void cleanup();
+
+private:
+    void workerLoop();
+
+    struct Job
+    {
+        size_t id{0};
+        std::string localPath{};
+        MeshImportOptions options{};
+    };
+
+    // The geometry is released once staged, only the metadata is kept.
+    struct StagedMesh
+    {
+        size_t jobID{0};
+        DecodedMesh mesh{};
+        StagedMeshUpload upload{};
+    };
+
+    struct InFlightCopy
+    {
+        VkFence fence{VK_NULL_HANDLE};
+        VkCommandBuffer cmd{VK_NULL_HANDLE};
+        std::vector<StagedMesh> meshes{};
+    };
+
+    VkDevice m_device{VK_NULL_HANDLE};
+    VmaAllocator m_allocator{VK_NULL_HANDLE};
+
+    VkCommandPool m_commandPool{VK_NULL_HANDLE};
+
+    std::vector<std::thread> m_workers{};
+
+    // Guards everything shared with the workers
+    mutable std::mutex m_mutex{};
+    std::condition_variable m_jobAvailable{};
+    bool m_stopping{false};
+
+    std::deque<Job> m_jobs{};
+    std::vector<StagedMesh> m_staged{};
+    std::vector<JobProgress> m_progress{};
+
+    // Only touched by the thread calling update
+    std::vector<InFlightCopy> m_inFlight{};
+};
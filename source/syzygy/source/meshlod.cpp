@@ -0,0 +1,461 @@
+#include "meshlod.hpp"
+
+#include "assets.hpp"
+#include "buffers.hpp"
+#include "helpers.hpp"
+
+#include <glm/gtx/component_wise.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <unordered_map>
+
+namespace
+{
+struct Cluster
+{
+    glm::vec3 positionSum{0.0F};
+    uint32_t vertexCount{0};
+
+    uint32_t representative{0};
+    float representativeDistance{FLT_MAX};
+};
+
+// A rough allowance for the allocation and links of each node of a standard
+// tree or hash table, on top of the value it stores.
+uint64_t constexpr CONTAINER_NODE_OVERHEAD_BYTES{48};
+
+// Shared by generating levels and bounding their size, so the two agree.
+auto maxReducedIndexCount(uint64_t const previousIndexCount) -> uint64_t
+{
+    return static_cast<uint64_t>(
+        static_cast<double>(previousIndexCount)
+        * (1.0 - static_cast<double>(LOD_MINIMUM_REDUCTION))
+    );
+}
+} // namespace
+
+auto lod::simplifyClustered(
+    std::span<Vertex const> const vertices,
+    std::span<uint32_t const> const indices,
+    uint32_t const gridResolution
+) -> SimplifiedIndices
+{
+    SimplifiedIndices const unchanged{
+        .indices = std::vector<uint32_t>(indices.begin(), indices.end()),
+        .error = 0.0F,
+    };
+
+    if (indices.empty() || gridResolution == 0)
+    {
+        return unchanged;
+    }
+
+    // Indices can repeat, so we track which vertices were already visited.
+    std::vector<bool> referenced(vertices.size(), false);
+    std::vector<uint32_t> uniqueVertices{};
+
+    glm::vec3 min{FLT_MAX};
+    glm::vec3 max{-FLT_MAX};
+    for (uint32_t const index : indices)
+    {
+        assert(index < vertices.size() && "Index was not validated on import.");
+        if (referenced[index])
+        {
+            continue;
+        }
+        referenced[index] = true;
+        uniqueVertices.push_back(index);
+
+        min = glm::min(min, vertices[index].position);
+        max = glm::max(max, vertices[index].position);
+    }
+
+    float const cellSize{
+        glm::compMax(max - min) / static_cast<float>(gridResolution)
+    };
+    if (cellSize <= 0.0F)
+    {
+        return unchanged;
+    }
+
+    auto const cellKey{[&](glm::vec3 const position) -> uint64_t
+    {
+        glm::uvec3 const cell{glm::min(
+            glm::uvec3((position - min) / cellSize),
+            glm::uvec3(gridResolution - 1)
+        )};
+
+        uint64_t const resolution{gridResolution};
+        return cell.x + resolution * (cell.y + resolution * cell.z);
+    }};
+
+    std::unordered_map<uint64_t, Cluster> clusters{};
+    for (uint32_t const index : uniqueVertices)
+    {
+        glm::vec3 const position{vertices[index].position};
+
+        Cluster& cluster{clusters[cellKey(position)]};
+        cluster.positionSum += position;
+        cluster.vertexCount += 1;
+    }
+
+    // Collapse onto an existing vertex, so we can keep sharing the vertex
+    // buffer between all levels of detail.
+    for (uint32_t const index : uniqueVertices)
+    {
+        glm::vec3 const position{vertices[index].position};
+
+        Cluster& cluster{clusters[cellKey(position)]};
+        glm::vec3 const centroid{
+            cluster.positionSum / static_cast<float>(cluster.vertexCount)
+        };
+
+        float const distance{glm::distance(position, centroid)};
+        if (distance < cluster.representativeDistance)
+        {
+            cluster.representative = index;
+            cluster.representativeDistance = distance;
+        }
+    }
+
+    SimplifiedIndices simplified{};
+
+    std::unordered_map<uint32_t, uint32_t> remapped{};
+    for (uint32_t const index : uniqueVertices)
+    {
+        glm::vec3 const position{vertices[index].position};
+        uint32_t const representative{
+            clusters[cellKey(position)].representative
+        };
+
+        remapped[index] = representative;
+        simplified.error = glm::max(
+            simplified.error,
+            glm::distance(position, vertices[representative].position)
+        );
+    }
+
+    std::set<std::array<uint32_t, 3>> emittedTriangles{};
+    for (size_t triangle{0}; triangle + 2 < indices.size(); triangle += 3)
+    {
+        std::array<uint32_t, 3> corners{
+            remapped[indices[triangle]],
+            remapped[indices[triangle + 1]],
+            remapped[indices[triangle + 2]]
+        };
+
+        if (corners[0] == corners[1] || corners[1] == corners[2]
+            || corners[2] == corners[0])
+        {
+            continue;
+        }
+
+        // Rotate so the smallest index is first, which preserves winding while
+        // letting us detect duplicate triangles.
+        std::array<uint32_t, 3> canonical{corners};
+        while (canonical[0] > canonical[1] || canonical[0] > canonical[2])
+        {
+            canonical = {canonical[1], canonical[2], canonical[0]};
+        }
+
+        if (!emittedTriangles.insert(canonical).second)
+        {
+            continue;
+        }
+
+        simplified.indices.insert(
+            simplified.indices.end(), corners.begin(), corners.end()
+        );
+    }
+
+    return simplified;
+}
+
+void lod::generateSurfaceLODs(
+    std::span<Vertex const> const vertices,
+    std::vector<uint32_t>& indices,
+    GeometrySurface& surface
+)
+{
+    // Grid resolutions of each level past the first. Each level is simplified
+    // from the original surface, so errors do not compound between levels.
+    std::array<uint32_t, MESH_LOD_CAPACITY - 1> constexpr GRID_RESOLUTIONS{
+        32, 16, 8
+    };
+
+    surface.lods.clear();
+
+    // Copy, since we append to the same index list.
+    std::vector<uint32_t> const original(
+        indices.begin() + surface.firstIndex,
+        indices.begin() + surface.firstIndex + surface.indexCount
+    );
+
+    size_t previousIndexCount{original.size()};
+    for (uint32_t const resolution : GRID_RESOLUTIONS)
+    {
+        SimplifiedIndices simplified{
+            simplifyClustered(vertices, original, resolution)
+        };
+
+        if (simplified.indices.empty())
+        {
+            // Coarser grids will not leave any triangles either.
+            break;
+        }
+
+        uint64_t const maximumIndexCount{
+            maxReducedIndexCount(previousIndexCount)
+        };
+        if (simplified.indices.size() > maximumIndexCount)
+        {
+            continue;
+        }
+
+        surface.lods.push_back(SurfaceLOD{
+            .firstIndex = static_cast<uint32_t>(indices.size()),
+            .indexCount = static_cast<uint32_t>(simplified.indices.size()),
+            .error = simplified.error,
+        });
+        indices.insert(
+            indices.end(), simplified.indices.begin(), simplified.indices.end()
+        );
+
+        previousIndexCount = simplified.indices.size();
+    }
+}
+
+auto lod::maxLODIndexCount(uint64_t const fullDetailIndexCount) -> uint64_t
+{
+    uint64_t total{fullDetailIndexCount};
+    uint64_t levelIndexCount{fullDetailIndexCount};
+    for (size_t level{1}; level < MESH_LOD_CAPACITY; level++)
+    {
+        levelIndexCount = maxReducedIndexCount(levelIndexCount);
+        total += levelIndexCount;
+    }
+    return total;
+}
+
+auto lod::maxLODScratchBytes(
+    uint64_t const vertexCount, uint64_t const indexCount
+) -> uint64_t
+{
+    // The original indices are copied once per surface, then simplification
+    // holds an unchanged copy and its output, which can grow to double.
+    uint64_t const indexCopyBytes{4 * indexCount * sizeof(uint32_t)};
+
+    // The visited flags, the unique vertices which can also grow to double,
+    // and a cluster and remapping per unique vertex in the worst case. Each
+    // hash table also has about a bucket pointer per node.
+    uint64_t const vertexBytes{
+        vertexCount
+            * (2 * sizeof(uint32_t)
+               + sizeof(std::pair<uint64_t const, Cluster>)
+               + sizeof(std::pair<uint32_t const, uint32_t>)
+               + 2 * (CONTAINER_NODE_OVERHEAD_BYTES + sizeof(void*)))
+        + vertexCount / 8 + 1
+    };
+
+    uint64_t const triangleBytes{
+        indexCount / 3
+        * (sizeof(std::array<uint32_t, 3>) + CONTAINER_NODE_OVERHEAD_BYTES)
+    };
+
+    return indexCopyBytes + vertexBytes + triangleBytes;
+}
+
+auto lod::surfaceLODCount(GeometrySurface const& surface) -> size_t
+{
+    return 1 + surface.lods.size();
+}
+
+auto lod::surfaceLODRange(GeometrySurface const& surface, size_t const level)
+    -> IndexRange
+{
+    if (level == 0 || surface.lods.empty())
+    {
+        return IndexRange{
+            .firstIndex = surface.firstIndex,
+            .indexCount = surface.indexCount,
+        };
+    }
+
+    SurfaceLOD const& lod{
+        surface.lods[std::min(level, surface.lods.size()) - 1]
+    };
+    return IndexRange{
+        .firstIndex = lod.firstIndex,
+        .indexCount = lod.indexCount,
+    };
+}
+
+namespace
+{
+// The coarsest level of the surface whose error spans at most the allowed
+// pixels, given how many pixels one unit of object space covers.
+auto selectSurfaceLevel(
+    GeometrySurface const& surface,
+    size_t const levelCount,
+    float const pixelsPerObjectUnit,
+    float const maxErrorPixels
+) -> size_t
+{
+    for (size_t level{levelCount - 1}; level > 0; level--)
+    {
+        if (surface.lods[level - 1].error * pixelsPerObjectUnit
+            <= maxErrorPixels)
+        {
+            return level;
+        }
+    }
+    return 0;
+}
+} // namespace
+
+void lod::selectInstanceLODs(
+    LODParameters const parameters,
+    gputypes::Camera const& camera,
+    float const viewportHeightPixels,
+    MeshAsset const& mesh,
+    MeshInstances& instances
+)
+{
+    std::span<glm::mat4x4 const> const models{
+        instances.models->readValidStaged()
+    };
+
+    bool anySurfaceHasLODs{false};
+    for (GeometrySurface const& surface : mesh.surfaces)
+    {
+        anySurfaceHasLODs |= surfaceLODCount(surface) > 1;
+    }
+    bool const selecting{parameters.enabled && anySurfaceHasLODs};
+
+    // Perspective projections place the depth into w, orthographic ones leave
+    // it alone, so we check the matrix instead of passing flags around.
+    bool const orthographic{glm::abs(camera.projection[2][3]) < 0.5F};
+
+    // How many pixels one world unit at unit distance from the camera covers.
+    float const pixelsPerUnit{
+        glm::abs(camera.projection[1][1]) * viewportHeightPixels / 2.0F
+    };
+
+    // How many pixels one unit of each instance's object space covers, which
+    // is infinite when the camera is within the instance's bounds.
+    std::vector<float>& pixelScales{instances.lodPixelScales};
+    std::vector<uint32_t>& sortedIndices{instances.lodSortScratch};
+    pixelScales.resize(models.size());
+    sortedIndices.resize(models.size());
+
+    for (size_t index{0}; index < models.size(); index++)
+    {
+        sortedIndices[index] = static_cast<uint32_t>(index);
+        if (!selecting)
+        {
+            continue;
+        }
+
+        glm::mat4x4 const& model{models[index]};
+        float const scale{glm::max(
+            glm::length(glm::vec3{model[0]}),
+            glm::max(
+                glm::length(glm::vec3{model[1]}),
+                glm::length(glm::vec3{model[2]})
+            )
+        )};
+
+        float distance{1.0F};
+        if (!orthographic)
+        {
+            glm::vec3 const center{model * glm::vec4{mesh.boundsCenter, 1.0F}};
+            distance = glm::distance(center, glm::vec3{camera.position})
+                     - mesh.boundsRadius * scale;
+        }
+
+        pixelScales[index] = distance > 0.0F
+                               ? scale * pixelsPerUnit / distance
+                               : std::numeric_limits<float>::infinity();
+    }
+
+    // Covering fewer pixels only ever allows coarser levels, so ordering by
+    // coverage leaves the instances of every level of every surface in one
+    // contiguous range. Ties keep their index order, so the order is stable
+    // between frames.
+    if (selecting)
+    {
+        std::sort(
+            sortedIndices.begin(),
+            sortedIndices.end(),
+            [&](uint32_t const lhs, uint32_t const rhs)
+            {
+                if (pixelScales[lhs] != pixelScales[rhs])
+                {
+                    return pixelScales[lhs] > pixelScales[rhs];
+                }
+                return lhs < rhs;
+            }
+        );
+    }
+
+    instances.lodRanges.resize(mesh.surfaces.size());
+    for (size_t surfaceIndex{0}; surfaceIndex < mesh.surfaces.size();
+         surfaceIndex++)
+    {
+        GeometrySurface const& surface{mesh.surfaces[surfaceIndex]};
+        size_t const levelCount{
+            selecting ? std::min(surfaceLODCount(surface), MESH_LOD_CAPACITY)
+                      : 1
+        };
+
+        std::vector<InstanceRange>& ranges{instances.lodRanges[surfaceIndex]};
+        ranges.assign(levelCount, InstanceRange{});
+        if (levelCount == 1)
+        {
+            ranges[0].instanceCount = static_cast<uint32_t>(models.size());
+            continue;
+        }
+
+        for (uint32_t const index : sortedIndices)
+        {
+            float const pixelsPerObjectUnit{pixelScales[index]};
+            size_t const level{
+                std::isinf(pixelsPerObjectUnit)
+                    ? 0
+                    : selectSurfaceLevel(
+                        surface,
+                        levelCount,
+                        pixelsPerObjectUnit,
+                        parameters.maxErrorPixels
+                    )
+            };
+            ranges[level].instanceCount += 1;
+        }
+
+        uint32_t firstInstance{0};
+        for (InstanceRange& range : ranges)
+        {
+            range.firstInstance = firstInstance;
+            firstInstance += range.instanceCount;
+        }
+    }
+
+    instances.lodSortedIndices->stage(sortedIndices);
+}
+
+auto lod::surfaceInstanceRanges(
+    MeshInstances const& instances, size_t const surface
+) -> std::span<InstanceRange const>
+{
+    if (surface >= instances.lodRanges.size())
+    {
+        return {};
+    }
+    return instances.lodRanges[surface];
+}
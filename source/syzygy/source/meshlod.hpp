@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "enginetypes.hpp"
+#include "gputypes.hpp"
+
+struct GeometrySurface;
+struct MeshAsset;
+
+// The most levels of detail, including the original, that a surface can have.
+size_t constexpr MESH_LOD_CAPACITY{4};
+
+// A level is only worth keeping if it removes at least this fraction of the
+// triangles in the previous level.
+float constexpr LOD_MINIMUM_REDUCTION{0.2F};
+
+struct LODParameters
+{
+    bool enabled{true};
+
+    // The coarsest level is picked whose simplification error, projected onto
+    // the screen, spans at most this many pixels.
+    float maxErrorPixels{1.0f};
+
+    bool operator==(LODParameters const& other) const = default;
+};
+
+namespace lod
+{
+struct SimplifiedIndices
+{
+    std::vector<uint32_t> indices{};
+
+    // The furthest distance in object space that any vertex was moved.
+    float error{0.0f};
+};
+
+// Simplifies a triangle list by snapping vertices onto a uniform grid with
+// the given number of cells along the longest axis of the surface bounds.
+// Each grid cell collapses onto its original vertex nearest to the cell's
+// centroid, so the output still indexes into the same vertices as the input.
+// Degenerate and duplicate triangles are removed. Indices are not bounds
+// checked, so they must all be in range, as importing ensures.
+SimplifiedIndices simplifyClustered(
+    std::span<Vertex const> vertices,
+    std::span<uint32_t const> indices,
+    uint32_t gridResolution
+);
+
+// Appends simplified levels of detail to the index list, recording their
+// ranges in the surface. Levels that do not meaningfully reduce the triangle
+// count are skipped. The vertices are only those of the surface, which its
+// indices are relative to and must not reach past.
+void generateSurfaceLODs(
+    std::span<Vertex const> vertices,
+    std::vector<uint32_t>& indices,
+    GeometrySurface& surface
+);
+
+// The most indices a surface can have across every level of detail, given
+// its full detail index count. Each level keeps at most 1 - reduction of the
+// previous level, so this is a geometric sum over the level capacity.
+uint64_t maxLODIndexCount(uint64_t fullDetailIndexCount);
+
+// The most scratch memory generateSurfaceLODs holds at once, in bytes.
+uint64_t maxLODScratchBytes(uint64_t vertexCount, uint64_t indexCount);
+
+struct IndexRange
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+size_t surfaceLODCount(GeometrySurface const& surface);
+
+// Level 0 is the full detail surface, and levels past the coarsest available
+// are clamped.
+IndexRange surfaceLODRange(GeometrySurface const& surface, size_t level);
+
+// Selects the level of detail of each surface of each instance, staging the
+// instance indices in an order where each surface's instances of every level
+// form a contiguous range. Models are read from the staged values, so they
+// should be up to date before calling this. Scratch memory is kept in the
+// instances, so this does not allocate once their count settles.
+void selectInstanceLODs(
+    LODParameters parameters,
+    gputypes::Camera const& camera,
+    float viewportHeightPixels,
+    MeshAsset const& mesh,
+    MeshInstances& instances
+);
+
+// The instance ranges drawn at each level of detail of the surface, starting
+// from full detail. Empty until levels of detail are first selected.
+std::span<InstanceRange const>
+surfaceInstanceRanges(MeshInstances const& instances, size_t surface);
+} // namespace lod
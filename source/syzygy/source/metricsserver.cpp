@@ -0,0 +1,467 @@
+#include "metricsserver.hpp"
+
+#include "cpuprofiler.hpp"
+#include "helpers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <optional>
+#include <string_view>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+NativeSocket const INVALID_NATIVE_SOCKET{INVALID_SOCKET};
+
+void closeSocket(NativeSocket const socket) { closesocket(socket); }
+auto pollSockets(pollfd* const fds, size_t const count, int const timeout)
+    -> int
+{
+    return WSAPoll(fds, static_cast<ULONG>(count), timeout);
+}
+auto receive(NativeSocket const socket, char* const data, size_t const size)
+    -> int64_t
+{
+    return recv(socket, data, static_cast<int>(size), 0);
+}
+auto transmit(
+    NativeSocket const socket, char const* const data, size_t const size
+) -> int64_t
+{
+    return send(socket, data, static_cast<int>(size), 0);
+}
+#else
+using NativeSocket = int;
+NativeSocket const INVALID_NATIVE_SOCKET{-1};
+
+void closeSocket(NativeSocket const socket) { close(socket); }
+auto pollSockets(pollfd* const fds, size_t const count, int const timeout)
+    -> int
+{
+    return poll(fds, static_cast<nfds_t>(count), timeout);
+}
+auto receive(NativeSocket const socket, char* const data, size_t const size)
+    -> int64_t
+{
+    return recv(socket, data, size, 0);
+}
+auto transmit(
+    NativeSocket const socket, char const* const data, size_t const size
+) -> int64_t
+{
+    // Without MSG_NOSIGNAL, a scraper hanging up would kill the process
+    return send(socket, data, size, MSG_NOSIGNAL);
+}
+#endif
+
+// How often the server thread wakes up to check whether it should stop
+int constexpr POLL_TIMEOUT_MILLISECONDS{200};
+
+// Scrapes are a single short GET, so anything longer is not worth reading
+size_t constexpr MAX_REQUEST_BYTES{4096};
+
+auto toNative(intptr_t const socket) -> NativeSocket
+{
+    return static_cast<NativeSocket>(socket);
+}
+
+// Reads until the end of the request's headers, or nothing on failure.
+auto readRequest(NativeSocket const client) -> std::optional<std::string>
+{
+    std::string request{};
+    std::array<char, 512> buffer{};
+    while (request.find("\r\n\r\n") == std::string::npos)
+    {
+        pollfd descriptor{.fd = client, .events = POLLIN, .revents = 0};
+        if (pollSockets(&descriptor, 1, POLL_TIMEOUT_MILLISECONDS) <= 0)
+        {
+            return std::nullopt;
+        }
+
+        int64_t const received{
+            receive(client, buffer.data(), buffer.size())
+        };
+        if (received <= 0)
+        {
+            return std::nullopt;
+        }
+        request.append(buffer.data(), static_cast<size_t>(received));
+        if (request.size() > MAX_REQUEST_BYTES)
+        {
+            return std::nullopt;
+        }
+    }
+    return request;
+}
+
+void sendAll(NativeSocket const client, std::string_view const bytes)
+{
+    size_t sent{0};
+    while (sent < bytes.size())
+    {
+        int64_t const result{
+            transmit(client, bytes.data() + sent, bytes.size() - sent)
+        };
+        if (result <= 0)
+        {
+            return;
+        }
+        sent += static_cast<size_t>(result);
+    }
+}
+
+auto httpResponse(std::string_view const status, std::string_view const body)
+    -> std::string
+{
+    return fmt::format(
+        "HTTP/1.1 {}\r\n"
+        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        "Content-Length: {}\r\n"
+        "Connection: close\r\n"
+        "\r\n"
+        "{}",
+        status,
+        body.size(),
+        body
+    );
+}
+
+// Label values escape backslashes, quotes, and newlines.
+auto escapeLabel(std::string_view const value) -> std::string
+{
+    std::string escaped{};
+    escaped.reserve(value.size());
+    for (char const character : value)
+    {
+        switch (character)
+        {
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        default:
+            escaped += character;
+            break;
+        }
+    }
+    return escaped;
+}
+
+void appendHeader(
+    std::string& output,
+    std::string_view const name,
+    std::string_view const type,
+    std::string_view const help
+)
+{
+    fmt::format_to(
+        std::back_inserter(output),
+        "# HELP {} {}\n# TYPE {} {}\n",
+        name,
+        help,
+        name,
+        type
+    );
+}
+
+auto openListener(std::string const& address, uint16_t const port)
+    -> std::optional<NativeSocket>
+{
+    sockaddr_in socketAddress{};
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &socketAddress.sin_addr) != 1)
+    {
+        Warning(fmt::format("{} is not an IPv4 address.", address));
+        return std::nullopt;
+    }
+
+    NativeSocket const listener{socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)};
+    if (listener == INVALID_NATIVE_SOCKET)
+    {
+        Warning("Unable to open a socket for metrics.");
+        return std::nullopt;
+    }
+
+    // Lets the port be reused right after a restart of the engine
+    int const reuse{1};
+    setsockopt(
+        listener,
+        SOL_SOCKET,
+        SO_REUSEADDR,
+        reinterpret_cast<char const*>(&reuse),
+        sizeof(reuse)
+    );
+
+    if (bind(
+            listener,
+            reinterpret_cast<sockaddr const*>(&socketAddress),
+            sizeof(socketAddress)
+        )
+            != 0
+        || listen(listener, SOMAXCONN) != 0)
+    {
+        Warning(fmt::format(
+            "Unable to listen on {}:{}, metrics are not served.", address, port
+        ));
+        closeSocket(listener);
+        return std::nullopt;
+    }
+
+    return listener;
+}
+} // namespace
+
+MetricsServer::MetricsServer(intptr_t const socket)
+    : m_socket(socket)
+{
+    m_thread = std::thread([this]() { serve(); });
+}
+
+auto MetricsServer::create(std::string const& address, uint16_t const port)
+    -> std::unique_ptr<MetricsServer>
+{
+#if defined(_WIN32)
+    WSADATA wsaData{};
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        Warning("Unable to initialize sockets, metrics are not served.");
+        return nullptr;
+    }
+#endif
+
+    std::optional<NativeSocket> const listener{openListener(address, port)};
+    if (!listener.has_value())
+    {
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+        return nullptr;
+    }
+
+    Log(fmt::format("Serving metrics at http://{}:{}/metrics", address, port));
+
+    return std::unique_ptr<MetricsServer>(
+        new MetricsServer(static_cast<intptr_t>(listener.value()))
+    );
+}
+
+MetricsServer::~MetricsServer()
+{
+    m_stopping.store(true, std::memory_order_relaxed);
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    closeSocket(toNative(m_socket));
+
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void MetricsServer::publish()
+{
+    auto const now{std::chrono::steady_clock::now()};
+    MetricsSnapshot& snapshot{m_snapshots.back()};
+
+    // The first call has no previous frame to measure from
+    if (m_previousFrame != std::chrono::steady_clock::time_point{})
+    {
+        double const seconds{
+            std::chrono::duration<double>(now - m_previousFrame).count()
+        };
+
+        auto const bucket{std::lower_bound(
+            MetricsSnapshot::FRAME_BUCKET_SECONDS.begin(),
+            MetricsSnapshot::FRAME_BUCKET_SECONDS.end(),
+            seconds
+        )};
+        m_frameBuckets[static_cast<size_t>(std::distance(
+            MetricsSnapshot::FRAME_BUCKET_SECONDS.begin(), bucket
+        ))] += 1;
+
+        m_frames += 1;
+        m_frameSecondsSum += seconds;
+        snapshot.lastFrameSeconds = seconds;
+    }
+    m_previousFrame = now;
+
+    snapshot.frames = m_frames;
+    snapshot.frameSecondsSum = m_frameSecondsSum;
+    snapshot.frameBuckets = m_frameBuckets;
+
+    m_snapshots.publish();
+}
+
+void MetricsServer::serve()
+{
+    CPUProfiler::setThreadName("Metrics Server");
+
+    NativeSocket const listener{toNative(m_socket)};
+    while (!m_stopping.load(std::memory_order_relaxed))
+    {
+        pollfd descriptor{.fd = listener, .events = POLLIN, .revents = 0};
+        if (pollSockets(&descriptor, 1, POLL_TIMEOUT_MILLISECONDS) <= 0)
+        {
+            continue;
+        }
+
+        NativeSocket const client{accept(listener, nullptr, nullptr)};
+        if (client == INVALID_NATIVE_SOCKET)
+        {
+            continue;
+        }
+
+        std::optional<std::string> const request{readRequest(client)};
+        if (request.has_value())
+        {
+            std::string_view const line{request.value()};
+            bool const scrape{
+                line.starts_with("GET /metrics ")
+                || line.starts_with("GET /metrics?")
+            };
+            sendAll(
+                client,
+                scrape ? httpResponse("200 OK", formatMetrics())
+                       : httpResponse("404 Not Found", "Not found.\n")
+            );
+        }
+        closeSocket(client);
+    }
+}
+
+auto MetricsServer::formatMetrics() -> std::string
+{
+    // Keeps the previous snapshot when the frame loop has not published since
+    m_snapshots.update();
+    MetricsSnapshot const& snapshot{m_snapshots.front()};
+
+    std::string output{};
+    auto out{std::back_inserter(output)};
+
+    appendHeader(
+        output, "syzygy_frames_total", "counter", "Frames rendered."
+    );
+    fmt::format_to(out, "syzygy_frames_total {}\n", snapshot.frames);
+
+    appendHeader(
+        output,
+        "syzygy_frame_seconds",
+        "gauge",
+        "Wall time of the most recent frame."
+    );
+    fmt::format_to(out, "syzygy_frame_seconds {}\n", snapshot.lastFrameSeconds);
+
+    appendHeader(
+        output,
+        "syzygy_frame_time_seconds",
+        "histogram",
+        "Wall time between the starts of consecutive frames."
+    );
+    uint64_t cumulative{0};
+    for (size_t bucket{0}; bucket < snapshot.frameBuckets.size(); bucket++)
+    {
+        cumulative += snapshot.frameBuckets[bucket];
+        std::string const bound{
+            bucket < MetricsSnapshot::FRAME_BUCKET_SECONDS.size()
+                ? fmt::format(
+                    "{}", MetricsSnapshot::FRAME_BUCKET_SECONDS[bucket]
+                )
+                : "+Inf"
+        };
+        fmt::format_to(
+            out,
+            "syzygy_frame_time_seconds_bucket{{le=\"{}\"}} {}\n",
+            bound,
+            cumulative
+        );
+    }
+    fmt::format_to(
+        out, "syzygy_frame_time_seconds_sum {}\n", snapshot.frameSecondsSum
+    );
+    fmt::format_to(
+        out, "syzygy_frame_time_seconds_count {}\n", snapshot.frames
+    );
+
+    struct HeapMetric
+    {
+        std::string_view name;
+        std::string_view help;
+        uint64_t MetricsSnapshot::Heap::* value;
+    };
+    std::array<HeapMetric, 4> constexpr HEAP_METRICS{
+        HeapMetric{
+            "syzygy_memory_heap_usage_bytes",
+            "Device memory used by this process, per heap.",
+            &MetricsSnapshot::Heap::usageBytes,
+        },
+        HeapMetric{
+            "syzygy_memory_heap_budget_bytes",
+            "Device memory available to this process, per heap.",
+            &MetricsSnapshot::Heap::budgetBytes,
+        },
+        HeapMetric{
+            "syzygy_memory_heap_allocation_bytes",
+            "Bytes of VMA allocations, per heap.",
+            &MetricsSnapshot::Heap::allocationBytes,
+        },
+        HeapMetric{
+            "syzygy_memory_heap_block_bytes",
+            "Bytes of device memory blocks allocated by VMA, per heap.",
+            &MetricsSnapshot::Heap::blockBytes,
+        },
+    };
+    for (HeapMetric const& metric : HEAP_METRICS)
+    {
+        appendHeader(output, metric.name, "gauge", metric.help);
+        for (uint32_t heap{0}; heap < snapshot.heapCount; heap++)
+        {
+            fmt::format_to(
+                out,
+                "{}{{heap=\"{}\"}} {}\n",
+                metric.name,
+                heap,
+                snapshot.heaps[heap].*metric.value
+            );
+        }
+    }
+
+    appendHeader(
+        output,
+        "syzygy_gpu_pass_seconds",
+        "gauge",
+        "GPU time of each profiled pass in the most recently read frame."
+    );
+    for (uint32_t pass{0}; pass < snapshot.passCount; pass++)
+    {
+        MetricsSnapshot::Pass const& timing{snapshot.passes[pass]};
+        std::string_view const name{timing.name.data()};
+        fmt::format_to(
+            out,
+            "syzygy_gpu_pass_seconds{{pass=\"{}\"}} {}\n",
+            escapeLabel(name),
+            timing.seconds
+        );
+    }
+
+    return output;
+}
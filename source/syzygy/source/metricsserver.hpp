@@ -0,0 +1,134 @@
+#pragma once
+
+#include "gpuprofiler.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Hands the latest value from one producer thread to one consumer thread
+// without locking. Each side owns a buffer, and the third is swapped between
+// them atomically, so the producer never waits on a slow consumer.
+template <typename T> class TripleBuffer
+{
+public:
+    // Producer only. Holds whatever was written two publishes ago.
+    T& back() { return m_buffers[m_backIndex]; }
+    void publish()
+    {
+        auto const published{static_cast<uint8_t>(m_backIndex | FRESH_BIT)};
+        m_backIndex =
+            m_middle.exchange(published, std::memory_order_acq_rel)
+            & INDEX_MASK;
+    }
+
+    // Consumer only. Returns whether a newer value was published since the
+    // last update, in which case front() now holds it.
+    bool update()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+        {
+            return false;
+        }
+        m_frontIndex =
+            m_middle.exchange(m_frontIndex, std::memory_order_acq_rel)
+            & INDEX_MASK;
+        return true;
+    }
+    T const& front() const { return m_buffers[m_frontIndex]; }
+
+private:
+    static uint8_t constexpr INDEX_MASK{0b011};
+    static uint8_t constexpr FRESH_BIT{0b100};
+
+    std::array<T, 3> m_buffers{};
+    uint8_t m_backIndex{0};
+    std::atomic<uint8_t> m_middle{1};
+    uint8_t m_frontIndex{2};
+};
+
+// Everything the metrics endpoint reports, fixed in size so publishing never
+// allocates.
+struct MetricsSnapshot
+{
+    // Upper bounds of the frame time histogram's buckets, before +Inf
+    static std::array<double, 10> constexpr FRAME_BUCKET_SECONDS{
+        0.004, 0.008, 0.012, 0.0167, 0.02, 0.025, 0.0333, 0.05, 0.1, 0.25
+    };
+
+    uint64_t frames{0};
+    double frameSecondsSum{0.0};
+    double lastFrameSeconds{0.0};
+
+    // Not cumulative, and the last bucket counts every longer frame
+    std::array<uint64_t, FRAME_BUCKET_SECONDS.size() + 1> frameBuckets{};
+
+    struct Heap
+    {
+        uint64_t usageBytes{0};
+        uint64_t budgetBytes{0};
+        uint64_t allocationBytes{0};
+        uint64_t blockBytes{0};
+    };
+    uint32_t heapCount{0};
+    std::array<Heap, VK_MAX_MEMORY_HEAPS> heaps{};
+
+    struct Pass
+    {
+        // Truncated, since copying into a string could allocate
+        std::array<char, 48> name{};
+        double seconds{0.0};
+    };
+    uint32_t passCount{0};
+    std::array<Pass, GPUProfiler::MAX_SCOPES_PER_FRAME> passes{};
+};
+
+// Serves the metrics of the frame loop over HTTP in the Prometheus text
+// format, from a background thread. The frame loop publishes a snapshot each
+// frame without locking or allocating, and the server formats whichever
+// snapshot is latest when scraped.
+class MetricsServer
+{
+public:
+    // Listens on the address, such as 127.0.0.1 to only serve this machine.
+    // Returns null if the socket could not be opened.
+    static std::unique_ptr<MetricsServer>
+    create(std::string const& address, uint16_t port);
+
+    MetricsServer(MetricsServer const& other) = delete;
+    MetricsServer& operator=(MetricsServer const& other) = delete;
+
+    // Stops serving and joins the thread.
+    ~MetricsServer();
+
+    // Frame loop only. Fill in the heaps and passes, then call publish.
+    MetricsSnapshot& snapshot() { return m_snapshots.back(); }
+
+    // Frame loop only, once per frame. Counts the time since the previous
+    // call as the frame's time.
+    void publish();
+
+private:
+    explicit MetricsServer(intptr_t socket);
+
+    void serve();
+    std::string formatMetrics();
+
+    // A platform socket handle, which is an integer on every platform
+    intptr_t m_socket;
+    std::atomic<bool> m_stopping{false};
+    std::thread m_thread{};
+
+    TripleBuffer<MetricsSnapshot> m_snapshots{};
+
+    // Cumulative, owned by the frame loop
+    std::chrono::steady_clock::time_point m_previousFrame{};
+    uint64_t m_frames{0};
+    double m_frameSecondsSum{0.0};
+    std::array<uint64_t, MetricsSnapshot::FRAME_BUCKET_SECONDS.size() + 1>
+        m_frameBuckets{};
+};
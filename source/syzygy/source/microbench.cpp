@@ -0,0 +1,340 @@
+#include "syzygy.hpp"
+
+#include "assets.hpp"
+#include "cpuprofiler.hpp"
+#include "engine.hpp"
+#include "engineparams.hpp"
+#include "geometryhelpers.hpp"
+#include "helpers.hpp"
+#include "shaders.hpp"
+
+#include <type_traits>
+
+namespace
+{
+struct MicrobenchmarkResult
+{
+    std::string name{};
+    uint64_t operations{0};
+    double nanosecondsPerOperation{0.0};
+
+    // Items, such as instances or bytes, processed per second
+    double itemsPerSecond{0.0};
+    std::string itemName{};
+};
+
+// Keeps the compiler from discarding work whose result is otherwise unused.
+template <typename T> void keepResult(T const& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static void const* volatile sink{nullptr};
+    sink = &value;
+#endif
+}
+
+class Microbenchmarks
+{
+public:
+    explicit Microbenchmarks(MicrobenchmarkParameters const& parameters)
+        : m_parameters(parameters)
+    {
+    }
+
+    // Runs the operation in batches that double in size, until a batch takes
+    // at least the minimum time, so the clock's overhead is negligible. An
+    // operation may return false on failure, which is checked on the first
+    // run, so that an error path is never timed.
+    template <typename Operation>
+    void run(
+        std::string const& name,
+        uint64_t const itemsPerOperation,
+        std::string const& itemName,
+        Operation&& operation
+    )
+    {
+        if (!m_parameters.filter.empty()
+            && name.find(m_parameters.filter) == std::string::npos)
+        {
+            return;
+        }
+
+        // The first run fills caches and makes any one-time allocations
+        if constexpr (std::is_same_v<std::invoke_result_t<Operation&>, bool>)
+        {
+            if (!operation())
+            {
+                Warning(fmt::format("Skipping {}, which failed.", name));
+                return;
+            }
+        }
+        else
+        {
+            operation();
+        }
+
+        auto const minimumNanoseconds{
+            static_cast<int64_t>(m_parameters.minimumSeconds * 1'000'000'000.0)
+        };
+        uint64_t constexpr MAX_OPERATIONS{1ULL << 32U};
+
+        uint64_t operations{1};
+        int64_t elapsedNanoseconds{0};
+        while (true)
+        {
+            int64_t const begin{CPUProfiler::now()};
+            for (uint64_t index{0}; index < operations; index++)
+            {
+                operation();
+            }
+            elapsedNanoseconds = CPUProfiler::now() - begin;
+
+            if (elapsedNanoseconds >= minimumNanoseconds
+                || operations >= MAX_OPERATIONS)
+            {
+                break;
+            }
+            operations *= 2;
+        }
+
+        double const nanosecondsPerOperation{
+            static_cast<double>(elapsedNanoseconds)
+            / static_cast<double>(operations)
+        };
+        MicrobenchmarkResult const& result{
+            m_results.emplace_back(MicrobenchmarkResult{
+                .name = name,
+                .operations = operations,
+                .nanosecondsPerOperation = nanosecondsPerOperation,
+                .itemsPerSecond = static_cast<double>(itemsPerOperation)
+                                * 1'000'000'000.0 / nanosecondsPerOperation,
+                .itemName = itemName,
+            })
+        };
+
+        Log(fmt::format(
+            "{:<36} {:>14.1f} ns/op {:>12.3f} M{}/s ({} ops)",
+            result.name,
+            result.nanosecondsPerOperation,
+            result.itemsPerSecond / 1'000'000.0,
+            result.itemName,
+            result.operations
+        ));
+    }
+
+    size_t count() const { return m_results.size(); }
+
+private:
+    MicrobenchmarkParameters m_parameters;
+    std::vector<MicrobenchmarkResult> m_results{};
+};
+
+// Matches the engine's default camera and sky, so the math follows the same
+// branches as a typical frame.
+CameraParameters const CAMERA{
+    .cameraPosition = glm::vec3{0.0F, -8.0F, -8.0F},
+    .eulerAngles = glm::vec3{-0.3F, 0.0F, 0.0F},
+    .fov = 70.0F,
+    .near = 0.1F,
+    .far = 10000.0F,
+};
+
+AtmosphereParameters const ATMOSPHERE{
+    .sunEulerAngles = glm::vec3(1.0, 0.0, 0.0),
+
+    .earthRadiusMeters = 6378000,
+    .atmosphereRadiusMeters = 6420000,
+
+    .groundColor = glm::vec3{0.9, 0.8, 0.6},
+
+    .scatteringCoefficientRayleigh = glm::vec3(0.0000038, 0.0000135, 0.0000331),
+    .altitudeDecayRayleigh = 7994.0,
+
+    .scatteringCoefficientMie = glm::vec3(0.000021),
+    .altitudeDecayMie = 1200.0,
+};
+
+void runMathBenchmarks(Microbenchmarks& benchmarks)
+{
+    float constexpr ASPECT_RATIO{16.0F / 9.0F};
+
+    benchmarks.run(
+        "geometry::projectionOrthoAABBVk",
+        1,
+        "projections",
+        [&]()
+        {
+            glm::mat4x4 const projection{geometry::projectionOrthoAABBVk(
+                geometry::viewVk(CAMERA.cameraPosition, CAMERA.eulerAngles),
+                glm::vec3{0.0, -4.0, 0.0},
+                glm::vec3{40.0, 5.0, 40.0}
+            )};
+            keepResult(projection);
+        }
+    );
+
+    benchmarks.run(
+        "CameraParameters::toDeviceEquivalent",
+        1,
+        "cameras",
+        [&]()
+        {
+            gputypes::Camera const camera{
+                CAMERA.toDeviceEquivalent(ASPECT_RATIO)
+            };
+            keepResult(camera);
+        }
+    );
+
+    benchmarks.run(
+        "AtmosphereParameters::toDeviceEquivalent",
+        1,
+        "atmospheres",
+        [&]()
+        {
+            gputypes::Atmosphere const atmosphere{
+                ATMOSPHERE.toDeviceEquivalent()
+            };
+            keepResult(atmosphere);
+        }
+    );
+}
+
+// Sizes match the default and dense benchmark scenes.
+void runInstanceBenchmarks(Microbenchmarks& benchmarks)
+{
+    for (size_t const gridSide : {81, 160})
+    {
+        size_t const instanceCount{gridSide * gridSide};
+
+        std::vector<glm::mat4x4> originals{};
+        originals.reserve(instanceCount);
+        for (size_t index{0}; index < instanceCount; index++)
+        {
+            originals.push_back(glm::translate(glm::vec3{
+                static_cast<float>(index % gridSide),
+                -4.0F,
+                static_cast<float>(index / gridSide)
+            }));
+        }
+        std::vector<glm::mat4x4> models(instanceCount);
+        std::vector<glm::mat4x4> modelInverseTransposes(instanceCount);
+
+        double timeElapsedSeconds{0.0};
+        benchmarks.run(
+            fmt::format("animateInstances/{}", instanceCount),
+            instanceCount,
+            "instances",
+            [&]()
+            {
+                animateInstances(
+                    originals,
+                    0,
+                    timeElapsedSeconds,
+                    models,
+                    modelInverseTransposes
+                );
+                keepResult(models);
+                keepResult(modelInverseTransposes);
+                timeElapsedSeconds += 1.0 / 60.0;
+            }
+        );
+    }
+}
+
+void runAssetBenchmarks(
+    Microbenchmarks& benchmarks, MicrobenchmarkParameters const& parameters
+)
+{
+    std::unique_ptr<std::filesystem::path> const meshPath{
+        DebugUtils::getLoadedDebugUtils().loadAssetPath(parameters.meshPath)
+    };
+    if (meshPath == nullptr)
+    {
+        Warning(fmt::format(
+            "Skipping mesh decoding, {} was not found.", parameters.meshPath
+        ));
+    }
+    else
+    {
+        // Only decoding, since uploading needs a device
+        uint64_t const meshBytes{std::filesystem::file_size(*meshPath)};
+        for (bool const packVertices : {false, true})
+        {
+            MeshImportOptions const options{.packVertices = packVertices};
+            benchmarks.run(
+                packVertices ? "decodeGltfMeshes/packed"
+                             : "decodeGltfMeshes/unpacked",
+                meshBytes,
+                "B",
+                [&]() -> bool
+                {
+                    size_t meshes{0};
+                    bool const decoded{decodeGltfMeshes(
+                        parameters.meshPath,
+                        options,
+                        [&](DecodedMesh&& mesh)
+                        {
+                            keepResult(mesh);
+                            meshes += 1;
+                            return true;
+                        }
+                    )};
+                    keepResult(meshes);
+                    return decoded;
+                }
+            );
+        }
+    }
+
+    AssetLoadingResult const shaderFile{
+        loadBuildOutputFile(parameters.shaderPath)
+    };
+    if (std::holds_alternative<AssetLoadingError>(shaderFile))
+    {
+        Warning(fmt::format(
+            "Skipping shader reflection, {}",
+            std::get<AssetLoadingError>(shaderFile).message
+        ));
+        return;
+    }
+
+    std::vector<uint8_t> const& spirv{
+        std::get<AssetFile>(shaderFile).fileBytes
+    };
+    benchmarks.run(
+        "vkutil::generateReflectionData",
+        spirv.size(),
+        "B",
+        [&]()
+        {
+            ShaderReflectionData const reflectionData{
+                vkutil::generateReflectionData(spirv)
+            };
+            keepResult(reflectionData);
+        }
+    );
+}
+} // namespace
+
+auto Application::runMicrobenchmarks(
+    MicrobenchmarkParameters const& parameters
+) -> ApplicationResult
+{
+    Microbenchmarks benchmarks{parameters};
+
+    runMathBenchmarks(benchmarks);
+    runInstanceBenchmarks(benchmarks);
+    runAssetBenchmarks(benchmarks, parameters);
+
+    if (benchmarks.count() == 0)
+    {
+        Error(fmt::format(
+            "No microbenchmarks ran with the filter '{}'.", parameters.filter
+        ));
+        return ApplicationResult::FAILURE;
+    }
+
+    return ApplicationResult::SUCCESS;
+}
@@ -0,0 +1,67 @@
+#include "pipelinecompiler.hpp"
+
+#include "cpuprofiler.hpp"
+
+PipelineCompiler::PipelineCompiler()
+{
+    for (size_t i{0}; i < WORKER_COUNT; i++)
+    {
+        m_workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+void PipelineCompiler::enqueue(std::function<void()> job)
+{
+    m_queueDepth++;
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_jobs.push_back(std::move(job));
+    }
+
+    m_jobAvailable.notify_one();
+}
+
+void PipelineCompiler::workerLoop()
+{
+    CPUProfiler::setThreadName("Pipeline Compiler");
+
+    while (true)
+    {
+        std::function<void()> job{};
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_jobAvailable.wait(
+                lock, [&]() { return m_stopping || !m_jobs.empty(); }
+            );
+            if (m_jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        {
+            VKR_PROFILE_ZONE("Compile Job");
+            job();
+        }
+
+        m_queueDepth--;
+    }
+}
+
+void PipelineCompiler::cleanup()
+{
+    {
+        std::lock_guard<std::mutex> const lock{m_mutex};
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "enginetypes.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+enum class CompileStatus
+{
+    QUEUED,
+    COMPILING,
+    READY,
+    FAILED,
+};
+
+// Refers to the result of a job on a PipelineCompiler. The result can be read
+// from any thread once ready, and is owned by whoever submitted the job, who
+// must destroy it. Default constructed handles were never submitted.
+template <typename T> class CompileHandle
+{
+public:
+    bool submitted() const { return m_shared != nullptr; }
+
+    CompileStatus status() const
+    {
+        return m_shared != nullptr
+                 ? m_shared->status.load(std::memory_order_acquire)
+                 : CompileStatus::FAILED;
+    }
+
+    bool ready() const { return status() == CompileStatus::READY; }
+
+    // Only valid once ready.
+    T const& get() const { return m_shared->result.value(); }
+
+private:
+    friend class PipelineCompiler;
+
+    struct Shared
+    {
+        std::atomic<CompileStatus> status{CompileStatus::QUEUED};
+        std::optional<T> result{};
+    };
+
+    std::shared_ptr<Shared> m_shared{};
+};
+
+// Creates pipelines and shader objects on worker threads, so that new
+// variants never stall a frame. Callers hold a handle and skip or fall back
+// while it is not ready.
+class PipelineCompiler
+{
+public:
+    static size_t constexpr WORKER_COUNT{2};
+
+    PipelineCompiler();
+
+    PipelineCompiler(PipelineCompiler const& other) = delete;
+    PipelineCompiler& operator=(PipelineCompiler const& other) = delete;
+
+    // Queues the job, which returns nothing if compilation failed. The job
+    // may run on any thread, so it must only touch thread-safe state, such as
+    // the device.
+    template <typename T>
+    CompileHandle<T> submit(std::function<std::optional<T>()> job)
+    {
+        CompileHandle<T> handle{};
+        handle.m_shared = std::make_shared<typename CompileHandle<T>::Shared>();
+
+        enqueue(
+            [shared = handle.m_shared, job = std::move(job)]()
+            {
+                shared->status.store(
+                    CompileStatus::COMPILING, std::memory_order_release
+                );
+                shared->result = job();
+                shared->status.store(
+                    shared->result.has_value() ? CompileStatus::READY
+                                               : CompileStatus::FAILED,
+                    std::memory_order_release
+                );
+            }
+        );
+
+        return handle;
+    }
+
+    // Jobs that are queued or compiling.
+    size_t queueDepth() const { return m_queueDepth.load(); }
+
+    // Finishes every queued job, so each handle ends ready or failed, then
+    // stops the workers.
+    void cleanup();
+
+private:
+    void enqueue(std::function<void()> job);
+
+    void workerLoop();
+
+    std::vector<std::thread> m_workers{};
+
+    mutable std::mutex m_mutex{};
+    std::condition_variable m_jobAvailable{};
+    bool m_stopping{false};
+    std::deque<std::function<void()>> m_jobs{};
+
+    std::atomic<size_t> m_queueDepth{0};
+};
@@ -1,7 +1,12 @@
 #include "pipelines.hpp"
 
+#include "gpuprofiler.hpp"
 #include "helpers.hpp"
 #include "initializers.hpp"
+#include "meshletcull.hpp"
+#include "meshlod.hpp"
+#include "shadercache.hpp"
+#include "shaderpermutations.hpp"
 #include "shaders.hpp"
 #include <fstream>
 
@@ -74,9 +79,24 @@ auto PipelineBuilder::buildPipeline(
         .pDynamicStates = dynamicStates.data(),
     };
 
+    // Reports whether the pipeline came from the on-disk cache
+    VkPipelineCreationFeedback pipelineFeedback{};
+    std::vector<VkPipelineCreationFeedback> stageFeedbacks(
+        m_shaderStages.size()
+    );
+    VkPipelineCreationFeedbackCreateInfo const feedbackInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO,
+        .pNext = &renderInfo,
+
+        .pPipelineCreationFeedback = &pipelineFeedback,
+        .pipelineStageCreationFeedbackCount =
+            static_cast<uint32_t>(stageFeedbacks.size()),
+        .pPipelineStageCreationFeedbacks = stageFeedbacks.data(),
+    };
+
     VkGraphicsPipelineCreateInfo const pipelineInfo{
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .pNext = &renderInfo,
+        .pNext = &feedbackInfo,
 
         .stageCount = static_cast<uint32_t>(m_shaderStages.size()),
         .pStages = m_shaderStages.data(),
@@ -101,13 +121,31 @@ auto PipelineBuilder::buildPipeline(
         .basePipelineIndex = 0,
     };
 
+    ShaderCache* const cache{ShaderCache::getLoadedShaderCache()};
+    VkPipelineCache const pipelineCache{
+        cache != nullptr ? cache->pipelineCache() : VK_NULL_HANDLE
+    };
+
     VkPipeline pipeline{VK_NULL_HANDLE};
     LogVkResult(
         vkCreateGraphicsPipelines(
-            device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline
+            device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline
         ),
         "Building graphics pipeline"
     );
+
+    if (cache != nullptr
+        && (pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT
+        ) != 0)
+    {
+        cache->recordPipeline(
+            (pipelineFeedback.flags
+             & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT
+            )
+            != 0
+        );
+    }
+
     return pipeline;
 }
 
@@ -210,20 +248,38 @@ void PipelineBuilder::enableDepthTest(
 ComputeCollectionPipeline::ComputeCollectionPipeline(
     VkDevice const device,
     VkDescriptorSetLayout const drawImageDescriptorLayout,
-    std::span<std::string const> const shaderPaths
+    std::span<std::string const> const shaderPaths,
+    WorkgroupSize const workgroupSize
 )
 {
+    m_workgroupSize = workgroupSize;
+
     std::vector<VkDescriptorSetLayout> const layouts{drawImageDescriptorLayout};
 
-    m_shaders.clear();
+    SpecializationConstants constants{};
+    constants.set(WorkgroupTuner::SIZE_X_CONSTANT_ID, workgroupSize.x)
+        .set(WorkgroupTuner::SIZE_Y_CONSTANT_ID, workgroupSize.y);
+    VkSpecializationInfo const specializationInfo{constants.info()};
+
+    // Compiled together as one batch
+    std::vector<vkutil::ShaderObjectLoadInfo> loadInfos{};
     for (std::string const& shaderPath : shaderPaths)
     {
-        std::optional<ShaderObjectReflected> loadResult{
-            vkutil::loadShaderObject(
-                device, shaderPath, VK_SHADER_STAGE_COMPUTE_BIT, 0, layouts, {}
-            )
-        };
+        loadInfos.push_back(vkutil::ShaderObjectLoadInfo{
+            .path = shaderPath,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .nextStage = 0,
+            .layouts = layouts,
+            .specializationInfo = specializationInfo,
+        });
+    }
+    std::vector<std::optional<ShaderObjectReflected>> const loadResults{
+        vkutil::loadShaderObjects(device, loadInfos)
+    };
 
+    m_shaders.clear();
+    for (std::optional<ShaderObjectReflected> const& loadResult : loadResults)
+    {
         if (!loadResult.has_value())
         {
             continue;
@@ -346,14 +402,13 @@ void ComputeCollectionPipeline::recordDrawCommands(
         );
     }
 
-    uint32_t constexpr WORKGROUP_SIZE{16};
-
     vkCmdDispatch(
         cmd,
-        computeDispatchCount(drawExtent.width, WORKGROUP_SIZE),
-        computeDispatchCount(drawExtent.height, WORKGROUP_SIZE),
+        computeDispatchCount(drawExtent.width, m_workgroupSize.x),
+        computeDispatchCount(drawExtent.height, m_workgroupSize.y),
         1
     );
+    GPUProfiler::countWork(WorkCounters{.dispatches = 1});
 }
 
 void ComputeCollectionPipeline::cleanup(VkDevice const device)
@@ -369,9 +424,15 @@ void ComputeCollectionPipeline::cleanup(VkDevice const device)
 }
 
 DebugLineGraphicsPipeline::DebugLineGraphicsPipeline(
-    VkDevice const device, ImageFormats const formats
+    VkDevice const device,
+    ImageFormats const formats,
+    PipelineCompiler& compiler
 )
 {
+    m_device = device;
+    m_formats = formats;
+    m_compiler = &compiler;
+
     ShaderModuleReflected const vertexShader{
         vkutil::loadShaderModule(device, "shaders/debug/debugline.vert.spv")
             .value_or(ShaderModuleReflected::MakeInvalid())
@@ -429,29 +490,65 @@ DebugLineGraphicsPipeline::DebugLineGraphicsPipeline(
         vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout)
     );
 
+    m_vertexShader = vertexShader;
+    m_fragmentShader = fragmentShader;
+
+    m_graphicsPipelineLayout = pipelineLayout;
+
+    requestVariant(false);
+}
+
+void DebugLineGraphicsPipeline::requestVariant(bool const occluded)
+{
+    CompileHandle<VkPipeline>& handle{m_pipelines[occluded ? 1 : 0]};
+    if (handle.submitted())
+    {
+        return;
+    }
+
+    // The stages point at the members' entry point names, which outlive the
+    // job since the compiler is cleaned up first.
     PipelineBuilder pipelineBuilder{};
-    pipelineBuilder.pushShader(vertexShader, VK_SHADER_STAGE_VERTEX_BIT);
-    pipelineBuilder.pushShader(fragmentShader, VK_SHADER_STAGE_FRAGMENT_BIT);
+    pipelineBuilder.pushShader(m_vertexShader, VK_SHADER_STAGE_VERTEX_BIT);
+    pipelineBuilder.pushShader(m_fragmentShader, VK_SHADER_STAGE_FRAGMENT_BIT);
     pipelineBuilder.setInputTopology(VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
     pipelineBuilder.setPolygonMode(VK_POLYGON_MODE_FILL);
     pipelineBuilder.setCullMode(VK_CULL_MODE_NONE, VK_FRONT_FACE_CLOCKWISE);
     pipelineBuilder.pushDynamicState(VK_DYNAMIC_STATE_LINE_WIDTH);
     pipelineBuilder.setMultisamplingNone();
-    pipelineBuilder.enableDepthTest(true, VK_COMPARE_OP_ALWAYS);
+    if (occluded)
+    {
+        // Reversed-Z, so nearer lines have greater depth
+        pipelineBuilder.enableDepthTest(false, VK_COMPARE_OP_GREATER_OR_EQUAL);
+    }
+    else
+    {
+        pipelineBuilder.enableDepthTest(true, VK_COMPARE_OP_ALWAYS);
+    }
 
-    pipelineBuilder.setColorAttachment(formats.color);
-    pipelineBuilder.setDepthFormat(formats.depth);
+    pipelineBuilder.setColorAttachment(m_formats.color);
+    pipelineBuilder.setDepthFormat(m_formats.depth);
 
-    m_vertexShader = vertexShader;
-    m_fragmentShader = fragmentShader;
-
-    m_graphicsPipelineLayout = pipelineLayout;
-    m_graphicsPipeline = pipelineBuilder.buildPipeline(device, pipelineLayout);
+    handle = m_compiler->submit<VkPipeline>(
+        [device = m_device,
+         pipelineBuilder,
+         layout = m_graphicsPipelineLayout]() -> std::optional<VkPipeline>
+        {
+            VkPipeline const pipeline{
+                pipelineBuilder.buildPipeline(device, layout)
+            };
+            if (pipeline == VK_NULL_HANDLE)
+            {
+                return std::nullopt;
+            }
+            return pipeline;
+        }
+    );
 }
 
 auto DebugLineGraphicsPipeline::recordDrawCommands(
     VkCommandBuffer const cmd,
-    bool const reuseDepthAttachment,
+    bool occluded,
     float const lineWidth,
     VkRect2D const drawRect,
     AllocatedImage const& color,
@@ -462,6 +559,16 @@ auto DebugLineGraphicsPipeline::recordDrawCommands(
     TStagedBuffer<uint32_t> const& indices
 ) const -> DrawResultsGraphics
 {
+    if (occluded && !variantReady(true))
+    {
+        occluded = false;
+    }
+    if (!variantReady(occluded))
+    {
+        return DrawResultsGraphics{};
+    }
+    VkPipeline const pipeline{m_pipelines[occluded ? 1 : 0].get()};
+
     VkRenderingAttachmentInfo const colorAttachment{
         .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
         .pNext = nullptr,
@@ -476,23 +583,22 @@ auto DebugLineGraphicsPipeline::recordDrawCommands(
         .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
     };
-    VkAttachmentLoadOp const depthLoadOp{
-        reuseDepthAttachment ? VK_ATTACHMENT_LOAD_OP_LOAD
-                             : VK_ATTACHMENT_LOAD_OP_CLEAR
-    };
     VkRenderingAttachmentInfo const depthAttachment{
         .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
         .pNext = nullptr,
 
         .imageView = depth.imageView,
-        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+        .imageLayout = occluded ? VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL
+                                : VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
 
         .resolveMode = VK_RESOLVE_MODE_NONE,
         .resolveImageView = VK_NULL_HANDLE,
         .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
 
-        .loadOp = depthLoadOp,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .loadOp = occluded ? VK_ATTACHMENT_LOAD_OP_LOAD
+                           : VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = occluded ? VK_ATTACHMENT_STORE_OP_NONE
+                            : VK_ATTACHMENT_STORE_OP_STORE,
 
         .clearValue = VkClearValue{.depthStencil{.depth = 0.0F}},
     };
@@ -520,7 +626,7 @@ auto DebugLineGraphicsPipeline::recordDrawCommands(
 
     vkCmdBeginRendering(cmd, &renderInfo);
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
     vkCmdSetLineWidth(cmd, lineWidth);
 
@@ -560,6 +666,7 @@ auto DebugLineGraphicsPipeline::recordDrawCommands(
     // but only draw a single surface.
     vkCmdBindIndexBuffer(cmd, indices.deviceBuffer(), 0, VK_INDEX_TYPE_UINT32);
     vkCmdDraw(cmd, indices.deviceSize(), 1, 0, 0);
+    GPUProfiler::countWork(WorkCounters{.drawCalls = 1, .instances = 1});
 
     vkCmdEndRendering(cmd);
 
@@ -575,7 +682,13 @@ void DebugLineGraphicsPipeline::cleanup(VkDevice const device)
     m_fragmentShader.cleanup(device);
     m_vertexShader.cleanup(device);
 
-    vkDestroyPipeline(device, m_graphicsPipeline, nullptr);
+    for (CompileHandle<VkPipeline> const& pipeline : m_pipelines)
+    {
+        if (pipeline.ready())
+        {
+            vkDestroyPipeline(device, pipeline.get(), nullptr);
+        }
+    }
     vkDestroyPipelineLayout(device, m_graphicsPipelineLayout, nullptr);
 }
 
@@ -671,7 +784,8 @@ void OffscreenPassGraphicsPipeline::recordDrawCommands(
     uint32_t const projViewIndex,
     TStagedBuffer<glm::mat4x4> const& projViewMatrices,
     MeshAsset const& mesh,
-    TStagedBuffer<glm::mat4x4> const& models
+    MeshInstances const& instances,
+    MeshletCullPass const* const meshletDraws
 ) const
 {
     VkAttachmentLoadOp const depthLoadOp{
@@ -735,11 +849,17 @@ void OffscreenPassGraphicsPipeline::recordDrawCommands(
     GPUMeshBuffers& meshBuffers{*mesh.meshBuffers};
 
     { // Vertex push constant
+        VertexEncoding const encoding{meshBuffers.vertexEncoding()};
         VertexPushConstant const vertexPushConstant{
-            .vertexBufferAddress = meshBuffers.vertexAddress(),
-            .modelBufferAddress = models.deviceAddress(),
+            .positionBufferAddress = meshBuffers.positionAddress(),
+            .modelBufferAddress = instances.models->deviceAddress(),
             .projViewBufferAddress = projViewMatrices.deviceAddress(),
+            .instanceIndexBufferAddress =
+                instances.lodSortedIndices->deviceAddress(),
             .projViewIndex = projViewIndex,
+            .vertexFormat = encoding.format,
+            .positionMin = glm::vec4{encoding.positionMin, 0.0F},
+            .positionExtent = glm::vec4{encoding.positionExtent, 0.0F},
         };
         vkCmdPushConstants(
             cmd,
@@ -757,16 +877,43 @@ void OffscreenPassGraphicsPipeline::recordDrawCommands(
     // Bind the entire index buffer of the mesh,
     // but only draw a single surface.
     vkCmdBindIndexBuffer(
-        cmd, meshBuffers.indexBuffer(), 0, VK_INDEX_TYPE_UINT32
-    );
-    vkCmdDrawIndexed(
-        cmd,
-        drawnSurface.indexCount,
-        models.deviceSize(),
-        drawnSurface.firstIndex,
-        0,
-        0
+        cmd, meshBuffers.indexBuffer(), 0, meshBuffers.indexType()
     );
+    // Levels of detail are selected from the main camera, so shadows match
+    // the geometry that is seen.
+    std::span<InstanceRange const> const ranges{
+        lod::surfaceInstanceRanges(instances, 0)
+    };
+    for (size_t level{0}; level < ranges.size(); level++)
+    {
+        InstanceRange const& range{ranges[level]};
+        if (range.instanceCount == 0)
+        {
+            continue;
+        }
+
+        // Full detail instances are replaced by their culled meshlets
+        if (level == 0 && meshletDraws != nullptr)
+        {
+            meshletDraws->recordDrawIndirect(cmd);
+            continue;
+        }
+
+        lod::IndexRange const indices{lod::surfaceLODRange(drawnSurface, level)
+        };
+        vkCmdDrawIndexed(
+            cmd,
+            indices.indexCount,
+            range.instanceCount,
+            indices.firstIndex,
+            drawnSurface.vertexOffset,
+            range.firstInstance
+        );
+        GPUProfiler::countWork(WorkCounters{
+            .drawCalls = 1,
+            .instances = range.instanceCount,
+        });
+    }
 
     vkCmdEndRendering(cmd);
 }
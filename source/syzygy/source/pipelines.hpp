@@ -10,7 +10,11 @@
 #include "assets.hpp"
 #include "buffers.hpp"
 #include "images.hpp"
+#include "pipelinecompiler.hpp"
 #include "shaders.hpp"
+#include "workgrouptuner.hpp"
+
+class MeshletCullPass;
 
 namespace
 {
@@ -124,7 +128,8 @@ public:
         uint32_t projViewIndex,
         TStagedBuffer<glm::mat4x4> const& projViewMatrices,
         MeshAsset const& mesh,
-        TStagedBuffer<glm::mat4x4> const& models
+        MeshInstances const& instances,
+        MeshletCullPass const* meshletDraws
     ) const;
 
     void cleanup(VkDevice device);
@@ -137,12 +142,18 @@ private:
 
     struct VertexPushConstant
     {
-        VkDeviceAddress vertexBufferAddress{};
+        VkDeviceAddress positionBufferAddress{};
         VkDeviceAddress modelBufferAddress{};
 
         VkDeviceAddress projViewBufferAddress{};
+        VkDeviceAddress instanceIndexBufferAddress{};
+
         uint32_t projViewIndex{0};
-        uint8_t padding0[4]{};
+        VertexFormat vertexFormat{VertexFormat::FULL};
+        uint8_t padding0[8]{};
+
+        glm::vec4 positionMin{};
+        glm::vec4 positionExtent{};
     };
 
     VertexPushConstant mutable m_vertexPushConstant{};
@@ -172,7 +183,8 @@ public:
     ComputeCollectionPipeline(
         VkDevice device,
         VkDescriptorSetLayout drawImageDescriptorLayout,
-        std::span<std::string const> shaderPaths
+        std::span<std::string const> shaderPaths,
+        WorkgroupSize workgroupSize
     );
 
     void recordDrawCommands(
@@ -225,6 +237,9 @@ public:
 private:
     size_t m_shaderIndex{0};
 
+    // Every shader is specialized to this size
+    WorkgroupSize m_workgroupSize{};
+
     std::vector<ShaderObjectReflected> m_shaders{};
     std::vector<std::vector<uint8_t>> m_shaderPushConstants{};
     std::vector<VkPipelineLayout> m_layouts{};
@@ -241,11 +256,26 @@ public:
         VkFormat depth;
     };
 
-    DebugLineGraphicsPipeline(VkDevice device, ImageFormats formats);
+    // Queues the unoccluded variant on the compiler, which must outlive this.
+    DebugLineGraphicsPipeline(
+        VkDevice device, ImageFormats formats, PipelineCompiler& compiler
+    );
+
+    // Queues the variant if it has not been already.
+    void requestVariant(bool occluded);
 
+    bool variantReady(bool occluded) const
+    {
+        return m_pipelines[occluded ? 1 : 0].ready();
+    }
+
+    // Occluded lines are depth tested against the scene's depth, which must
+    // be in DEPTH_READ_ONLY_OPTIMAL. Otherwise the depth is cleared and lines
+    // draw over everything. Falls back to the unoccluded variant while the
+    // requested one compiles, and draws nothing if neither is ready.
     DrawResultsGraphics recordDrawCommands(
         VkCommandBuffer cmd,
-        bool reuseDepthAttachment,
+        bool occluded,
         float lineWidth,
         VkRect2D drawRect,
         AllocatedImage const& color,
@@ -274,7 +304,12 @@ private:
 
     VertexPushConstant mutable m_vertexPushConstant{};
 
-    VkPipeline m_graphicsPipeline{VK_NULL_HANDLE};
+    VkDevice m_device{VK_NULL_HANDLE};
+    ImageFormats m_formats{};
+    PipelineCompiler* m_compiler{nullptr};
+
+    // Indexed by whether the variant is occluded
+    std::array<CompileHandle<VkPipeline>, 2> m_pipelines{};
     VkPipelineLayout m_graphicsPipelineLayout{VK_NULL_HANDLE};
 
 public:
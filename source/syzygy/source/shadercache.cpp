@@ -0,0 +1,499 @@
+#include "shadercache.hpp"
+
+#include "helpers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+uint64_t constexpr FNV_OFFSET_BASIS{0xcbf29ce484222325ULL};
+
+auto hashBytes(std::span<uint8_t const> const bytes, uint64_t hash)
+    -> uint64_t
+{
+    for (uint8_t const byte : bytes)
+    {
+        hash ^= byte;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+template <typename T> auto hashValue(T const& value, uint64_t const hash)
+{
+    return hashBytes(
+        std::span<uint8_t const>{
+            reinterpret_cast<uint8_t const*>(&value), sizeof(T)
+        },
+        hash
+    );
+}
+
+// Prefixes every file, and covers the driver's own header check for data
+// that is truncated or corrupted.
+struct CacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    std::array<uint8_t, VK_UUID_SIZE> uuid;
+    uint32_t uuidVersion;
+    uint32_t driverVersion;
+    uint64_t dataBytes;
+    uint64_t dataHash;
+};
+
+uint32_t constexpr PIPELINE_CACHE_MAGIC{0x4C505A53};      // "SZPL"
+uint32_t constexpr SHADER_OBJECT_CACHE_MAGIC{0x4F535A53}; // "SZSO"
+
+// Bump this whenever the file layout changes.
+uint32_t constexpr CACHE_VERSION{1};
+
+auto toUUID(uint8_t const (&uuid)[VK_UUID_SIZE])
+    -> std::array<uint8_t, VK_UUID_SIZE>
+{
+    std::array<uint8_t, VK_UUID_SIZE> result{};
+    std::copy(std::begin(uuid), std::end(uuid), result.begin());
+    return result;
+}
+
+auto cachePath(std::filesystem::path const& localPath) -> std::filesystem::path
+{
+    return DebugUtils::getLoadedDebugUtils().makeAbsolutePath(
+        std::filesystem::path{"cache"} / localPath
+    );
+}
+
+auto readCacheFile(
+    std::filesystem::path const& path, CacheHeader const& expected
+) -> std::optional<std::vector<uint8_t>>
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader));
+    if (!file || header.magic != expected.magic
+        || header.version != expected.version || header.uuid != expected.uuid
+        || header.uuidVersion != expected.uuidVersion
+        || header.driverVersion != expected.driverVersion)
+    {
+        return std::nullopt;
+    }
+
+    // A corrupted size would otherwise allocate however much it claims.
+    std::error_code error{};
+    uintmax_t const fileBytes{std::filesystem::file_size(path, error)};
+    if (error || header.dataBytes != fileBytes - sizeof(CacheHeader))
+    {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> data(header.dataBytes);
+    file.read(
+        reinterpret_cast<char*>(data.data()),
+        static_cast<std::streamsize>(data.size())
+    );
+    if (!file || hashBytes(data, FNV_OFFSET_BASIS) != header.dataHash)
+    {
+        return std::nullopt;
+    }
+
+    return data;
+}
+
+void writeCacheFile(
+    std::filesystem::path const& path,
+    CacheHeader header,
+    std::span<uint8_t const> const data
+)
+{
+    std::error_code error{};
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error)
+    {
+        Warning(fmt::format(
+            "Unable to create shader cache directory: {}", error.message()
+        ));
+        return;
+    }
+
+    header.dataBytes = data.size();
+    header.dataHash = hashBytes(data, FNV_OFFSET_BASIS);
+
+    // Written aside and then renamed, so that other threads or runs never
+    // read a partial entry.
+    size_t const threadHash{
+        std::hash<std::thread::id>{}(std::this_thread::get_id())
+    };
+    std::filesystem::path const partialPath{
+        path.string() + fmt::format(".{}.partial", threadHash)
+    };
+
+    {
+        std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            Warning("Unable to write shader cache entry.");
+            return;
+        }
+
+        file.write(reinterpret_cast<char const*>(&header), sizeof(CacheHeader));
+        file.write(
+            reinterpret_cast<char const*>(data.data()),
+            static_cast<std::streamsize>(data.size())
+        );
+    }
+
+    std::filesystem::rename(partialPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(partialPath, error);
+    }
+}
+
+auto pipelineCacheHeader(VkPhysicalDeviceProperties const& properties)
+    -> CacheHeader
+{
+    return CacheHeader{
+        .magic = PIPELINE_CACHE_MAGIC,
+        .version = CACHE_VERSION,
+        .uuid = toUUID(properties.pipelineCacheUUID),
+        .uuidVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE,
+        .driverVersion = properties.driverVersion,
+    };
+}
+
+auto pipelineCachePath(VkPhysicalDeviceProperties const& properties)
+    -> std::filesystem::path
+{
+    return cachePath(fmt::format(
+        "pipelines/{:04x}_{:04x}_{:08x}.bin",
+        properties.vendorID,
+        properties.deviceID,
+        properties.driverVersion
+    ));
+}
+
+// The driver checks this too, but rejected data would still cost a log line
+// from the validation layers.
+auto pipelineCacheCompatible(
+    std::span<uint8_t const> const data,
+    VkPhysicalDeviceProperties const& properties
+) -> bool
+{
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && std::equal(
+               std::begin(header.pipelineCacheUUID),
+               std::end(header.pipelineCacheUUID),
+               std::begin(properties.pipelineCacheUUID)
+        );
+}
+} // namespace
+
+void ShaderCache::init(
+    VkPhysicalDevice const physicalDevice, VkDevice const device
+)
+{
+    if (m_loadedShaderCache != nullptr)
+    {
+        Warning("Called ShaderCache::init when one was already loaded.");
+        return;
+    }
+
+    std::unique_ptr<ShaderCache> cache{new ShaderCache()};
+    cache->m_device = device;
+
+    cache->m_shaderObjectProperties = VkPhysicalDeviceShaderObjectPropertiesEXT{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_PROPERTIES_EXT,
+        .pNext = nullptr,
+    };
+    VkPhysicalDeviceProperties2 properties{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &cache->m_shaderObjectProperties,
+    };
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+    cache->m_deviceProperties = properties.properties;
+
+    std::optional<std::vector<uint8_t>> initialData{readCacheFile(
+        pipelineCachePath(cache->m_deviceProperties),
+        pipelineCacheHeader(cache->m_deviceProperties)
+    )};
+    if (initialData.has_value()
+        && !pipelineCacheCompatible(
+            initialData.value(), cache->m_deviceProperties
+        ))
+    {
+        Warning("Discarding pipeline cache written by a different device.");
+        initialData.reset();
+    }
+
+    VkPipelineCacheCreateInfo const createInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .initialDataSize = initialData.has_value() ? initialData->size() : 0,
+        .pInitialData =
+            initialData.has_value() ? initialData->data() : nullptr,
+    };
+
+    VkResult const result{vkCreatePipelineCache(
+        device, &createInfo, nullptr, &cache->m_pipelineCache
+    )};
+    if (result != VK_SUCCESS && initialData.has_value())
+    {
+        LogVkResult(result, "Pipeline cache data was refused, starting empty");
+
+        VkPipelineCacheCreateInfo const emptyCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        };
+        CheckVkResult(vkCreatePipelineCache(
+            device, &emptyCreateInfo, nullptr, &cache->m_pipelineCache
+        ));
+    }
+    else
+    {
+        CheckVkResult(result);
+    }
+
+    Log(fmt::format(
+        "Shader cache loaded, with {} bytes of pipeline cache data.",
+        initialData.has_value() ? initialData->size() : 0
+    ));
+
+    m_loadedShaderCache = std::move(cache);
+}
+
+void ShaderCache::cleanup()
+{
+    if (m_loadedShaderCache == nullptr)
+    {
+        return;
+    }
+
+    ShaderCache const& cache{*m_loadedShaderCache};
+
+    size_t dataSize{0};
+    VkResult result{vkGetPipelineCacheData(
+        cache.m_device, cache.m_pipelineCache, &dataSize, nullptr
+    )};
+    std::vector<uint8_t> data(dataSize);
+    if (result == VK_SUCCESS)
+    {
+        result = vkGetPipelineCacheData(
+            cache.m_device, cache.m_pipelineCache, &dataSize, data.data()
+        );
+    }
+
+    if (result == VK_SUCCESS)
+    {
+        data.resize(dataSize);
+        writeCacheFile(
+            pipelineCachePath(cache.m_deviceProperties),
+            pipelineCacheHeader(cache.m_deviceProperties),
+            data
+        );
+    }
+    else
+    {
+        LogVkResult(result, "Unable to read back pipeline cache data");
+    }
+
+    cache.logStatistics();
+
+    m_loadedShaderCache.reset();
+}
+
+ShaderCache::~ShaderCache()
+{
+    vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+}
+
+void ShaderCache::registerSetLayout(
+    VkDescriptorSetLayout const layout,
+    VkDescriptorSetLayoutCreateInfo const& createInfo,
+    std::span<VkDescriptorBindingFlags const> const bindingFlags
+)
+{
+    uint64_t hash{FNV_OFFSET_BASIS};
+
+    hash = hashValue(createInfo.flags, hash);
+    for (VkDescriptorSetLayoutBinding const& binding :
+         std::span<VkDescriptorSetLayoutBinding const>{
+             createInfo.pBindings, createInfo.bindingCount
+         })
+    {
+        // Immutable samplers are handles, so only their presence is stable.
+        hash = hashValue(binding.binding, hash);
+        hash = hashValue(binding.descriptorType, hash);
+        hash = hashValue(binding.descriptorCount, hash);
+        hash = hashValue(binding.stageFlags, hash);
+        hash = hashValue(binding.pImmutableSamplers != nullptr, hash);
+    }
+    for (VkDescriptorBindingFlags const flags : bindingFlags)
+    {
+        hash = hashValue(flags, hash);
+    }
+
+    std::lock_guard<std::mutex> const lock{m_setLayoutMutex};
+    m_setLayoutHashes[layout] = hash;
+}
+
+auto ShaderCache::shaderObjectKey(VkShaderCreateInfoEXT const& createInfo)
+    -> std::optional<uint64_t>
+{
+    uint64_t hash{FNV_OFFSET_BASIS};
+
+    hash = hashValue(createInfo.flags, hash);
+    hash = hashValue(createInfo.stage, hash);
+    hash = hashValue(createInfo.nextStage, hash);
+    hash = hashValue(createInfo.codeType, hash);
+    hash = hashBytes(
+        std::span<uint8_t const>{
+            static_cast<uint8_t const*>(createInfo.pCode), createInfo.codeSize
+        },
+        hash
+    );
+    hash = hashBytes(
+        std::span<uint8_t const>{
+            reinterpret_cast<uint8_t const*>(createInfo.pName),
+            std::strlen(createInfo.pName)
+        },
+        hash
+    );
+    hash = hashValue(createInfo.setLayoutCount, hash);
+    {
+        std::lock_guard<std::mutex> const lock{m_setLayoutMutex};
+        for (VkDescriptorSetLayout const layout :
+             std::span<VkDescriptorSetLayout const>{
+                 createInfo.pSetLayouts, createInfo.setLayoutCount
+             })
+        {
+            auto const layoutHash{m_setLayoutHashes.find(layout)};
+            if (layoutHash == m_setLayoutHashes.end())
+            {
+                return std::nullopt;
+            }
+            hash = hashValue(layoutHash->second, hash);
+        }
+    }
+
+    hash = hashValue(createInfo.pushConstantRangeCount, hash);
+
+    std::span<VkPushConstantRange const> const pushConstantRanges{
+        createInfo.pPushConstantRanges, createInfo.pushConstantRangeCount
+    };
+    for (VkPushConstantRange const& range : pushConstantRanges)
+    {
+        hash = hashValue(range, hash);
+    }
+
+    if (VkSpecializationInfo const* const specialization{
+            createInfo.pSpecializationInfo
+        };
+        specialization != nullptr)
+    {
+        for (VkSpecializationMapEntry const& entry :
+             std::span<VkSpecializationMapEntry const>{
+                 specialization->pMapEntries, specialization->mapEntryCount
+             })
+        {
+            hash = hashValue(entry, hash);
+        }
+        hash = hashBytes(
+            std::span<uint8_t const>{
+                static_cast<uint8_t const*>(specialization->pData),
+                specialization->dataSize
+            },
+            hash
+        );
+    }
+
+    return hash;
+}
+
+auto ShaderCache::loadShaderBinary(uint64_t const key) const
+    -> std::optional<std::vector<uint8_t>>
+{
+    return readCacheFile(
+        cachePath(fmt::format("shaders/{:016x}.bin", key)),
+        CacheHeader{
+            .magic = SHADER_OBJECT_CACHE_MAGIC,
+            .version = CACHE_VERSION,
+            .uuid = toUUID(m_shaderObjectProperties.shaderBinaryUUID),
+            .uuidVersion = m_shaderObjectProperties.shaderBinaryVersion,
+            .driverVersion = m_deviceProperties.driverVersion,
+        }
+    );
+}
+
+void ShaderCache::storeShaderBinary(
+    uint64_t const key, std::span<uint8_t const> const binary
+) const
+{
+    writeCacheFile(
+        cachePath(fmt::format("shaders/{:016x}.bin", key)),
+        CacheHeader{
+            .magic = SHADER_OBJECT_CACHE_MAGIC,
+            .version = CACHE_VERSION,
+            .uuid = toUUID(m_shaderObjectProperties.shaderBinaryUUID),
+            .uuidVersion = m_shaderObjectProperties.shaderBinaryVersion,
+            .driverVersion = m_deviceProperties.driverVersion,
+        },
+        binary
+    );
+}
+
+void ShaderCache::recordPipeline(bool const hit)
+{
+    (hit ? m_pipelineHits : m_pipelineMisses)++;
+}
+
+void ShaderCache::recordShaderObject(bool const hit)
+{
+    (hit ? m_shaderObjectHits : m_shaderObjectMisses)++;
+}
+
+void ShaderCache::recordShaderObjectRejection() { m_shaderObjectRejections++; }
+
+auto ShaderCache::statistics() const -> Statistics
+{
+    return Statistics{
+        .pipelineHits = m_pipelineHits.load(),
+        .pipelineMisses = m_pipelineMisses.load(),
+        .shaderObjectHits = m_shaderObjectHits.load(),
+        .shaderObjectMisses = m_shaderObjectMisses.load(),
+        .shaderObjectRejections = m_shaderObjectRejections.load(),
+    };
+}
+
+void ShaderCache::logStatistics() const
+{
+    Statistics const stats{statistics()};
+    Log(fmt::format(
+        "Shader cache: pipelines {} hit / {} missed, shader objects {} hit / "
+        "{} missed / {} rejected by the driver.",
+        stats.pipelineHits,
+        stats.pipelineMisses,
+        stats.shaderObjectHits,
+        stats.shaderObjectMisses,
+        stats.shaderObjectRejections
+    ));
+}
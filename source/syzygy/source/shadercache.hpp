@@ -0,0 +1,103 @@
+#pragma once
+
+#include "enginetypes.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Persists compiled shaders between launches, so that a warm start skips
+// driver compilation. Pipelines go through a VkPipelineCache that is saved to
+// disk, and shader objects are saved as the driver's binaries. Both are keyed
+// by the device and driver that produced them, and anything that fails
+// validation is ignored and rebuilt from SPIR-V.
+//
+// There is at most one loaded cache. Shader compilation works the same, just
+// without caching, when none is loaded. Safe to use from any thread.
+class ShaderCache
+{
+public:
+    struct Statistics
+    {
+        size_t pipelineHits{0};
+        size_t pipelineMisses{0};
+
+        size_t shaderObjectHits{0};
+        size_t shaderObjectMisses{0};
+
+        // Binaries that were found on disk but refused by the driver.
+        size_t shaderObjectRejections{0};
+    };
+
+    // Reads the caches for the device from disk. The device must outlive the
+    // cache, which is destroyed with cleanup.
+    static void init(VkPhysicalDevice physicalDevice, VkDevice device);
+
+    // Null when no cache is loaded.
+    static ShaderCache* getLoadedShaderCache()
+    {
+        return m_loadedShaderCache.get();
+    }
+
+    // Writes the pipeline cache to disk and destroys the loaded cache.
+    static void cleanup();
+
+    ShaderCache(ShaderCache const& other) = delete;
+    ShaderCache& operator=(ShaderCache const& other) = delete;
+
+    ~ShaderCache();
+
+    // Records what a descriptor set layout was built from, since its handle
+    // differs between launches. Works without a loaded cache, so layouts can
+    // be built before it.
+    static void registerSetLayout(
+        VkDescriptorSetLayout layout,
+        VkDescriptorSetLayoutCreateInfo const& createInfo,
+        std::span<VkDescriptorBindingFlags const> bindingFlags
+    );
+
+    // Identifies a shader object by everything its binary depends on,
+    // including its set layouts and push constant ranges. Empty if any set
+    // layout was not registered, in which case the shader is not cached.
+    static std::optional<uint64_t>
+    shaderObjectKey(VkShaderCreateInfoEXT const& createInfo);
+
+    VkPipelineCache pipelineCache() const { return m_pipelineCache; }
+
+    // Reads a binary previously stored for this device and driver.
+    std::optional<std::vector<uint8_t>> loadShaderBinary(uint64_t key) const;
+
+    void storeShaderBinary(uint64_t key, std::span<uint8_t const> binary) const;
+
+    void recordPipeline(bool hit);
+    void recordShaderObject(bool hit);
+    void recordShaderObjectRejection();
+
+    Statistics statistics() const;
+
+    void logStatistics() const;
+
+private:
+    ShaderCache() = default;
+
+    inline static std::unique_ptr<ShaderCache> m_loadedShaderCache{nullptr};
+
+    inline static std::mutex m_setLayoutMutex{};
+    inline static std::unordered_map<VkDescriptorSetLayout, uint64_t>
+        m_setLayoutHashes{};
+
+    VkDevice m_device{VK_NULL_HANDLE};
+    VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};
+
+    VkPhysicalDeviceProperties m_deviceProperties{};
+    VkPhysicalDeviceShaderObjectPropertiesEXT m_shaderObjectProperties{};
+
+    std::atomic<size_t> m_pipelineHits{0};
+    std::atomic<size_t> m_pipelineMisses{0};
+    std::atomic<size_t> m_shaderObjectHits{0};
+    std::atomic<size_t> m_shaderObjectMisses{0};
+    std::atomic<size_t> m_shaderObjectRejections{0};
+};
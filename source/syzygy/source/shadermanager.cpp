@@ -0,0 +1,111 @@
+#include "shadermanager.hpp"
+
+#include "assets.hpp"
+#include "cpuprofiler.hpp"
+#include "helpers.hpp"
+
+#include <future>
+#include <map>
+#include <mutex>
+
+namespace
+{
+using LoadedShader = ShaderManager::LoadedShader;
+using ShaderFuture = std::shared_future<std::shared_ptr<LoadedShader const>>;
+
+struct PreloadedShaders
+{
+    std::mutex mutex{};
+    std::map<std::string, ShaderFuture> shaders{};
+};
+
+auto preloadedShaders() -> PreloadedShaders&
+{
+    static PreloadedShaders shaders{};
+    return shaders;
+}
+
+auto loadShader(std::string const& path) -> std::shared_ptr<LoadedShader const>
+{
+    VKR_PROFILE_FUNCTION();
+
+    AssetLoadingResult fileLoadingResult{loadBuildOutputFile(path)};
+
+    if (AssetLoadingError const* const error{
+            std::get_if<AssetLoadingError>(&fileLoadingResult)
+        };
+        error != nullptr)
+    {
+        Error(fmt::format("Failed to load asset for shader: {}", error->message)
+        );
+        return nullptr;
+    }
+
+    AssetFile& file{std::get<AssetFile>(fileLoadingResult)};
+
+    auto shader{std::make_shared<LoadedShader>()};
+    shader->reflectionData = vkutil::generateReflectionData(file.fileBytes);
+    shader->name = std::move(file.fileName);
+    shader->spirv = std::move(file.fileBytes);
+
+    return shader;
+}
+} // namespace
+
+void ShaderManager::preload(std::span<std::string const> const paths)
+{
+    // Loaded lazily otherwise, which would race between the workers
+    DebugUtils::getLoadedDebugUtils();
+
+    PreloadedShaders& preloaded{preloadedShaders()};
+    std::lock_guard const lock{preloaded.mutex};
+
+    for (std::string const& path : paths)
+    {
+        if (preloaded.shaders.contains(path))
+        {
+            continue;
+        }
+
+        preloaded.shaders.emplace(
+            path, std::async(std::launch::async, loadShader, path).share()
+        );
+    }
+}
+
+auto ShaderManager::get(std::string const& path)
+    -> std::shared_ptr<LoadedShader const>
+{
+    ShaderFuture future{};
+    {
+        PreloadedShaders& preloaded{preloadedShaders()};
+        std::lock_guard const lock{preloaded.mutex};
+
+        auto const iterator{preloaded.shaders.find(path)};
+        if (iterator != preloaded.shaders.end())
+        {
+            future = iterator->second;
+        }
+    }
+
+    if (future.valid())
+    {
+        return future.get();
+    }
+
+    return loadShader(path);
+}
+
+void ShaderManager::clear()
+{
+    std::map<std::string, ShaderFuture> shaders{};
+    {
+        PreloadedShaders& preloaded{preloadedShaders()};
+        std::lock_guard const lock{preloaded.mutex};
+        shaders.swap(preloaded.shaders);
+    }
+
+    // Any loads still running are waited on as the futures are destroyed,
+    // outside of the lock.
+    shaders.clear();
+}
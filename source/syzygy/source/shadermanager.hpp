@@ -0,0 +1,39 @@
+#pragma once
+
+#include "shaders.hpp"
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Reads and reflects SPIR-V on worker threads ahead of the pipelines that
+// need it, so that startup waits on the slowest shader rather than on every
+// shader in turn. The shader loading functions in vkutil go through here, and
+// load on the calling thread anything that was not preloaded.
+//
+// Safe to use from any thread.
+class ShaderManager
+{
+public:
+    struct LoadedShader
+    {
+        std::string name{};
+        std::vector<uint8_t> spirv{};
+        ShaderReflectionData reflectionData{};
+    };
+
+    ShaderManager() = delete;
+
+    // Starts loading each shader on its own worker thread. Paths are relative
+    // to the build tree's root, where shaders are compiled to, as with
+    // loadBuildOutputFile.
+    static void preload(std::span<std::string const> paths);
+
+    // Waits on a preloaded shader, or loads it now if it was not preloaded.
+    // Null if the file could not be read.
+    static std::shared_ptr<LoadedShader const> get(std::string const& path);
+
+    // Drops every preloaded shader, once the pipelines that use them exist.
+    static void clear();
+};
@@ -0,0 +1,134 @@
+#include "shaderpermutations.hpp"
+
+#include <algorithm>
+
+auto SpecializationConstants::set(
+    uint32_t const constantID, uint32_t const value
+) -> SpecializationConstants&
+{
+    auto const position{
+        std::lower_bound(m_constantIDs.begin(), m_constantIDs.end(), constantID)
+    };
+    auto const index{std::distance(m_constantIDs.begin(), position)};
+
+    if (position != m_constantIDs.end() && *position == constantID)
+    {
+        m_values[index] = value;
+        return *this;
+    }
+
+    m_constantIDs.insert(position, constantID);
+    m_values.insert(m_values.begin() + index, value);
+    return *this;
+}
+
+auto SpecializationConstants::info() const -> VkSpecializationInfo
+{
+    m_entries.clear();
+    for (size_t index{0}; index < m_constantIDs.size(); index++)
+    {
+        m_entries.push_back(VkSpecializationMapEntry{
+            .constantID = m_constantIDs[index],
+            .offset = static_cast<uint32_t>(index * sizeof(uint32_t)),
+            .size = sizeof(uint32_t),
+        });
+    }
+
+    return VkSpecializationInfo{
+        .mapEntryCount = static_cast<uint32_t>(m_entries.size()),
+        .pMapEntries = m_entries.data(),
+        .dataSize = m_values.size() * sizeof(uint32_t),
+        .pData = m_values.data(),
+    };
+}
+
+ShaderObjectPermutations::ShaderObjectPermutations(
+    VkDevice const device,
+    ShaderObjectReflected generic,
+    PipelineCompiler& compiler,
+    vkutil::ShaderObjectLoadInfo const& loadInfo
+)
+    : m_device(device)
+    , m_generic(std::move(generic))
+    , m_compiler(&compiler)
+    , m_path(loadInfo.path)
+    , m_stage(loadInfo.stage)
+    , m_nextStage(loadInfo.nextStage)
+    , m_layouts(loadInfo.layouts.begin(), loadInfo.layouts.end())
+    , m_rangeOverride(loadInfo.rangeOverride)
+{
+}
+
+auto ShaderObjectPermutations::select(SpecializationConstants const& constants
+) -> ShaderObjectReflected const&
+{
+    auto iterator{m_variants.find(constants)};
+    if (iterator == m_variants.end())
+    {
+        CompileHandle<ShaderObjectReflected> handle{
+            m_compiler->submit<ShaderObjectReflected>(
+                [device = m_device,
+                 constants,
+                 path = m_path,
+                 stage = m_stage,
+                 nextStage = m_nextStage,
+                 layouts = m_layouts,
+                 rangeOverride = m_rangeOverride]()
+                {
+                    std::array<vkutil::ShaderObjectLoadInfo, 1> const
+                        loadInfos{vkutil::ShaderObjectLoadInfo{
+                            .path = path,
+                            .stage = stage,
+                            .nextStage = nextStage,
+                            .layouts = layouts,
+                            .rangeOverride = rangeOverride,
+                            .specializationInfo = constants.info(),
+                        }};
+                    return vkutil::loadShaderObjects(device, loadInfos)[0];
+                }
+            )
+        };
+        iterator = m_variants.emplace(constants, std::move(handle)).first;
+    }
+
+    if (iterator->second.ready())
+    {
+        return iterator->second.get();
+    }
+    return m_generic;
+}
+
+auto ShaderObjectPermutations::status(SpecializationConstants const& constants
+) const -> CompileStatus
+{
+    auto const iterator{m_variants.find(constants)};
+    if (iterator == m_variants.end())
+    {
+        return CompileStatus::FAILED;
+    }
+    return iterator->second.status();
+}
+
+auto ShaderObjectPermutations::readyCount() const -> size_t
+{
+    return std::count_if(
+        m_variants.begin(),
+        m_variants.end(),
+        [](auto const& variant) { return variant.second.ready(); }
+    );
+}
+
+void ShaderObjectPermutations::cleanup(VkDevice const device)
+{
+    for (auto& [constants, handle] : m_variants)
+    {
+        if (handle.ready())
+        {
+            ShaderObjectReflected shader{handle.get()};
+            shader.cleanup(device);
+        }
+    }
+    m_variants.clear();
+
+    m_generic.cleanup(device);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "enginetypes.hpp"
+#include "pipelinecompiler.hpp"
+#include "shaders.hpp"
+
+#include <map>
+#include <tuple>
+
+// A set of 32-bit specialization constants, which also identifies a variant.
+class SpecializationConstants
+{
+public:
+    SpecializationConstants& set(uint32_t constantID, uint32_t value);
+    SpecializationConstants& setBool(uint32_t constantID, bool value)
+    {
+        return set(constantID, value ? VK_TRUE : VK_FALSE);
+    }
+
+    // Points into this object, so it must outlive the returned info.
+    VkSpecializationInfo info() const;
+
+    // Orders variants by their constants, so they can key a map.
+    bool operator<(SpecializationConstants const& other) const
+    {
+        return std::tie(m_constantIDs, m_values)
+             < std::tie(other.m_constantIDs, other.m_values);
+    }
+
+private:
+    // Kept sorted by ID, so equal sets compare equal
+    std::vector<uint32_t> m_constantIDs{};
+    std::vector<uint32_t> m_values{};
+
+    std::vector<VkSpecializationMapEntry> mutable m_entries{};
+};
+
+// A shader object compiled once for each set of specialization constants it
+// is used with. The generic variant, compiled with the shader's defaults, is
+// available from the start. Other variants compile in the background, and the
+// generic variant stands in until they are ready.
+class ShaderObjectPermutations
+{
+public:
+    ShaderObjectPermutations(
+        VkDevice device,
+        ShaderObjectReflected generic,
+        PipelineCompiler& compiler,
+        vkutil::ShaderObjectLoadInfo const& loadInfo
+    );
+
+    ShaderObjectPermutations(ShaderObjectPermutations const& other) = delete;
+    ShaderObjectPermutations& operator=(ShaderObjectPermutations const& other
+    ) = delete;
+
+    // The variant for the constants if it is compiled, otherwise queues it
+    // and returns the generic variant.
+    ShaderObjectReflected const& select(SpecializationConstants const& constants
+    );
+
+    // The status of the variant, which is failed if it was never selected.
+    CompileStatus status(SpecializationConstants const& constants) const;
+
+    ShaderObjectReflected const& generic() const { return m_generic; }
+
+    size_t readyCount() const;
+    size_t variantCount() const { return m_variants.size(); }
+
+    // The compiler must be cleaned up first, so no variant is in flight.
+    void cleanup(VkDevice device);
+
+private:
+    VkDevice m_device{VK_NULL_HANDLE};
+    ShaderObjectReflected m_generic;
+    PipelineCompiler* m_compiler{nullptr};
+
+    // Copied out of the load info, so jobs do not reference the caller's
+    std::string m_path{};
+    VkShaderStageFlagBits m_stage{};
+    VkShaderStageFlags m_nextStage{0};
+    std::vector<VkDescriptorSetLayout> m_layouts{};
+    std::optional<VkPushConstantRange> m_rangeOverride{};
+
+    std::map<SpecializationConstants, CompileHandle<ShaderObjectReflected>>
+        m_variants{};
+};
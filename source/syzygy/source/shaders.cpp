@@ -2,6 +2,8 @@
 
 #include "assets.hpp"
 #include "helpers.hpp"
+#include "shadercache.hpp"
+#include "shadermanager.hpp"
 #include <spirv_reflect.h>
 
 auto vkutil::generateReflectionData(
@@ -523,15 +525,112 @@ auto vkutil::compileShaderObject(
         .pSpecializationInfo = &specializationInfo,
     };
 
-    VkShaderEXT shaderObject{VK_NULL_HANDLE};
-    VkResult const result{
-        vkCreateShadersEXT(device, 1, &createInfo, nullptr, &shaderObject)
-    };
+    std::array<VkShaderCreateInfoEXT, 1> const createInfos{createInfo};
+    return compileShaderObjects(device, createInfos)[0];
+}
 
-    return ShaderResult<VkShaderEXT>{
-        .shader = shaderObject,
-        .result = result,
+auto vkutil::compileShaderObjects(
+    VkDevice const device,
+    std::span<VkShaderCreateInfoEXT const> const createInfos
+) -> std::vector<vkutil::ShaderResult<VkShaderEXT>>
+{
+    ShaderCache* const cache{ShaderCache::getLoadedShaderCache()};
+
+    std::vector<std::optional<uint64_t>> cacheKeys(createInfos.size());
+    std::vector<std::optional<std::vector<uint8_t>>> binaries(
+        createInfos.size()
+    );
+    std::vector<VkShaderCreateInfoEXT> batch{
+        createInfos.begin(), createInfos.end()
     };
+    if (cache != nullptr)
+    {
+        for (size_t index{0}; index < batch.size(); index++)
+        {
+            cacheKeys[index] = ShaderCache::shaderObjectKey(createInfos[index]);
+            if (!cacheKeys[index].has_value())
+            {
+                continue;
+            }
+            binaries[index] = cache->loadShaderBinary(cacheKeys[index].value());
+            if (binaries[index].has_value())
+            {
+                batch[index].codeType = VK_SHADER_CODE_TYPE_BINARY_EXT;
+                batch[index].codeSize = binaries[index]->size();
+                batch[index].pCode = binaries[index]->data();
+            }
+        }
+    }
+
+    std::vector<VkShaderEXT> shaderObjects(batch.size(), VK_NULL_HANDLE);
+    vkCreateShadersEXT(
+        device,
+        static_cast<uint32_t>(batch.size()),
+        batch.data(),
+        nullptr,
+        shaderObjects.data()
+    );
+
+    auto const storeBinary{[&](size_t const index)
+    {
+        size_t binarySize{0};
+        if (vkGetShaderBinaryDataEXT(
+                device, shaderObjects[index], &binarySize, nullptr
+            )
+            != VK_SUCCESS)
+        {
+            return;
+        }
+        std::vector<uint8_t> binary(binarySize);
+        if (vkGetShaderBinaryDataEXT(
+                device, shaderObjects[index], &binarySize, binary.data()
+            )
+            != VK_SUCCESS)
+        {
+            return;
+        }
+        binary.resize(binarySize);
+        cache->storeShaderBinary(cacheKeys[index].value(), binary);
+    }};
+
+    std::vector<ShaderResult<VkShaderEXT>> results{};
+    results.reserve(batch.size());
+    for (size_t index{0}; index < batch.size(); index++)
+    {
+        bool hit{binaries[index].has_value()};
+
+        VkResult result{VK_SUCCESS};
+        if (shaderObjects[index] == VK_NULL_HANDLE)
+        {
+            // Refused binaries, and shaders caught up in another's failure,
+            // are retried alone from SPIR-V.
+            if (hit)
+            {
+                cache->recordShaderObjectRejection();
+                hit = false;
+            }
+            result = vkCreateShadersEXT(
+                device, 1, &createInfos[index], nullptr, &shaderObjects[index]
+            );
+        }
+
+        if (cache != nullptr && result == VK_SUCCESS)
+        {
+            cache->recordShaderObject(hit);
+            if (!hit && cacheKeys[index].has_value())
+            {
+                // Also replaces any binary that the driver refused
+                storeBinary(index);
+            }
+        }
+
+        results.push_back(ShaderResult<VkShaderEXT>{
+            .shader = shaderObjects[index],
+            .result = result,
+        });
+    }
+
+    return results;
 }
 
 auto vkutil::loadShaderObject(
@@ -543,34 +642,15 @@ auto vkutil::loadShaderObject(
     VkSpecializationInfo const specializationInfo
 ) -> std::optional<ShaderObjectReflected>
 {
-    AssetLoadingResult const fileLoadingResult{loadAssetFile(path)};
-
-    return std::visit(
-        overloaded{
-            [&](AssetFile const& file)
-            {
-                return std::optional<ShaderObjectReflected>{
-                    ShaderObjectReflected::fromBytecodeReflected(
-                        device,
-                        file.fileName,
-                        file.fileBytes,
-                        stage,
-                        nextStage,
-                        layouts,
-                        specializationInfo
-                    )
-                };
-            },
-            [&](AssetLoadingError const& error)
-            {
-                Error(fmt::format(
-                    "Failed to load asset for shader: {}", error.message
-                ));
-                return std::optional<ShaderObjectReflected>{};
-            }
-        },
-        fileLoadingResult
-    );
+    std::array<ShaderObjectLoadInfo, 1> const loadInfos{ShaderObjectLoadInfo{
+        .path = path,
+        .stage = stage,
+        .nextStage = nextStage,
+        .layouts = layouts,
+        .rangeOverride = std::nullopt,
+        .specializationInfo = specializationInfo,
+    }};
+    return loadShaderObjects(device, loadInfos)[0];
 }
 
 auto vkutil::loadShaderObject(
@@ -583,36 +663,116 @@ auto vkutil::loadShaderObject(
     VkSpecializationInfo const specializationInfo
 ) -> std::optional<ShaderObjectReflected>
 {
-    AssetLoadingResult const fileLoadingResult{loadAssetFile(path)};
+    std::array<ShaderObjectLoadInfo, 1> const loadInfos{ShaderObjectLoadInfo{
+        .path = path,
+        .stage = stage,
+        .nextStage = nextStage,
+        .layouts = layouts,
+        .rangeOverride = rangeOverride,
+        .specializationInfo = specializationInfo,
+    }};
+    return loadShaderObjects(device, loadInfos)[0];
+}
 
-    std::array<VkPushConstantRange, 1> rangeOverrides{rangeOverride};
-    return std::visit(
-        overloaded{
-            [&](AssetFile const& file)
-            {
-                return std::optional<ShaderObjectReflected>{
-                    ShaderObjectReflected::fromBytecode(
-                        device,
-                        file.fileName,
-                        file.fileBytes,
-                        stage,
-                        nextStage,
-                        layouts,
-                        rangeOverrides,
-                        specializationInfo
-                    )
-                };
-            },
-            [&](AssetLoadingError const& error)
-            {
-                Error(fmt::format(
-                    "Failed to load asset for shader: {}", error.message
-                ));
-                return std::optional<ShaderObjectReflected>{};
-            }
-        },
-        fileLoadingResult
+auto vkutil::loadShaderObjects(
+    VkDevice const device, std::span<ShaderObjectLoadInfo const> const loadInfos
+) -> std::vector<std::optional<ShaderObjectReflected>>
+{
+    std::vector<std::shared_ptr<ShaderManager::LoadedShader const>> shaders{};
+    std::vector<std::vector<VkPushConstantRange>> pushConstantRanges(
+        loadInfos.size()
     );
+
+    // Shaders whose files could not be read are left out of the batch
+    std::vector<VkShaderCreateInfoEXT> createInfos{};
+    std::vector<size_t> loadInfoIndices{};
+
+    for (size_t index{0}; index < loadInfos.size(); index++)
+    {
+        ShaderObjectLoadInfo const& loadInfo{loadInfos[index]};
+
+        shaders.push_back(ShaderManager::get(loadInfo.path));
+        if (shaders.back() == nullptr)
+        {
+            continue;
+        }
+
+        ShaderManager::LoadedShader const& shader{*shaders.back()};
+
+        std::vector<VkPushConstantRange>& ranges{pushConstantRanges[index]};
+        if (loadInfo.rangeOverride.has_value())
+        {
+            ranges.push_back(loadInfo.rangeOverride.value());
+        }
+        else if (shader.reflectionData.defaultEntryPointHasPushConstant())
+        {
+            ranges.push_back(
+                shader.reflectionData.defaultPushConstant().totalRange(
+                    loadInfo.stage
+                )
+            );
+        }
+
+        createInfos.push_back(VkShaderCreateInfoEXT{
+            .sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT,
+            .pNext = nullptr,
+
+            .flags = 0,
+
+            .stage = loadInfo.stage,
+            .nextStage = loadInfo.nextStage,
+
+            .codeType = VkShaderCodeTypeEXT::VK_SHADER_CODE_TYPE_SPIRV_EXT,
+            .codeSize = shader.spirv.size(),
+            .pCode = shader.spirv.data(),
+
+            .pName = "main",
+
+            .setLayoutCount = static_cast<uint32_t>(loadInfo.layouts.size()),
+            .pSetLayouts = loadInfo.layouts.data(),
+
+            .pushConstantRangeCount = static_cast<uint32_t>(ranges.size()),
+            .pPushConstantRanges = ranges.data(),
+
+            .pSpecializationInfo = &loadInfo.specializationInfo,
+        });
+        loadInfoIndices.push_back(index);
+    }
+
+    std::vector<ShaderResult<VkShaderEXT>> const compilationResults{
+        compileShaderObjects(device, createInfos)
+    };
+
+    std::vector<std::optional<ShaderObjectReflected>> results(
+        loadInfos.size()
+    );
+    for (size_t batchIndex{0}; batchIndex < compilationResults.size();
+         batchIndex++)
+    {
+        size_t const index{loadInfoIndices[batchIndex]};
+        ShaderManager::LoadedShader const& shader{*shaders[index]};
+        ShaderResult<VkShaderEXT> const& compilationResult{
+            compilationResults[batchIndex]
+        };
+
+        LogVkResult(
+            compilationResult.result,
+            fmt::format("Created Shader Object {}", shader.name)
+        );
+        if (compilationResult.result != VK_SUCCESS)
+        {
+            continue;
+        }
+
+        Log(fmt::format(
+            "Successfully compiled ShaderObjectReflected: {}", shader.name
+        ));
+        results[index] = ShaderObjectReflected::fromCompiled(
+            shader.name, shader.reflectionData, compilationResult.shader
+        );
+    }
+
+    return results;
 }
 
 auto vkutil::compileShaderModule(
@@ -643,26 +803,30 @@ auto vkutil::compileShaderModule(
 auto vkutil::loadShaderModule(VkDevice const device, std::string const& path)
     -> std::optional<ShaderModuleReflected>
 {
-    AssetLoadingResult const fileLoadingResult{loadAssetFile(path)};
+    std::shared_ptr<ShaderManager::LoadedShader const> const shader{
+        ShaderManager::get(path)
+    };
+    if (shader == nullptr)
+    {
+        return std::nullopt;
+    }
 
-    return std::visit(
-        overloaded{
-            [&](AssetFile const& file)
-            {
-                return std::optional<ShaderModuleReflected>{
-                    ShaderModuleReflected::FromBytecode(
-                        device, file.fileName, file.fileBytes
-                    )
-                };
-            },
-            [&](AssetLoadingError const& error)
-            {
-                Error(fmt::format(
-                    "Failed to load asset for shader: {}", error.message
-                ));
-                return std::optional<ShaderModuleReflected>{};
-            }
-        },
-        fileLoadingResult
+    vkutil::ShaderResult<VkShaderModule> const compilationResult{
+        vkutil::compileShaderModule(device, shader->spirv)
+    };
+    if (compilationResult.result != VK_SUCCESS)
+    {
+        LogVkResult(
+            compilationResult.result,
+            fmt::format("Failed to create shader module {}", shader->name)
+        );
+        return std::nullopt;
+    }
+
+    Log(fmt::format(
+        "Successfully compiled ShaderModuleReflected: {}", shader->name
+    ));
+    return ShaderModuleReflected::fromCompiled(
+        shader->name, shader->reflectionData, compilationResult.shader
     );
 }
@@ -197,6 +197,15 @@ public:
         std::string const& name,
         std::span<uint8_t const> spirvBytecode
     );
+    // Wraps a module that was compiled from already reflected bytecode.
+    static ShaderModuleReflected fromCompiled(
+        std::string const& name,
+        ShaderReflectionData const& reflectionData,
+        VkShaderModule shaderModule
+    )
+    {
+        return ShaderModuleReflected(name, reflectionData, shaderModule);
+    }
     static ShaderModuleReflected MakeInvalid()
     {
         return ShaderModuleReflected(
@@ -246,6 +255,17 @@ public:
         VkSpecializationInfo specializationInfo
     );
 
+    // Wraps a shader object that was compiled from already reflected
+    // bytecode, such as one of a batch.
+    static ShaderObjectReflected fromCompiled(
+        std::string const& name,
+        ShaderReflectionData const& reflectionData,
+        VkShaderEXT shaderObject
+    )
+    {
+        return ShaderObjectReflected(name, reflectionData, shaderObject);
+    }
+
     static ShaderObjectReflected makeInvalid()
     {
         return ShaderObjectReflected(
@@ -277,9 +297,34 @@ ShaderResult<VkShaderEXT> compileShaderObject(
     VkSpecializationInfo specializationInfo
 );
 
+// Creates every shader object in one driver call, so the driver is free to
+// compile them together. Results are in the same order as the create infos.
+std::vector<ShaderResult<VkShaderEXT>> compileShaderObjects(
+    VkDevice device, std::span<VkShaderCreateInfoEXT const> createInfos
+);
+
 ShaderResult<VkShaderModule>
 compileShaderModule(VkDevice device, std::span<uint8_t const> spirvBytecode);
 
+struct ShaderObjectLoadInfo
+{
+    std::string path{};
+    VkShaderStageFlagBits stage{};
+    VkShaderStageFlags nextStage{0};
+    std::span<VkDescriptorSetLayout const> layouts{};
+
+    // Replaces the push constant range derived from reflection.
+    std::optional<VkPushConstantRange> rangeOverride{};
+
+    VkSpecializationInfo specializationInfo{};
+};
+
+// Loads and compiles shader objects as one batch. Results are in the same
+// order as the load infos, and are empty for any shader that failed.
+std::vector<std::optional<ShaderObjectReflected>> loadShaderObjects(
+    VkDevice device, std::span<ShaderObjectLoadInfo const> loadInfos
+);
+
 std::optional<ShaderObjectReflected> loadShaderObject(
     VkDevice device,
     std::string const& path,
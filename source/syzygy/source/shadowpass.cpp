@@ -2,6 +2,7 @@
 #include "helpers.hpp"
 #include "images.hpp"
 #include "initializers.hpp"
+#include "meshletcull.hpp"
 
 auto ShadowPassArray::create(
     VkDevice const device,
@@ -244,11 +245,21 @@ void ShadowPassArray::recordInitialize(
 void ShadowPassArray::recordDrawCommands(
     VkCommandBuffer const cmd,
     MeshAsset const& mesh,
-    TStagedBuffer<glm::mat4x4> const& models
+    MeshInstances const& instances,
+    MeshletCullPass* const meshletCullPass
 )
 {
     for (size_t i{0}; i < m_projViewMatrices->deviceSize(); i++)
     {
+        // Shadow maps cull front faces instead of back faces, so only the
+        // frustum can be used to cull meshlets.
+        bool const culled{
+            meshletCullPass != nullptr
+            && meshletCullPass->recordCull(
+                cmd, static_cast<uint32_t>(i + 1), false, mesh, instances
+            )
+        };
+
         AllocatedImage const& texture{m_textures[i]};
         m_pipeline->recordDrawCommands(
             cmd,
@@ -259,7 +270,8 @@ void ShadowPassArray::recordDrawCommands(
             i,
             *m_projViewMatrices,
             mesh,
-            models
+            instances,
+            culled ? meshletCullPass : nullptr
         );
     }
 }
@@ -9,6 +9,8 @@ struct ShadowPassParameters
 {
     float depthBiasConstant{2.00f};
     float depthBiasSlope{-1.75f};
+
+    bool operator==(ShadowPassParameters const& other) const = default;
 };
 
 // Handles the resources for an array of depth maps,
@@ -35,12 +37,20 @@ public:
         std::span<gputypes::LightSpot const> spotLights
     );
 
+    // If meshletCullPass is not null, each shadow map's full detail instances
+    // are culled against the view at the shadow map's index plus one.
     void recordDrawCommands(
         VkCommandBuffer cmd,
         MeshAsset const& mesh,
-        TStagedBuffer<glm::mat4x4> const& models
+        MeshInstances const& instances,
+        MeshletCullPass* meshletCullPass
     );
 
+    std::span<glm::mat4x4 const> projViewMatrices() const
+    {
+        return m_projViewMatrices->readValidStaged();
+    }
+
     // Transitions all the shadow map VkImages, with a total memory barrier.
     void recordTransitionActiveShadowMaps(
         VkCommandBuffer cmd, VkImageLayout dstLayout
@@ -1,9 +1,212 @@
 #include "syzygy.hpp"
 
 #include "editor/editor.hpp"
+#include "engine.hpp"
+#include "helpers.hpp"
+#include "inputrecording.hpp"
 
-auto Application::run() -> ApplicationResult
+#include <chrono>
+#include <thread>
+
+namespace
+{
+// Starts what the parameters ask for alongside any run of the engine.
+void startRecordingAndMetrics(
+    Engine& renderer, ApplicationParameters const& parameters
+)
+{
+    if (parameters.recordPath.has_value())
+    {
+        renderer.startInputRecording(parameters.recordPath.value());
+    }
+
+    if (parameters.metricsPort.has_value())
+    {
+        renderer.startMetricsServer(
+            parameters.metricsAddress, parameters.metricsPort.value()
+        );
+    }
+}
+
+auto runHeadless(ApplicationParameters const& parameters) -> ApplicationResult
 {
+    glm::u16vec2 const extent{
+        parameters.headlessWidth, parameters.headlessHeight
+    };
+    Engine* const renderer{Engine::loadHeadlessEngine(extent)};
+    if (renderer == nullptr)
+    {
+        Error("Failed to load headless renderer.");
+        return ApplicationResult::FAILURE;
+    }
+
+    startRecordingAndMetrics(*renderer, parameters);
+
+    // A fixed timestep, since frames are not paced by a display
+    double constexpr DELTA_TIME_SECONDS{1.0 / 60.0};
+    for (uint32_t frame{0}; frame < parameters.headlessFrames; frame++)
+    {
+        renderer->mainLoop(
+            static_cast<double>(frame) * DELTA_TIME_SECONDS,
+            DELTA_TIME_SECONDS,
+            true,
+            extent
+        );
+    }
+
+    Log(fmt::format("Rendered {} headless frames.", parameters.headlessFrames)
+    );
+
+    renderer->cleanup();
+
+    return ApplicationResult::SUCCESS;
+}
+
+auto runReplay(ApplicationParameters const& parameters) -> ApplicationResult
+{
+    std::optional<std::vector<FrameInputs>> const frames{
+        loadInputRecording(parameters.replayPath.value())
+    };
+    if (!frames.has_value() || frames.value().empty())
+    {
+        Error("No frames to replay.");
+        return ApplicationResult::FAILURE;
+    }
+
+    // The scene is drawn at the extent of the recorded viewport
+    glm::u16vec2 extent{frames.value().front().sceneExtent};
+    if (extent.x == 0 || extent.y == 0)
+    {
+        extent = glm::u16vec2{
+            parameters.headlessWidth, parameters.headlessHeight
+        };
+    }
+
+    Engine* const renderer{Engine::loadHeadlessEngine(extent)};
+    if (renderer == nullptr)
+    {
+        Error("Failed to load headless renderer.");
+        return ApplicationResult::FAILURE;
+    }
+
+    // Recording the replay allows checking that it matches the original
+    startRecordingAndMetrics(*renderer, parameters);
+
+    double const firstElapsedTimeSeconds{
+        frames.value().front().elapsedTimeSeconds
+    };
+    auto const replayBegin{std::chrono::steady_clock::now()};
+    for (FrameInputs const& inputs : frames.value())
+    {
+        if (parameters.replayPacing == ReplayPacing::RECORDED)
+        {
+            // Waits until the frame's recorded offset from the first frame
+            std::this_thread::sleep_until(
+                replayBegin
+                + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::duration<double>(
+                        inputs.elapsedTimeSeconds - firstElapsedTimeSeconds
+                    )
+                )
+            );
+        }
+
+        renderer->applyFrameInputs(inputs);
+        renderer->mainLoop(
+            inputs.elapsedTimeSeconds,
+            inputs.deltaTimeSeconds,
+            inputs.shouldRender,
+            extent
+        );
+    }
+
+    std::chrono::duration<double, std::milli> const replayMilliseconds{
+        std::chrono::steady_clock::now() - replayBegin
+    };
+    Log(fmt::format(
+        "Replayed {} frames in {:.1f} ms, {:.3f} ms per frame.",
+        frames.value().size(),
+        replayMilliseconds.count(),
+        replayMilliseconds.count() / static_cast<double>(frames.value().size())
+    ));
+
+    renderer->cleanup();
+
+    return ApplicationResult::SUCCESS;
+}
+
+auto runKernelBenchmark(ApplicationParameters const& parameters)
+    -> ApplicationResult
+{
+    Engine* const renderer{Engine::loadHeadlessEngine(
+        {parameters.headlessWidth, parameters.headlessHeight}
+    )};
+    if (renderer == nullptr)
+    {
+        Error("Failed to load headless renderer.");
+        return ApplicationResult::FAILURE;
+    }
+
+    std::vector<KernelBenchmarkResult> const results{
+        renderer->benchmarkComputeKernel(KernelBenchmarkParameters{
+            .shaderName = parameters.kernelBenchmarkShader.value(),
+            .dispatches = parameters.kernelBenchmarkDispatches,
+            .saveReference = parameters.kernelSaveReference,
+        })
+    };
+
+    renderer->cleanup();
+
+    bool mismatched{false};
+    for (KernelBenchmarkResult const& result : results)
+    {
+        std::string reference{"no reference"};
+        if (result.matchesReference.has_value())
+        {
+            reference = fmt::format(
+                "{} reference, max difference {:.2e}",
+                result.matchesReference.value() ? "matches" : "differs from",
+                result.maxDifference
+            );
+        }
+        Log(fmt::format(
+            "{}x{}: {:.4f} ms per dispatch, {:.1f} Mpixel/s, {}",
+            result.extent.width,
+            result.extent.height,
+            result.millisecondsPerDispatch,
+            result.megapixelsPerSecond,
+            reference
+        ));
+
+        mismatched |= !result.matchesReference.value_or(true);
+    }
+
+    if (results.empty() || mismatched)
+    {
+        return ApplicationResult::FAILURE;
+    }
+    return ApplicationResult::SUCCESS;
+}
+} // namespace
+
+auto Application::run(ApplicationParameters const& parameters)
+    -> ApplicationResult
+{
+    if (parameters.replayPath.has_value())
+    {
+        return runReplay(parameters);
+    }
+
+    if (parameters.kernelBenchmarkShader.has_value())
+    {
+        return runKernelBenchmark(parameters);
+    }
+
+    if (parameters.headless)
+    {
+        return runHeadless(parameters);
+    }
+
     std::optional<Editor> editor{Editor::create()};
 
     if (!editor.has_value())
@@ -11,6 +214,8 @@ auto Application::run() -> ApplicationResult
         return ApplicationResult::FAILURE;
     }
 
+    startRecordingAndMetrics(*editor.value().renderer(), parameters);
+
     EditorResult const runResult{editor.value().run()};
 
     if (runResult != EditorResult::SUCCESS)
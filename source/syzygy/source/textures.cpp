@@ -0,0 +1,459 @@
+#include "textures.hpp"
+
+#include "helpers.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+namespace
+{
+size_t constexpr BC1_BLOCK_BYTES{8};
+uint32_t constexpr BC1_BLOCK_DIMENSION{4};
+
+auto blockCount(uint32_t const texels) -> uint32_t
+{
+    return (texels + BC1_BLOCK_DIMENSION - 1) / BC1_BLOCK_DIMENSION;
+}
+
+auto toRGB565(std::array<int32_t, 3> const& color) -> uint16_t
+{
+    auto const r{static_cast<uint32_t>(color[0]) >> 3U};
+    auto const g{static_cast<uint32_t>(color[1]) >> 2U};
+    auto const b{static_cast<uint32_t>(color[2]) >> 3U};
+    return static_cast<uint16_t>((r << 11U) | (g << 5U) | b);
+}
+
+auto fromRGB565(uint16_t const packed) -> std::array<int32_t, 3>
+{
+    uint32_t const r{(packed >> 11U) & 0x1FU};
+    uint32_t const g{(packed >> 5U) & 0x3FU};
+    uint32_t const b{packed & 0x1FU};
+
+    // Replicate the high bits, so that the extremes map to 0 and 255
+    return {
+        static_cast<int32_t>((r << 3U) | (r >> 2U)),
+        static_cast<int32_t>((g << 2U) | (g >> 4U)),
+        static_cast<int32_t>((b << 3U) | (b >> 2U)),
+    };
+}
+
+// Fits endpoints to the bounding box of the block's colors, which is fast
+// and close enough to an exhaustive search for color textures.
+auto encodeBlock(std::array<std::array<int32_t, 3>, 16> const& texels)
+    -> std::array<uint8_t, BC1_BLOCK_BYTES>
+{
+    std::array<int32_t, 3> minColor{255, 255, 255};
+    std::array<int32_t, 3> maxColor{0, 0, 0};
+    for (std::array<int32_t, 3> const& texel : texels)
+    {
+        for (size_t channel{0}; channel < 3; channel++)
+        {
+            minColor[channel] = std::min(minColor[channel], texel[channel]);
+            maxColor[channel] = std::max(maxColor[channel], texel[channel]);
+        }
+    }
+
+    // Pulling the endpoints in reduces the error of the interpolated colors
+    for (size_t channel{0}; channel < 3; channel++)
+    {
+        int32_t const inset{(maxColor[channel] - minColor[channel]) >> 4};
+        minColor[channel] += inset;
+        maxColor[channel] -= inset;
+    }
+
+    uint16_t color0{toRGB565(maxColor)};
+    uint16_t color1{toRGB565(minColor)};
+
+    // The first endpoint being larger selects the opaque four color mode
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices{0};
+    if (color0 != color1)
+    {
+        std::array<int32_t, 3> const endpoint0{fromRGB565(color0)};
+        std::array<int32_t, 3> const endpoint1{fromRGB565(color1)};
+
+        std::array<std::array<int32_t, 3>, 4> palette{endpoint0, endpoint1};
+        for (size_t channel{0}; channel < 3; channel++)
+        {
+            palette[2][channel] =
+                (2 * endpoint0[channel] + endpoint1[channel]) / 3;
+            palette[3][channel] =
+                (endpoint0[channel] + 2 * endpoint1[channel]) / 3;
+        }
+
+        for (size_t texel{0}; texel < texels.size(); texel++)
+        {
+            uint32_t bestIndex{0};
+            int32_t bestDistance{std::numeric_limits<int32_t>::max()};
+            for (uint32_t index{0}; index < palette.size(); index++)
+            {
+                int32_t distance{0};
+                for (size_t channel{0}; channel < 3; channel++)
+                {
+                    int32_t const difference{
+                        texels[texel][channel] - palette[index][channel]
+                    };
+                    distance += difference * difference;
+                }
+
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = index;
+                }
+            }
+
+            indices |= bestIndex << (2U * texel);
+        }
+    }
+
+    return {
+        static_cast<uint8_t>(color0 & 0xFFU),
+        static_cast<uint8_t>(color0 >> 8U),
+        static_cast<uint8_t>(color1 & 0xFFU),
+        static_cast<uint8_t>(color1 >> 8U),
+        static_cast<uint8_t>(indices & 0xFFU),
+        static_cast<uint8_t>((indices >> 8U) & 0xFFU),
+        static_cast<uint8_t>((indices >> 16U) & 0xFFU),
+        static_cast<uint8_t>(indices >> 24U),
+    };
+}
+
+// Box filters RGBA8 down to the next mip level. The filter runs on the
+// encoded sRGB values, which slightly darkens high contrast detail.
+auto downsample(
+    std::span<uint8_t const> const rgba,
+    uint32_t const width,
+    uint32_t const height
+) -> std::vector<uint8_t>
+{
+    uint32_t const nextWidth{std::max(width / 2, 1U)};
+    uint32_t const nextHeight{std::max(height / 2, 1U)};
+
+    std::vector<uint8_t> next(static_cast<size_t>(nextWidth) * nextHeight * 4);
+    for (uint32_t y{0}; y < nextHeight; y++)
+    {
+        uint32_t const y0{std::min(y * 2, height - 1)};
+        uint32_t const y1{std::min(y * 2 + 1, height - 1)};
+        for (uint32_t x{0}; x < nextWidth; x++)
+        {
+            uint32_t const x0{std::min(x * 2, width - 1)};
+            uint32_t const x1{std::min(x * 2 + 1, width - 1)};
+
+            for (size_t channel{0}; channel < 4; channel++)
+            {
+                auto const texel{[&](uint32_t const texelX, uint32_t texelY)
+                {
+                    return static_cast<uint32_t>(
+                        rgba[(static_cast<size_t>(texelY) * width + texelX) * 4
+                             + channel]
+                    );
+                }};
+
+                uint32_t const sum{
+                    texel(x0, y0) + texel(x1, y0) + texel(x0, y1)
+                    + texel(x1, y1)
+                };
+                next[(static_cast<size_t>(y) * nextWidth + x) * 4 + channel] =
+                    static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+
+    return next;
+}
+
+auto hashBytes(std::span<uint8_t const> const bytes) -> uint64_t
+{
+    // 64-bit FNV-1a
+    uint64_t hash{0xcbf29ce484222325ULL};
+    for (uint8_t const byte : bytes)
+    {
+        hash ^= byte;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+struct CacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;
+    uint32_t levelCount;
+};
+
+uint32_t constexpr CACHE_MAGIC{0x58545A53}; // "SZTX"
+
+// Bump this whenever encoding changes, so stale entries are not read.
+uint32_t constexpr CACHE_VERSION{1};
+
+auto cachePath(uint64_t const key) -> std::filesystem::path
+{
+    std::filesystem::path const localPath{
+        std::filesystem::path{"cache/textures"}
+        / fmt::format("{:016x}.bc1", key)
+    };
+    return DebugUtils::getLoadedDebugUtils().makeAbsolutePath(localPath);
+}
+
+auto readCache(std::filesystem::path const& path)
+    -> std::optional<textures::CompressedTexture>
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader));
+    if (!file || header.magic != CACHE_MAGIC
+        || header.version != CACHE_VERSION)
+    {
+        return std::nullopt;
+    }
+
+    textures::CompressedTexture texture{
+        .width = header.width,
+        .height = header.height,
+        .format = static_cast<VkFormat>(header.format),
+    };
+    for (uint32_t level{0}; level < header.levelCount; level++)
+    {
+        VkExtent3D const extent{texture.levelExtent(level)};
+        uint64_t const expectedBytes{
+            static_cast<uint64_t>(blockCount(extent.width))
+            * blockCount(extent.height) * BC1_BLOCK_BYTES
+        };
+
+        uint64_t levelBytes{0};
+        file.read(reinterpret_cast<char*>(&levelBytes), sizeof(uint64_t));
+        if (!file || levelBytes != expectedBytes)
+        {
+            return std::nullopt;
+        }
+
+        std::vector<uint8_t>& levelData{texture.mipLevels.emplace_back()};
+        levelData.resize(levelBytes);
+        file.read(
+            reinterpret_cast<char*>(levelData.data()),
+            static_cast<std::streamsize>(levelBytes)
+        );
+        if (!file)
+        {
+            return std::nullopt;
+        }
+    }
+
+    return texture;
+}
+
+void writeCache(
+    std::filesystem::path const& path,
+    textures::CompressedTexture const& texture
+)
+{
+    std::error_code error{};
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error)
+    {
+        Warning(fmt::format(
+            "Unable to create texture cache directory: {}", error.message()
+        ));
+        return;
+    }
+
+    // Written aside and then renamed, so that other threads or runs never
+    // read a partial entry.
+    size_t const threadHash{
+        std::hash<std::thread::id>{}(std::this_thread::get_id())
+    };
+    std::filesystem::path const partialPath{
+        path.string() + fmt::format(".{}.partial", threadHash)
+    };
+
+    {
+        std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            Warning("Unable to write texture cache entry.");
+            return;
+        }
+
+        CacheHeader const header{
+            .magic = CACHE_MAGIC,
+            .version = CACHE_VERSION,
+            .width = texture.width,
+            .height = texture.height,
+            .format = static_cast<uint32_t>(texture.format),
+            .levelCount = static_cast<uint32_t>(texture.mipLevels.size()),
+        };
+        file.write(reinterpret_cast<char const*>(&header), sizeof(CacheHeader));
+
+        for (std::vector<uint8_t> const& level : texture.mipLevels)
+        {
+            uint64_t const levelBytes{level.size()};
+            file.write(
+                reinterpret_cast<char const*>(&levelBytes), sizeof(uint64_t)
+            );
+            file.write(
+                reinterpret_cast<char const*>(level.data()),
+                static_cast<std::streamsize>(level.size())
+            );
+        }
+    }
+
+    std::filesystem::rename(partialPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(partialPath, error);
+    }
+}
+} // namespace
+
+namespace textures
+{
+auto CompressedTexture::levelExtent(uint32_t const level) const -> VkExtent3D
+{
+    return VkExtent3D{
+        .width = std::max(width >> level, 1U),
+        .height = std::max(height >> level, 1U),
+        .depth = 1,
+    };
+}
+
+auto CompressedTexture::bytesFromLevel(uint32_t const level) const -> size_t
+{
+    size_t bytes{0};
+    for (size_t index{level}; index < mipLevels.size(); index++)
+    {
+        bytes += mipLevels[index].size();
+    }
+    return bytes;
+}
+
+auto encodeBC1(
+    std::span<uint8_t const> const rgba,
+    uint32_t const width,
+    uint32_t const height
+) -> std::vector<uint8_t>
+{
+    uint32_t const blocksWide{blockCount(width)};
+    uint32_t const blocksHigh{blockCount(height)};
+
+    std::vector<uint8_t> blocks{};
+    blocks.reserve(
+        static_cast<size_t>(blocksWide) * blocksHigh * BC1_BLOCK_BYTES
+    );
+
+    for (uint32_t blockY{0}; blockY < blocksHigh; blockY++)
+    {
+        for (uint32_t blockX{0}; blockX < blocksWide; blockX++)
+        {
+            std::array<std::array<int32_t, 3>, 16> texels{};
+            for (uint32_t y{0}; y < BC1_BLOCK_DIMENSION; y++)
+            {
+                for (uint32_t x{0}; x < BC1_BLOCK_DIMENSION; x++)
+                {
+                    uint32_t const texelX{
+                        std::min(blockX * BC1_BLOCK_DIMENSION + x, width - 1)
+                    };
+                    uint32_t const texelY{
+                        std::min(blockY * BC1_BLOCK_DIMENSION + y, height - 1)
+                    };
+                    size_t const offset{
+                        (static_cast<size_t>(texelY) * width + texelX) * 4
+                    };
+
+                    texels[y * BC1_BLOCK_DIMENSION + x] = {
+                        rgba[offset],
+                        rgba[offset + 1],
+                        rgba[offset + 2],
+                    };
+                }
+            }
+
+            std::array<uint8_t, BC1_BLOCK_BYTES> const block{
+                encodeBlock(texels)
+            };
+            blocks.insert(blocks.end(), block.begin(), block.end());
+        }
+    }
+
+    return blocks;
+}
+
+auto loadCompressedTexture(std::span<uint8_t const> const encodedImage)
+    -> std::optional<CompressedTexture>
+{
+    std::filesystem::path const path{cachePath(hashBytes(encodedImage))};
+
+    std::optional<CompressedTexture> cached{readCache(path)};
+    if (cached.has_value())
+    {
+        return cached;
+    }
+
+    int32_t width{0};
+    int32_t height{0};
+    int32_t channels{0};
+    stbi_uc* const pixels{stbi_load_from_memory(
+        encodedImage.data(),
+        static_cast<int32_t>(encodedImage.size()),
+        &width,
+        &height,
+        &channels,
+        STBI_rgb_alpha
+    )};
+    if (pixels == nullptr)
+    {
+        Warning(fmt::format(
+            "Failed to decode texture: {}", stbi_failure_reason()
+        ));
+        return std::nullopt;
+    }
+
+    CompressedTexture texture{
+        .width = static_cast<uint32_t>(width),
+        .height = static_cast<uint32_t>(height),
+    };
+
+    std::vector<uint8_t> level(
+        pixels, pixels + static_cast<size_t>(width) * height * 4
+    );
+    stbi_image_free(pixels);
+
+    uint32_t levelWidth{texture.width};
+    uint32_t levelHeight{texture.height};
+    while (true)
+    {
+        texture.mipLevels.push_back(encodeBC1(level, levelWidth, levelHeight));
+
+        if (levelWidth == 1 && levelHeight == 1)
+        {
+            break;
+        }
+
+        level = downsample(level, levelWidth, levelHeight);
+        levelWidth = std::max(levelWidth / 2, 1U);
+        levelHeight = std::max(levelHeight / 2, 1U);
+    }
+
+    writeCache(path, texture);
+
+    return texture;
+}
+} // namespace textures
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "enginetypes.hpp"
+
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace textures
+{
+/** A block compressed texture and its full mip chain, held on the host. */
+struct CompressedTexture
+{
+    uint32_t width{0};
+    uint32_t height{0};
+
+    VkFormat format{VK_FORMAT_BC1_RGBA_SRGB_BLOCK};
+
+    // The encoded blocks of each level, from full resolution down to 1x1.
+    std::vector<std::vector<uint8_t>> mipLevels{};
+
+    VkExtent3D levelExtent(uint32_t level) const;
+
+    // The bytes taken on the device by every level from this one down.
+    size_t bytesFromLevel(uint32_t level) const;
+};
+
+// Encodes tightly packed RGBA8 pixels into BC1 blocks, ignoring alpha. Edge
+// blocks of images that are not a multiple of 4 repeat their last pixels.
+std::vector<uint8_t>
+encodeBC1(std::span<uint8_t const> rgba, uint32_t width, uint32_t height);
+
+// Decodes an encoded image such as a PNG or JPEG, then builds and compresses
+// its mip chain. This is slow, so the result is cached on disk keyed by the
+// encoded bytes, and later calls with the same image read the cache instead.
+// Safe to call from any thread.
+std::optional<CompressedTexture>
+loadCompressedTexture(std::span<uint8_t const> encodedImage);
+} // namespace textures
@@ -0,0 +1,555 @@
+#include "texturestreamer.hpp"
+
+#include "helpers.hpp"
+#include "initializers.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+auto megabytesToBytes(float const megabytes) -> VkDeviceSize
+{
+    return static_cast<VkDeviceSize>(
+        static_cast<double>(megabytes) * 1024.0 * 1024.0
+    );
+}
+
+auto allocateStaging(
+    VkDevice const device, VmaAllocator const allocator, size_t const size
+) -> std::unique_ptr<AllocatedBuffer>
+{
+    return std::make_unique<AllocatedBuffer>(AllocatedBuffer::allocate(
+        device,
+        allocator,
+        size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VMA_MEMORY_USAGE_CPU_ONLY,
+        VMA_ALLOCATION_CREATE_MAPPED_BIT
+    ));
+}
+} // namespace
+
+TextureStreamer::TextureStreamer(
+    VkDevice const device,
+    VmaAllocator const allocator,
+    size_t const framesInFlight
+)
+{
+    m_device = device;
+    m_allocator = allocator;
+    m_framesInFlight = framesInFlight;
+
+    std::vector<DescriptorAllocator::PoolSizeRatio> const poolRatios{
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+         static_cast<float>(TEXTURE_CAPACITY)}
+    };
+    m_descriptorAllocator.initPool(device, 1, poolRatios, 0);
+
+    // Indices are rewritten while earlier frames are in flight, but never
+    // ones those frames sample.
+    std::optional<VkDescriptorSetLayout> const layoutResult{
+        DescriptorLayoutBuilder{}
+            .addBinding(
+                DescriptorLayoutBuilder::AddBindingParameters{
+                    .binding = 0,
+                    .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    .stageMask = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    .bindingFlags =
+                        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+                        | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT,
+                },
+                TEXTURE_CAPACITY
+            )
+            .build(device, 0)
+    };
+    if (!layoutResult.has_value())
+    {
+        Warning("Unable to build TextureStreamer descriptor layout.");
+        return;
+    }
+    m_layout = layoutResult.value();
+    m_set = m_descriptorAllocator.allocate(device, m_layout);
+
+    VkSamplerCreateInfo samplerInfo{vkinit::samplerCreateInfo(
+        0,
+        VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
+        VK_FILTER_LINEAR,
+        VK_SAMPLER_ADDRESS_MODE_REPEAT
+    )};
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    LogVkResult(
+        vkCreateSampler(device, &samplerInfo, nullptr, &m_sampler),
+        "Creating texture sampler"
+    );
+
+    std::optional<AllocatedImage> const fallbackResult{AllocatedImage::allocate(
+        allocator,
+        device,
+        AllocatedImage::AllocationParameters{
+            .extent = VkExtent3D{.width = 1, .height = 1, .depth = 1},
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .usageFlags =
+                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .viewFlags = VK_IMAGE_ASPECT_COLOR_BIT,
+        }
+    )};
+    if (!fallbackResult.has_value())
+    {
+        Warning("Unable to allocate fallback texture.");
+        return;
+    }
+    m_fallback = fallbackResult.value();
+    writeDescriptor(FALLBACK_INDEX, m_fallback.imageView);
+
+    // Reversed, so that the lowest indices are handed out first
+    for (uint32_t index{TEXTURE_CAPACITY - 1}; index > FALLBACK_INDEX; index--)
+    {
+        m_freeDescriptorIndices.push_back(index);
+    }
+}
+
+void TextureStreamer::requestTexture(
+    std::shared_ptr<textures::CompressedTexture const> const& texture,
+    uint64_t const currentFrame
+)
+{
+    if (texture == nullptr || texture->mipLevels.empty())
+    {
+        return;
+    }
+
+    auto [iterator, inserted]{
+        m_textureIndices.try_emplace(texture.get(), m_textures.size())
+    };
+    if (inserted)
+    {
+        m_textures.push_back(StreamedTexture{
+            .source = texture,
+            .residentLevel = static_cast<uint32_t>(texture->mipLevels.size()),
+        });
+    }
+
+    m_textures[iterator->second].lastUsedFrame = currentFrame;
+}
+
+void TextureStreamer::recordUpdate(
+    VkCommandBuffer const cmd,
+    TextureStreamingParameters const& parameters,
+    uint64_t const currentFrame
+)
+{
+    auto const idle{[&](PendingDestruction const& pending)
+    { return currentFrame >= pending.lastUsedFrame + m_framesInFlight; }};
+    for (PendingDestruction& pending : m_pendingDestruction)
+    {
+        if (!idle(pending))
+        {
+            continue;
+        }
+
+        pending.image.cleanup(m_device, m_allocator);
+        if (pending.descriptorIndex.has_value())
+        {
+            m_freeDescriptorIndices.push_back(pending.descriptorIndex.value());
+        }
+    }
+    std::erase_if(m_pendingDestruction, idle);
+
+    if (!m_fallbackUploaded)
+    {
+        recordUploadFallback(cmd, currentFrame);
+    }
+
+    VkDeviceSize const budgetBytes{
+        megabytesToBytes(parameters.budgetMegabytes)
+    };
+
+    VkDeviceSize residentBytes{0};
+    for (StreamedTexture const& texture : m_textures)
+    {
+        residentBytes += texture.source->bytesFromLevel(texture.residentLevel);
+    }
+
+    if (residentBytes > budgetBytes)
+    {
+        // Textures drawn this frame are never downgraded, so the budget may
+        // still be exceeded until they go unused.
+        std::vector<StreamedTexture*> candidates{};
+        for (StreamedTexture& texture : m_textures)
+        {
+            if (texture.resident() && texture.lastUsedFrame < currentFrame)
+            {
+                candidates.push_back(&texture);
+            }
+        }
+
+        std::sort(
+            candidates.begin(),
+            candidates.end(),
+            [](StreamedTexture const* lhs, StreamedTexture const* rhs)
+            { return lhs->lastUsedFrame < rhs->lastUsedFrame; }
+        );
+
+        for (StreamedTexture* const texture : candidates)
+        {
+            if (residentBytes <= budgetBytes)
+            {
+                break;
+            }
+
+            textures::CompressedTexture const& source{*texture->source};
+            VkDeviceSize const currentBytes{
+                source.bytesFromLevel(texture->residentLevel)
+            };
+
+            // Drop straight to the finest level that fits, so that only one
+            // new image is needed.
+            VkDeviceSize const otherBytes{residentBytes - currentBytes};
+            uint32_t level{texture->residentLevel + 1};
+            while (level < texture->levelCount()
+                   && otherBytes + source.bytesFromLevel(level) > budgetBytes)
+            {
+                level++;
+            }
+
+            if (level == texture->levelCount())
+            {
+                retire(*texture, texture->lastUsedFrame);
+                texture->residentLevel = level;
+            }
+            else if (!recordResidentLevel(cmd, *texture, level, currentFrame))
+            {
+                continue;
+            }
+
+            residentBytes -= currentBytes - source.bytesFromLevel(level);
+        }
+    }
+
+    // The textures missing the most levels are improved first, so that new
+    // textures appear before resident ones gain detail.
+    std::vector<StreamedTexture*> upgrades{};
+    for (StreamedTexture& texture : m_textures)
+    {
+        if (texture.lastUsedFrame == currentFrame && texture.residentLevel > 0)
+        {
+            upgrades.push_back(&texture);
+        }
+    }
+
+    std::sort(
+        upgrades.begin(),
+        upgrades.end(),
+        [](StreamedTexture const* lhs, StreamedTexture const* rhs)
+        { return lhs->residentLevel > rhs->residentLevel; }
+    );
+
+    VkDeviceSize const uploadLimitBytes{
+        megabytesToBytes(parameters.uploadMegabytesPerFrame)
+    };
+    VkDeviceSize uploadedBytes{0};
+    for (StreamedTexture* const texture : upgrades)
+    {
+        textures::CompressedTexture const& source{*texture->source};
+
+        uint32_t const level{texture->residentLevel - 1};
+        VkDeviceSize const currentBytes{
+            source.bytesFromLevel(texture->residentLevel)
+        };
+        VkDeviceSize const upgradedBytes{source.bytesFromLevel(level)};
+
+        if (residentBytes - currentBytes + upgradedBytes > budgetBytes)
+        {
+            continue;
+        }
+        if (uploadedBytes > 0
+            && uploadedBytes + upgradedBytes > uploadLimitBytes)
+        {
+            break;
+        }
+
+        if (!recordResidentLevel(cmd, *texture, level, currentFrame))
+        {
+            break;
+        }
+
+        residentBytes += upgradedBytes - currentBytes;
+        uploadedBytes += upgradedBytes;
+    }
+
+    m_statistics = Statistics{
+        .textureCount = m_textures.size(),
+        .residentBytes = residentBytes,
+        .uploadedBytesLastFrame = uploadedBytes,
+    };
+    for (StreamedTexture const& texture : m_textures)
+    {
+        m_statistics.requestedBytes += texture.source->bytesFromLevel(0);
+        if (texture.resident())
+        {
+            m_statistics.residentTextures += 1;
+        }
+        if (texture.residentLevel == 0)
+        {
+            m_statistics.fullyResidentTextures += 1;
+        }
+    }
+}
+
+auto TextureStreamer::bindlessIndex(
+    textures::CompressedTexture const* const texture
+) const -> uint32_t
+{
+    auto const found{m_textureIndices.find(texture)};
+    if (found == m_textureIndices.end())
+    {
+        return FALLBACK_INDEX;
+    }
+
+    return m_textures[found->second].descriptorIndex;
+}
+
+auto TextureStreamer::recordResidentLevel(
+    VkCommandBuffer const cmd,
+    StreamedTexture& texture,
+    uint32_t const level,
+    uint64_t const currentFrame
+) -> bool
+{
+    if (m_freeDescriptorIndices.empty())
+    {
+        return false;
+    }
+
+    textures::CompressedTexture const& source{*texture.source};
+
+    std::optional<AllocatedImage> const imageResult{AllocatedImage::allocate(
+        m_allocator,
+        m_device,
+        AllocatedImage::AllocationParameters{
+            .extent = source.levelExtent(level),
+            .format = source.format,
+            .usageFlags =
+                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .viewFlags = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevels = texture.levelCount() - level,
+        }
+    )};
+    if (!imageResult.has_value())
+    {
+        Warning("Unable to allocate streamed texture.");
+        return false;
+    }
+    AllocatedImage const image{imageResult.value()};
+
+    // Levels that were already resident are uploaded again too, which keeps
+    // the old image untouched while frames in flight sample it.
+    std::unique_ptr<AllocatedBuffer> staging{
+        allocateStaging(m_device, m_allocator, source.bytesFromLevel(level))
+    };
+    auto* const stagingBytes{
+        reinterpret_cast<uint8_t*>(staging->allocation->GetMappedData())
+    };
+
+    std::vector<VkBufferImageCopy> copies{};
+    VkDeviceSize offset{0};
+    for (uint32_t sourceLevel{level}; sourceLevel < texture.levelCount();
+         sourceLevel++)
+    {
+        std::vector<uint8_t> const& levelBytes{source.mipLevels[sourceLevel]};
+        std::copy(levelBytes.begin(), levelBytes.end(), stagingBytes + offset);
+
+        copies.push_back(VkBufferImageCopy{
+            .bufferOffset = offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = vkinit::imageSubresourceLayers(
+                VK_IMAGE_ASPECT_COLOR_BIT, sourceLevel - level, 0, 1
+            ),
+            .imageOffset = VkOffset3D{},
+            .imageExtent = source.levelExtent(sourceLevel),
+        });
+
+        offset += levelBytes.size();
+    }
+
+    vkutil::transitionImage(
+        cmd,
+        image.image,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+    vkCmdCopyBufferToImage(
+        cmd,
+        staging->buffer,
+        image.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VKR_ARRAY(copies)
+    );
+    vkutil::transitionImage(
+        cmd,
+        image.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+
+    uint32_t const descriptorIndex{m_freeDescriptorIndices.back()};
+    m_freeDescriptorIndices.pop_back();
+    writeDescriptor(descriptorIndex, image.imageView);
+
+    retire(texture, texture.lastUsedFrame);
+    m_pendingDestruction.push_back(PendingDestruction{
+        .lastUsedFrame = currentFrame,
+        .staging = std::move(staging),
+    });
+
+    texture.residentLevel = level;
+    texture.image = image;
+    texture.descriptorIndex = descriptorIndex;
+
+    return true;
+}
+
+void TextureStreamer::retire(
+    StreamedTexture& texture, uint64_t const lastUsedFrame
+)
+{
+    if (!texture.resident())
+    {
+        return;
+    }
+
+    m_pendingDestruction.push_back(PendingDestruction{
+        .lastUsedFrame = lastUsedFrame,
+        .image = texture.image,
+        .descriptorIndex = texture.descriptorIndex,
+    });
+
+    texture.image = AllocatedImage{};
+    texture.descriptorIndex = FALLBACK_INDEX;
+}
+
+void TextureStreamer::writeDescriptor(
+    uint32_t const index, VkImageView const view
+)
+{
+    VkDescriptorImageInfo const imageInfo{
+        .sampler = m_sampler,
+        .imageView = view,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+
+    VkWriteDescriptorSet const textureWrite{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+
+        .dstSet = m_set,
+        .dstBinding = 0,
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+
+        .pImageInfo = &imageInfo,
+        .pBufferInfo = nullptr,
+        .pTexelBufferView = nullptr,
+    };
+
+    std::vector<VkWriteDescriptorSet> const writes{textureWrite};
+    vkUpdateDescriptorSets(m_device, VKR_ARRAY(writes), VKR_ARRAY_NONE);
+}
+
+void TextureStreamer::recordUploadFallback(
+    VkCommandBuffer const cmd, uint64_t const currentFrame
+)
+{
+    if (m_fallback.image == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::array<uint8_t, 4> constexpr WHITE_RGBA{255, 255, 255, 255};
+
+    std::unique_ptr<AllocatedBuffer> staging{
+        allocateStaging(m_device, m_allocator, WHITE_RGBA.size())
+    };
+    std::copy(
+        WHITE_RGBA.begin(),
+        WHITE_RGBA.end(),
+        reinterpret_cast<uint8_t*>(staging->allocation->GetMappedData())
+    );
+
+    VkBufferImageCopy const copy{
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = vkinit::imageSubresourceLayers(
+            VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1
+        ),
+        .imageOffset = VkOffset3D{},
+        .imageExtent = m_fallback.imageExtent,
+    };
+
+    vkutil::transitionImage(
+        cmd,
+        m_fallback.image,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+    vkCmdCopyBufferToImage(
+        cmd,
+        staging->buffer,
+        m_fallback.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &copy
+    );
+    vkutil::transitionImage(
+        cmd,
+        m_fallback.image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+
+    m_pendingDestruction.push_back(PendingDestruction{
+        .lastUsedFrame = currentFrame,
+        .staging = std::move(staging),
+    });
+
+    m_fallbackUploaded = true;
+}
+
+void TextureStreamer::cleanup()
+{
+    for (PendingDestruction& pending : m_pendingDestruction)
+    {
+        pending.image.cleanup(m_device, m_allocator);
+    }
+    m_pendingDestruction.clear();
+
+    for (StreamedTexture& texture : m_textures)
+    {
+        texture.image.cleanup(m_device, m_allocator);
+    }
+    m_textures.clear();
+    m_textureIndices.clear();
+    m_freeDescriptorIndices.clear();
+
+    m_fallback.cleanup(m_device, m_allocator);
+    m_fallback = AllocatedImage{};
+    m_fallbackUploaded = false;
+
+    vkDestroySampler(m_device, m_sampler, nullptr);
+    m_sampler = VK_NULL_HANDLE;
+
+    m_descriptorAllocator.destroyPool(m_device);
+    vkDestroyDescriptorSetLayout(m_device, m_layout, nullptr);
+    m_layout = VK_NULL_HANDLE;
+    m_set = VK_NULL_HANDLE;
+
+    m_statistics = {};
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "buffers.hpp"
+#include "descriptors.hpp"
+#include "enginetypes.hpp"
+#include "images.hpp"
+#include "textures.hpp"
+
+#include <unordered_map>
+
+struct TextureStreamingParameters
+{
+    // The most device memory that streamed textures can use in total.
+    float budgetMegabytes{256.0F};
+
+    // Caps the bytes copied each frame, so that new textures sharpen over
+    // several frames instead of stalling one. At least one level is always
+    // uploaded per frame.
+    float uploadMegabytesPerFrame{4.0F};
+
+    bool operator==(TextureStreamingParameters const& other) const = default;
+};
+
+// Owns a bindless array of sampled textures, streaming in the mip levels of
+// compressed textures as they are drawn. Each texture starts at its smallest
+// level and gains one finer level per frame while under budget. When over
+// budget, the least recently drawn textures drop their finest levels.
+//
+// A texture's index into the array changes whenever its levels do, so
+// indices should be looked up each frame. Index 0 is always a white texture,
+// used in place of any texture that is not resident.
+class TextureStreamer
+{
+public:
+    static uint32_t constexpr TEXTURE_CAPACITY{1024};
+    static uint32_t constexpr FALLBACK_INDEX{0};
+
+    struct Statistics
+    {
+        size_t textureCount{0};
+        size_t residentTextures{0};
+        size_t fullyResidentTextures{0};
+
+        VkDeviceSize residentBytes{0};
+
+        // The device memory every texture would need at full resolution.
+        VkDeviceSize requestedBytes{0};
+
+        VkDeviceSize uploadedBytesLastFrame{0};
+    };
+
+    TextureStreamer(
+        VkDevice device, VmaAllocator allocator, size_t framesInFlight
+    );
+
+    TextureStreamer(TextureStreamer const& other) = delete;
+    TextureStreamer& operator=(TextureStreamer const& other) = delete;
+
+    // Records that the texture is drawn this frame, which begins streaming it
+    // in if it is new.
+    void requestTexture(
+        std::shared_ptr<textures::CompressedTexture const> const& texture,
+        uint64_t currentFrame
+    );
+
+    // Must be called after waiting on the current frame's fence, and before
+    // any indices are read for the frame. Destroys images that are no longer
+    // in flight, then records the copies for this frame's levels. The new
+    // levels are bound immediately, so the command buffer must be submitted.
+    void recordUpdate(
+        VkCommandBuffer cmd,
+        TextureStreamingParameters const& parameters,
+        uint64_t currentFrame
+    );
+
+    // The index to sample in the bindless array. Unknown and null textures
+    // map to the fallback.
+    uint32_t bindlessIndex(textures::CompressedTexture const* texture) const;
+
+    VkDescriptorSetLayout layout() const { return m_layout; }
+    VkDescriptorSet set() const { return m_set; }
+
+    Statistics statistics() const { return m_statistics; }
+
+    // Destroys everything immediately, so the device must be idle.
+    void cleanup();
+
+private:
+    struct StreamedTexture
+    {
+        std::shared_ptr<textures::CompressedTexture const> source{};
+
+        // The finest level on the device. Equal to the level count while
+        // nothing is resident.
+        uint32_t residentLevel{0};
+        AllocatedImage image{};
+        uint32_t descriptorIndex{FALLBACK_INDEX};
+
+        uint64_t lastUsedFrame{0};
+
+        uint32_t levelCount() const
+        {
+            return static_cast<uint32_t>(source->mipLevels.size());
+        }
+        bool resident() const { return residentLevel < levelCount(); }
+    };
+
+    // Replaces the texture's image with one holding every level from the
+    // given one down, uploaded from the host copy. Returns false if the image
+    // or a descriptor index could not be allocated, leaving it unchanged.
+    bool recordResidentLevel(
+        VkCommandBuffer cmd,
+        StreamedTexture& texture,
+        uint32_t level,
+        uint64_t currentFrame
+    );
+
+    void retire(StreamedTexture& texture, uint64_t lastUsedFrame);
+
+    void writeDescriptor(uint32_t index, VkImageView view);
+
+    void recordUploadFallback(VkCommandBuffer cmd, uint64_t currentFrame);
+
+    struct PendingDestruction
+    {
+        uint64_t lastUsedFrame{0};
+
+        // Any of these may be null.
+        AllocatedImage image{};
+        std::unique_ptr<AllocatedBuffer> staging{};
+        std::optional<uint32_t> descriptorIndex{};
+    };
+
+    VkDevice m_device{VK_NULL_HANDLE};
+    VmaAllocator m_allocator{VK_NULL_HANDLE};
+    size_t m_framesInFlight{0};
+
+    DescriptorAllocator m_descriptorAllocator{};
+    VkDescriptorSetLayout m_layout{VK_NULL_HANDLE};
+    VkDescriptorSet m_set{VK_NULL_HANDLE};
+    VkSampler m_sampler{VK_NULL_HANDLE};
+
+    AllocatedImage m_fallback{};
+    bool m_fallbackUploaded{false};
+
+    std::vector<StreamedTexture> m_textures{};
+    std::unordered_map<textures::CompressedTexture const*, size_t>
+        m_textureIndices{};
+
+    std::vector<uint32_t> m_freeDescriptorIndices{};
+
+    std::vector<PendingDestruction> m_pendingDestruction{};
+
+    Statistics m_statistics{};
+};
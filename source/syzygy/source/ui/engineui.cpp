@@ -1,7 +1,12 @@
 #include "engineui.hpp"
 #include "../assets.hpp"
+#include "../cpuprofiler.hpp"
 #include "../debuglines.hpp"
 #include "../engineparams.hpp"
+#include "../gpuprofiler.hpp"
+#include "../helpers.hpp"
+#include "../meshloader.hpp"
+#include "../shadercache.hpp"
 #include "../shaders.hpp"
 #include "../shadowpass.hpp"
 #include "imgui_internal.h"
@@ -10,14 +15,213 @@
 #include <array>
 #include <fmt/format.h>
 #include <implot.h>
+#include <misc/cpp/imgui_stdlib.h>
 
-void imguiPerformanceWindow(PerformanceValues const values, float& targetFPS)
+namespace
 {
-    if (ImGui::Begin("Performance Information"))
+void rowWorkCounters(
+    PropertyTable& table,
+    std::string const& name,
+    WorkCounters const& work,
+    bool const pipelineStatistics
+)
+{
+    auto const count{
+        [](uint64_t const value) { return fmt::format("{}", value); }
+    };
+
+    table.rowChildPropertyBegin(name)
+        .rowReadOnlyText("Draw Calls", count(work.drawCalls))
+        .rowReadOnlyText("Dispatches", count(work.dispatches))
+        .rowReadOnlyText("Direct Instances", count(work.instances))
+        .rowReadOnlyText("Barriers", count(work.barriers))
+        .rowReadOnlyText(
+            "Bytes Copied",
+            fmt::format(
+                "{:.1f} KiB", static_cast<double>(work.bytesCopied) / 1024.0
+            )
+        );
+    if (pipelineStatistics)
+    {
+        table.rowReadOnlyText("Primitives", count(work.primitives))
+            .rowReadOnlyText(
+                "Vertex Invocations", count(work.vertexInvocations)
+            )
+            .rowReadOnlyText(
+                "Fragment Invocations", count(work.fragmentInvocations)
+            )
+            .rowReadOnlyText(
+                "Compute Invocations", count(work.computeInvocations)
+            );
+    }
+    table.childPropertyEnd();
+}
+
+void renderGPUTimings(GPUProfiler& profiler, ImVec2 const plotSize)
+{
+    std::span<GPUProfiler::ScopeHistory const> const scopes{profiler.scopes()};
+
+    auto table{PropertyTable::begin()};
+    for (GPUProfiler::ScopeHistory const& scope : scopes)
+    {
+        table.rowReadOnlyText(
+            scope.name,
+            fmt::format("{:.3f} ms", profiler.averageMilliseconds(scope))
+        );
+    }
+    table.end();
+
+    // Work lets regressions show up before they cost frame time
+    auto workTable{PropertyTable::begin("GPU Work")};
+    bool const pipelineStatistics{profiler.pipelineStatisticsSupported()};
+    rowWorkCounters(
+        workTable, "Frame Total", profiler.frameWork(), pipelineStatistics
+    );
+    for (GPUProfiler::ScopeHistory const& scope : scopes)
+    {
+        rowWorkCounters(workTable, scope.name, scope.work, pipelineStatistics);
+    }
+    workTable.end();
+
+    if (ImPlot::BeginPlot("GPU Timings", plotSize))
+    {
+        ImPlot::SetupAxes(
+            "",
+            "ms",
+            ImPlotAxisFlags_NoDecorations | ImPlotAxisFlags_Lock,
+            ImPlotAxisFlags_AutoFit
+        );
+        ImPlot::SetupAxisLimits(
+            ImAxis_X1, 0, static_cast<double>(GPUProfiler::HISTORY_LENGTH)
+        );
+
+        for (GPUProfiler::ScopeHistory const& scope : scopes)
+        {
+            ImPlot::PlotLine(
+                scope.name.c_str(),
+                scope.milliseconds.data(),
+                static_cast<int32_t>(scope.milliseconds.size())
+            );
+        }
+
+        auto const currentFrame{static_cast<double>(profiler.historyIndex())};
+        ImPlot::PlotInfLines("##current", &currentFrame, 1);
+
+        ImPlot::EndPlot();
+    }
+
+    if (ImGui::Button("Export GPU Timings"))
+    {
+        profiler.exportCSV(DebugUtils::getLoadedDebugUtils().makeAbsolutePath(
+            std::filesystem::path{"profiles"} / "gpu_timings.csv"
+        ));
+    }
+}
+
+void renderCPUTimings()
+{
+    // Totals of the last whole second, so the table follows the current load.
+    // Only zones since the previous frame are read each frame.
+    int64_t constexpr WINDOW_NANOSECONDS{1'000'000'000};
+    static CPUZoneCollector collector{};
+    static std::vector<CPUProfiler::ZoneStatistics> statistics{};
+    static int64_t windowBegin{0};
+
+    collector.update();
+    if (int64_t const now{CPUProfiler::now()};
+        now - windowBegin >= WINDOW_NANOSECONDS)
+    {
+        statistics = collector.statistics();
+        collector.reset();
+        windowBegin = now;
+    }
+
+    auto table{PropertyTable::begin("CPU Zones")};
+    for (CPUProfiler::ZoneStatistics const& zone : statistics)
     {
-        ImGui::Text(
-            "%s", fmt::format("FPS: {:.1f}", values.averageFPS).c_str()
+        table.rowReadOnlyText(
+            zone.name,
+            fmt::format(
+                "{:.3f} ms mean, {:.3f} ms max, {} calls",
+                zone.meanMilliseconds(),
+                zone.maxMilliseconds,
+                zone.calls
+            )
         );
+    }
+
+    bool exportOnExit{CPUProfiler::exportOnExit()};
+    table.rowBoolean("Export Trace on Exit", exportOnExit, false);
+    CPUProfiler::setExportOnExit(exportOnExit);
+
+    table.end();
+
+    if (ImGui::Button("Export CPU Trace"))
+    {
+        CPUProfiler::exportChromeTrace(
+            DebugUtils::getLoadedDebugUtils().makeAbsolutePath(
+                std::filesystem::path{"profiles"} / "cpu_trace.json"
+            )
+        );
+    }
+}
+
+void renderFrameTimeSummary(
+    FrameTimeSummary const& summary, size_t& windowFrames
+)
+{
+    std::array<size_t, 3> constexpr WINDOW_OPTIONS{120, 500, 2000};
+    std::array<std::string, 3> const windowLabels{
+        "120 Frames", "500 Frames", "2000 Frames"
+    };
+
+    size_t windowIndex{static_cast<size_t>(
+        std::find(WINDOW_OPTIONS.begin(), WINDOW_OPTIONS.end(), windowFrames)
+        - WINDOW_OPTIONS.begin()
+    )};
+    size_t const defaultWindowIndex{1};
+    if (windowIndex >= WINDOW_OPTIONS.size())
+    {
+        windowIndex = defaultWindowIndex;
+    }
+
+    auto const formatMilliseconds{
+        [](double const milliseconds)
+        { return fmt::format("{:.2f} ms", milliseconds); }
+    };
+
+    PropertyTable::begin("Frame Times")
+        .rowDropdown("Window", windowIndex, defaultWindowIndex, windowLabels)
+        .rowReadOnlyText(
+            "FPS",
+            fmt::format(
+                "{:.1f}",
+                summary.meanMilliseconds > 0.0
+                    ? 1000.0 / summary.meanMilliseconds
+                    : 0.0
+            )
+        )
+        .rowReadOnlyText("Mean", formatMilliseconds(summary.meanMilliseconds))
+        .rowReadOnlyText("p50", formatMilliseconds(summary.p50Milliseconds))
+        .rowReadOnlyText("p95", formatMilliseconds(summary.p95Milliseconds))
+        .rowReadOnlyText("p99", formatMilliseconds(summary.p99Milliseconds))
+        .rowReadOnlyText("Max", formatMilliseconds(summary.maxMilliseconds))
+        .rowReadOnlyText(
+            "Stutters",
+            fmt::format("{} of {} frames", summary.stutters, summary.frames)
+        )
+        .end();
+
+    windowFrames = WINDOW_OPTIONS[windowIndex];
+}
+} // namespace
+
+void imguiPerformanceWindow(
+    PerformanceValues const& values, float& targetFPS, size_t& windowFrames
+)
+{
+    if (ImGui::Begin("Performance Information"))
+    {
         float const minFPS{10.0};
         float const maxFPS{1000.0};
         ImGui::DragScalar(
@@ -31,37 +235,90 @@ void imguiPerformanceWindow(PerformanceValues const values, float& targetFPS)
             ImGuiSliderFlags_AlwaysClamp
         );
 
+        renderFrameTimeSummary(values.summary, windowFrames);
+
         ImVec2 const plotSize{-1, 200};
 
-        if (ImPlot::BeginPlot("FPS", plotSize))
+        if (ImPlot::BeginPlot("Frame Times", plotSize))
         {
             ImPlot::SetupAxes(
                 "",
-                "FPS",
+                "ms",
                 ImPlotAxisFlags_NoDecorations | ImPlotAxisFlags_Lock,
                 ImPlotAxisFlags_LockMin
             );
 
-            double constexpr DISPLAYED_FPS_MIN{0.0};
-            double constexpr DISPLAYED_FPS_MAX{320.0};
+            double constexpr DISPLAYED_MILLISECONDS_MIN{0.0};
+            double constexpr DISPLAYED_MILLISECONDS_MAX{50.0};
 
             ImPlot::SetupAxesLimits(
                 0,
-                static_cast<double>(values.samplesFPS.size()),
-                DISPLAYED_FPS_MIN,
-                DISPLAYED_FPS_MAX
+                static_cast<double>(values.samplesMilliseconds.size()),
+                DISPLAYED_MILLISECONDS_MIN,
+                DISPLAYED_MILLISECONDS_MAX
             );
 
             ImPlot::PlotLine(
-                "##fpsValues",
-                values.samplesFPS.data(),
-                static_cast<int32_t>(values.samplesFPS.size())
+                "##frameTimes",
+                values.samplesMilliseconds.data(),
+                static_cast<int32_t>(values.samplesMilliseconds.size())
             );
 
-            ImPlot::PlotInfLines("##current", &values.currentFrame, 1);
+            auto const currentFrame{static_cast<double>(values.currentFrame)};
+            ImPlot::PlotInfLines("##current", &currentFrame, 1);
 
             ImPlot::EndPlot();
         }
+
+        if (ImPlot::BeginPlot("Frame Time Histogram", plotSize))
+        {
+            ImPlot::SetupAxes(
+                "ms", "Frames", ImPlotAxisFlags_None, ImPlotAxisFlags_AutoFit
+            );
+
+            double constexpr BUCKET_WIDTH{
+                FrameTimeSummary::HISTOGRAM_BUCKET_MILLISECONDS
+            };
+            ImPlot::SetupAxisLimits(
+                ImAxis_X1,
+                0.0,
+                BUCKET_WIDTH * FrameTimeSummary::HISTOGRAM_BUCKET_COUNT,
+                ImPlotCond_Always
+            );
+
+            // Bars are centered, so place them in the middle of their bucket
+            std::array<double, FrameTimeSummary::HISTOGRAM_BUCKET_COUNT>
+                bucketCenters{};
+            std::array<double, FrameTimeSummary::HISTOGRAM_BUCKET_COUNT>
+                bucketFrames{};
+            for (size_t bucket{0}; bucket < bucketCenters.size(); bucket++)
+            {
+                bucketCenters[bucket] =
+                    BUCKET_WIDTH * (static_cast<double>(bucket) + 0.5);
+                bucketFrames[bucket] =
+                    static_cast<double>(values.summary.histogram[bucket]);
+            }
+
+            ImPlot::PlotBars(
+                "##histogram",
+                bucketCenters.data(),
+                bucketFrames.data(),
+                static_cast<int32_t>(bucketCenters.size()),
+                BUCKET_WIDTH
+            );
+
+            ImPlot::EndPlot();
+        }
+
+        // Timings lag a few frames behind, since they are read back without
+        // waiting on the GPU
+        if (GPUProfiler* const profiler{GPUProfiler::getLoadedGPUProfiler()};
+            profiler != nullptr)
+        {
+            renderGPUTimings(*profiler, plotSize);
+        }
+
+        renderCPUTimings();
     }
     ImGui::End();
 }
@@ -229,23 +486,339 @@ auto buildDefaultMultiWindowLayout(
 }
 
 void imguiMeshInstanceControls(
-    bool& shouldRender,
-    std::span<std::shared_ptr<MeshAsset> const> const meshes,
-    size_t& meshIndexSelected
+    bool& shouldRender, AssetRegistry const& meshes, MeshHandle& meshSelected
 )
 {
+    std::vector<MeshHandle> const handles{meshes.meshHandles()};
+
     std::vector<std::string> meshNames{};
-    for (std::shared_ptr<MeshAsset> const& asset : meshes)
+    size_t meshIndexSelected{0};
+    for (size_t index{0}; index < handles.size(); index++)
     {
-        MeshAsset const& mesh{*asset};
+        MeshAsset const& mesh{*meshes.get(handles[index])};
 
-        meshNames.push_back(mesh.name);
+        meshNames.push_back(
+            mesh.meshBuffers != nullptr ? mesh.name : mesh.name + " (Evicted)"
+        );
+        if (handles[index] == meshSelected)
+        {
+            meshIndexSelected = index;
+        }
     }
 
     PropertyTable::begin()
         .rowBoolean("Render Mesh Instances", shouldRender, true)
         .rowDropdown("Mesh", meshIndexSelected, 0, meshNames)
         .end();
+
+    if (meshIndexSelected < handles.size())
+    {
+        meshSelected = handles[meshIndexSelected];
+    }
+}
+
+void imguiMeshLoadingControls(
+    MeshLoader& loader, std::string& localPath, MeshImportOptions& options
+)
+{
+    bool const headerOpen{
+        ImGui::CollapsingHeader("Mesh Loading", ImGuiTreeNodeFlags_DefaultOpen)
+    };
+
+    if (!headerOpen)
+    {
+        return;
+    }
+
+    MeshImportOptions const defaults{};
+
+    PropertyTable::begin()
+        .rowBoolean(
+            "Pack Vertices", options.packVertices, defaults.packVertices
+        )
+        .rowBoolean("Streaming", options.streaming, defaults.streaming)
+        .end();
+
+    ImGui::InputText("Path", &localPath);
+    if (ImGui::Button("Load in Background"))
+    {
+        loader.loadAsync(localPath, options);
+    }
+
+    std::vector<MeshLoader::JobProgress> const jobs{loader.progress()};
+    if (jobs.empty())
+    {
+        return;
+    }
+
+    auto table{PropertyTable::begin("Mesh Loading Jobs")};
+    for (MeshLoader::JobProgress const& job : jobs)
+    {
+        std::string status{};
+        switch (job.status)
+        {
+        case MeshLoader::JobStatus::QUEUED:
+            status = "Queued";
+            break;
+        case MeshLoader::JobStatus::DECODING:
+            status = fmt::format("Decoding, {} meshes", job.meshesDecoded);
+            break;
+        case MeshLoader::JobStatus::UPLOADING:
+            status = fmt::format(
+                "Uploading, {} of {} meshes",
+                job.meshesUploaded,
+                job.meshesDecoded
+            );
+            break;
+        case MeshLoader::JobStatus::FINISHED:
+            status = fmt::format("Finished, {} meshes", job.meshesUploaded);
+            break;
+        case MeshLoader::JobStatus::FAILED:
+            status = "Failed";
+            break;
+        }
+
+        table.rowReadOnlyText(job.localPath, status);
+    }
+    table.end();
+}
+
+void imguiMeshResidencyControls(
+    MeshResidencyParameters& parameters,
+    AssetRegistry::Statistics const& statistics
+)
+{
+    bool const headerOpen{ImGui::CollapsingHeader(
+        "Mesh Residency", ImGuiTreeNodeFlags_DefaultOpen
+    )};
+
+    if (!headerOpen)
+    {
+        return;
+    }
+
+    MeshResidencyParameters const defaults{};
+
+    auto const toMegabytes{[](VkDeviceSize const bytes)
+    { return static_cast<double>(bytes) / (1024.0 * 1024.0); }};
+
+    PropertyTable::begin()
+        .rowFloat(
+            "Budget (MB)",
+            parameters.budgetMegabytes,
+            defaults.budgetMegabytes,
+            PropertySliderBehavior{
+                .speed = 1.0F,
+                .bounds = FloatBounds{0.0F, 65536.0F},
+            }
+        )
+        .rowFloat(
+            "Device Budget Fraction",
+            parameters.deviceBudgetFraction,
+            defaults.deviceBudgetFraction,
+            PropertySliderBehavior{
+                .speed = 0.01F,
+                .bounds = FloatBounds{0.0F, 1.0F},
+            }
+        )
+        .rowReadOnlyText(
+            "Meshes",
+            fmt::format(
+                "{} resident, {} evicted",
+                statistics.residentMeshes,
+                statistics.evictedMeshes
+            )
+        )
+        .rowReadOnlyText(
+            "Resident",
+            fmt::format(
+                "{:.1f} MB, {:.1f} MB pending release",
+                toMegabytes(statistics.residentBytes),
+                toMegabytes(statistics.pendingDestructionBytes)
+            )
+        )
+        .rowReadOnlyText(
+            "Device Memory",
+            fmt::format(
+                "{:.1f} MB of {:.1f} MB",
+                toMegabytes(statistics.deviceUsageBytes),
+                toMegabytes(statistics.deviceBudgetBytes)
+            )
+        )
+        .end();
+}
+
+void imguiTextureStreamingControls(
+    TextureStreamingParameters& parameters,
+    TextureStreamer::Statistics const& statistics
+)
+{
+    bool const headerOpen{ImGui::CollapsingHeader(
+        "Texture Streaming", ImGuiTreeNodeFlags_DefaultOpen
+    )};
+
+    if (!headerOpen)
+    {
+        return;
+    }
+
+    TextureStreamingParameters const defaults{};
+
+    auto const toMegabytes{[](VkDeviceSize const bytes)
+    { return static_cast<double>(bytes) / (1024.0 * 1024.0); }};
+
+    PropertyTable::begin()
+        .rowFloat(
+            "Budget (MB)",
+            parameters.budgetMegabytes,
+            defaults.budgetMegabytes,
+            PropertySliderBehavior{
+                .speed = 1.0F,
+                .bounds = FloatBounds{0.0F, 65536.0F},
+            }
+        )
+        .rowFloat(
+            "Upload per Frame (MB)",
+            parameters.uploadMegabytesPerFrame,
+            defaults.uploadMegabytesPerFrame,
+            PropertySliderBehavior{
+                .speed = 0.1F,
+                .bounds = FloatBounds{0.0F, 1024.0F},
+            }
+        )
+        .rowReadOnlyText(
+            "Textures",
+            fmt::format(
+                "{} total, {} resident, {} at full resolution",
+                statistics.textureCount,
+                statistics.residentTextures,
+                statistics.fullyResidentTextures
+            )
+        )
+        .rowReadOnlyText(
+            "Resident",
+            fmt::format(
+                "{:.1f} MB of {:.1f} MB requested",
+                toMegabytes(statistics.residentBytes),
+                toMegabytes(statistics.requestedBytes)
+            )
+        )
+        .rowReadOnlyText(
+            "Uploaded Last Frame",
+            fmt::format(
+                "{:.2f} MB", toMegabytes(statistics.uploadedBytesLastFrame)
+            )
+        )
+        .end();
+}
+
+void imguiPipelineCompilationStatus(PipelineCompiler const& compiler)
+{
+    bool const headerOpen{ImGui::CollapsingHeader(
+        "Pipeline Compilation", ImGuiTreeNodeFlags_DefaultOpen
+    )};
+
+    if (!headerOpen)
+    {
+        return;
+    }
+
+    auto table{PropertyTable::begin()};
+    table.rowReadOnlyInteger(
+        "Compile Queue Depth", static_cast<int32_t>(compiler.queueDepth())
+    );
+
+    if (ShaderCache const* const cache{ShaderCache::getLoadedShaderCache()};
+        cache != nullptr)
+    {
+        ShaderCache::Statistics const statistics{cache->statistics()};
+        table
+            .rowReadOnlyText(
+                "Pipeline Cache",
+                fmt::format(
+                    "{} hit, {} missed",
+                    statistics.pipelineHits,
+                    statistics.pipelineMisses
+                )
+            )
+            .rowReadOnlyText(
+                "Shader Object Cache",
+                fmt::format(
+                    "{} hit, {} missed, {} rejected",
+                    statistics.shaderObjectHits,
+                    statistics.shaderObjectMisses,
+                    statistics.shaderObjectRejections
+                )
+            );
+    }
+
+    table.end();
+}
+
+void imguiLODControls(
+    LODParameters& parameters,
+    MeshInstances const& instances,
+    MeshAsset const& mesh
+)
+{
+    bool const headerOpen{ImGui::CollapsingHeader(
+        "Levels of Detail", ImGuiTreeNodeFlags_DefaultOpen
+    )};
+
+    if (!headerOpen)
+    {
+        return;
+    }
+
+    LODParameters const defaults{};
+
+    auto table{PropertyTable::begin()};
+    table.rowBoolean("Enabled", parameters.enabled, defaults.enabled)
+        .rowFloat(
+            "Max Error (Pixels)",
+            parameters.maxErrorPixels,
+            defaults.maxErrorPixels,
+            PropertySliderBehavior{
+                .speed = 0.05F,
+                .bounds = FloatBounds{0.0F, 64.0F},
+            }
+        );
+
+    if (mesh.surfaces.empty())
+    {
+        table.end();
+        return;
+    }
+
+    GeometrySurface const& surface{mesh.surfaces[0]};
+
+    table.rowReadOnlyInteger(
+        "Meshlets", static_cast<int32_t>(surface.meshletCount)
+    );
+
+    std::span<InstanceRange const> const ranges{
+        lod::surfaceInstanceRanges(instances, 0)
+    };
+    int32_t trianglesDrawn{0};
+    for (size_t level{0}; level < ranges.size(); level++)
+    {
+        lod::IndexRange const indices{lod::surfaceLODRange(surface, level)};
+        uint32_t const instanceCount{ranges[level].instanceCount};
+
+        table.rowReadOnlyText(
+            fmt::format("LOD {}", level),
+            fmt::format(
+                "{} instances, {} triangles each",
+                instanceCount,
+                indices.indexCount / 3
+            )
+        );
+
+        trianglesDrawn +=
+            static_cast<int32_t>(instanceCount * (indices.indexCount / 3));
+    }
+
+    table.rowReadOnlyInteger("Triangles Drawn", trianglesDrawn).end();
 }
 
 void imguiRenderingSelection(RenderingPipelines& currentActivePipeline)
@@ -532,6 +1105,13 @@ template <> void imguiStructureControls<DebugLines>(DebugLines& structure)
         }
     );
 
+    table.rowBoolean("Occluded by Scene", structure.occluded, false);
+    if (structure.occluded && structure.pipeline != nullptr
+        && !structure.pipeline->variantReady(true))
+    {
+        table.rowReadOnlyText("Occluded Variant", "Compiling...");
+    }
+
     {
         DrawResultsGraphics const drawResults{structure.lastFrameDrawResults};
 
@@ -5,10 +5,17 @@
 
 #include <imgui.h>
 
+#include "../assetregistry.hpp"
 #include "../enginetypes.hpp"
+#include "../frametimes.hpp"
+#include "../meshlod.hpp"
+#include "../pipelinecompiler.hpp"
 #include "../pipelines.hpp"
+#include "../texturestreamer.hpp"
 
 struct MeshAsset;
+struct MeshImportOptions;
+class MeshLoader;
 
 struct UIRectangle
 {
@@ -97,20 +104,53 @@ template <typename T> void imguiStructureControls(T& structure);
 template <typename T> void imguiStructureDisplay(T const& structure);
 
 void imguiMeshInstanceControls(
-    bool& shouldRender,
-    std::span<std::shared_ptr<MeshAsset> const> meshes,
-    size_t& meshIndex
+    bool& shouldRender, AssetRegistry const& meshes, MeshHandle& meshSelected
 );
 
+// Requests meshes to load in the background, and shows their progress.
+void imguiMeshLoadingControls(
+    MeshLoader& loader, std::string& localPath, MeshImportOptions& options
+);
+
+// Shows the mesh memory budget, alongside how much is resident.
+void imguiMeshResidencyControls(
+    MeshResidencyParameters& parameters,
+    AssetRegistry::Statistics const& statistics
+);
+
+// Shows the texture memory and upload budgets, alongside how much of each
+// texture is resident.
+void imguiTextureStreamingControls(
+    TextureStreamingParameters& parameters,
+    TextureStreamer::Statistics const& statistics
+);
+
+// Shows the level of detail parameters, alongside how many instances were
+// drawn at each level last frame.
+void imguiLODControls(
+    LODParameters& parameters,
+    MeshInstances const& instances,
+    MeshAsset const& mesh
+);
+
+// Shows the background compiler's queue, and how many shaders came from the
+// on-disk cache.
+void imguiPipelineCompilationStatus(PipelineCompiler const& compiler);
+
 void imguiRenderingSelection(RenderingPipelines& currentActivePipeline);
 
 struct PerformanceValues
 {
-    std::span<double const> samplesFPS;
-    double averageFPS;
+    // Frame times in milliseconds, wrapping around at currentFrame
+    std::span<double const> samplesMilliseconds;
+    FrameTimeSummary summary;
 
     // Used to draw a vertical line indicating the current frame
     size_t currentFrame;
 };
 
-void imguiPerformanceWindow(PerformanceValues values, float& targetFPS);
\ No newline at end of file
+// windowFrames is how many recent frames the summary covers, and is picked
+// in the window.
+void imguiPerformanceWindow(
+    PerformanceValues const& values, float& targetFPS, size_t& windowFrames
+);
\ No newline at end of file
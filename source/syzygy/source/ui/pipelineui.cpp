@@ -422,6 +422,41 @@ template <> void imguiPipelineControls(ComputeCollectionPipeline& pipeline)
 
 template <> void imguiPipelineControls(DeferredShadingPipeline& pipeline)
 {
+    DeferredShadingPipeline::Parameters const defaults{};
+
+    std::array<std::string, 3> const skyQualityLabels{"Low", "Medium", "High"};
+    auto skyQualityIndex{
+        static_cast<size_t>(pipeline.m_parameters.skyQuality)
+    };
+
+    PropertyTable::begin()
+        .rowBoolean(
+            "Meshlet Culling",
+            pipeline.m_parameters.meshletCulling,
+            defaults.meshletCulling
+        )
+        .rowBoolean(
+            "Shadows", pipeline.m_parameters.shadows, defaults.shadows
+        )
+        .rowDropdown(
+            "Sky Quality",
+            skyQualityIndex,
+            static_cast<size_t>(defaults.skyQuality),
+            skyQualityLabels
+        )
+        .rowReadOnlyText(
+            "Shader Variants",
+            fmt::format(
+                "{} of {} compiled",
+                pipeline.shaderVariantsReady(),
+                pipeline.shaderVariantsRequested()
+            )
+        )
+        .end();
+
+    pipeline.m_parameters.skyQuality =
+        static_cast<DeferredShadingPipeline::SkyQuality>(skyQualityIndex);
+
     imguiStructureControls(
         pipeline.m_parameters.shadowPassParameters, ShadowPassParameters{}
     );
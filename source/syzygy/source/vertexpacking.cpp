@@ -0,0 +1,115 @@
+#include "vertexpacking.hpp"
+
+#include <glm/gtc/packing.hpp>
+#include <glm/packing.hpp>
+
+#include <limits>
+
+auto vertexpacking::computePackedEncoding(
+    std::span<Vertex const> const vertices
+) -> VertexEncoding
+{
+    if (vertices.empty())
+    {
+        return VertexEncoding{.format = VertexFormat::PACKED};
+    }
+
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+    for (Vertex const& vertex : vertices)
+    {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+
+    // Flat meshes would otherwise divide by zero when quantizing.
+    float constexpr MINIMUM_EXTENT{1e-6F};
+
+    return VertexEncoding{
+        .format = VertexFormat::PACKED,
+        .positionMin = min,
+        .positionExtent = glm::max(max - min, glm::vec3{MINIMUM_EXTENT}),
+    };
+}
+
+auto vertexpacking::encodeOctahedral(glm::vec3 const normal) -> glm::vec2
+{
+    float const manhattanLength{
+        glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z)
+    };
+    if (manhattanLength == 0.0F)
+    {
+        return glm::vec2{0.0F};
+    }
+
+    glm::vec3 const octahedron{normal / manhattanLength};
+    if (octahedron.z >= 0.0F)
+    {
+        return glm::vec2{octahedron};
+    }
+
+    // Fold the lower hemisphere over the diagonals
+    glm::vec2 const signs{
+        octahedron.x >= 0.0F ? 1.0F : -1.0F,
+        octahedron.y >= 0.0F ? 1.0F : -1.0F,
+    };
+    return (1.0F - glm::abs(glm::vec2{octahedron.y, octahedron.x})) * signs;
+}
+
+auto vertexpacking::packVertex(
+    Vertex const& vertex, VertexEncoding const& encoding
+) -> PackedVertex
+{
+    glm::vec3 const position{glm::clamp(
+        (vertex.position - encoding.positionMin) / encoding.positionExtent,
+        0.0F,
+        1.0F
+    )};
+    glm::vec2 const normal{encodeOctahedral(vertex.normal)};
+
+    return PackedVertex{.data{
+        glm::packUnorm2x16(glm::vec2{position.x, position.y}),
+        static_cast<uint32_t>(glm::packUnorm1x16(position.z))
+            | (static_cast<uint32_t>(glm::packSnorm2x8(normal)) << 16U),
+        glm::packHalf2x16(glm::vec2{vertex.uv_x, vertex.uv_y}),
+        glm::packUnorm4x8(glm::clamp(vertex.color, 0.0F, 1.0F)),
+    }};
+}
+
+auto vertexpacking::packVertices(
+    std::span<Vertex const> const vertices, VertexEncoding const& encoding
+) -> std::vector<PackedVertex>
+{
+    std::vector<PackedVertex> packed{};
+    packed.reserve(vertices.size());
+    for (Vertex const& vertex : vertices)
+    {
+        packed.push_back(packVertex(vertex, encoding));
+    }
+    return packed;
+}
+
+auto vertexpacking::extractPositions(std::span<Vertex const> const vertices)
+    -> std::vector<glm::vec3>
+{
+    std::vector<glm::vec3> positions{};
+    positions.reserve(vertices.size());
+    for (Vertex const& vertex : vertices)
+    {
+        positions.push_back(vertex.position);
+    }
+    return positions;
+}
+
+auto vertexpacking::extractPackedPositions(
+    std::span<PackedVertex const> const vertices
+) -> std::vector<glm::uvec2>
+{
+    std::vector<glm::uvec2> positions{};
+    positions.reserve(vertices.size());
+    for (PackedVertex const& vertex : vertices)
+    {
+        positions.push_back(glm::uvec2{vertex.data.x, vertex.data.y});
+    }
+    return positions;
+}
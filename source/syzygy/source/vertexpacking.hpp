@@ -0,0 +1,29 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "enginetypes.hpp"
+
+namespace vertexpacking
+{
+// Computes the position bounds that packed positions are quantized against.
+VertexEncoding computePackedEncoding(std::span<Vertex const> vertices);
+
+// Maps a unit vector onto the [-1,1] square using an octahedral projection.
+glm::vec2 encodeOctahedral(glm::vec3 normal);
+
+PackedVertex packVertex(Vertex const& vertex, VertexEncoding const& encoding);
+
+std::vector<PackedVertex>
+packVertices(std::span<Vertex const> vertices, VertexEncoding const& encoding);
+
+// Copies out only the positions, for passes that only write depth. These are
+// tightly packed floats, at a quarter of the size of Vertex.
+std::vector<glm::vec3> extractPositions(std::span<Vertex const> vertices);
+
+// Copies out the first half of each packed vertex, which holds its quantized
+// position. The upper bytes of y still hold the normal, and are ignored.
+std::vector<glm::uvec2>
+extractPackedPositions(std::span<PackedVertex const> vertices);
+} // namespace vertexpacking
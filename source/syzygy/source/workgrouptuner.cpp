@@ -0,0 +1,360 @@
+#include "workgrouptuner.hpp"
+
+#include "helpers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+// 2D shapes that are a few multiples of the common subgroup sizes
+std::array<WorkgroupSize, 7> constexpr CANDIDATE_SIZES{
+    WorkgroupSize{.x = 8, .y = 8},
+    WorkgroupSize{.x = 16, .y = 8},
+    WorkgroupSize{.x = 8, .y = 16},
+    WorkgroupSize{.x = 16, .y = 16},
+    WorkgroupSize{.x = 32, .y = 8},
+    WorkgroupSize{.x = 64, .y = 4},
+    WorkgroupSize{.x = 32, .y = 16},
+};
+
+auto deviceProperties(VkPhysicalDevice const physicalDevice)
+    -> VkPhysicalDeviceProperties
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return properties;
+}
+
+auto fitsDevice(
+    WorkgroupSize const size, VkPhysicalDeviceLimits const& limits
+) -> bool
+{
+    return size.x * size.y <= limits.maxComputeWorkGroupInvocations
+        && size.x <= limits.maxComputeWorkGroupSize[0]
+        && size.y <= limits.maxComputeWorkGroupSize[1];
+}
+
+auto tunedSizePath(
+    VkPhysicalDeviceProperties const& properties, std::string const& passName
+) -> std::filesystem::path
+{
+    return DebugUtils::getLoadedDebugUtils().makeAbsolutePath(
+        std::filesystem::path{"cache"} / "workgroups"
+        / fmt::format(
+            "{:04x}_{:04x}_{:08x}_{}.txt",
+            properties.vendorID,
+            properties.deviceID,
+            properties.driverVersion,
+            passName
+        )
+    );
+}
+
+auto readTunedSize(
+    VkPhysicalDeviceProperties const& properties, std::string const& passName
+) -> std::optional<WorkgroupSize>
+{
+    std::ifstream file(tunedSizePath(properties, passName));
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    WorkgroupSize size{};
+    file >> size.x >> size.y;
+    if (!file || !fitsDevice(size, properties.limits))
+    {
+        return std::nullopt;
+    }
+
+    return size;
+}
+
+void writeTunedSize(
+    VkPhysicalDeviceProperties const& properties,
+    std::string const& passName,
+    WorkgroupSize const size
+)
+{
+    std::filesystem::path const path{tunedSizePath(properties, passName)};
+
+    std::error_code error{};
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error)
+    {
+        Warning(fmt::format(
+            "Unable to create workgroup size directory: {}", error.message()
+        ));
+        return;
+    }
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        Warning("Unable to write tuned workgroup size.");
+        return;
+    }
+
+    file << size.x << " " << size.y << "\n";
+}
+
+auto median(std::vector<double> samples) -> double
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+
+    auto const middle{samples.begin() + samples.size() / 2};
+    std::nth_element(samples.begin(), middle, samples.end());
+    return *middle;
+}
+} // namespace
+
+WorkgroupTuner::WorkgroupTuner(
+    VkPhysicalDevice const physicalDevice,
+    VkDevice const device,
+    std::string passName
+)
+    : m_device(device)
+    , m_passName(std::move(passName))
+    , m_deviceProperties(deviceProperties(physicalDevice))
+{
+    if (std::optional<WorkgroupSize> const tunedSize{
+            readTunedSize(m_deviceProperties, m_passName)
+        };
+        tunedSize.has_value())
+    {
+        m_best = tunedSize.value();
+        return;
+    }
+
+    if (m_deviceProperties.limits.timestampComputeAndGraphics == VK_FALSE)
+    {
+        Warning(fmt::format(
+            "Timestamps are unsupported, so the workgroup size of {} will not "
+            "be tuned.",
+            m_passName
+        ));
+        return;
+    }
+
+    for (WorkgroupSize const size : CANDIDATE_SIZES)
+    {
+        if (fitsDevice(size, m_deviceProperties.limits))
+        {
+            m_candidates.push_back(size);
+        }
+    }
+    m_samplesNanoseconds.resize(m_candidates.size());
+
+    VkQueryPoolCreateInfo const createInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = static_cast<uint32_t>(QUERY_SLOT_COUNT * 2),
+        .pipelineStatistics = 0,
+    };
+    VkResult const result{
+        vkCreateQueryPool(device, &createInfo, nullptr, &m_queryPool)
+    };
+    if (result != VK_SUCCESS)
+    {
+        LogVkResult(result, "Creating workgroup tuner query pool");
+        m_candidates.clear();
+        m_samplesNanoseconds.clear();
+        return;
+    }
+
+    Log(fmt::format(
+        "Tuning workgroup size of {} over {} candidates.",
+        m_passName,
+        m_candidates.size()
+    ));
+}
+
+auto WorkgroupTuner::loadTunedSize(
+    VkPhysicalDevice const physicalDevice, std::string const& passName
+) -> std::optional<WorkgroupSize>
+{
+    return readTunedSize(deviceProperties(physicalDevice), passName);
+}
+
+void WorkgroupTuner::update()
+{
+    if (!tuning())
+    {
+        return;
+    }
+
+    m_updateCount += 1;
+
+    collectSamples();
+    while (tuning()
+           && m_samplesNanoseconds[m_candidateIndex].size()
+                  >= SAMPLES_PER_CANDIDATE)
+    {
+        m_candidateIndex++;
+    }
+    if (!tuning())
+    {
+        finishTuning();
+    }
+}
+
+auto WorkgroupTuner::size() const -> WorkgroupSize
+{
+    if (tuning())
+    {
+        return m_candidates[m_candidateIndex];
+    }
+    return m_best;
+}
+
+void WorkgroupTuner::recordBegin(
+    VkCommandBuffer const cmd, bool const measured
+)
+{
+    if (!tuning())
+    {
+        return;
+    }
+
+    size_t const slot{m_nextSlot};
+    if (!measured || m_slots[slot].has_value())
+    {
+        return;
+    }
+
+    auto const firstQuery{static_cast<uint32_t>(slot * 2)};
+    vkCmdResetQueryPool(cmd, m_queryPool, firstQuery, 2);
+    vkCmdWriteTimestamp2(
+        cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, m_queryPool, firstQuery
+    );
+
+    m_slots[slot] = QuerySlot{
+        .candidateIndex = m_candidateIndex,
+        .recordedUpdate = m_updateCount,
+    };
+    m_openSlot = slot;
+    m_nextSlot = (slot + 1) % QUERY_SLOT_COUNT;
+}
+
+void WorkgroupTuner::recordEnd(VkCommandBuffer const cmd)
+{
+    if (!m_openSlot.has_value())
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp2(
+        cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        m_queryPool,
+        static_cast<uint32_t>(m_openSlot.value() * 2 + 1)
+    );
+    m_openSlot.reset();
+}
+
+void WorkgroupTuner::rejectCandidate()
+{
+    if (!tuning())
+    {
+        return;
+    }
+
+    m_samplesNanoseconds[m_candidateIndex].assign(
+        SAMPLES_PER_CANDIDATE, std::numeric_limits<double>::infinity()
+    );
+}
+
+void WorkgroupTuner::collectSamples()
+{
+    for (size_t slot{0}; slot < QUERY_SLOT_COUNT; slot++)
+    {
+        if (!m_slots[slot].has_value())
+        {
+            continue;
+        }
+        QuerySlot const querySlot{m_slots[slot].value()};
+
+        // Each query is its timestamp followed by its availability
+        std::array<uint64_t, 4> results{};
+        VkResult const result{vkGetQueryPoolResults(
+            m_device,
+            m_queryPool,
+            static_cast<uint32_t>(slot * 2),
+            2,
+            sizeof(results),
+            results.data(),
+            sizeof(uint64_t) * 2,
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+        )};
+        if (result == VK_NOT_READY || results[1] == 0 || results[3] == 0)
+        {
+            if (m_updateCount - querySlot.recordedUpdate > STALE_SLOT_UPDATES)
+            {
+                m_slots[slot].reset();
+            }
+            continue;
+        }
+        if (result != VK_SUCCESS)
+        {
+            LogVkResult(result, "Reading workgroup tuner timestamps");
+            m_slots[slot].reset();
+            continue;
+        }
+
+        double const nanoseconds{
+            static_cast<double>(results[2] - results[0])
+            * static_cast<double>(m_deviceProperties.limits.timestampPeriod)
+        };
+        m_samplesNanoseconds[querySlot.candidateIndex].push_back(nanoseconds);
+        m_slots[slot].reset();
+    }
+}
+
+void WorkgroupTuner::finishTuning()
+{
+    std::vector<double> medians{};
+    for (std::vector<double> const& samples : m_samplesNanoseconds)
+    {
+        medians.push_back(median(samples));
+    }
+
+    auto const fastest{std::min_element(medians.begin(), medians.end())};
+    if (fastest == medians.end() || std::isinf(*fastest))
+    {
+        Warning(fmt::format(
+            "No workgroup size of {} could be timed, keeping the default.",
+            m_passName
+        ));
+        return;
+    }
+
+    auto const fastestIndex{
+        static_cast<size_t>(std::distance(medians.begin(), fastest))
+    };
+    m_best = m_candidates[fastestIndex];
+
+    Log(fmt::format(
+        "Tuned workgroup size of {} to {}x{}, taking {:.1f} us.",
+        m_passName,
+        m_best.x,
+        m_best.y,
+        *fastest / 1000.0
+    ));
+
+    writeTunedSize(m_deviceProperties, m_passName, m_best);
+}
+
+void WorkgroupTuner::cleanup(VkDevice const device)
+{
+    vkDestroyQueryPool(device, m_queryPool, nullptr);
+    m_queryPool = VK_NULL_HANDLE;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "enginetypes.hpp"
+
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct WorkgroupSize
+{
+    // Matches the local size that full-screen compute shaders default to
+    uint32_t x{16};
+    uint32_t y{16};
+
+    bool operator==(WorkgroupSize const& other) const = default;
+};
+
+// Picks the workgroup size of a full-screen compute pass for the device. Each
+// candidate is timed with timestamp queries over the first frames the pass is
+// recorded, then the fastest is kept and saved per device and driver, so that
+// later launches use it immediately.
+//
+// Tuned shaders declare their local size through the constant IDs below, and
+// the pass dispatches with size() only once that variant is compiled.
+class WorkgroupTuner
+{
+public:
+    static uint32_t constexpr SIZE_X_CONSTANT_ID{100};
+    static uint32_t constexpr SIZE_Y_CONSTANT_ID{101};
+
+    // Starts tuning unless a size was saved for this pass on this device.
+    // Without timestamp support, the default size is kept.
+    WorkgroupTuner(
+        VkPhysicalDevice physicalDevice,
+        VkDevice device,
+        std::string passName
+    );
+
+    WorkgroupTuner(WorkgroupTuner const& other) = delete;
+    WorkgroupTuner& operator=(WorkgroupTuner const& other) = delete;
+
+    // The size saved for a pass, if it has been tuned on this device before.
+    static std::optional<WorkgroupSize>
+    loadTunedSize(VkPhysicalDevice physicalDevice, std::string const& passName);
+
+    bool tuning() const { return m_candidateIndex < m_candidates.size(); }
+
+    // Reads back finished timings, and moves on from the current candidate
+    // once it has enough of them. Call once per frame before size(), so the
+    // size dispatched is the candidate that recordBegin times.
+    void update();
+
+    // The candidate being timed while tuning, otherwise the best size.
+    WorkgroupSize size() const;
+
+    // Wraps the dispatch of the pass. Pass measured as false when the dispatch
+    // does not use size(), such as while its variant compiles, so that frame
+    // is not counted.
+    void recordBegin(VkCommandBuffer cmd, bool measured);
+    void recordEnd(VkCommandBuffer cmd);
+
+    // Drops the current candidate, such as when its variant failed to
+    // compile.
+    void rejectCandidate();
+
+    void cleanup(VkDevice device);
+
+private:
+    // Each slot holds a begin and end timestamp. There are enough slots that
+    // one is always finished by the time it comes around again.
+    static size_t constexpr QUERY_SLOT_COUNT{4};
+    static size_t constexpr SAMPLES_PER_CANDIDATE{16};
+
+    // A slot still unavailable this many updates after it was recorded
+    // belongs to a command buffer that was never submitted, so it is freed.
+    static uint64_t constexpr STALE_SLOT_UPDATES{8};
+
+    struct QuerySlot
+    {
+        size_t candidateIndex{0};
+        uint64_t recordedUpdate{0};
+    };
+
+    void collectSamples();
+    void finishTuning();
+
+    VkDevice m_device{VK_NULL_HANDLE};
+    std::string m_passName{};
+    VkPhysicalDeviceProperties m_deviceProperties{};
+
+    VkQueryPool m_queryPool{VK_NULL_HANDLE};
+    std::array<std::optional<QuerySlot>, QUERY_SLOT_COUNT> m_slots{};
+    size_t m_nextSlot{0};
+    uint64_t m_updateCount{0};
+    std::optional<size_t> m_openSlot{};
+
+    std::vector<WorkgroupSize> m_candidates{};
+    std::vector<std::vector<double>> m_samplesNanoseconds{};
+    size_t m_candidateIndex{0};
+
+    WorkgroupSize m_best{};
+};